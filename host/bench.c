@@ -0,0 +1,542 @@
+/*
+ * WiiMedic host backend - bench.c
+ * Microbenchmarks for the hot paths of the diagnostic modules.
+ *
+ *   wiimedic_bench [-f filter] [-n scale]
+ *
+ * Module output (console text, the report file) is discarded; results go to
+ * stdout as "<name> <iterations> <ns/op>" so runs can be diffed per change.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fat.h>
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <ogc/wd.h>
+#include <wiiuse/wpad.h>
+
+#include "controller_test.h"
+#include "heap_map.h"
+#include "host_platform.h"
+#include "ios_check.h"
+#include "line_store.h"
+#include "nand_health.h"
+#include "network_test.h"
+#include "png_stream.h"
+#include "quick_check.h"
+#include "report.h"
+#include "report_rec.h"
+#include "results.h"
+#include "screen.h"
+#include "screenshot.h"
+#include "scroll_search.h"
+#include "snapshot.h"
+#include "startup.h"
+#include "storage_test.h"
+#include "system_info.h"
+#include "ui_common.h"
+#include "xfb_text.h"
+
+#define SCAN_BUF_SIZE 4096
+#define SNAP_BENCH_A "sd:/WiiMedic_Snap_bench_a.bin"
+#define SNAP_BENCH_B "sd:/WiiMedic_Snap_bench_b.bin"
+
+typedef struct {
+  const char *name;
+  void (*fn)(int iters);
+  int iters;
+} bench_case;
+
+static FILE *s_out;
+static u8 s_scan_buf[SCAN_BUF_SIZE] ATTRIBUTE_ALIGN(32);
+static s32 s_scan_ret;
+
+/*---------------------------------------------------------------------------*/
+static void bench_ui_printf(int iters) {
+  int i;
+  ui_scroll_begin();
+  for (i = 0; i < iters; i++) {
+    if ((i & 127) == 0)
+      ui_scroll_begin();
+    ui_printf("   %sIOS%-4u  rev %-8u %-10s" UI_WHITE " %s\n" UI_RESET,
+              UI_BGREEN, (unsigned)(i & 0xFF), (unsigned)i, "OK",
+              "Used by many games");
+  }
+}
+
+static void bench_ui_draw_kv(int iters) {
+  int i;
+  ui_scroll_begin();
+  for (i = 0; i < iters; i++) {
+    if ((i & 127) == 0)
+      ui_scroll_begin();
+    ui_draw_kv("Clusters Used", "21345 / 32768 clusters");
+  }
+}
+
+static void bench_ui_draw_bar(int iters) {
+  int i;
+  ui_scroll_begin();
+  for (i = 0; i < iters; i++) {
+    if ((i & 127) == 0)
+      ui_scroll_begin();
+    ui_draw_bar((u32)(i & 0x7FFF), 32768, 40);
+  }
+}
+
+/* Worker -> UI line throughput: a worker thread ui_printf's while the
+   calling thread drains its ring */
+static int s_ring_lines;
+
+static void *ring_producer(void *arg) {
+  int i;
+  (void)arg;
+  for (i = 0; i < s_ring_lines; i++)
+    ui_printf("   %sIOS%-4u  rev %-8u\n" UI_RESET, UI_BGREEN,
+              (unsigned)(i & 0xFF), (unsigned)i);
+  ui_output_detach();
+  return NULL;
+}
+
+static void bench_ui_ring(int iters) {
+  lwp_t worker;
+  int drained = 0, since_reset = 0;
+
+  ui_scroll_begin();
+  s_ring_lines = iters;
+  if (LWP_CreateThread(&worker, ring_producer, NULL, NULL, 0, 64) < 0)
+    return;
+  while (drained < iters) {
+    int n = ui_output_drain();
+    if (n == 0)
+      LWP_YieldThread();
+    drained += n;
+    since_reset += n;
+    if (since_reset >= 128) {
+      ui_scroll_begin();
+      since_reset = 0;
+    }
+  }
+  LWP_JoinThread(worker, NULL);
+  ui_output_drain();
+}
+
+/* Scroll buffer store and redraw, on lines shaped like the IOS scan's */
+static const char s_scan_line[] =
+    UI_RESET "   " UI_BGREEN "IOS58   rev 6176     OK        " UI_WHITE
+             " Used by many games";
+
+static void bench_line_store(int iters) {
+  line_store ls;
+  int i;
+
+  line_store_init(&ls);
+  for (i = 0; i < iters; i++) {
+    if ((i & 127) == 0)
+      line_store_clear(&ls);
+    line_store_add(&ls, s_scan_line, sizeof(s_scan_line) - 1);
+  }
+  line_store_free(&ls);
+}
+
+static void bench_line_render(int iters) {
+  line_store ls;
+  int i;
+
+  line_store_init(&ls);
+  for (i = 0; i < 18; i++)
+    line_store_add(&ls, s_scan_line, sizeof(s_scan_line) - 1);
+  for (i = 0; i < iters; i++)
+    line_store_print(&ls, (u32)(i % 18));
+  fflush(stdout);
+  line_store_free(&ls);
+}
+
+/* One-line scroll steps through a 200-line report, as the viewer draws
+   them: only the cells that changed go to the console */
+static void bench_screen_scroll(int iters) {
+  line_store ls;
+  line_view v;
+  char line[96];
+  int i, r;
+
+  line_store_init(&ls);
+  for (i = 0; i < 200; i++) {
+    int n = snprintf(line, sizeof(line),
+                     UI_RESET "   " UI_CYAN "IOS%-3d " UI_RESET
+                              "......... " UI_BWHITE "rev %u",
+                     i, (unsigned)(i * 257));
+    line_store_add(&ls, line, (u32)n);
+  }
+  screen_invalidate();
+  for (i = 0; i < iters; i++) {
+    int offset = i % (200 - 18);
+
+    screen_begin();
+    for (r = 0; r < 18; r++) {
+      line_store_get(&ls, (u32)(offset + r), &v);
+      screen_line(&v);
+    }
+    screen_present();
+  }
+  line_store_free(&ls);
+}
+
+/* Opening the viewer on a 500-line scan and searching it: index build,
+   one severity preset, one text query and a jump for each */
+static void bench_scroll_search(int iters) {
+  scroll_search search;
+  line_store ls;
+  char line[96];
+  int i;
+
+  line_store_init(&ls);
+  for (i = 0; i < 500; i++) {
+    int n = snprintf(line, sizeof(line),
+                     UI_RESET "   IOS%-3d rev %-5u " UI_BRED "%s" UI_RESET
+                              "  Used by many games",
+                     i, (unsigned)(i * 257), i % 50 ? "OK  " : "[XX] STUB");
+    line_store_add(&ls, line, (u32)n);
+  }
+  for (i = 0; i < iters; i++) {
+    search_begin(&search, &ls);
+    search_next_preset(&search);
+    search_jump(&search, 0, 1);
+    search_set_text(&search, "stub");
+    search_jump(&search, 0, 1);
+    search_end(&search);
+  }
+  line_store_free(&ls);
+}
+
+/* Three full screens of text, each different from the others in every
+   cell, with the framebuffer renderer set up to draw them */
+static screen_cell s_frames[3][SCREEN_ROWS][SCREEN_COLS];
+
+static bool xfb_ready(void) {
+  static bool ready = false;
+  int i, r, c;
+
+  if (!ready) {
+    GXRModeObj *rmode = VIDEO_GetPreferredMode(NULL);
+    void *fb = SYS_AllocateFramebuffer(rmode);
+
+    console_init(fb, 20, 20, rmode->fbWidth, rmode->xfbHeight,
+                 rmode->fbWidth * VI_DISPLAY_PIX_SZ);
+    if (!xfb_text_init(rmode, fb))
+      return false;
+    for (i = 0; i < 3; i++)
+      for (r = 0; r < SCREEN_ROWS; r++)
+        for (c = 0; c < SCREEN_COLS; c++)
+          s_frames[i][r][c] =
+              SCREEN_CELL('A' + (r + c + i) % 26,
+                          LINE_ATTR_FG | LINE_ATTR_BOLD | ((r + i) & 7));
+    ready = true;
+  }
+  return true;
+}
+
+/* Full-screen redraws straight into the framebuffer: each frame differs
+   from the one its back buffer holds in every cell */
+static void bench_xfb_redraw(int iters) {
+  int i;
+
+  if (!xfb_ready())
+    return;
+  for (i = 0; i < iters; i++)
+    xfb_text_present(s_frames[i % 3]);
+}
+
+/* A screenshot of a full screen of text, converted and encoded as
+   screenshot_save does it, with the file going to /dev/null */
+static void bench_screenshot(int iters) {
+  static u8 rgb[PNG_MAX_WIDTH * 3];
+  static png_stream png;
+  const u32 *fb;
+  u32 w, h, y;
+  int i;
+
+  if (!xfb_ready())
+    return;
+  xfb_text_present(s_frames[0]);
+  fb = xfb_text_shown(&w, &h);
+  for (i = 0; i < iters; i++) {
+    FILE *fp = fopen("/dev/null", "wb");
+
+    png_begin(&png, fp, w, h);
+    for (y = 0; y < h; y++) {
+      yuyv_to_rgb(fb + y * (w / 2), rgb, w / 2);
+      png_row(&png, rgb);
+    }
+    png_end(&png);
+    fclose(fp);
+  }
+}
+
+/* Conversion alone, one frame per iteration */
+static void bench_yuyv_to_rgb(int iters) {
+  static u8 rgb[PNG_MAX_WIDTH * 3];
+  const u32 *fb;
+  u32 w, h, y;
+  int i;
+
+  if (!xfb_ready())
+    return;
+  xfb_text_present(s_frames[0]);
+  fb = xfb_text_shown(&w, &h);
+  for (i = 0; i < iters; i++)
+    for (y = 0; y < h; y++)
+      yuyv_to_rgb(fb + y * (w / 2), rgb, w / 2);
+}
+
+/*---------------------------------------------------------------------------*/
+static void bench_ap_scan_parse(int iters) {
+  int i;
+  for (i = 0; i < iters; i++) {
+    ui_scroll_begin();
+    network_parse_ap_scan(s_scan_buf, s_scan_ret);
+  }
+}
+
+static void bench_health_score(int iters) {
+  volatile int sink = 0;
+  int i;
+  for (i = 0; i < iters; i++)
+    sink += nand_compute_health_score((u32)(i * 7) & 0x7FFF,
+                                      (u32)(i * 3) % 6143, i & 1, i & 15);
+  (void)sink;
+}
+
+static void bench_nand_scan(int iters) {
+  int i;
+  for (i = 0; i < iters; i++) {
+    ui_scroll_begin();
+    run_nand_health();
+  }
+}
+
+static void bench_ios_scan(int iters) {
+  int i;
+  for (i = 0; i < iters; i++) {
+    ui_scroll_begin();
+    run_ios_check();
+  }
+}
+
+/* Walk a heap with a few thousand chunks, every other one freed */
+static void bench_heap_walk(int iters) {
+  static void *blocks[4096];
+  static bool fragmented = false;
+  heap_region_stats st;
+  char cells[HEAP_MAP_CELLS];
+  int i;
+
+  if (!fragmented) {
+    for (i = 0; i < 4096; i++)
+      blocks[i] = malloc(64 + (i & 7) * 48);
+    for (i = 0; i < 4096; i += 2) {
+      free(blocks[i]);
+      blocks[i] = NULL;
+    }
+    fragmented = true;
+  }
+  for (i = 0; i < iters; i++)
+    heap_map_walk_mem1(&st, cells);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Section formatting only: every module's report() as text, JSON and
+   binary into sinks with no file */
+static void bench_report_sections(int iters) {
+  report_sink text, json, tlv;
+  report_rec rec;
+  int i, id;
+
+  if (!report_open(&text, NULL))
+    return;
+  if (report_open(&json, NULL)) {
+    if (report_open(&tlv, NULL)) {
+      rec_begin(&rec, &text, &json, &tlv);
+      for (i = 0; i < iters; i++) {
+        for (id = 0; id < MODULE_MEMORY; id++) {
+          const module_desc *m = module_get((module_id)id);
+
+          rec_section(&rec, m->name);
+          m->report(&rec);
+          rec_section_end(&rec);
+        }
+      }
+      rec_end(&rec);
+      report_close(&tlv);
+    }
+    report_close(&json);
+  }
+  report_close(&text);
+}
+
+/* The whole "Generate Full Report" path, including the SD write */
+static void bench_report_full(int iters) {
+  int i;
+  for (i = 0; i < iters; i++) {
+    remove("sd:/WiiMedic_Report.txt");
+    host_pad_rewind();
+    ui_scroll_begin();
+    for (int id = 0; id < MODULE_COUNT; id++)
+      result_invalidate((module_id)id); /* collect everything */
+    run_report_generator();
+  }
+}
+
+/* Every module fresh from the previous run: only formatting and saving */
+static void bench_report_cached(int iters) {
+  int i;
+  for (i = 0; i < iters; i++) {
+    remove("sd:/WiiMedic_Report.txt");
+    host_pad_rewind();
+    ui_scroll_begin();
+    run_report_generator();
+  }
+}
+
+/* Quick Health Check with a cold IOS scan, as on the first run after boot */
+static void bench_quick_check(int iters) {
+  quick_summary sum;
+  int i;
+  for (i = 0; i < iters; i++) {
+    result_invalidate(MODULE_IOS);
+    quick_check_run(QUICK_BUDGET_MS, &sum);
+  }
+}
+
+/* Every title's TMD and ticket, NAND usage and settings, to SD */
+static void bench_snapshot_take(int iters) {
+  snapshot_summary sum;
+  int i;
+  for (i = 0; i < iters; i++)
+    snapshot_take(SNAP_BENCH_A, &sum);
+  remove(SNAP_BENCH_A);
+}
+
+/* Two snapshots of the fixture console compared: a full merge join */
+static void bench_snapshot_diff(int iters) {
+  snapshot_summary sum;
+  int i;
+
+  if (snapshot_take(SNAP_BENCH_A, &sum) && snapshot_take(SNAP_BENCH_B, &sum)) {
+    for (i = 0; i < iters; i++) {
+      ui_scroll_begin();
+      snapshot_diff(SNAP_BENCH_A, SNAP_BENCH_B);
+    }
+  }
+  remove(SNAP_BENCH_A);
+  remove(SNAP_BENCH_B);
+}
+
+/*---------------------------------------------------------------------------*/
+static const bench_case s_cases[] = {
+    {"ui_printf", bench_ui_printf, 200000},
+    {"ui_draw_kv", bench_ui_draw_kv, 100000},
+    {"ui_draw_bar", bench_ui_draw_bar, 20000},
+    {"ui_ring", bench_ui_ring, 200000},
+    {"line_store", bench_line_store, 500000},
+    {"line_render", bench_line_render, 500000},
+    {"screen_scroll", bench_screen_scroll, 50000},
+    {"xfb_redraw", bench_xfb_redraw, 2000},
+    {"scroll_search", bench_scroll_search, 5000},
+    {"yuyv_to_rgb", bench_yuyv_to_rgb, 500},
+    {"screenshot", bench_screenshot, 100},
+    {"ap_scan_parse", bench_ap_scan_parse, 20000},
+    {"health_score", bench_health_score, 2000000},
+    {"nand_scan", bench_nand_scan, 2000},
+    {"ios_scan", bench_ios_scan, 500},
+    {"heap_walk", bench_heap_walk, 2000},
+    {"report_sections", bench_report_sections, 2000},
+    {"report_full", bench_report_full, 50},
+    {"report_cached", bench_report_cached, 50},
+    {"quick_check", bench_quick_check, 200},
+    {"snapshot_take", bench_snapshot_take, 200},
+    {"snapshot_diff", bench_snapshot_diff, 20000},
+};
+
+#define NUM_CASES (int)(sizeof(s_cases) / sizeof(s_cases[0]))
+
+/*---------------------------------------------------------------------------*/
+static void prepare(void) {
+  ScanParameters sparams;
+
+  PAD_Init();
+  devices_start();
+  devices_wait(DEV_ALL);
+  host_vsync_pacing(false); /* measure CPU time, not frames */
+
+  /* Populate module state the report sections read from */
+  ui_scroll_begin();
+  run_ios_check();
+  run_storage_test();
+  scan_controllers_quick();
+  run_network_test();
+
+  WD_Init(AOSSAPScan);
+  WD_SetDefaultScanParameters(&sparams);
+  sparams.ChannelBitmap = 0x3FFF;
+  s_scan_ret = WD_ScanOnce(&sparams, s_scan_buf, sizeof(s_scan_buf));
+}
+
+/*---------------------------------------------------------------------------*/
+int main(int argc, char **argv) {
+  const char *filter = NULL;
+  double scale = 1.0;
+  int saved_stdout, devnull, opt, c;
+
+  while ((opt = getopt(argc, argv, "f:n:")) != -1) {
+    switch (opt) {
+    case 'f':
+      filter = optarg;
+      break;
+    case 'n':
+      scale = atof(optarg);
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-f filter] [-n scale]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  /* Keep results on the real stdout; module printf output goes nowhere */
+  fflush(stdout);
+  saved_stdout = dup(STDOUT_FILENO);
+  s_out = fdopen(saved_stdout, "w");
+  devnull = open("/dev/null", O_WRONLY);
+  dup2(devnull, STDOUT_FILENO);
+  close(devnull);
+
+  prepare();
+
+  fprintf(s_out, "%-18s %10s %14s\n", "benchmark", "iters", "ns/op");
+  for (c = 0; c < NUM_CASES; c++) {
+    const bench_case *bc = &s_cases[c];
+    int iters = (int)(bc->iters * scale);
+    u64 start, elapsed;
+
+    if (filter && !strstr(bc->name, filter))
+      continue;
+    if (iters < 1)
+      iters = 1;
+
+    bc->fn(iters > 10 ? iters / 10 : 1); /* warm caches */
+    start = gettime();
+    bc->fn(iters);
+    elapsed = gettime() - start;
+    fflush(stdout);
+
+    fprintf(s_out, "%-18s %10d %14.1f\n", bc->name, iters,
+            (double)ticks_to_nanosecs(elapsed) / iters);
+    fflush(s_out);
+  }
+  return 0;
+}
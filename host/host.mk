@@ -0,0 +1,73 @@
+#---------------------------------------------------------------------------------
+# WiiMedic - host build (Linux/x86)
+# Builds the diagnostic modules against the fixture-driven libogc stand-in in
+# host/ so they can be run, profiled and benchmarked without a console.
+#
+#   make host          build host/build/wiimedic and host/build/wiimedic_bench
+#   make host-bench    build and run the microbenchmarks
+#   make host-clean    remove host/build
+#
+# PROFILE=1 builds in the SIGPROF sampling profiler, output in
+# host/build/profile; each binary gets a linker map next to it.
+# TRACE=1 builds in span tracing, output in host/build[/profile]/trace.
+#
+# WIIMEDIC_FIXTURES / WIIMEDIC_HOST_ROOT override the fixture set and the
+# directory that stands in for sd:/ and usb:/ at run time.
+#---------------------------------------------------------------------------------
+
+HOST_CC		?=	cc
+HOST_BUILD	:=	host/build
+HOST_OUT	:=	$(HOST_BUILD)
+
+HOST_CFLAGS	:=	-g -O2 -Wall -fno-pie -D_GNU_SOURCE -DWIIMEDIC_HOST \
+				-DHOST_FIXTURE_DEFAULT=\"$(CURDIR)/host/fixtures/default\" \
+				-DHOST_ROOT_DEFAULT=\"$(CURDIR)/$(HOST_BUILD)/root\" \
+				-Ihost/include -Ihost -Isource
+HOST_LDFLAGS	=	-no-pie -Wl,-Map,$@.map
+HOST_LIBS	:=	-lm -lpthread
+
+ifeq ($(PROFILE),1)
+HOST_OUT	:=	$(HOST_BUILD)/profile
+HOST_CFLAGS	+=	-DWIIMEDIC_PROFILE -ffunction-sections -fno-omit-frame-pointer
+endif
+
+ifeq ($(TRACE),1)
+HOST_OUT	:=	$(HOST_OUT)/trace
+HOST_CFLAGS	+=	-DWIIMEDIC_TRACE
+endif
+
+HOST_OBJ	:=	$(HOST_OUT)/obj
+
+HOST_MODULES	:=	$(filter-out source/main.c,$(wildcard source/*.c))
+HOST_BACKEND	:=	$(filter-out host/bench.c,$(wildcard host/*.c))
+
+HOST_MODULE_OBJS	:=	$(patsubst source/%.c,$(HOST_OBJ)/source/%.o,$(HOST_MODULES))
+HOST_BACKEND_OBJS	:=	$(patsubst host/%.c,$(HOST_OBJ)/host/%.o,$(HOST_BACKEND))
+HOST_COMMON_OBJS	:=	$(HOST_MODULE_OBJS) $(HOST_BACKEND_OBJS)
+
+.PHONY: host host-bench host-clean
+
+host: $(HOST_OUT)/wiimedic $(HOST_OUT)/wiimedic_bench
+
+host-bench: $(HOST_OUT)/wiimedic_bench
+	@$(HOST_OUT)/wiimedic_bench
+
+host-clean:
+	@echo clean host ...
+	@rm -rf $(HOST_BUILD)
+
+$(HOST_OUT)/wiimedic: $(HOST_COMMON_OBJS) $(HOST_OBJ)/source/main.o
+	$(HOST_CC) -o $@ $^ $(HOST_LDFLAGS) $(HOST_LIBS)
+
+$(HOST_OUT)/wiimedic_bench: $(HOST_COMMON_OBJS) $(HOST_OBJ)/host/bench.o
+	$(HOST_CC) -o $@ $^ $(HOST_LDFLAGS) $(HOST_LIBS)
+
+$(HOST_OBJ)/source/%.o: source/%.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) -MMD -MP -c $< -o $@
+
+$(HOST_OBJ)/host/%.o: host/%.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(HOST_CFLAGS) -MMD -MP -c $< -o $@
+
+-include $(wildcard $(HOST_OBJ)/*/*.d)
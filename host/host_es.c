@@ -0,0 +1,172 @@
+/*
+ * WiiMedic host backend - host_es.c
+ * ES title enumeration from titles.txt and TMD blobs from tmd/<tid>.tmd
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <gccore.h>
+
+#include "host_platform.h"
+
+#define HOST_MAX_TITLES 512
+
+#define ES_ENOENT -106
+#define ES_EINVAL -1017
+
+static u64 s_titles[HOST_MAX_TITLES];
+static u32 s_title_count = 0;
+static bool s_titles_loaded = false;
+
+/*---------------------------------------------------------------------------*/
+static void load_titles(void) {
+  char path[PATH_MAX];
+  char line[64];
+  FILE *fp;
+
+  if (s_titles_loaded)
+    return;
+  s_titles_loaded = true;
+
+  host_fixture_path("titles.txt", path, sizeof(path));
+  fp = fopen(path, "r");
+  if (!fp)
+    return;
+  while (fgets(line, sizeof(line), fp) && s_title_count < HOST_MAX_TITLES) {
+    char *end;
+    u64 tid = strtoull(line, &end, 16);
+    if (end != line)
+      s_titles[s_title_count++] = tid;
+  }
+  fclose(fp);
+}
+
+/*---------------------------------------------------------------------------*/
+static void tmd_path(u64 tid, char *out, int outsize) {
+  char rel[64];
+  snprintf(rel, sizeof(rel), "tmd/%016llx.tmd", tid);
+  host_fixture_path(rel, out, outsize);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Fixtures are console dumps (big-endian); convert the fields WiiMedic reads */
+static void tmd_to_host_order(signed_blob *stmd, u32 size) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  tmd *t;
+  u16 i;
+
+  *stmd = __builtin_bswap32(*stmd);
+  if (SIGNATURE_SIZE(stmd) == 0 || SIGNATURE_SIZE(stmd) + sizeof(tmd) > size)
+    return;
+
+  t = (tmd *)SIGNATURE_PAYLOAD(stmd);
+  t->sys_version = __builtin_bswap64(t->sys_version);
+  t->title_id = __builtin_bswap64(t->title_id);
+  t->title_type = __builtin_bswap32(t->title_type);
+  t->group_id = __builtin_bswap16(t->group_id);
+  t->region = __builtin_bswap16(t->region);
+  t->access_rights = __builtin_bswap32(t->access_rights);
+  t->title_version = __builtin_bswap16(t->title_version);
+  t->num_contents = __builtin_bswap16(t->num_contents);
+  t->boot_index = __builtin_bswap16(t->boot_index);
+
+  for (i = 0; i < t->num_contents; i++) {
+    tmd_content *c = &t->contents[i];
+    if ((u8 *)(c + 1) > (u8 *)stmd + size)
+      break;
+    c->cid = __builtin_bswap32(c->cid);
+    c->index = __builtin_bswap16(c->index);
+    c->type = __builtin_bswap16(c->type);
+    c->size = __builtin_bswap64(c->size);
+  }
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+s32 ES_GetNumTitles(u32 *cnt) {
+  host_ipc_delay();
+  load_titles();
+  *cnt = s_title_count;
+  return 0;
+}
+
+s32 ES_GetTitles(u64 *titles, u32 cnt) {
+  host_ipc_delay();
+  load_titles();
+  if (cnt > s_title_count)
+    return ES_EINVAL;
+  memcpy(titles, s_titles, cnt * sizeof(u64));
+  return 0;
+}
+
+s32 ES_GetStoredTMDSize(u64 titleID, u32 *size) {
+  char path[PATH_MAX];
+  struct stat st;
+
+  host_ipc_delay();
+  tmd_path(titleID, path, sizeof(path));
+  if (stat(path, &st) != 0)
+    return ES_ENOENT;
+  *size = (u32)st.st_size;
+  return 0;
+}
+
+s32 ES_GetStoredTMD(u64 titleID, signed_blob *stmd, u32 size) {
+  char path[PATH_MAX];
+  FILE *fp;
+  long len;
+
+  host_ipc_delay();
+  tmd_path(titleID, path, sizeof(path));
+  fp = fopen(path, "rb");
+  if (!fp)
+    return ES_ENOENT;
+
+  fseek(fp, 0, SEEK_END);
+  len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  if (len <= 0 || (u32)len > size) {
+    fclose(fp);
+    return ES_EINVAL;
+  }
+  if (fread(stmd, 1, (size_t)len, fp) != (size_t)len) {
+    fclose(fp);
+    return ES_EINVAL;
+  }
+  fclose(fp);
+
+  tmd_to_host_order(stmd, (u32)len);
+  return 0;
+}
+
+/* One view per ticket file in nand/ticket/<hi>/<lo>.tik */
+s32 ES_GetNumTicketViews(u64 titleID, u32 *cnt) {
+  char rel[64], path[PATH_MAX];
+  struct stat st;
+
+  host_ipc_delay();
+  snprintf(rel, sizeof(rel), "nand/ticket/%08x/%08x.tik",
+           (u32)(titleID >> 32), (u32)titleID);
+  host_fixture_path(rel, path, sizeof(path));
+  *cnt = stat(path, &st) == 0 ? 1 : 0;
+  return 0;
+}
+
+s32 ES_GetBoot2Version(u32 *version) {
+  host_ipc_delay();
+  long v = host_config_int("boot2", 4);
+  if (v < 0)
+    return (s32)v;
+  *version = (u32)v;
+  return 0;
+}
+
+s32 ES_GetDeviceID(u32 *device_id) {
+  host_ipc_delay();
+  *device_id = (u32)host_config_int("device_id", 0x0403AC68);
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * WiiMedic host backend - host_fixture.c
+ * Fixture directory selection, config.txt parsing and file-tree helpers
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "host_platform.h"
+
+#ifndef HOST_FIXTURE_DEFAULT
+#define HOST_FIXTURE_DEFAULT "host/fixtures/default"
+#endif
+#ifndef HOST_ROOT_DEFAULT
+#define HOST_ROOT_DEFAULT "host/build/root"
+#endif
+
+#define CONFIG_MAX_KEYS 128
+#define CONFIG_KEY_LEN 32
+#define CONFIG_VAL_LEN 96
+
+typedef struct {
+  char key[CONFIG_KEY_LEN];
+  char val[CONFIG_VAL_LEN];
+} config_entry;
+
+static bool s_loaded = false;
+static char s_fixture_dir[PATH_MAX];
+static char s_root_dir[PATH_MAX];
+static config_entry s_config[CONFIG_MAX_KEYS];
+static int s_config_count = 0;
+
+volatile u32 host_hw_regs[0x400 / 4];
+
+/*---------------------------------------------------------------------------*/
+static char *trim(char *s) {
+  char *end;
+  while (*s == ' ' || *s == '\t')
+    s++;
+  end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' ||
+                     end[-1] == '\r'))
+    *--end = '\0';
+  return s;
+}
+
+/*---------------------------------------------------------------------------*/
+static void load_config(void) {
+  char path[PATH_MAX];
+  char line[256];
+  FILE *fp;
+
+  s_config_count = 0;
+  host_fixture_path("config.txt", path, sizeof(path));
+  fp = fopen(path, "r");
+  if (!fp)
+    return;
+
+  while (fgets(line, sizeof(line), fp) && s_config_count < CONFIG_MAX_KEYS) {
+    char *hash = strchr(line, '#');
+    char *eq, *key, *val;
+
+    if (hash)
+      *hash = '\0';
+    eq = strchr(line, '=');
+    if (!eq)
+      continue;
+    *eq = '\0';
+    key = trim(line);
+    val = trim(eq + 1);
+    if (*key == '\0')
+      continue;
+
+    snprintf(s_config[s_config_count].key, CONFIG_KEY_LEN, "%s", key);
+    snprintf(s_config[s_config_count].val, CONFIG_VAL_LEN, "%s", val);
+    s_config_count++;
+  }
+  fclose(fp);
+}
+
+/*---------------------------------------------------------------------------*/
+void host_platform_init(const char *fixture_dir) {
+  const char *dir = fixture_dir;
+  const char *root = getenv("WIIMEDIC_HOST_ROOT");
+
+  if (!dir)
+    dir = getenv("WIIMEDIC_FIXTURES");
+  if (!dir)
+    dir = HOST_FIXTURE_DEFAULT;
+
+  /* Resolve now: fatInitDefault() changes the working directory */
+  if (!realpath(dir, s_fixture_dir)) {
+    fprintf(stderr, "wiimedic-host: fixture dir '%s': %s\n", dir,
+            strerror(errno));
+    exit(1);
+  }
+
+  if (!root)
+    root = HOST_ROOT_DEFAULT;
+  mkdir(root, 0755);
+  if (!realpath(root, s_root_dir))
+    snprintf(s_root_dir, sizeof(s_root_dir), "%s", root);
+
+  s_loaded = true;
+  load_config();
+  host_pad_rewind();
+}
+
+/*---------------------------------------------------------------------------*/
+static void ensure_loaded(void) {
+  if (!s_loaded)
+    host_platform_init(NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+void host_fixture_path(const char *rel, char *out, int outsize) {
+  ensure_loaded();
+  while (*rel == '/')
+    rel++;
+  if (snprintf(out, outsize, "%s/%s", s_fixture_dir, rel) >= outsize)
+    out[0] = '\0';
+}
+
+/*---------------------------------------------------------------------------*/
+const char *host_root_dir(void) {
+  ensure_loaded();
+  return s_root_dir;
+}
+
+/*---------------------------------------------------------------------------*/
+const char *host_config_str(const char *key, const char *def) {
+  int i;
+  ensure_loaded();
+  for (i = 0; i < s_config_count; i++) {
+    if (strcmp(s_config[i].key, key) == 0)
+      return s_config[i].val;
+  }
+  return def;
+}
+
+/*---------------------------------------------------------------------------*/
+long host_config_int(const char *key, long def) {
+  const char *val = host_config_str(key, NULL);
+  if (!val || *val == '\0')
+    return def;
+  return strtol(val, NULL, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+int host_copy_tree(const char *src, const char *dst) {
+  DIR *dir = opendir(src);
+  struct dirent *entry;
+
+  if (!dir)
+    return -1;
+  mkdir(dst, 0755);
+
+  while ((entry = readdir(dir)) != NULL) {
+    char from[PATH_MAX], to[PATH_MAX];
+    struct stat st;
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    snprintf(from, sizeof(from), "%s/%s", src, entry->d_name);
+    snprintf(to, sizeof(to), "%s/%s", dst, entry->d_name);
+    if (stat(from, &st) != 0)
+      continue;
+
+    if (S_ISDIR(st.st_mode)) {
+      host_copy_tree(from, to);
+    } else {
+      FILE *in = fopen(from, "rb");
+      FILE *out = in ? fopen(to, "wb") : NULL;
+      char buf[4096];
+      size_t n;
+      if (in && out) {
+        while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+          fwrite(buf, 1, n, out);
+      }
+      if (out)
+        fclose(out);
+      if (in)
+        fclose(in);
+    }
+  }
+  closedir(dir);
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+int host_remove_tree(const char *path) {
+  DIR *dir = opendir(path);
+  struct dirent *entry;
+
+  if (!dir)
+    return remove(path);
+
+  while ((entry = readdir(dir)) != NULL) {
+    char child[PATH_MAX];
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+    host_remove_tree(child);
+  }
+  closedir(dir);
+  return rmdir(path);
+}
@@ -0,0 +1,142 @@
+/*
+ * WiiMedic host backend - host_isfs.c
+ * ISFS served from the fixture's nand/ directory. Dotfiles (e.g. .keep
+ * placeholders) are invisible, the same as they would be on a real NAND.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gccore.h>
+
+#include "host_platform.h"
+
+#define ISFS_ENOENT -106
+#define NAND_CLUSTER_SIZE 16384
+#define NAND_NAME_LEN 13
+
+/*---------------------------------------------------------------------------*/
+static void nand_path(const char *filepath, char *out, int outsize) {
+  char rel[PATH_MAX];
+  snprintf(rel, sizeof(rel), "nand%s", filepath);
+  host_fixture_path(rel, out, outsize);
+}
+
+/*---------------------------------------------------------------------------*/
+s32 ISFS_Initialize(void) {
+  host_ipc_delay();
+  return (s32)host_config_int("isfs_init", 0);
+}
+
+s32 ISFS_Deinitialize(void) {
+  host_ipc_delay();
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+s32 ISFS_Open(const char *filepath, u8 mode) {
+  char path[PATH_MAX];
+  int fd;
+
+  host_ipc_delay();
+  nand_path(filepath, path, sizeof(path));
+  fd = open(path, O_RDONLY);
+  return fd >= 0 ? fd : ISFS_ENOENT;
+}
+
+s32 ISFS_Close(s32 fd) {
+  host_ipc_delay();
+  return close(fd) == 0 ? 0 : ISFS_EINVAL;
+}
+
+s32 ISFS_Read(s32 fd, void *buffer, u32 length) {
+  host_ipc_delay();
+  ssize_t n = read(fd, buffer, length);
+  return n >= 0 ? (s32)n : ISFS_EINVAL;
+}
+
+/*---------------------------------------------------------------------------*/
+s32 ISFS_ReadDir(const char *filepath, char *name_list, u32 *num) {
+  char path[PATH_MAX];
+  DIR *dir;
+  struct dirent *entry;
+  u32 count = 0;
+  u32 max = name_list ? *num : 0;
+  char *out = name_list;
+
+  host_ipc_delay();
+  nand_path(filepath, path, sizeof(path));
+  dir = opendir(path);
+  if (!dir)
+    return ISFS_ENOENT;
+
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.')
+      continue;
+    if (out && count < max) {
+      int len = (int)strnlen(entry->d_name, NAND_NAME_LEN - 1);
+      memcpy(out, entry->d_name, len);
+      out[len] = '\0';
+      out += len + 1;
+    }
+    count++;
+  }
+  closedir(dir);
+
+  *num = (name_list && count > max) ? max : count;
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+static void walk_usage(const char *path, u32 *clusters, u32 *inodes) {
+  DIR *dir = opendir(path);
+  struct dirent *entry;
+
+  if (!dir)
+    return;
+  while ((entry = readdir(dir)) != NULL) {
+    char child[PATH_MAX];
+    struct stat st;
+
+    if (entry->d_name[0] == '.')
+      continue;
+    snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+    if (stat(child, &st) != 0)
+      continue;
+
+    (*inodes)++;
+    if (S_ISDIR(st.st_mode))
+      walk_usage(child, clusters, inodes);
+    else
+      *clusters += (u32)((st.st_size + NAND_CLUSTER_SIZE - 1) /
+                         NAND_CLUSTER_SIZE);
+  }
+  closedir(dir);
+}
+
+s32 ISFS_GetUsage(const char *filepath, u32 *usage1, u32 *usage2) {
+  char path[PATH_MAX];
+  u32 clusters = 0, inodes = 0;
+  struct stat st;
+
+  host_ipc_delay();
+  nand_path(filepath, path, sizeof(path));
+  if (stat(path, &st) != 0)
+    return ISFS_ENOENT;
+
+  /* A fixture tree is tiny; config.txt can pin realistic totals for the
+     root, while subdirectories report what their fixture files use */
+  walk_usage(path, &clusters, &inodes);
+  if (strcmp(filepath, "/") == 0) {
+    clusters = (u32)host_config_int("nand_clusters", clusters);
+    inodes = (u32)host_config_int("nand_inodes", inodes);
+  }
+  *usage1 = clusters;
+  *usage2 = inodes;
+  return 0;
+}
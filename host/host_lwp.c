@@ -0,0 +1,100 @@
+/*
+ * WiiMedic host backend - host_lwp.c
+ * LWP_* threads mapped onto pthreads. Handles index a fixed table; handle 0
+ * is the main thread so LWP_GetSelf() works before any thread is created.
+ */
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include <gccore.h>
+
+#include "host_platform.h"
+
+#define HOST_MAX_THREADS 32
+
+typedef struct {
+  pthread_t thread;
+  void *(*entry)(void *);
+  void *arg;
+  bool used;
+} host_thread;
+
+static host_thread s_threads[HOST_MAX_THREADS];
+static pthread_mutex_t s_table_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread lwp_t t_self = 0;
+
+/* newlib has a single heap shared by every thread. Keep glibc to its main
+   arena too, so heap_map's walk still covers worker allocations. */
+__attribute__((constructor)) static void single_arena(void) {
+  mallopt(M_ARENA_MAX, 1);
+}
+
+static void *trampoline(void *p) {
+  host_thread *t = (host_thread *)p;
+  t_self = (lwp_t)(t - s_threads);
+  return t->entry(t->arg);
+}
+
+s32 LWP_CreateThread(lwp_t *thethread, void *(*entry)(void *), void *arg,
+                     void *stackbase, u32 stack_size, u8 prio) {
+  host_thread *t = NULL;
+  int i;
+
+  (void)stackbase;
+  (void)stack_size;
+  (void)prio;
+
+  pthread_mutex_lock(&s_table_lock);
+  for (i = 1; i < HOST_MAX_THREADS; i++) {
+    if (!s_threads[i].used) {
+      t = &s_threads[i];
+      t->used = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&s_table_lock);
+  if (!t)
+    return -1;
+
+  t->entry = entry;
+  t->arg = arg;
+  if (pthread_create(&t->thread, NULL, trampoline, t) != 0) {
+    t->used = false;
+    return -1;
+  }
+  if (thethread)
+    *thethread = (lwp_t)(t - s_threads);
+  return 0;
+}
+
+s32 LWP_JoinThread(lwp_t thethread, void **value_ptr) {
+  host_thread *t;
+
+  if (thethread == 0 || thethread >= HOST_MAX_THREADS)
+    return -1;
+  t = &s_threads[thethread];
+  if (!t->used || pthread_join(t->thread, value_ptr) != 0)
+    return -1;
+
+  pthread_mutex_lock(&s_table_lock);
+  t->used = false;
+  pthread_mutex_unlock(&s_table_lock);
+  return 0;
+}
+
+lwp_t LWP_GetSelf(void) { return t_self; }
+
+int host_lwp_active(void) {
+  int i, n = 0;
+
+  pthread_mutex_lock(&s_table_lock);
+  for (i = 1; i < HOST_MAX_THREADS; i++)
+    n += s_threads[i].used;
+  pthread_mutex_unlock(&s_table_lock);
+  return n;
+}
+
+void LWP_YieldThread(void) { sched_yield(); }
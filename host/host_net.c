@@ -0,0 +1,210 @@
+/*
+ * WiiMedic host backend - host_net.c
+ * net_* and WD_* simulated from config.txt and aps.txt.
+ *
+ * aps.txt: one access point per line
+ *   <bssid> <channel> <rssi> <open|wep|wpa2> <ssid...>
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <gccore.h>
+#include <network.h>
+#include <ogc/wd.h>
+
+#include "host_platform.h"
+
+#define HOST_MAX_APS 64
+#define WPA2_IE_LEN 20
+
+static bool s_net_up = false;
+static bool s_wd_up = false;
+static s32 s_next_sock = 3;
+
+/*---------------------------------------------------------------------------*/
+static u32 parse_ip(const char *str) {
+  unsigned a = 0, b = 0, c = 0, d = 0;
+  if (sscanf(str, "%u.%u.%u.%u", &a, &b, &c, &d) != 4)
+    return 0;
+  return (a << 24) | (b << 16) | (c << 8) | d;
+}
+
+/*---------------------------------------------------------------------------*/
+s32 net_init(void) {
+  s32 ret = (s32)host_config_int("net_init", 0);
+  long delay_ms = host_config_int("net_init_ms", 0);
+
+  /* DHCP on the console takes seconds; let fixtures model that */
+  if (delay_ms > 0)
+    usleep((useconds_t)delay_ms * 1000);
+  s_net_up = (ret >= 0);
+  return ret;
+}
+
+void net_deinit(void) { s_net_up = false; }
+
+u32 net_gethostip(void) {
+  if (!s_net_up)
+    return 0;
+  return parse_ip(host_config_str("ip", "192.168.1.42"));
+}
+
+s32 net_socket(u32 domain, u32 type, u32 protocol) {
+  return s_net_up ? s_next_sock++ : -1;
+}
+
+s32 net_connect(s32 s, struct sockaddr *addr, socklen_t addrlen) {
+  struct sockaddr_in *in = (struct sockaddr_in *)addr;
+  char key[32];
+
+  if (!s_net_up)
+    return -1;
+  /* connect_<port> overrides the global connect result */
+  snprintf(key, sizeof(key), "connect_%u", (unsigned)ntohs(in->sin_port));
+  return (s32)host_config_int(key, host_config_int("connect", 0));
+}
+
+s32 net_close(s32 s) { return 0; }
+
+/*---------------------------------------------------------------------------*/
+s32 WD_Init(u8 mode) {
+  s32 ret = (s32)host_config_int("wd_init", 0);
+  s_wd_up = (ret == 0);
+  return ret;
+}
+
+void WD_Deinit(void) { s_wd_up = false; }
+
+s32 WD_GetInfo(WDInfo *info) {
+  unsigned m[6] = {0};
+  const char *cc;
+
+  if (!s_wd_up)
+    return -1;
+
+  memset(info, 0, sizeof(*info));
+  sscanf(host_config_str("wd_mac", "00:17:AB:12:34:56"),
+         "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]);
+  for (int i = 0; i < 6; i++)
+    info->MAC[i] = (u8)m[i];
+
+  info->EnableChannelsMask = (u16)host_config_int("wd_channels", 0x07FF);
+  cc = host_config_str("wd_country", "US");
+  info->CountryCode[0] = (u8)cc[0];
+  info->CountryCode[1] = cc[0] ? (u8)cc[1] : 0;
+  info->channel = (u8)host_config_int("wd_channel", 6);
+  info->initialized = 1;
+  snprintf((char *)info->version, sizeof(info->version), "%s",
+           host_config_str("wd_firmware", "1.0.0.0"));
+  return 0;
+}
+
+void WD_SetDefaultScanParameters(ScanParameters *params) {
+  memset(params, 0, sizeof(*params));
+  params->ChannelBitmap = 0x07FF;
+  params->MaxChannelTime = 100;
+  memset(params->BSSID, 0xFF, sizeof(params->BSSID));
+  params->ScanType = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+s32 WD_ScanOnce(ScanParameters *params, u8 *buf, u16 len) {
+  char path[PATH_MAX];
+  char line[160];
+  FILE *fp;
+  u8 *ptr = buf + 2;
+  u8 *end = buf + len;
+  u16 count = 0;
+
+  if (!s_wd_up)
+    return -1;
+  if (len < 2)
+    return -1;
+  memset(buf, 0, len);
+
+  host_fixture_path("aps.txt", path, sizeof(path));
+  fp = fopen(path, "r");
+  if (fp) {
+    while (fgets(line, sizeof(line), fp) && count < HOST_MAX_APS) {
+      unsigned m[6];
+      unsigned channel, rssi;
+      char sec[8];
+      int ssid_off = 0;
+      BSSDescriptor *bss;
+      u16 ies_len, entry_len;
+      char *ssid;
+      size_t ssid_len;
+
+      if (line[0] == '#' || line[0] == '\n')
+        continue;
+      if (sscanf(line, "%x:%x:%x:%x:%x:%x %u %u %7s %n", &m[0], &m[1], &m[2],
+                 &m[3], &m[4], &m[5], &channel, &rssi, sec, &ssid_off) < 9)
+        continue;
+      if (!(params->ChannelBitmap & (1 << (channel - 1))))
+        continue;
+
+      ssid = line + ssid_off;
+      ssid[strcspn(ssid, "\r\n")] = '\0';
+      ssid_len = strlen(ssid);
+      if (ssid_len > 32)
+        ssid_len = 32;
+
+      ies_len = (strcmp(sec, "wpa2") == 0) ? 2 + WPA2_IE_LEN : 0;
+      entry_len = (u16)(sizeof(BSSDescriptor) + ies_len);
+      if (ptr + entry_len > end)
+        break;
+
+      bss = (BSSDescriptor *)ptr;
+      bss->length = entry_len / 2;
+      bss->RSSI = (u16)rssi;
+      for (int i = 0; i < 6; i++)
+        bss->BSSID[i] = (u8)m[i];
+      bss->SSIDLength = (u16)ssid_len;
+      memcpy(bss->SSID, ssid, ssid_len);
+      bss->Capabilities = (strcmp(sec, "open") == 0) ? 0 : CAPAB_SECURED_FLAG;
+      bss->beaconPeriod = 100;
+      bss->channel = (u16)channel;
+      bss->IEs_length = ies_len;
+      if (ies_len) {
+        u8 *ie = ptr + sizeof(BSSDescriptor);
+        ie[0] = IEID_SECURITY;
+        ie[1] = WPA2_IE_LEN;
+      }
+
+      ptr += entry_len;
+      count++;
+    }
+    fclose(fp);
+  }
+
+  buf[0] = (u8)(count >> 8);
+  buf[1] = (u8)count;
+  return (s32)(ptr - buf);
+}
+
+/*---------------------------------------------------------------------------*/
+u8 WD_GetRadioLevel(BSSDescriptor *bss) {
+  if (bss->RSSI >= 0xC4)
+    return 3;
+  if (bss->RSSI >= 0xB5)
+    return 2;
+  if (bss->RSSI >= 0xAB)
+    return 1;
+  return 0;
+}
+
+u16 WD_GetIELength(BSSDescriptor *bss, u8 id) {
+  u8 *ie = (u8 *)bss + sizeof(BSSDescriptor);
+  u8 *end = ie + bss->IEs_length;
+
+  while (ie + 2 <= end) {
+    if (ie[0] == id)
+      return ie[1];
+    ie += 2 + ie[1];
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+/*
+ * WiiMedic host backend - host_pad.c
+ * PAD_* / WPAD_* replayed from the fixture's pads.txt.
+ *
+ * Each line of pads.txt is one scan; "*N" at the start repeats it N times.
+ * Tokens are key<chan>=value:
+ *   wd/wh   Wii Remote buttons down / held       gd/gh   GC buttons down / held
+ *   gsx/gsy GC main stick   gcx/gcy C-stick      gtl/gtr GC triggers
+ *   wp      WPAD_Probe result   we extension     wb battery   wir IR valid
+ *   wnx/wny Nunchuk stick offset from centre
+ * "down" values last one scan; everything else holds until changed. When the
+ * recording runs out every scan reports B + HOME/START so any loop exits.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gccore.h>
+#include <wiiuse/wpad.h>
+
+#include "host_platform.h"
+
+#define PAD_MAX_FRAMES 4096
+#define PAD_LINE_LEN 256
+
+typedef struct {
+  u32 w_down, w_held;
+  s32 w_probe;
+  u32 w_ext;
+  u8 w_batt;
+  bool w_ir;
+  s8 w_nun_x, w_nun_y;
+  u16 g_down, g_held;
+  s8 g_sx, g_sy, g_cx, g_cy;
+  u8 g_tl, g_tr;
+} chan_state;
+
+typedef struct {
+  char line[PAD_LINE_LEN];
+  int repeat;
+} pad_frame;
+
+static pad_frame *s_frames = NULL;
+static int s_frame_count = 0;
+static bool s_frames_loaded = false;
+
+/* Separate cursors: modules scan PAD and WPAD independently */
+static int s_wpad_frame, s_wpad_rep;
+static int s_pad_frame, s_pad_rep;
+static chan_state s_wpad[4];
+static chan_state s_pad[4];
+static WPADData s_wpad_data[4];
+
+/*---------------------------------------------------------------------------*/
+static void load_frames(void) {
+  char path[PATH_MAX];
+  char line[PAD_LINE_LEN];
+  FILE *fp;
+
+  if (s_frames_loaded)
+    return;
+  s_frames_loaded = true;
+
+  s_frames = calloc(PAD_MAX_FRAMES, sizeof(pad_frame));
+  if (!s_frames)
+    return;
+
+  host_fixture_path("pads.txt", path, sizeof(path));
+  fp = fopen(path, "r");
+  if (!fp)
+    return;
+
+  while (fgets(line, sizeof(line), fp) && s_frame_count < PAD_MAX_FRAMES) {
+    char *p = line;
+    char *hash = strchr(line, '#');
+    int repeat = 1;
+
+    if (hash)
+      *hash = '\0';
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (*p == '\0' || *p == '\n' || *p == '\r')
+      continue;
+    if (*p == '*') {
+      repeat = (int)strtol(p + 1, &p, 10);
+      if (repeat < 1)
+        repeat = 1;
+    }
+    snprintf(s_frames[s_frame_count].line, PAD_LINE_LEN, "%s", p);
+    s_frames[s_frame_count].repeat = repeat;
+    s_frame_count++;
+  }
+  fclose(fp);
+}
+
+/*---------------------------------------------------------------------------*/
+static void reset_state(chan_state *st) {
+  int c;
+  memset(st, 0, sizeof(chan_state) * 4);
+  for (c = 0; c < 4; c++)
+    st[c].w_probe = WPAD_ERR_NO_CONTROLLER;
+}
+
+void host_pad_rewind(void) {
+  s_wpad_frame = s_wpad_rep = 0;
+  s_pad_frame = s_pad_rep = 0;
+  reset_state(s_wpad);
+  reset_state(s_pad);
+}
+
+/*---------------------------------------------------------------------------*/
+static void apply_frame(chan_state *st, const char *line) {
+  char buf[PAD_LINE_LEN];
+  char *tok, *save = NULL;
+  int c;
+
+  for (c = 0; c < 4; c++) {
+    st[c].w_down = 0;
+    st[c].g_down = 0;
+  }
+
+  snprintf(buf, sizeof(buf), "%s", line);
+  for (tok = strtok_r(buf, " \t\r\n", &save); tok;
+       tok = strtok_r(NULL, " \t\r\n", &save)) {
+    char *eq = strchr(tok, '=');
+    long val;
+    int chan;
+    size_t klen;
+
+    if (!eq || eq == tok)
+      continue;
+    chan = eq[-1] - '0';
+    if (chan < 0 || chan > 3)
+      continue;
+    klen = (size_t)(eq - tok - 1);
+    val = strtol(eq + 1, NULL, 0);
+
+#define KEY(k) (klen == sizeof(k) - 1 && strncmp(tok, k, klen) == 0)
+    if (KEY("wd"))
+      st[chan].w_down = (u32)val;
+    else if (KEY("wh"))
+      st[chan].w_held = (u32)val;
+    else if (KEY("wp"))
+      st[chan].w_probe = (s32)val;
+    else if (KEY("we"))
+      st[chan].w_ext = (u32)val;
+    else if (KEY("wb"))
+      st[chan].w_batt = (u8)val;
+    else if (KEY("wir"))
+      st[chan].w_ir = val != 0;
+    else if (KEY("wnx"))
+      st[chan].w_nun_x = (s8)val;
+    else if (KEY("wny"))
+      st[chan].w_nun_y = (s8)val;
+    else if (KEY("gd"))
+      st[chan].g_down = (u16)val;
+    else if (KEY("gh"))
+      st[chan].g_held = (u16)val;
+    else if (KEY("gsx"))
+      st[chan].g_sx = (s8)val;
+    else if (KEY("gsy"))
+      st[chan].g_sy = (s8)val;
+    else if (KEY("gcx"))
+      st[chan].g_cx = (s8)val;
+    else if (KEY("gcy"))
+      st[chan].g_cy = (s8)val;
+    else if (KEY("gtl"))
+      st[chan].g_tl = (u8)val;
+    else if (KEY("gtr"))
+      st[chan].g_tr = (u8)val;
+#undef KEY
+  }
+}
+
+/* Advance one cursor; returns false once the recording is exhausted */
+static bool step(chan_state *st, int *frame, int *rep) {
+  load_frames();
+  if (*frame >= s_frame_count) {
+    int c;
+    for (c = 0; c < 4; c++) {
+      st[c].w_down = WPAD_BUTTON_B | WPAD_BUTTON_HOME;
+      st[c].g_down = PAD_BUTTON_B | PAD_BUTTON_START;
+    }
+    return false;
+  }
+  apply_frame(st, s_frames[*frame].line);
+  if (++(*rep) >= s_frames[*frame].repeat) {
+    (*frame)++;
+    *rep = 0;
+  }
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+u32 PAD_Init(void) {
+  load_frames();
+  return 1;
+}
+
+u32 PAD_ScanPads(void) {
+  step(s_pad, &s_pad_frame, &s_pad_rep);
+  return 1;
+}
+
+static bool pad_ok(int pad) { return pad >= 0 && pad < 4; }
+
+u16 PAD_ButtonsDown(int pad) { return pad_ok(pad) ? s_pad[pad].g_down : 0; }
+u16 PAD_ButtonsHeld(int pad) { return pad_ok(pad) ? s_pad[pad].g_held : 0; }
+s8 PAD_StickX(int pad) { return pad_ok(pad) ? s_pad[pad].g_sx : 0; }
+s8 PAD_StickY(int pad) { return pad_ok(pad) ? s_pad[pad].g_sy : 0; }
+s8 PAD_SubStickX(int pad) { return pad_ok(pad) ? s_pad[pad].g_cx : 0; }
+s8 PAD_SubStickY(int pad) { return pad_ok(pad) ? s_pad[pad].g_cy : 0; }
+u8 PAD_TriggerL(int pad) { return pad_ok(pad) ? s_pad[pad].g_tl : 0; }
+u8 PAD_TriggerR(int pad) { return pad_ok(pad) ? s_pad[pad].g_tr : 0; }
+
+/*---------------------------------------------------------------------------*/
+s32 WPAD_Init(void) {
+  load_frames();
+  return WPAD_ERR_NONE;
+}
+
+s32 WPAD_Shutdown(void) { return WPAD_ERR_NONE; }
+
+s32 WPAD_SetDataFormat(s32 chan, s32 fmt) { return WPAD_ERR_NONE; }
+
+s32 WPAD_ScanPads(void) {
+  step(s_wpad, &s_wpad_frame, &s_wpad_rep);
+  return WPAD_ERR_NONE;
+}
+
+s32 WPAD_Probe(s32 chan, u32 *type) {
+  if (chan < 0 || chan > 3)
+    return WPAD_ERR_NO_CONTROLLER;
+  if (type)
+    *type = s_wpad[chan].w_ext;
+  return s_wpad[chan].w_probe;
+}
+
+u32 WPAD_ButtonsDown(int chan) {
+  return (chan >= 0 && chan < 4) ? s_wpad[chan].w_down : 0;
+}
+
+u32 WPAD_ButtonsHeld(int chan) {
+  return (chan >= 0 && chan < 4) ? s_wpad[chan].w_held : 0;
+}
+
+WPADData *WPAD_Data(int chan) {
+  WPADData *d;
+  chan_state *st;
+
+  if (chan < 0 || chan > 3)
+    return NULL;
+  d = &s_wpad_data[chan];
+  st = &s_wpad[chan];
+
+  memset(d, 0, sizeof(*d));
+  d->err = (s16)st->w_probe;
+  d->battery_level = st->w_batt;
+  d->btns_h = st->w_held;
+  d->btns_d = st->w_down;
+  d->ir.valid = st->w_ir;
+  d->exp.type = (int)st->w_ext;
+  d->exp.nunchuk.js.center.x = 128;
+  d->exp.nunchuk.js.center.y = 128;
+  d->exp.nunchuk.js.pos.x = (u8)(128 + st->w_nun_x);
+  d->exp.nunchuk.js.pos.y = (u8)(128 + st->w_nun_y);
+  return d;
+}
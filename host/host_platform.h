@@ -0,0 +1,45 @@
+/*
+ * WiiMedic host backend - host_platform.h
+ * Internal helpers shared by the Linux implementation of the libogc subset.
+ * The backend initializes itself lazily from $WIIMEDIC_FIXTURES (default:
+ * host/fixtures/default), so module code never has to call into it.
+ */
+
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+#include <gccore.h>
+
+/* Load (or reload) a fixture directory. NULL = environment/default. */
+void host_platform_init(const char *fixture_dir);
+
+/* Absolute path of a file inside the active fixture directory */
+void host_fixture_path(const char *rel, char *out, int outsize);
+
+/* config.txt lookups (key = value, '#' comments) */
+const char *host_config_str(const char *key, const char *def);
+long host_config_int(const char *key, long def);
+
+/* Directory the "sd:" / "usb:" mounts live under (cwd after fatInitDefault) */
+const char *host_root_dir(void);
+
+/* Restart pad playback from the first recorded frame */
+void host_pad_rewind(void);
+
+/* Sleep for the fixture's simulated IOS round trip (config ipc_us) */
+void host_ipc_delay(void);
+
+/* Number of VIDEO_WaitVSync calls since start-up */
+u64 host_vsync_count(void);
+
+/* VIDEO_WaitVSync sleeps a frame while workers run (default on) */
+void host_vsync_pacing(bool on);
+
+/* LWP threads created and not yet joined */
+int host_lwp_active(void);
+
+/* Recursive copy / delete used to stage the sd: and usb: trees */
+int host_copy_tree(const char *src, const char *dst);
+int host_remove_tree(const char *path);
+
+#endif // HOST_PLATFORM_H
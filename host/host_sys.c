@@ -0,0 +1,194 @@
+/*
+ * WiiMedic host backend - host_sys.c
+ * SYS/VIDEO/CONF/IOS, the timebase and libfat mounts
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <fat.h>
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <ogc/usbstorage.h>
+#include <sdcard/wiisd_io.h>
+
+#include "host_platform.h"
+
+static GXRModeObj s_rmode = {VI_INTERLACE, 640, 480, 480, 40, 0, 640, 480};
+static u64 s_vsync_count = 0;
+static bool s_vsync_pacing = true;
+
+/* libogc's console font; here a stand-in filled in by console_init */
+u8 console_font_8x16[256 * 16];
+
+/*---------------------------------------------------------------------------*/
+u64 gettime(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return nanosecs_to_ticks((u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec);
+}
+
+/*---------------------------------------------------------------------------*/
+u32 SYS_GetHollywoodRevision(void) {
+  return (u32)host_config_int("hollywood", 0x11);
+}
+
+u32 SYS_GetArena1Size(void) {
+  return (u32)host_config_int("mem1_free", 22 * 1024 * 1024);
+}
+
+u32 SYS_GetArena2Size(void) {
+  return (u32)host_config_int("mem2_free", 50 * 1024 * 1024);
+}
+
+void *SYS_AllocateFramebuffer(GXRModeObj *rmode) {
+  return calloc(1, (size_t)rmode->fbWidth * rmode->xfbHeight *
+                       VI_DISPLAY_PIX_SZ);
+}
+
+void SYS_ResetSystem(s32 reset, u32 reset_code, s32 force_menu) {
+  fflush(stdout);
+  exit(0);
+}
+
+s32 WII_LaunchTitle(u64 titleID) {
+  fflush(stdout);
+  exit(0);
+}
+
+/*---------------------------------------------------------------------------*/
+s32 IOS_GetVersion(void) { return (s32)host_config_int("ios", 58); }
+
+s32 IOS_GetRevision(void) { return (s32)host_config_int("ios_rev", 6176); }
+
+/*---------------------------------------------------------------------------*/
+s32 CONF_GetRegion(void) {
+  return (s32)host_config_int("region", CONF_REGION_US);
+}
+
+s32 CONF_GetVideo(void) {
+  return (s32)host_config_int("video", CONF_VIDEO_NTSC);
+}
+
+s32 CONF_GetLanguage(void) {
+  return (s32)host_config_int("language", CONF_LANG_ENGLISH);
+}
+
+s32 CONF_GetAspectRatio(void) {
+  return (s32)host_config_int("aspect", CONF_ASPECT_16_9);
+}
+
+s32 CONF_GetProgressiveScan(void) {
+  return (s32)host_config_int("progressive", 0);
+}
+
+/*---------------------------------------------------------------------------*/
+void VIDEO_Init(void) {}
+
+GXRModeObj *VIDEO_GetPreferredMode(GXRModeObj *mode) { return &s_rmode; }
+
+void VIDEO_Configure(GXRModeObj *rmode) {}
+
+void VIDEO_SetNextFramebuffer(void *fb) {}
+
+void VIDEO_SetBlack(bool black) {}
+
+void VIDEO_Flush(void) {}
+
+/* Frames are free on the host, except while the UI thread waits on a worker:
+   then pace at 60 Hz so pad playback lines up with real elapsed time */
+void VIDEO_WaitVSync(void) {
+  if (LWP_GetSelf() != 0)
+    return;
+  s_vsync_count++;
+  if (host_lwp_active() == 0)
+    return;
+  /* On the console the caller blocks here and the workers get the CPU */
+  if (s_vsync_pacing)
+    usleep(16667);
+  else
+    LWP_YieldThread();
+}
+
+u32 VIDEO_GetRetraceCount(void) { return (u32)s_vsync_count; }
+
+void host_vsync_pacing(bool on) { s_vsync_pacing = on; }
+
+u64 host_vsync_count(void) { return s_vsync_count; }
+
+void host_ipc_delay(void) {
+  long us = host_config_int("ipc_us", 0);
+  if (us > 0)
+    usleep((useconds_t)us);
+}
+
+/* No font ships with the host build: each printable character gets a box
+   with its code in binary down the middle, so glyphs differ and cost what
+   real ones do to draw */
+void console_init(void *framebuffer, int xstart, int ystart, int xres,
+                  int yres, int stride) {
+  int ch, row;
+
+  for (ch = 0x21; ch < 0x7F; ch++) {
+    u8 *glyph = &console_font_8x16[ch * 16];
+
+    glyph[3] = glyph[12] = 0x7E;
+    for (row = 4; row < 12; row++)
+      glyph[row] = 0x42 | ((ch >> (row - 4)) & 1 ? 0x18 : 0);
+  }
+}
+
+void DCStoreRange(void *startaddress, u32 len) {}
+
+void DCFlushRange(void *startaddress, u32 len) {}
+
+void DCInvalidateRange(void *startaddress, u32 len) {}
+
+/*---------------------------------------------------------------------------*/
+/* Stage one device directory: "<root>/sd:" seeded from "<fixture>/sd" */
+static void mount_device(const char *name, const char *key) {
+  char mount[PATH_MAX], seed[PATH_MAX];
+
+  snprintf(mount, sizeof(mount), "%s/%s:", host_root_dir(), name);
+  if (!host_config_int(key, 1)) {
+    host_remove_tree(mount);
+    return;
+  }
+
+  mkdir(mount, 0755);
+  host_fixture_path(name, seed, sizeof(seed));
+  host_copy_tree(seed, mount);
+}
+
+/* Delete or recreate "<root>/sd:" while running to simulate hot-plug */
+static bool device_present(const char *name) {
+  char mount[PATH_MAX];
+  struct stat st;
+
+  snprintf(mount, sizeof(mount), "%s/%s:", host_root_dir(), name);
+  return stat(mount, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool sd_inserted(void) { return device_present("sd"); }
+static bool usb_inserted(void) { return device_present("usb"); }
+
+const DISC_INTERFACE __io_wiisd = {0, 0, NULL, sd_inserted};
+const DISC_INTERFACE __io_usbstorage = {0, 0, NULL, usb_inserted};
+
+bool fatInitDefault(void) {
+  long delay_ms = host_config_int("fat_init_ms", 0);
+
+  /* A slow or absent USB drive holds libfat up for seconds */
+  if (delay_ms > 0)
+    usleep((useconds_t)delay_ms * 1000);
+  mount_device("sd", "sd");
+  mount_device("usb", "usb");
+
+  /* "sd:/foo" is a plain relative path once we sit in the root */
+  return chdir(host_root_dir()) == 0;
+}
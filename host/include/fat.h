@@ -0,0 +1,14 @@
+/*
+ * WiiMedic host backend - fat.h
+ * fatInitDefault() maps "sd:" and "usb:" onto directories under the host
+ * root so the modules' stdio paths work unchanged.
+ */
+
+#ifndef _HOST_FAT_H_
+#define _HOST_FAT_H_
+
+#include "gctypes.h"
+
+bool fatInitDefault(void);
+
+#endif /* _HOST_FAT_H_ */
@@ -0,0 +1,30 @@
+/*
+ * WiiMedic host backend - gccore.h
+ * Stand-in for libogc's umbrella header. Only the subset of the API used by
+ * WiiMedic is declared; everything is implemented in host/host_*.c on top of
+ * fixture files (see host/host.mk).
+ */
+
+#ifndef _HOST_GCCORE_H_
+#define _HOST_GCCORE_H_
+
+#include "gctypes.h"
+
+#include "ogc/cache.h"
+#include "ogc/conf.h"
+#include "ogc/console.h"
+#include "ogc/es.h"
+#include "ogc/ios.h"
+#include "ogc/isfs.h"
+#include "ogc/lwp.h"
+#include "ogc/pad.h"
+#include "ogc/system.h"
+#include "ogc/video.h"
+
+/* Hollywood register window. system_info.c pokes AHBPROT/OTP through this;
+   on the host it points at a zero-filled array so the OTP probe reports
+   "no AHBPROT" instead of faulting. */
+extern volatile u32 host_hw_regs[];
+#define HW_REG_BASE ((uintptr_t)host_hw_regs)
+
+#endif /* _HOST_GCCORE_H_ */
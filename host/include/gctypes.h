@@ -0,0 +1,42 @@
+/*
+ * WiiMedic host backend - gctypes.h
+ * libogc-compatible scalar types and attributes for the Linux host build
+ */
+
+#ifndef _HOST_GCTYPES_H_
+#define _HOST_GCTYPES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+
+typedef signed char s8;
+typedef signed short s16;
+typedef signed int s32;
+typedef signed long long s64;
+
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+typedef volatile u64 vu64;
+
+typedef float f32;
+typedef double f64;
+
+typedef unsigned int BOOL;
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define ATTRIBUTE_ALIGN(v) __attribute__((aligned(v)))
+#define ATTRIBUTE_PACKED __attribute__((packed))
+
+#endif /* _HOST_GCTYPES_H_ */
@@ -0,0 +1,23 @@
+/*
+ * WiiMedic host backend - network.h
+ * net_* calls are simulated from config.txt; no real sockets are opened so
+ * runs stay deterministic.
+ */
+
+#ifndef _HOST_NETWORK_H_
+#define _HOST_NETWORK_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "gctypes.h"
+
+s32 net_init(void);
+void net_deinit(void);
+u32 net_gethostip(void);
+s32 net_socket(u32 domain, u32 type, u32 protocol);
+s32 net_connect(s32 s, struct sockaddr *addr, socklen_t addrlen);
+s32 net_close(s32 s);
+
+#endif /* _HOST_NETWORK_H_ */
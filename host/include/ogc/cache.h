@@ -0,0 +1,16 @@
+/*
+ * WiiMedic host backend - ogc/cache.h
+ * The host has no separate uncached view of memory; cache maintenance is a
+ * no-op.
+ */
+
+#ifndef _HOST_OGC_CACHE_H_
+#define _HOST_OGC_CACHE_H_
+
+#include "gctypes.h"
+
+void DCStoreRange(void *startaddress, u32 len);
+void DCFlushRange(void *startaddress, u32 len);
+void DCInvalidateRange(void *startaddress, u32 len);
+
+#endif /* _HOST_OGC_CACHE_H_ */
@@ -0,0 +1,49 @@
+/*
+ * WiiMedic host backend - ogc/conf.h
+ * SYSCONF accessors; values come from the fixture's config.txt
+ */
+
+#ifndef _HOST_OGC_CONF_H_
+#define _HOST_OGC_CONF_H_
+
+#include "gctypes.h"
+
+enum {
+  CONF_REGION_JP = 0,
+  CONF_REGION_US = 1,
+  CONF_REGION_EU = 2,
+  CONF_REGION_KR = 4,
+  CONF_REGION_CN = 5,
+};
+
+enum {
+  CONF_VIDEO_NTSC = 0,
+  CONF_VIDEO_PAL = 1,
+  CONF_VIDEO_MPAL = 2,
+};
+
+enum {
+  CONF_LANG_JAPANESE = 0,
+  CONF_LANG_ENGLISH,
+  CONF_LANG_GERMAN,
+  CONF_LANG_FRENCH,
+  CONF_LANG_SPANISH,
+  CONF_LANG_ITALIAN,
+  CONF_LANG_DUTCH,
+  CONF_LANG_SIMP_CHINESE,
+  CONF_LANG_TRAD_CHINESE,
+  CONF_LANG_KOREAN,
+};
+
+enum {
+  CONF_ASPECT_4_3 = 0,
+  CONF_ASPECT_16_9 = 1,
+};
+
+s32 CONF_GetRegion(void);
+s32 CONF_GetVideo(void);
+s32 CONF_GetLanguage(void);
+s32 CONF_GetAspectRatio(void);
+s32 CONF_GetProgressiveScan(void);
+
+#endif /* _HOST_OGC_CONF_H_ */
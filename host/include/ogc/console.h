@@ -0,0 +1,13 @@
+/*
+ * WiiMedic host backend - ogc/console.h
+ */
+
+#ifndef _HOST_OGC_CONSOLE_H_
+#define _HOST_OGC_CONSOLE_H_
+
+#include "gctypes.h"
+
+void console_init(void *framebuffer, int xstart, int ystart, int xres,
+                  int yres, int stride);
+
+#endif /* _HOST_OGC_CONSOLE_H_ */
@@ -0,0 +1,33 @@
+/*
+ * WiiMedic host backend - ogc/disc_io.h
+ * Block device interface; only isInserted() does anything on the host.
+ */
+
+#ifndef _HOST_OGC_DISC_IO_H_
+#define _HOST_OGC_DISC_IO_H_
+
+#include "gctypes.h"
+
+typedef u32 sec_t;
+
+typedef bool (*FN_MEDIUM_STARTUP)(void);
+typedef bool (*FN_MEDIUM_ISINSERTED)(void);
+typedef bool (*FN_MEDIUM_READSECTORS)(sec_t sector, sec_t numSectors,
+                                      void *buffer);
+typedef bool (*FN_MEDIUM_WRITESECTORS)(sec_t sector, sec_t numSectors,
+                                       const void *buffer);
+typedef bool (*FN_MEDIUM_CLEARSTATUS)(void);
+typedef bool (*FN_MEDIUM_SHUTDOWN)(void);
+
+typedef struct DISC_INTERFACE_STRUCT {
+  unsigned long ioType;
+  unsigned long features;
+  FN_MEDIUM_STARTUP startup;
+  FN_MEDIUM_ISINSERTED isInserted;
+  FN_MEDIUM_READSECTORS readSectors;
+  FN_MEDIUM_WRITESECTORS writeSectors;
+  FN_MEDIUM_CLEARSTATUS clearStatus;
+  FN_MEDIUM_SHUTDOWN shutdown;
+} DISC_INTERFACE;
+
+#endif /* _HOST_OGC_DISC_IO_H_ */
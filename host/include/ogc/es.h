@@ -0,0 +1,87 @@
+/*
+ * WiiMedic host backend - ogc/es.h
+ * ES title/TMD structures (layout identical to libogc) and the ES calls
+ * WiiMedic uses. TMD fixtures are raw big-endian dumps; the host backend
+ * byte-swaps them into native order on load.
+ */
+
+#ifndef _HOST_OGC_ES_H_
+#define _HOST_OGC_ES_H_
+
+#include "gctypes.h"
+
+#define ES_SIG_RSA4096 0x10000
+#define ES_SIG_RSA2048 0x10001
+#define ES_SIG_ECDSA 0x10002
+
+typedef u32 sigtype;
+typedef sigtype signed_blob;
+typedef u8 sha1[20];
+typedef char sig_issuer[0x40];
+
+typedef struct _sig_rsa2048 {
+  sigtype type;
+  u8 sig[256];
+  u8 fill[60];
+} ATTRIBUTE_PACKED sig_rsa2048;
+
+typedef struct _sig_rsa4096 {
+  sigtype type;
+  u8 sig[512];
+  u8 fill[60];
+} ATTRIBUTE_PACKED sig_rsa4096;
+
+typedef struct _sig_ecdsa {
+  sigtype type;
+  u8 sig[60];
+  u8 fill[64];
+} ATTRIBUTE_PACKED sig_ecdsa;
+
+typedef struct _tmd_content {
+  u32 cid;
+  u16 index;
+  u16 type;
+  u64 size;
+  sha1 hash;
+} ATTRIBUTE_PACKED tmd_content;
+
+typedef struct _tmd {
+  sig_issuer issuer;
+  u8 version;
+  u8 ca_crl_version;
+  u8 signer_crl_version;
+  u8 fill2;
+  u64 sys_version;
+  u64 title_id;
+  u32 title_type;
+  u16 group_id;
+  u16 zero;
+  u16 region;
+  u8 ratings[16];
+  u8 reserved[12];
+  u8 ipc_mask[12];
+  u8 reserved2[18];
+  u32 access_rights;
+  u16 title_version;
+  u16 num_contents;
+  u16 boot_index;
+  u16 fill3;
+  tmd_content contents[];
+} ATTRIBUTE_PACKED tmd;
+
+#define SIGNATURE_SIZE(x)                                                      \
+  (((*(x)) == ES_SIG_RSA2048)   ? sizeof(sig_rsa2048)                          \
+   : ((*(x)) == ES_SIG_RSA4096) ? sizeof(sig_rsa4096)                          \
+   : ((*(x)) == ES_SIG_ECDSA)   ? sizeof(sig_ecdsa)                            \
+                                : 0)
+#define SIGNATURE_PAYLOAD(x) ((void *)(((u8 *)(x)) + SIGNATURE_SIZE(x)))
+
+s32 ES_GetNumTitles(u32 *cnt);
+s32 ES_GetTitles(u64 *titles, u32 cnt);
+s32 ES_GetStoredTMDSize(u64 titleID, u32 *size);
+s32 ES_GetStoredTMD(u64 titleID, signed_blob *stmd, u32 size);
+s32 ES_GetNumTicketViews(u64 titleID, u32 *cnt);
+s32 ES_GetBoot2Version(u32 *version);
+s32 ES_GetDeviceID(u32 *device_id);
+
+#endif /* _HOST_OGC_ES_H_ */
@@ -0,0 +1,13 @@
+/*
+ * WiiMedic host backend - ogc/ios.h
+ */
+
+#ifndef _HOST_OGC_IOS_H_
+#define _HOST_OGC_IOS_H_
+
+#include "gctypes.h"
+
+s32 IOS_GetVersion(void);
+s32 IOS_GetRevision(void);
+
+#endif /* _HOST_OGC_IOS_H_ */
@@ -0,0 +1,29 @@
+/*
+ * WiiMedic host backend - ogc/isfs.h
+ * NAND filesystem calls, served from the fixture's nand/ directory tree
+ */
+
+#ifndef _HOST_OGC_ISFS_H_
+#define _HOST_OGC_ISFS_H_
+
+#include "gctypes.h"
+
+#define ISFS_MAXPATH 64
+
+#define ISFS_OPEN_READ 0x01
+#define ISFS_OPEN_WRITE 0x02
+#define ISFS_OPEN_RW (ISFS_OPEN_READ | ISFS_OPEN_WRITE)
+
+#define ISFS_OK 0
+#define ISFS_ENOMEM -22
+#define ISFS_EINVAL -101
+
+s32 ISFS_Initialize(void);
+s32 ISFS_Deinitialize(void);
+s32 ISFS_Open(const char *filepath, u8 mode);
+s32 ISFS_Close(s32 fd);
+s32 ISFS_Read(s32 fd, void *buffer, u32 length);
+s32 ISFS_ReadDir(const char *filepath, char *name_list, u32 *num);
+s32 ISFS_GetUsage(const char *filepath, u32 *usage1, u32 *usage2);
+
+#endif /* _HOST_OGC_ISFS_H_ */
@@ -0,0 +1,26 @@
+/*
+ * WiiMedic host backend - ogc/lwp.h
+ * LWP threads on top of pthreads. Priorities are accepted and ignored; the
+ * host scheduler is preemptive, so code must not rely on LWP's cooperative
+ * same-priority scheduling for correctness.
+ */
+
+#ifndef _HOST_OGC_LWP_H_
+#define _HOST_OGC_LWP_H_
+
+#include "gctypes.h"
+
+#define LWP_THREAD_NULL 0xffffffff
+
+#define LWP_PRIO_IDLE 0
+#define LWP_PRIO_HIGHEST 127
+
+typedef u32 lwp_t;
+
+s32 LWP_CreateThread(lwp_t *thethread, void *(*entry)(void *), void *arg,
+                     void *stackbase, u32 stack_size, u8 prio);
+s32 LWP_JoinThread(lwp_t thethread, void **value_ptr);
+lwp_t LWP_GetSelf(void);
+void LWP_YieldThread(void);
+
+#endif /* _HOST_OGC_LWP_H_ */
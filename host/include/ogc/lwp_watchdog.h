@@ -0,0 +1,34 @@
+/*
+ * WiiMedic host backend - ogc/lwp_watchdog.h
+ * Timebase helpers. Ticks keep the Wii's 60.75 MHz timebase so tick math
+ * (and anything stored in ticks) means the same thing on both builds.
+ */
+
+#ifndef _HOST_OGC_LWP_WATCHDOG_H_
+#define _HOST_OGC_LWP_WATCHDOG_H_
+
+#include "gctypes.h"
+
+#define TB_BUS_CLOCK 243000000u
+#define TB_CORE_CLOCK 729000000u
+#define TB_TIMER_CLOCK (TB_BUS_CLOCK / 4000)
+
+#define ticks_to_secs(ticks) (((u64)(ticks) / (u64)(TB_TIMER_CLOCK * 1000)))
+#define ticks_to_millisecs(ticks) (((u64)(ticks) / (u64)(TB_TIMER_CLOCK)))
+#define ticks_to_microsecs(ticks)                                              \
+  ((((u64)(ticks) * 8) / (u64)(TB_TIMER_CLOCK / 125)))
+#define ticks_to_nanosecs(ticks)                                               \
+  ((((u64)(ticks) * 8000) / (u64)(TB_TIMER_CLOCK / 125)))
+
+#define secs_to_ticks(sec) ((u64)(sec) * (TB_TIMER_CLOCK * 1000))
+#define millisecs_to_ticks(msec) ((u64)(msec) * (TB_TIMER_CLOCK))
+#define microsecs_to_ticks(usec) (((u64)(usec) * (TB_TIMER_CLOCK / 125)) / 8)
+#define nanosecs_to_ticks(nsec) (((u64)(nsec) * (TB_TIMER_CLOCK / 125)) / 8000)
+
+#define diff_ticks(tick0, tick1)                                               \
+  (((u64)(tick1) < (u64)(tick0)) ? ((u64)-1 - (u64)(tick0) + (u64)(tick1))     \
+                                 : ((u64)(tick1) - (u64)(tick0)))
+
+u64 gettime(void);
+
+#endif /* _HOST_OGC_LWP_WATCHDOG_H_ */
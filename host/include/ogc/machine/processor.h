@@ -0,0 +1,11 @@
+/*
+ * WiiMedic host backend - ogc/machine/processor.h
+ * Nothing from the PPC intrinsics header is used on the host.
+ */
+
+#ifndef _HOST_OGC_PROCESSOR_H_
+#define _HOST_OGC_PROCESSOR_H_
+
+#include "gctypes.h"
+
+#endif /* _HOST_OGC_PROCESSOR_H_ */
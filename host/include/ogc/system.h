@@ -0,0 +1,28 @@
+/*
+ * WiiMedic host backend - ogc/system.h
+ */
+
+#ifndef _HOST_OGC_SYSTEM_H_
+#define _HOST_OGC_SYSTEM_H_
+
+#include "gctypes.h"
+
+#define SYS_RESTART 0
+#define SYS_HOTRESET 1
+#define SYS_SHUTDOWN 2
+#define SYS_RETURNTOMENU 3
+#define SYS_POWEROFF 4
+
+#define MEM_K0_TO_K1(x) ((void *)(x))
+#define MEM_K1_TO_K0(x) ((void *)(x))
+
+struct _gx_rmodeobj;
+
+u32 SYS_GetHollywoodRevision(void);
+u32 SYS_GetArena1Size(void);
+u32 SYS_GetArena2Size(void);
+void *SYS_AllocateFramebuffer(struct _gx_rmodeobj *rmode);
+void SYS_ResetSystem(s32 reset, u32 reset_code, s32 force_menu);
+s32 WII_LaunchTitle(u64 titleID);
+
+#endif /* _HOST_OGC_SYSTEM_H_ */
@@ -0,0 +1,13 @@
+/*
+ * WiiMedic host backend - ogc/usbstorage.h
+ * USB mass storage: inserted while "<root>/usb:" exists.
+ */
+
+#ifndef _HOST_OGC_USBSTORAGE_H_
+#define _HOST_OGC_USBSTORAGE_H_
+
+#include "ogc/disc_io.h"
+
+extern const DISC_INTERFACE __io_usbstorage;
+
+#endif /* _HOST_OGC_USBSTORAGE_H_ */
@@ -0,0 +1,38 @@
+/*
+ * WiiMedic host backend - ogc/video.h
+ * Video is a no-op on the host; VIDEO_WaitVSync only counts frames.
+ * Framebuffers are plain memory that nothing displays.
+ */
+
+#ifndef _HOST_OGC_VIDEO_H_
+#define _HOST_OGC_VIDEO_H_
+
+#include "gctypes.h"
+
+#define VI_INTERLACE 0
+#define VI_NON_INTERLACE 1
+#define VI_PROGRESSIVE 2
+
+#define VI_DISPLAY_PIX_SZ 2
+
+typedef struct _gx_rmodeobj {
+  u32 viTVMode;
+  u16 fbWidth;
+  u16 efbHeight;
+  u16 xfbHeight;
+  u16 viXOrigin;
+  u16 viYOrigin;
+  u16 viWidth;
+  u16 viHeight;
+} GXRModeObj;
+
+void VIDEO_Init(void);
+GXRModeObj *VIDEO_GetPreferredMode(GXRModeObj *mode);
+void VIDEO_Configure(GXRModeObj *rmode);
+void VIDEO_SetNextFramebuffer(void *fb);
+void VIDEO_SetBlack(bool black);
+void VIDEO_Flush(void);
+void VIDEO_WaitVSync(void);
+u32 VIDEO_GetRetraceCount(void);
+
+#endif /* _HOST_OGC_VIDEO_H_ */
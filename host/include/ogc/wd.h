@@ -0,0 +1,65 @@
+/*
+ * WiiMedic host backend - ogc/wd.h
+ * Wireless driver scan API. WD_ScanOnce builds a scan buffer from the
+ * fixture's aps.txt in the same [count][BSSDescriptor + IEs]... layout the
+ * real driver returns (native byte order).
+ */
+
+#ifndef _HOST_OGC_WD_H_
+#define _HOST_OGC_WD_H_
+
+#include "gctypes.h"
+
+#define CAPAB_SECURED_FLAG 0x0010
+#define IEID_SECURITY 48
+#define AOSSAPScan 3
+
+typedef struct BSSDescriptor {
+  u16 length;
+  u16 RSSI;
+  u8 BSSID[6];
+  u16 SSIDLength;
+  u8 SSID[32];
+  u16 Capabilities;
+  struct {
+    u16 basic;
+    u16 support;
+  } rateSet;
+  u16 beaconPeriod;
+  u16 DTIMPeriod;
+  u16 channel;
+  u16 CF_Period;
+  u16 CF_MaxDuration;
+  u16 IEs_length;
+} ATTRIBUTE_PACKED BSSDescriptor;
+
+typedef struct ScanParameters {
+  u16 ChannelBitmap;
+  u16 MaxChannelTime;
+  u8 BSSID[6];
+  u16 ScanType;
+  u16 SSIDLength;
+  u8 SSID[32];
+  u8 SSIDMatchMask[32];
+} ScanParameters;
+
+typedef struct WDInfo {
+  u8 MAC[6];
+  u16 EnableChannelsMask;
+  u16 NTRallowedChannels;
+  u8 CountryCode[4];
+  u8 channel;
+  u8 initialized;
+  u8 version[80];
+  u8 unknown[48];
+} WDInfo;
+
+s32 WD_Init(u8 mode);
+void WD_Deinit(void);
+s32 WD_GetInfo(WDInfo *info);
+void WD_SetDefaultScanParameters(ScanParameters *params);
+s32 WD_ScanOnce(ScanParameters *params, u8 *buf, u16 len);
+u8 WD_GetRadioLevel(BSSDescriptor *bss);
+u16 WD_GetIELength(BSSDescriptor *bss, u8 id);
+
+#endif /* _HOST_OGC_WD_H_ */
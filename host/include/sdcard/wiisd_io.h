@@ -0,0 +1,13 @@
+/*
+ * WiiMedic host backend - sdcard/wiisd_io.h
+ * Front SD slot: inserted while "<root>/sd:" exists.
+ */
+
+#ifndef _HOST_SDCARD_WIISD_IO_H_
+#define _HOST_SDCARD_WIISD_IO_H_
+
+#include "ogc/disc_io.h"
+
+extern const DISC_INTERFACE __io_wiisd;
+
+#endif /* _HOST_SDCARD_WIISD_IO_H_ */
@@ -0,0 +1,87 @@
+/*
+ * WiiMedic host backend - wiiuse/wpad.h
+ * Wii Remote API, replayed from the fixture's pads.txt
+ */
+
+#ifndef _HOST_WIIUSE_WPAD_H_
+#define _HOST_WIIUSE_WPAD_H_
+
+#include "gctypes.h"
+
+#define WPAD_MAX_WIIMOTES 4
+#define WPAD_CHAN_ALL -1
+#define WPAD_CHAN_0 0
+
+#define WPAD_FMT_BTNS 0
+#define WPAD_FMT_BTNS_ACC 1
+#define WPAD_FMT_BTNS_ACC_IR 2
+
+#define WPAD_ERR_NONE 0
+#define WPAD_ERR_NO_CONTROLLER -1
+#define WPAD_ERR_NOT_READY -2
+
+#define WPAD_EXP_NONE 0
+#define WPAD_EXP_NUNCHUK 1
+#define WPAD_EXP_CLASSIC 2
+#define WPAD_EXP_GUITARHERO3 3
+#define WPAD_EXP_WIIBOARD 4
+
+#define WPAD_BUTTON_2 0x0001
+#define WPAD_BUTTON_1 0x0002
+#define WPAD_BUTTON_B 0x0004
+#define WPAD_BUTTON_A 0x0008
+#define WPAD_BUTTON_MINUS 0x0010
+#define WPAD_BUTTON_HOME 0x0080
+#define WPAD_BUTTON_LEFT 0x0100
+#define WPAD_BUTTON_RIGHT 0x0200
+#define WPAD_BUTTON_DOWN 0x0400
+#define WPAD_BUTTON_UP 0x0800
+#define WPAD_BUTTON_PLUS 0x1000
+
+typedef struct vec2b_t {
+  u8 x, y;
+} vec2b_t;
+
+typedef struct joystick_t {
+  vec2b_t max;
+  vec2b_t min;
+  vec2b_t center;
+  vec2b_t pos;
+} joystick_t;
+
+typedef struct nunchuk_t {
+  joystick_t js;
+} nunchuk_t;
+
+typedef struct expansion_t {
+  int type;
+  nunchuk_t nunchuk;
+} expansion_t;
+
+typedef struct ir_t {
+  int valid;
+  f32 x, y;
+} ir_t;
+
+typedef struct _wpad_data {
+  s16 err;
+  u32 data_present;
+  u8 battery_level;
+  u32 btns_h;
+  u32 btns_l;
+  u32 btns_d;
+  u32 btns_u;
+  ir_t ir;
+  expansion_t exp;
+} WPADData;
+
+s32 WPAD_Init(void);
+s32 WPAD_Shutdown(void);
+s32 WPAD_SetDataFormat(s32 chan, s32 fmt);
+s32 WPAD_ScanPads(void);
+s32 WPAD_Probe(s32 chan, u32 *type);
+u32 WPAD_ButtonsDown(int chan);
+u32 WPAD_ButtonsHeld(int chan);
+WPADData *WPAD_Data(int chan);
+
+#endif /* _HOST_WIIUSE_WPAD_H_ */
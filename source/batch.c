@@ -0,0 +1,325 @@
+/*
+ * WiiMedic - batch.c
+ * Unattended runs for sweeping many consoles. Plans are parsed from
+ * key=value tokens, whether they come from argv or a plan file, then the
+ * report is built with all screen output dropped at ui_printf so nothing is
+ * formatted or drawn, and no prompt can wait for a button.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wiiuse/wpad.h>
+
+#include "batch.h"
+#include "modules.h"
+#include "report.h"
+#include "storage_test.h"
+#include "trace.h"
+#include "ui_common.h"
+
+#define BATCH_LINE_MAX 256
+
+static int s_plan_errors = 0; /* shown on screen so far */
+
+/*---------------------------------------------------------------------------*/
+static bool parse_u32(const char *s, u32 *out) {
+  char *end;
+  unsigned long v = strtoul(s, &end, 10);
+
+  if (end == s || *end)
+    return false;
+  *out = (u32)v;
+  return true;
+}
+
+static bool parse_target(const char *s, u32 *ip, u16 *port) {
+  unsigned a, b, c, d, p;
+  char tail;
+
+  if (sscanf(s, "%u.%u.%u.%u:%u%c", &a, &b, &c, &d, &p, &tail) != 5 ||
+      a > 255 || b > 255 || c > 255 || d > 255 || p == 0 || p > 65535)
+    return false;
+  *ip = a << 24 | b << 16 | c << 8 | d;
+  *port = (u16)p;
+  return true;
+}
+
+/* "all" or a comma-separated list of module names */
+static bool parse_modules(const char *s, u32 *mask) {
+  char name[32];
+
+  if (strcmp(s, "all") == 0) {
+    *mask = MODULE_ALL;
+    return true;
+  }
+  *mask = 0;
+  while (*s) {
+    int len = (int)strcspn(s, ",");
+    int id;
+
+    if (len == 0 || len >= (int)sizeof(name))
+      return false;
+    memcpy(name, s, len);
+    name[len] = '\0';
+    for (id = 0; id < MODULE_COUNT; id++) {
+      if (strcmp(module_get((module_id)id)->name, name) == 0)
+        break;
+    }
+    if (id == MODULE_COUNT)
+      return false;
+    *mask |= MODULE_BIT(id);
+    s += len;
+    if (*s == ',')
+      s++;
+  }
+  return *mask != 0;
+}
+
+/* Comma-separated report forms: text, json, bin */
+static bool parse_formats(const char *s, u32 *formats) {
+  static const char *const names[] = {"text", "json", "bin"};
+
+  *formats = 0;
+  while (*s) {
+    int len = (int)strcspn(s, ",");
+    int i;
+
+    for (i = 0; i < 3; i++) {
+      if ((int)strlen(names[i]) == len && strncmp(s, names[i], len) == 0)
+        break;
+    }
+    if (i == 3)
+      return false;
+    *formats |= 1u << i;
+    s += len;
+    if (*s == ',')
+      s++;
+  }
+  return *formats != 0;
+}
+
+/* Apply one key=value setting. Returns false with *why set on error. */
+static bool plan_set(batch_plan *plan, const char *token, const char **why) {
+  char key[32];
+  const char *val;
+  int klen;
+  bool ok;
+
+  if (token[0] == '-' && token[1] == '-')
+    token += 2;
+  val = strchr(token, '=');
+  klen = val ? (int)(val - token) : 0;
+  if (!val || klen == 0 || klen >= (int)sizeof(key)) {
+    *why = "expected key=value";
+    return false;
+  }
+  memcpy(key, token, klen);
+  key[klen] = '\0';
+  val++;
+
+  if (strcmp(key, "modules") == 0) {
+    ok = parse_modules(val, &plan->modules);
+  } else if (strcmp(key, "out") == 0) {
+    ok = val[0] && strlen(val) < sizeof(plan->out);
+    if (ok)
+      strcpy(plan->out, val);
+  } else if (strcmp(key, "formats") == 0) {
+    ok = parse_formats(val, &plan->formats);
+  } else if (strcmp(key, "exit") == 0) {
+    ok = true;
+    if (strcmp(val, "return") == 0)
+      plan->exit_mode = BATCH_EXIT_RETURN;
+    else if (strcmp(val, "menu") == 0)
+      plan->exit_mode = BATCH_EXIT_MENU;
+    else if (strcmp(val, "off") == 0)
+      plan->exit_mode = BATCH_EXIT_OFF;
+    else
+      ok = false;
+  } else if (strcmp(key, "storage.file_kb") == 0) {
+    ok = parse_u32(val, &plan->storage_file_kb);
+  } else if (strcmp(key, "storage.block_kb") == 0) {
+    ok = parse_u32(val, &plan->storage_block_kb);
+  } else if (strcmp(key, "storage.iterations") == 0) {
+    ok = parse_u32(val, &plan->storage_iterations);
+  } else if (strcmp(key, "network.target1") == 0) {
+    ok = parse_target(val, &plan->target_ip[0], &plan->target_port[0]);
+  } else if (strcmp(key, "network.target2") == 0) {
+    ok = parse_target(val, &plan->target_ip[1], &plan->target_port[1]);
+  } else {
+    *why = "unknown key";
+    return false;
+  }
+  if (!ok)
+    *why = "bad value";
+  return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+/* A bad plan goes to stderr for the host and to the screen for an HBC
+   launch, which would otherwise just return to the loader */
+static void plan_error(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+
+static void plan_error(const char *fmt, ...) {
+  char msg[BATCH_LINE_MAX + 64];
+  va_list args;
+
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  fprintf(stderr, "WiiMedic: %s\n", msg);
+  if (s_plan_errors++ == 0) {
+    ui_clear();
+    ui_draw_banner();
+    ui_draw_section("Batch Mode");
+  }
+  ui_draw_err(msg);
+}
+
+/* Leave the errors on screen until a button is pressed */
+static int plan_failed(void) {
+  ui_printf("\n");
+  ui_draw_info("Batch mode was not started.");
+  ui_wait_button_to("exit");
+  return BATCH_ERROR;
+}
+
+/* Returns false if the file exists but has a bad line (reported) */
+static bool plan_load(batch_plan *plan, const char *path, bool *found) {
+  char line[BATCH_LINE_MAX];
+  FILE *fp = TRACE_CALL("fopen", fopen(path, "r"));
+  int lineno = 0;
+  bool ok = true;
+
+  *found = fp != NULL;
+  if (!fp)
+    return true;
+  while (ok && fgets(line, sizeof(line), fp)) {
+    char *s = line;
+    char *end;
+    const char *why;
+
+    lineno++;
+    while (*s == ' ' || *s == '\t')
+      s++;
+    end = s + strlen(s);
+    while (end > s && (end[-1] == '\n' || end[-1] == '\r' ||
+                       end[-1] == ' ' || end[-1] == '\t'))
+      *--end = '\0';
+    if (*s == '\0' || *s == '#')
+      continue;
+    if (!plan_set(plan, s, &why)) {
+      plan_error("%s line %d: %s: %s", path, lineno, why, s);
+      ok = false;
+    }
+  }
+  TRACE_CALL("fclose", fclose(fp));
+  return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+int batch_configure(int argc, char **argv, batch_plan *plan) {
+  const char *plan_path = BATCH_PLAN_SD;
+  bool explicit_plan = false;
+  bool batch = false;
+  bool found;
+  int i;
+
+  memset(plan, 0, sizeof(*plan));
+  plan->modules = MODULE_ALL;
+  plan->formats = REPORT_FMT_DEFAULT;
+
+  /* The HBC passes no argv at all when meta.xml has no <arguments> */
+  if (!argv)
+    argc = 0;
+
+  /* Flags first: they decide whether and which plan file is read */
+  for (i = 1; i < argc; i++) {
+    const char *a = argv[i];
+
+    if (strcmp(a, "--menu") == 0)
+      return BATCH_NONE;
+    if (strcmp(a, "--batch") == 0) {
+      batch = true;
+    } else if (strncmp(a, "plan=", 5) == 0 || strncmp(a, "--plan=", 7) == 0) {
+      plan_path = strchr(a, '=') + 1;
+      explicit_plan = true;
+    } else if (strchr(a, '=')) {
+      batch = true;
+    }
+  }
+
+  if (!plan_load(plan, plan_path, &found))
+    return plan_failed();
+  if (explicit_plan && !found) {
+    plan_error("cannot read plan file %s", plan_path);
+    return plan_failed();
+  }
+  batch = batch || found;
+
+  for (i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *why;
+
+    if (strcmp(a, "--batch") == 0 || strncmp(a, "plan=", 5) == 0 ||
+        strncmp(a, "--plan=", 7) == 0)
+      continue;
+    if (!plan_set(plan, a, &why)) {
+      plan_error("argument '%s': %s", a, why);
+      return plan_failed();
+    }
+  }
+  return batch ? BATCH_RUN : BATCH_NONE;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The menu report's choice when no out= is given: SD if writable, else USB */
+static const char *default_out(void) {
+  FILE *fp = TRACE_CALL("fopen", fopen(REPORT_PATH_SD, "w"));
+
+  if (fp) {
+    TRACE_CALL("fclose", fclose(fp));
+    return REPORT_PATH_SD;
+  }
+  return REPORT_PATH_USB;
+}
+
+int batch_run(const batch_plan *plan) {
+  const char *out = plan->out[0] ? plan->out : default_out();
+  u64 start = gettime();
+  int i, len;
+
+  storage_test_set_params(plan->storage_file_kb, plan->storage_block_kb,
+                          plan->storage_iterations);
+  for (i = 0; i < NETWORK_TEST_TARGETS; i++) {
+    if (plan->target_port[i])
+      network_test_set_target(i, plan->target_ip[i], plan->target_port[i]);
+  }
+
+  fprintf(stderr, "WiiMedic batch: %d module(s) -> %s\n",
+          __builtin_popcount(plan->modules), out);
+
+  ui_set_headless(true);
+  ui_scroll_begin();
+  len = TRACE_CALL("batch", report_write(plan->modules, out, plan->formats));
+  ui_set_headless(false);
+
+  if (len < 0)
+    fprintf(stderr, "WiiMedic batch: could not write %s\n", out);
+  else
+    fprintf(stderr, "WiiMedic batch: %d bytes in %u ms\n", len,
+            (u32)ticks_to_millisecs(gettime() - start));
+
+  if (trace_write(TRACE_OUT_SD) < 0)
+    trace_write(TRACE_OUT_USB);
+  WPAD_Shutdown();
+  if (plan->exit_mode == BATCH_EXIT_MENU)
+    SYS_ResetSystem(SYS_RETURNTOMENU, 0, 0);
+  else if (plan->exit_mode == BATCH_EXIT_OFF)
+    SYS_ResetSystem(SYS_POWEROFF, 0, 0);
+  return len < 0 ? 1 : 0;
+}
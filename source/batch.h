@@ -0,0 +1,58 @@
+/*
+ * WiiMedic - batch.h
+ * Unattended mode: run a plan of modules with no UI, write the report and
+ * exit. Selected by HBC arguments (meta.xml <arguments>), an SD plan file or
+ * the host command line.
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <gccore.h>
+
+#include "network_test.h"
+
+// Read when present; its lines use the same key=value syntax as arguments
+#define BATCH_PLAN_SD "sd:/WiiMedic_Plan.txt"
+
+// batch_configure results
+#define BATCH_NONE 0  // interactive menu
+#define BATCH_RUN 1   // plan filled in
+#define BATCH_ERROR 2 // bad plan; shown until a button is pressed
+
+// How batch_run leaves
+#define BATCH_EXIT_RETURN 0 // return from main (to the loader / shell)
+#define BATCH_EXIT_MENU 1   // Wii System Menu
+#define BATCH_EXIT_OFF 2    // power off
+
+typedef struct {
+  u32 modules;   // MODULE_BIT()s
+  char out[128]; // "" = SD, else USB, as the menu report does; "-" = stdout
+  u32 formats;   // REPORT_FMT_*
+  int exit_mode; // BATCH_EXIT_*
+
+  /* Module parameters; 0 keeps the module's default */
+  u32 storage_file_kb;
+  u32 storage_block_kb;
+  u32 storage_iterations;
+  u32 target_ip[NETWORK_TEST_TARGETS]; // host order
+  u16 target_port[NETWORK_TEST_TARGETS];
+} batch_plan;
+
+// Decide from argv and BATCH_PLAN_SD whether to run unattended. Arguments:
+//   --batch             run with defaults (all modules)
+//   --menu              ignore the plan file and show the menu
+//   plan=PATH           read a plan file instead of BATCH_PLAN_SD
+//   modules=all|nand,ios,...   out=PATH   exit=return|menu|off
+//   formats=text,json,bin   (default text,json)
+//   storage.file_kb=N  storage.block_kb=N  storage.iterations=N
+//   network.target1=A.B.C.D:PORT  network.target2=A.B.C.D:PORT
+// A leading "--" on key=value arguments is accepted; arguments override the
+// plan file. Call after fatInitDefault. Returns BATCH_*.
+int batch_configure(int argc, char **argv, batch_plan *plan);
+
+// Run the plan with console rendering off, write the report and leave as
+// plan->exit_mode says. Returns the exit status: 0 = report written,
+// 1 = it could not be.
+int batch_run(const batch_plan *plan);
+
+#endif // BATCH_H
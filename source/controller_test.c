@@ -15,6 +15,7 @@
 
 static int s_gc_ports_detected  = 0;
 static int s_wiimotes_detected  = 0;
+static int s_lowest_battery     = -1; /* percent, -1 = no Wii Remote */
 
 /*---------------------------------------------------------------------------*/
 static void test_gc_controllers(void) {
@@ -231,11 +232,10 @@ void run_controller_test(void) {
 }
 
 /*---------------------------------------------------------------------------*/
-void scan_controllers_quick(void) {
-    int warmup, chan, port;
+/* GC ports showing any input after one scan */
+static int count_gc_ports(void) {
+    int port, count = 0;
 
-    /* GC controllers */
-    s_gc_ports_detected = 0;
     PAD_ScanPads();
     for (port = 0; port < 4; port++) {
         s16 stickX = PAD_StickX(port);
@@ -244,29 +244,69 @@ void scan_controllers_quick(void) {
         u8  trigL  = PAD_TriggerL(port);
         u8  trigR  = PAD_TriggerR(port);
         if (stickX || stickY || btns || trigL || trigR)
-            s_gc_ports_detected++;
+            count++;
+    }
+    return count;
+}
+
+/* Also notes the lowest battery level among them */
+static int count_wiimotes(void) {
+    int chan, count = 0;
+
+    s_lowest_battery = -1;
+    for (chan = 0; chan < 4; chan++) {
+        u32 type;
+        if (WPAD_Probe(chan, &type) == WPAD_ERR_NONE) {
+            WPADData *wdata = WPAD_Data(chan);
+            int pct = wdata ? wdata->battery_level * 100 / 208 : -1;
+            if (pct > 100) pct = 100;
+            if (pct >= 0 && (s_lowest_battery < 0 || pct < s_lowest_battery))
+                s_lowest_battery = pct;
+            count++;
+        }
     }
+    return count;
+}
+
+void scan_controllers_quick(void) {
+    int warmup;
+
+    s_gc_ports_detected = count_gc_ports();
 
     /* Wii Remotes - need warmup for BT stack */
-    s_wiimotes_detected = 0;
     for (warmup = 0; warmup < 30; warmup++) {
         WPAD_ScanPads();
         VIDEO_WaitVSync();
     }
-    for (chan = 0; chan < 4; chan++) {
-        u32 type;
-        if (WPAD_Probe(chan, &type) == WPAD_ERR_NONE)
-            s_wiimotes_detected++;
-    }
+    s_wiimotes_detected = count_wiimotes();
+}
+
+/* Remotes paired since boot are already connected; a single scan only
+   misses one that is still syncing, which the full test waits for */
+void quick_controller_test(quick_result *q) {
+    int gc, wiimotes;
+
+    gc = count_gc_ports();
+    WPAD_ScanPads();
+    wiimotes = count_wiimotes();
+
+    q->level = (gc || wiimotes) ? QUICK_GREEN : QUICK_YELLOW;
+    snprintf(q->summary, sizeof(q->summary), "%d Wii Remote(s), %d GC port(s)",
+             wiimotes, gc);
+}
+
+/*---------------------------------------------------------------------------*/
+int controller_test_lowest_battery(void) {
+    return s_lowest_battery;
 }
 
 /*---------------------------------------------------------------------------*/
-void get_controller_test_report(char *buf, int bufsize) {
-    snprintf(buf, bufsize,
-        "=== CONTROLLER DIAGNOSTICS ===\n"
-        "GameCube Ports Active: %d / 4\n"
-        "Wii Remotes Connected: %d / 4\n"
-        "\n",
-        s_gc_ports_detected, s_wiimotes_detected
-    );
+void get_controller_test_report(report_rec *out) {
+    rec_text(out, "=== CONTROLLER DIAGNOSTICS ===\n");
+    rec_int(out, "gc_ports", "GameCube Ports Active: %d / 4",
+        s_gc_ports_detected);
+    rec_int(out, "wiimotes", "Wii Remotes Connected: %d / 4",
+        s_wiimotes_detected);
+    rec_int(out, "lowest_battery_pct", NULL, s_lowest_battery);
+    rec_text(out, "\n");
 }
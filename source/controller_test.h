@@ -5,13 +5,22 @@
 #ifndef CONTROLLER_TEST_H
 #define CONTROLLER_TEST_H
 
+#include "modules.h"
+
 // Run the controller diagnostic test
 void run_controller_test(void);
 
 // Quick scan - just count connected controllers (no UI output)
 void scan_controllers_quick(void);
 
-// Get controller test report as string
-void get_controller_test_report(char *buf, int bufsize);
+// Quick Health Check: one pad scan, no Bluetooth warmup
+void quick_controller_test(quick_result *q);
+
+// Lowest Wii Remote battery level of the last scan in percent; -1 if no
+// Wii Remote was connected
+int controller_test_lowest_battery(void);
+
+// Write the controller test report section
+void get_controller_test_report(report_rec *out);
 
 #endif // CONTROLLER_TEST_H
@@ -0,0 +1,640 @@
+/*
+ * WiiMedic - dashboard.c
+ * Live dashboard. Sampler threads fill fixed rings that the UI thread reads
+ * every frame:
+ *   system  10 Hz     CPU load, MEM1/MEM2 arena free, tracked heap
+ *   input   60 Hz     the pads; the only thread scanning them while the
+ *                     dashboard runs, it hands button presses to the UI
+ *   Wi-Fi   every 3s  strongest access point of a scan
+ * CPU load comes from a counter spun by a thread at idle priority: it only
+ * runs when nothing else wants the CPU, so its rate against the rate with
+ * nothing else running is the idle fraction. The dashboard's own drawing
+ * and sampling are timed and shown next to it. Host: the spinner has a
+ * core of its own, so the load reads near zero.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <ogc/wd.h>
+#include <string.h>
+#include <unistd.h>
+#include <wiiuse/wpad.h>
+
+#include "dashboard.h"
+#include "mem_budget.h"
+#include "network_test.h"
+#include "screen.h"
+#include "ui_common.h"
+
+#ifndef AOSSAPScan
+#define AOSSAPScan 3
+#endif
+
+#define DASH_HISTORY 64 /* samples per ring, a power of two */
+#define DASH_SPARK 40   /* sparkline width of the metric rows */
+#define DASH_WIFI_SPARK 24
+#define DASH_STICK_SPARK 12
+#define DASH_STACK_SIZE (16 * 1024)
+#define DASH_SAMPLER_PRIO 80 /* above the UI thread (64): short and periodic */
+#define DASH_WIFI_PRIO 48    /* below it: a scan blocks in IOS for a while */
+#define DASH_SYSTEM_US 100000
+#define DASH_INPUT_US 16667
+#define DASH_STICK_DECIM 4 /* input scans per stick sample (the peak) */
+#define DASH_WIFI_MS 3000
+#define DASH_WIFI_STEP_MS 100 /* sleep in steps, so leaving is quick */
+#define DASH_CALIBRATE_FRAMES 15
+#define DASH_SCAN_BUF 4096
+#define DASH_FRAME_MAX_US 33333 /* top of the frame time sparkline */
+#define DASH_STICK_MAX 100
+
+/* One producer pushes; readers take the newest samples. A reader copies at
+   most DASH_SPARK of the DASH_HISTORY slots, so the producer would have to
+   push the difference during one copy to overwrite what is being read. */
+typedef struct {
+  u32 head; /* samples pushed; written only by the producer */
+  s32 v[DASH_HISTORY];
+} dash_ring;
+
+typedef struct {
+  bool connected;
+  bool stick; /* has a stick (a GC pad, a Wii Remote with a Nunchuk) */
+  s32 probe;  /* Wii Remotes: WPAD_Probe result */
+  u32 ext;    /* Wii Remotes: WPAD_EXP_* */
+  s8 x, y;
+} dash_pad;
+
+typedef enum {
+  WIFI_STARTING,
+  WIFI_OK,
+  WIFI_NONE,  /* the scan found nothing */
+  WIFI_FAILED /* no driver, or the scan failed */
+} wifi_state;
+
+typedef struct {
+  wifi_state state;
+  int aps;
+  char ssid[33];
+} wifi_info;
+
+typedef struct {
+  lwp_t thread;
+  void *stack;
+  bool running;
+} dash_thread;
+
+static volatile bool s_stop;
+static volatile u32 s_spins;
+static u32 s_idle_rate; /* spins per ms with the CPU otherwise idle */
+static u32 s_sampler_ticks; /* sampler work since the UI last took it */
+
+static dash_ring s_cpu, s_frame, s_mem1, s_mem2, s_heap, s_rssi;
+static dash_ring s_gc_ring[4], s_wr_ring[4];
+static volatile dash_pad s_gc[4], s_wr[4];
+static u32 s_wpad_down, s_gpad_down, s_wpad_held;
+static int s_input_scans;
+static s32 s_gc_peak[4], s_wr_peak[4];
+
+/* Two slots: the Wi-Fi thread fills the one readers are not using, then
+   flips s_wifi_seq */
+static wifi_info s_wifi[2];
+static u32 s_wifi_seq;
+static u8 s_scan_buf[DASH_SCAN_BUF] ATTRIBUTE_ALIGN(32);
+
+static const char s_levels[] = "_.:-=+*#";
+
+/*---------------------------------------------------------------------------*/
+static void ring_push(dash_ring *r, s32 v) {
+  u32 head = r->head;
+
+  r->v[head & (DASH_HISTORY - 1)] = v;
+  __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* The newest n samples (fewer if not pushed yet), oldest first */
+static u32 ring_last(const dash_ring *r, s32 *out, u32 n) {
+  u32 head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+  u32 i;
+
+  if (n > head)
+    n = head;
+  for (i = 0; i < n; i++)
+    out[i] = r->v[(head - n + i) & (DASH_HISTORY - 1)];
+  return n;
+}
+
+static bool ring_latest(const dash_ring *r, s32 *v) {
+  return ring_last(r, v, 1) == 1;
+}
+
+/* Add the work since start to the samplers' total */
+static void charge(u64 start) {
+  __atomic_fetch_add(&s_sampler_ticks, (u32)(gettime() - start),
+                     __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------*/
+static void *spin_entry(void *arg) {
+  (void)arg;
+  while (!s_stop)
+    s_spins++;
+  return NULL;
+}
+
+static u32 spin_rate(u32 spins, u64 ticks) {
+  return ticks ? (u32)((u64)spins * TB_TIMER_CLOCK / ticks) : 0;
+}
+
+static void *system_entry(void *arg) {
+  u32 last_spins = s_spins;
+  u64 last = gettime();
+
+  (void)arg;
+  while (!s_stop) {
+    mem_tag_stats heap;
+    u64 now;
+    u32 spins, rate;
+
+    usleep(DASH_SYSTEM_US);
+    now = gettime();
+    spins = s_spins;
+    rate = spin_rate(spins - last_spins, now - last);
+    last = now;
+    last_spins = spins;
+
+    /* Never idler than calibrated, but keep the best rate seen */
+    if (rate > s_idle_rate)
+      s_idle_rate = rate;
+    if (s_idle_rate)
+      ring_push(&s_cpu, 1000 - (s32)((u64)rate * 1000 / s_idle_rate));
+
+    ring_push(&s_mem1, (s32)(SYS_GetArena1Size() / 1024));
+    ring_push(&s_mem2, (s32)(SYS_GetArena2Size() / 1024));
+    mem_get_stats(MEM_TAG_COUNT, &heap);
+    ring_push(&s_heap, (s32)(heap.current / 1024));
+    charge(now);
+  }
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static s32 stick_peak(s32 peak, s8 x, s8 y) {
+  s32 ax = x < 0 ? -x : x, ay = y < 0 ? -y : y;
+
+  if (ax > peak)
+    peak = ax;
+  return ay > peak ? ay : peak;
+}
+
+/* One scan of every pad; the sticks go into their rings as the peak
+   deflection of every DASH_STICK_DECIM scans */
+static void sample_input(void) {
+  u32 gc_mask = PAD_ScanPads();
+  int chan;
+
+  WPAD_ScanPads();
+  __atomic_fetch_or(&s_wpad_down, WPAD_ButtonsDown(0), __ATOMIC_RELEASE);
+  __atomic_fetch_or(&s_gpad_down, (u32)PAD_ButtonsDown(0), __ATOMIC_RELEASE);
+  __atomic_store_n(&s_wpad_held, WPAD_ButtonsHeld(0), __ATOMIC_RELEASE);
+
+  for (chan = 0; chan < 4; chan++) {
+    volatile dash_pad *gc = &s_gc[chan], *wr = &s_wr[chan];
+    WPADData *data;
+    u32 type = WPAD_EXP_NONE;
+
+    gc->connected = gc->stick = (gc_mask & (1u << chan)) != 0;
+    gc->x = PAD_StickX(chan);
+    gc->y = PAD_StickY(chan);
+    if (gc->connected)
+      s_gc_peak[chan] = stick_peak(s_gc_peak[chan], gc->x, gc->y);
+
+    wr->probe = WPAD_Probe(chan, &type);
+    wr->connected = wr->probe == WPAD_ERR_NONE;
+    wr->ext = type;
+    wr->stick = wr->connected && type == WPAD_EXP_NUNCHUK;
+    data = wr->stick ? WPAD_Data(chan) : NULL;
+    if (data) {
+      wr->x = (s8)(data->exp.nunchuk.js.pos.x - data->exp.nunchuk.js.center.x);
+      wr->y = (s8)(data->exp.nunchuk.js.pos.y - data->exp.nunchuk.js.center.y);
+      s_wr_peak[chan] = stick_peak(s_wr_peak[chan], wr->x, wr->y);
+    }
+  }
+
+  if (++s_input_scans == DASH_STICK_DECIM) {
+    s_input_scans = 0;
+    for (chan = 0; chan < 4; chan++) {
+      ring_push(&s_gc_ring[chan], s_gc_peak[chan]);
+      ring_push(&s_wr_ring[chan], s_wr_peak[chan]);
+      s_gc_peak[chan] = s_wr_peak[chan] = 0;
+    }
+  }
+}
+
+static void *input_entry(void *arg) {
+  (void)arg;
+  while (!s_stop) {
+    u64 start = gettime();
+
+    sample_input();
+    charge(start);
+    usleep(DASH_INPUT_US);
+  }
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static void wifi_publish(const wifi_info *info) {
+  u32 seq = s_wifi_seq + 1;
+
+  s_wifi[seq & 1] = *info;
+  __atomic_store_n(&s_wifi_seq, seq, __ATOMIC_RELEASE);
+}
+
+static void *wifi_entry(void *arg) {
+  ScanParameters params;
+  wifi_info info;
+  u32 ms;
+
+  (void)arg;
+  memset(&info, 0, sizeof(info));
+  if (WD_Init(AOSSAPScan) != 0 && WD_Init(0) != 0) {
+    info.state = WIFI_FAILED;
+    wifi_publish(&info);
+    return NULL;
+  }
+  WD_SetDefaultScanParameters(&params);
+  params.ChannelBitmap = 0x3FFF; /* channels 1-14, as the network test */
+
+  while (!s_stop) {
+    s32 ret;
+    u16 rssi = 0;
+    u64 start;
+
+    /* Waiting for the scan is IOS time, not CPU time: not charged */
+    memset(s_scan_buf, 0, sizeof(s_scan_buf));
+    ret = WD_ScanOnce(&params, s_scan_buf, sizeof(s_scan_buf));
+    start = gettime();
+    info.aps = network_strongest_ap(s_scan_buf, ret, info.ssid,
+                                    sizeof(info.ssid), &rssi);
+    info.state = ret < 0 ? WIFI_FAILED : info.aps ? WIFI_OK : WIFI_NONE;
+    /* The driver's RSSI is a signed dBm byte: WD_GetRadioLevel's "strong"
+       threshold 0xC4 is -60 dBm */
+    if (info.aps)
+      ring_push(&s_rssi, (s8)(rssi & 0xFF));
+    wifi_publish(&info);
+    charge(start);
+
+    for (ms = 0; ms < DASH_WIFI_MS && !s_stop; ms += DASH_WIFI_STEP_MS)
+      usleep(DASH_WIFI_STEP_MS * 1000);
+  }
+  WD_Deinit();
+  return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static bool thread_start(dash_thread *t, void *(*entry)(void *), u8 prio) {
+  t->stack = mem_memalign(MEM_TAG_UI, 32, DASH_STACK_SIZE);
+  t->running = t->stack && LWP_CreateThread(&t->thread, entry, NULL, t->stack,
+                                            DASH_STACK_SIZE, prio) >= 0;
+  if (!t->running) {
+    mem_free(t->stack);
+    t->stack = NULL;
+  }
+  return t->running;
+}
+
+static void thread_join(dash_thread *t) {
+  if (t->running)
+    LWP_JoinThread(t->thread, NULL);
+  mem_free(t->stack);
+  t->stack = NULL;
+  t->running = false;
+}
+
+/*---------------------------------------------------------------------------*/
+static void put_num(ui_line *l, s32 v, int width, bool sign) {
+  char buf[12];
+  int i = sizeof(buf) - 1;
+  u32 m = v < 0 ? 0u - (u32)v : (u32)v;
+
+  buf[i] = '\0';
+  do {
+    buf[--i] = (char)('0' + m % 10);
+    m /= 10;
+  } while (m);
+  if (v < 0)
+    buf[--i] = '-';
+  else if (sign)
+    buf[--i] = '+';
+  ui_line_fill(l, ' ', width - (int)(sizeof(buf) - 1 - i));
+  ui_line_puts(l, buf + i);
+}
+
+/* v in tenths, as "12.3" right-aligned in width */
+static void put_tenths(ui_line *l, s32 v, int width) {
+  put_num(l, v / 10, width - 2, false);
+  ui_line_puts(l, ".");
+  ui_line_uint(l, (u32)(v % 10));
+}
+
+/* The newest width samples scaled from lo to hi; a flat window is drawn
+   mid-height when lo and hi come from it (auto) */
+static void put_spark(ui_line *l, const dash_ring *r, int width, s32 lo,
+                      s32 hi, bool autorange) {
+  s32 v[DASH_HISTORY];
+  char buf[DASH_HISTORY + 1];
+  u32 n = ring_last(r, v, (u32)width), i;
+  int top = (int)sizeof(s_levels) - 2;
+
+  if (autorange && n) {
+    lo = hi = v[0];
+    for (i = 1; i < n; i++) {
+      if (v[i] < lo)
+        lo = v[i];
+      if (v[i] > hi)
+        hi = v[i];
+    }
+  }
+  for (i = 0; i < n; i++) {
+    s32 x = v[i] < lo ? lo : v[i] > hi ? hi : v[i];
+
+    buf[i] = hi > lo ? s_levels[(s64)(x - lo) * top / (hi - lo)]
+                     : s_levels[top / 2];
+  }
+  buf[n] = '\0';
+  ui_line_fill(l, ' ', width - (int)n);
+  ui_line_color(l, UI_BGREEN);
+  ui_line_puts(l, buf);
+}
+
+static void row_begin(ui_line *l, const char *label) {
+  ui_line_begin(l);
+  ui_line_puts(l, "   ");
+  ui_line_color(l, UI_CYAN);
+  ui_line_puts(l, label);
+  ui_line_fill(l, ' ', 12 - (int)strlen(label));
+}
+
+/* Label, the newest sample in tenths or whole units, and the sparkline */
+static void draw_metric(const char *label, const dash_ring *r, bool tenths,
+                        const char *unit, s32 lo, s32 hi, bool autorange,
+                        s32 warn, s32 bad) {
+  ui_line l;
+  s32 v;
+
+  row_begin(&l, label);
+  if (!ring_latest(r, &v)) {
+    ui_line_color(&l, UI_WHITE);
+    ui_line_puts(&l, "       --");
+  } else {
+    ui_line_color(&l, bad && v >= bad     ? UI_BRED
+                      : warn && v >= warn ? UI_BYELLOW
+                                          : UI_BWHITE);
+    if (tenths)
+      put_tenths(&l, v, 9);
+    else
+      put_num(&l, v, 9, false);
+  }
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, unit);
+  put_spark(&l, r, DASH_SPARK, lo, hi, autorange);
+  ui_line_end(&l);
+}
+
+static void draw_wifi(void) {
+  wifi_info info = s_wifi[__atomic_load_n(&s_wifi_seq, __ATOMIC_ACQUIRE) & 1];
+  ui_line l;
+  s32 dbm;
+
+  row_begin(&l, "Wi-Fi");
+  if (info.state == WIFI_OK && ring_latest(&s_rssi, &dbm)) {
+    ui_line_color(&l, dbm >= -60 ? UI_BGREEN
+                      : dbm >= -75 ? UI_BWHITE
+                                   : UI_BYELLOW);
+    put_num(&l, dbm, 9, false);
+    ui_line_color(&l, UI_WHITE);
+    ui_line_puts(&l, " dBm ");
+    put_spark(&l, &s_rssi, DASH_WIFI_SPARK, -100, -30, false);
+    ui_line_color(&l, UI_WHITE);
+    ui_line_puts(&l, " ");
+    ui_line_puts(&l, info.ssid);
+    ui_line_puts(&l, " (");
+    ui_line_uint(&l, (u32)info.aps);
+    ui_line_puts(&l, info.aps == 1 ? " AP)" : " APs)");
+  } else {
+    static const char *const states[] = {
+        [WIFI_STARTING] = "Scanning...",
+        [WIFI_OK] = "Scanning...",
+        [WIFI_NONE] = "No access points found",
+        [WIFI_FAILED] = "WiFi driver unavailable",
+    };
+
+    ui_line_color(&l, info.state >= WIFI_NONE ? UI_BYELLOW : UI_WHITE);
+    ui_line_puts(&l, "       ");
+    ui_line_puts(&l, states[info.state]);
+  }
+  ui_line_end(&l);
+}
+
+/* Stick position and the peak deflection history, or why there is none */
+static void put_pad(ui_line *l, const dash_pad *p, const dash_ring *r,
+                    const char *state) {
+  if (p->stick) {
+    ui_line_color(l, UI_BWHITE);
+    put_num(l, p->x, 4, true);
+    put_num(l, p->y, 5, true);
+    ui_line_puts(l, "  ");
+    put_spark(l, r, DASH_STICK_SPARK, 0, DASH_STICK_MAX, false);
+  } else {
+    ui_line_color(l, p->connected ? UI_BWHITE : UI_WHITE);
+    ui_line_puts(l, state);
+    ui_line_fill(l, ' ', 23 - (int)strlen(state));
+  }
+}
+
+static void draw_port(int chan) {
+  static const char *const ext_names[] = {
+      [WPAD_EXP_NONE] = "No extension",
+      [WPAD_EXP_NUNCHUK] = "Nunchuk ",
+      [WPAD_EXP_CLASSIC] = "Classic Controller",
+      [WPAD_EXP_GUITARHERO3] = "Guitar",
+      [WPAD_EXP_WIIBOARD] = "Balance Board",
+  };
+  dash_pad gc = s_gc[chan], wr = s_wr[chan];
+  const char *ext = wr.ext < sizeof(ext_names) / sizeof(ext_names[0])
+                        ? ext_names[wr.ext]
+                        : "Extension";
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_CYAN);
+  ui_line_puts(&l, "   GC ");
+  ui_line_uint(&l, (u32)chan + 1);
+  ui_line_puts(&l, "  ");
+  put_pad(&l, &gc, &s_gc_ring[chan], gc.connected ? "Connected" : "--");
+
+  ui_line_color(&l, UI_CYAN);
+  ui_line_puts(&l, "   Remote ");
+  ui_line_uint(&l, (u32)chan + 1);
+  ui_line_puts(&l, "  ");
+  if (wr.stick) {
+    ui_line_color(&l, UI_WHITE);
+    ui_line_puts(&l, ext);
+  }
+  put_pad(&l, &wr, &s_wr_ring[chan],
+          wr.connected                        ? ext
+          : wr.probe == WPAD_ERR_NOT_READY ? "Connecting..."
+                                              : "--");
+  ui_line_end(&l);
+}
+
+typedef struct {
+  u32 draw_us;     /* per frame */
+  u32 sampler_us;  /* per second */
+  u32 permille;    /* of the CPU, both together */
+  bool valid;
+} dash_cost;
+
+static void draw_cost(const dash_cost *cost) {
+  ui_line l;
+
+  row_begin(&l, "Dashboard");
+  ui_line_color(&l, UI_WHITE);
+  if (!cost->valid) {
+    ui_line_puts(&l, "       measuring its own cost...");
+  } else {
+    ui_line_puts(&l, "draw ");
+    ui_line_uint(&l, cost->draw_us);
+    ui_line_puts(&l, " us/frame, sampling ");
+    ui_line_uint(&l, cost->sampler_us);
+    ui_line_puts(&l, " us/s: ");
+    ui_line_color(&l, UI_BWHITE);
+    put_tenths(&l, (s32)cost->permille, 3);
+    ui_line_color(&l, UI_WHITE);
+    ui_line_puts(&l, "% of the CPU");
+  }
+  ui_line_end(&l);
+}
+
+static void draw_dashboard(const dash_cost *cost) {
+  ui_line l;
+  int chan;
+
+  screen_begin();
+  ui_draw_banner();
+  ui_draw_section("Live System Dashboard");
+
+  draw_metric("CPU load", &s_cpu, true, " %   ", 0, 1000, false, 700, 900);
+  draw_metric("Frame time", &s_frame, true, " ms  ", 0,
+              DASH_FRAME_MAX_US / 100, false, 175, 334);
+  draw_metric("MEM1 free", &s_mem1, false, " KB  ", 0, 0, true, 0, 0);
+  draw_metric("MEM2 free", &s_mem2, false, " KB  ", 0, 0, true, 0, 0);
+  draw_metric("Heap used", &s_heap, false, " KB  ", 0, 0, true, 0, 0);
+  draw_wifi();
+
+  ui_line_begin(&l);
+  ui_line_end(&l);
+  for (chan = 0; chan < 4; chan++)
+    draw_port(chan);
+  ui_line_begin(&l);
+  ui_line_end(&l);
+  draw_cost(cost);
+
+  ui_draw_footer(ui_screenshot_note()[0] ? ui_screenshot_note()
+                                         : "[B] Back   [1]+[2] Screenshot");
+  screen_present();
+}
+
+/*---------------------------------------------------------------------------*/
+void run_dashboard(void) {
+  dash_thread spinner, system, input, wifi;
+  dash_cost cost;
+  u64 last, window, draw_ticks = 0;
+  u32 frames = 0, spins;
+  int i;
+
+  s_stop = false;
+  s_spins = 0;
+  s_idle_rate = 0;
+  s_sampler_ticks = 0;
+  s_input_scans = 0;
+  memset(&s_cpu, 0, sizeof(s_cpu));
+  memset(&s_frame, 0, sizeof(s_frame));
+  memset(&s_mem1, 0, sizeof(s_mem1));
+  memset(&s_mem2, 0, sizeof(s_mem2));
+  memset(&s_heap, 0, sizeof(s_heap));
+  memset(&s_rssi, 0, sizeof(s_rssi));
+  memset(s_gc_ring, 0, sizeof(s_gc_ring));
+  memset(s_wr_ring, 0, sizeof(s_wr_ring));
+  memset((void *)s_gc, 0, sizeof(s_gc));
+  memset((void *)s_wr, 0, sizeof(s_wr));
+  memset(s_gc_peak, 0, sizeof(s_gc_peak));
+  memset(s_wr_peak, 0, sizeof(s_wr_peak));
+  memset(s_wifi, 0, sizeof(s_wifi));
+  s_wifi_seq = 0;
+  s_wpad_down = s_gpad_down = s_wpad_held = 0;
+  memset(&cost, 0, sizeof(cost));
+
+  ui_clear();
+  draw_dashboard(&cost);
+
+  /* Idle rate: the spinner alone while this thread waits for vsyncs */
+  thread_start(&spinner, spin_entry, LWP_PRIO_IDLE);
+  last = gettime();
+  spins = s_spins;
+  for (i = 0; i < DASH_CALIBRATE_FRAMES; i++)
+    VIDEO_WaitVSync();
+  s_idle_rate = spin_rate(s_spins - spins, gettime() - last);
+
+  thread_start(&system, system_entry, DASH_SAMPLER_PRIO);
+  thread_start(&input, input_entry, DASH_SAMPLER_PRIO);
+  thread_start(&wifi, wifi_entry, DASH_WIFI_PRIO);
+
+  last = window = gettime();
+  while (1) {
+    u32 wpad, gpad;
+    u64 now;
+
+    VIDEO_WaitVSync();
+    now = gettime();
+    ring_push(&s_frame, (s32)(ticks_to_microsecs(now - last) / 100));
+    last = now;
+
+    /* Without the input thread, scan here */
+    if (!input.running)
+      sample_input();
+    wpad = __atomic_exchange_n(&s_wpad_down, 0, __ATOMIC_ACQ_REL);
+    gpad = __atomic_exchange_n(&s_gpad_down, 0, __ATOMIC_ACQ_REL);
+    if ((wpad & (WPAD_BUTTON_B | WPAD_BUTTON_HOME)) ||
+        (gpad & (PAD_BUTTON_B | PAD_BUTTON_START)))
+      break;
+    ui_screenshot_poll(__atomic_load_n(&s_wpad_held, __ATOMIC_ACQUIRE), gpad,
+                       NULL);
+
+    now = gettime();
+    draw_dashboard(&cost);
+    draw_ticks += gettime() - now;
+    frames++;
+
+    /* The dashboard's own cost over the last second */
+    if (now - window >= secs_to_ticks(1)) {
+      u64 elapsed = now - window;
+      u32 sampler = __atomic_exchange_n(&s_sampler_ticks, 0, __ATOMIC_RELAXED);
+
+      cost.draw_us = (u32)(ticks_to_microsecs(draw_ticks) / frames);
+      cost.sampler_us =
+          (u32)ticks_to_microsecs((u64)sampler * secs_to_ticks(1) / elapsed);
+      cost.permille = (u32)((draw_ticks + sampler) * 1000 / elapsed);
+      cost.valid = true;
+      window = now;
+      draw_ticks = 0;
+      frames = 0;
+    }
+  }
+
+  s_stop = true;
+  thread_join(&wifi);
+  thread_join(&input);
+  thread_join(&system);
+  thread_join(&spinner);
+  ui_clear();
+}
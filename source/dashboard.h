@@ -0,0 +1,13 @@
+/*
+ * WiiMedic - dashboard.h
+ * Live system dashboard: CPU load, memory, controllers and Wi-Fi, sampled
+ * in the background and redrawn every frame until the user leaves
+ */
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+// Run the dashboard (UI thread). Reads the pads itself; returns on B or
+// HOME (GC B or START).
+void run_dashboard(void);
+
+#endif // DASHBOARD_H
@@ -0,0 +1,300 @@
+/*
+ * WiiMedic - heap_map.c
+ * Walks the malloc heap chunk by chunk. newlib's malloc (dlmalloc 2.6) and
+ * glibc's ptmalloc share the boundary-tag layout: each chunk starts with
+ * prev_size and size words, the low size bits are flags, and a chunk is in
+ * use when the next chunk has PREV_INUSE set. The last chunk ("top") is
+ * always free.
+ *
+ * Console: the heap runs from newlib's sbrk base to the end of the top chunk,
+ * and the MEM1 arena left above it is free space contiguous with top.
+ * The walk holds newlib's malloc lock, so worker threads cannot split or
+ * merge chunks under it.
+ * Host: the main glibc arena is [sbrk(0) - mallinfo2().arena, sbrk(0)).
+ * Chunks cached in glibc's tcache/fastbins still look used there, and
+ * glibc has no public lock, so a busy worker can end the walk early.
+ *
+ * MEM2 has no malloc heap. Its map is the free arena, then anything
+ * libogc placed above it, then WiiMedic's I/O arena block by block.
+ */
+
+#include <gccore.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "heap_map.h"
+#include "io_arena.h"
+#include "ui_common.h"
+
+#define CHUNK_HDR (2 * sizeof(size_t)) /* prev_size + size */
+#define CHUNK_ALIGN (2 * sizeof(size_t))
+#define CHUNK_MIN (2 * CHUNK_HDR)
+#define PREV_INUSE 0x1
+#define SIZE_FLAGS 0x7
+
+#ifndef WIIMEDIC_HOST
+#include <reent.h>
+
+/* newlib malloc internals (mallocr.c, INTERNAL_NEWLIB names) */
+extern char *__malloc_sbrk_base;
+extern void *__malloc_av_[];
+#define NEWLIB_TOP ((uintptr_t)__malloc_av_[2])
+extern void __malloc_lock(struct _reent *);
+extern void __malloc_unlock(struct _reent *);
+#define HEAP_LOCK() __malloc_lock(_REENT)
+#define HEAP_UNLOCK() __malloc_unlock(_REENT)
+#else
+#define HEAP_LOCK() ((void)0)
+#define HEAP_UNLOCK() ((void)0)
+#endif
+
+/*---------------------------------------------------------------------------*/
+static inline size_t chunk_size_at(uintptr_t p) {
+  return ((const size_t *)p)[1] & ~(size_t)SIZE_FLAGS;
+}
+
+static inline bool prev_inuse_at(uintptr_t p) {
+  return (((const size_t *)p)[1] & PREV_INUSE) != 0;
+}
+
+/* Add [a, b) with the given state to the per-cell used-byte counts */
+static void map_span(u32 *cell_used, const heap_region_stats *st, uintptr_t a,
+                     uintptr_t b, bool used) {
+  uintptr_t span = st->end - st->start;
+  u32 c, first, last;
+
+  if (!used || b <= a || span == 0)
+    return;
+  first = (u32)((u64)(a - st->start) * HEAP_MAP_CELLS / span);
+  last = (u32)((u64)(b - 1 - st->start) * HEAP_MAP_CELLS / span);
+  for (c = first; c <= last && c < HEAP_MAP_CELLS; c++) {
+    uintptr_t lo = st->start + (uintptr_t)((u64)span * c / HEAP_MAP_CELLS);
+    uintptr_t hi = st->start + (uintptr_t)((u64)span * (c + 1) / HEAP_MAP_CELLS);
+    if (lo < a)
+      lo = a;
+    if (hi > b)
+      hi = b;
+    cell_used[c] += (u32)(hi - lo);
+  }
+}
+
+static void add_free_run(heap_region_stats *st, u32 *run) {
+  if (*run > st->largest_free)
+    st->largest_free = *run;
+  *run = 0;
+}
+
+/* One walk: the stats, the map counts and the free run in progress */
+typedef struct {
+  heap_region_stats *st;
+  u32 cell_used[HEAP_MAP_CELLS];
+  u32 run;
+} walk_state;
+
+/* Account [a, a + size) as one used or free chunk, in address order */
+static void walk_span(uintptr_t a, u32 size, bool used, void *ctx) {
+  walk_state *w = (walk_state *)ctx;
+
+  if (used) {
+    w->st->used_bytes += size;
+    w->st->used_chunks++;
+    add_free_run(w->st, &w->run);
+  } else {
+    w->st->free_bytes += size;
+    w->st->free_chunks++;
+    w->run += size;
+  }
+  map_span(w->cell_used, w->st, a, a + size, used);
+}
+
+static void finish_stats(heap_region_stats *st) {
+  if (st->free_bytes > 0)
+    st->frag_pct = (int)(100 - (u64)st->largest_free * 100 / st->free_bytes);
+  else
+    st->frag_pct = 0;
+}
+
+/* Close the last free run and render the map */
+static void finish_walk(walk_state *w, char *cells) {
+  heap_region_stats *st = w->st;
+  uintptr_t span = st->end - st->start;
+  int c;
+
+  add_free_run(st, &w->run);
+  finish_stats(st);
+  if (!cells)
+    return;
+  for (c = 0; c < HEAP_MAP_CELLS; c++) {
+    u32 cell = (u32)((u64)span * (c + 1) / HEAP_MAP_CELLS -
+                     (u64)span * c / HEAP_MAP_CELLS);
+    if (w->cell_used[c] == 0)
+      cells[c] = '.';
+    else if (w->cell_used[c] >= cell)
+      cells[c] = '#';
+    else
+      cells[c] = ':';
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+static bool find_heap(uintptr_t *first, uintptr_t *heap_end, u32 *tail) {
+#ifdef WIIMEDIC_HOST
+  struct mallinfo2 mi = mallinfo2();
+  uintptr_t brk_end = (uintptr_t)sbrk(0);
+
+  if (mi.arena == 0)
+    return false;
+  *first = (brk_end - mi.arena + CHUNK_ALIGN - 1) & ~(CHUNK_ALIGN - 1);
+  *heap_end = brk_end;
+  *tail = 0;
+#else
+  uintptr_t top = NEWLIB_TOP;
+  uintptr_t arena_lo = (uintptr_t)SYS_GetArena1Lo();
+  uintptr_t arena_hi = (uintptr_t)SYS_GetArena1Hi();
+
+  if (__malloc_sbrk_base == (char *)-1 || top == 0)
+    return false;
+  *first = ((uintptr_t)__malloc_sbrk_base + CHUNK_HDR + CHUNK_ALIGN - 1) &
+               ~(CHUNK_ALIGN - 1);
+  *first -= CHUNK_HDR;
+  *heap_end = top + chunk_size_at(top);
+  *tail = (*heap_end == arena_lo && arena_hi > arena_lo)
+              ? (u32)(arena_hi - arena_lo)
+              : 0;
+#endif
+  return *heap_end > *first;
+}
+
+bool heap_map_walk_mem1(heap_region_stats *st, char *cells) {
+  static walk_state w;
+  uintptr_t p, heap_end;
+
+  memset(st, 0, sizeof(*st));
+  memset(&w, 0, sizeof(w));
+  w.st = st;
+
+  /* Hold malloc still: a worker thread allocating mid-walk would move top
+     and split chunks under us */
+  HEAP_LOCK();
+  if (!find_heap(&st->start, &heap_end, &st->tail_free)) {
+    HEAP_UNLOCK();
+    return false;
+  }
+  st->end = heap_end + st->tail_free;
+
+  p = st->start;
+  while (p < heap_end) {
+    size_t size = chunk_size_at(p);
+    uintptr_t next = p + size;
+
+    if (size < CHUNK_MIN || next > heap_end || next < p)
+      break;
+
+    /* The top chunk has no successor and is free by definition */
+    walk_span(p, (u32)size, next < heap_end && prev_inuse_at(next), &w);
+    p = next;
+  }
+  HEAP_UNLOCK();
+  st->walk_ok = (p == heap_end);
+
+  /* Arena tail continues the top chunk's free run */
+  st->free_bytes += st->tail_free;
+  w.run += st->tail_free;
+  finish_walk(&w, cells);
+  return true;
+}
+
+bool heap_map_walk_mem2(heap_region_stats *st, char *cells) {
+  static walk_state w;
+  io_arena_stats io;
+  uintptr_t lo, hi, io_base;
+
+  memset(st, 0, sizeof(*st));
+  memset(&w, 0, sizeof(w));
+  w.st = st;
+
+  /* The I/O arena is carved from the top of the free arena */
+  io_arena_get_stats(&io);
+  io_base = io.base;
+#ifdef WIIMEDIC_HOST
+  /* No MEM2 here: the arena's free size stands just below the I/O arena */
+  hi = io_base;
+  lo = hi - SYS_GetArena2Size();
+#else
+  lo = (uintptr_t)SYS_GetArena2Lo();
+  hi = (uintptr_t)SYS_GetArena2Hi();
+#endif
+  st->start = lo;
+  st->end = io_base ? io_base + io.arena_size : hi;
+  st->tail_free = (u32)(hi - lo);
+  st->walk_ok = true;
+
+  walk_span(lo, st->tail_free, false, &w);
+  if (io_base) {
+    /* Whoever lowered the arena after us (libogc's network buffers) */
+    if (io_base > hi)
+      walk_span(hi, (u32)(io_base - hi), true, &w);
+    io_arena_walk(walk_span, &w);
+  }
+  finish_walk(&w, cells);
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+static void draw_region(const char *name, const heap_region_stats *st) {
+  char key[32];
+  char buf[64];
+
+  snprintf(key, sizeof(key), "%s Free", name);
+  snprintf(buf, sizeof(buf), "%u KB in %u chunk(s)", st->free_bytes / 1024,
+           st->free_chunks);
+  ui_draw_kv(key, buf);
+
+  snprintf(key, sizeof(key), "%s Largest Free", name);
+  snprintf(buf, sizeof(buf), "%u KB", st->largest_free / 1024);
+  ui_draw_kv(key, buf);
+
+  snprintf(key, sizeof(key), "%s Fragmentation", name);
+  snprintf(buf, sizeof(buf), "%d%%", st->frag_pct);
+  ui_draw_kv(key, buf);
+}
+
+static void draw_map(const heap_region_stats *st, const char *cells) {
+  int r;
+
+  ui_printf(UI_WHITE "   Block map (%u KB/cell, # used . free : mixed)\n",
+            (u32)((st->end - st->start) / HEAP_MAP_CELLS + 1023) / 1024);
+  for (r = 0; r < HEAP_MAP_ROWS; r++)
+    ui_printf(UI_CYAN "   |%.*s|\n" UI_RESET, HEAP_MAP_COLS,
+              cells + r * HEAP_MAP_COLS);
+}
+
+void heap_map_draw(void) {
+  heap_region_stats mem1, mem2;
+  char cells[HEAP_MAP_CELLS];
+  char buf[64];
+
+  ui_draw_section("Heap Fragmentation");
+
+  if (!heap_map_walk_mem1(&mem1, cells)) {
+    ui_draw_warn("MEM1 heap not found (nothing allocated yet?)");
+  } else {
+    snprintf(buf, sizeof(buf), "%u KB used in %u chunk(s)",
+             mem1.used_bytes / 1024, mem1.used_chunks);
+    ui_draw_kv("MEM1 Heap", buf);
+    draw_region("MEM1", &mem1);
+    if (!mem1.walk_ok)
+      ui_draw_warn("MEM1 heap walk stopped at an unreadable chunk");
+
+    draw_map(&mem1, cells);
+  }
+
+  heap_map_walk_mem2(&mem2, cells);
+  snprintf(buf, sizeof(buf), "%u KB used in %u block(s)",
+           mem2.used_bytes / 1024, mem2.used_chunks);
+  ui_draw_kv("MEM2 Arena", buf);
+  draw_region("MEM2", &mem2);
+  draw_map(&mem2, cells);
+}
@@ -0,0 +1,42 @@
+/*
+ * WiiMedic - heap_map.h
+ * MEM1/MEM2 heap walker: free/used chunks, largest free block, block map
+ */
+#ifndef HEAP_MAP_H
+#define HEAP_MAP_H
+
+#include <gccore.h>
+
+// Cells in the rendered block map (HEAP_MAP_ROWS lines of HEAP_MAP_COLS)
+#define HEAP_MAP_COLS 48
+#define HEAP_MAP_ROWS 4
+#define HEAP_MAP_CELLS (HEAP_MAP_COLS * HEAP_MAP_ROWS)
+
+typedef struct {
+  uintptr_t start;  // first chunk of the region
+  uintptr_t end;    // end of the region, including any arena tail
+  u32 used_bytes;   // chunk bytes (headers included) in use
+  u32 free_bytes;   // free chunk bytes plus the arena tail
+  u32 used_chunks;
+  u32 free_chunks;
+  u32 largest_free; // largest contiguous free run
+  u32 tail_free;    // unclaimed arena (MEM1: directly above the heap)
+  int frag_pct;     // 100 * (1 - largest_free / free_bytes)
+  bool walk_ok;     // false if the walk hit a chunk it could not parse
+} heap_region_stats;
+
+// Walk the malloc heap in MEM1 (the host allocator's main heap on host
+// builds). If cells is not NULL it receives HEAP_MAP_CELLS map characters:
+// '#' used, '.' free, ':' mixed. Returns false if no heap could be found.
+bool heap_map_walk_mem1(heap_region_stats *st, char *cells);
+
+// MEM2 has no malloc heap: walk the free arena, then WiiMedic's I/O arena
+// (io_arena.h) pool block by pool block, with the scratch stack as one
+// used span. Memory libogc took from between the two counts as used.
+// tail_free is the free arena; cells as above. Always returns true.
+bool heap_map_walk_mem2(heap_region_stats *st, char *cells);
+
+// Draw both regions and their block maps into the scroll view
+void heap_map_draw(void);
+
+#endif // HEAP_MAP_H
@@ -0,0 +1,548 @@
+/*
+ * WiiMedic - history.c
+ * Append-only metrics history. Records have one fixed size, so an append
+ * is a seek to the end and one write, record n is found by arithmetic, and
+ * a range of runs comes in with one fread per chunk. The trend screen
+ * compares the last few runs of this console against the ones before with
+ * Welch's t-test and only warns when the difference is both significant
+ * and large enough to matter.
+ */
+
+#include <gccore.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "history.h"
+#include "controller_test.h"
+#include "ios_check.h"
+#include "modules.h"
+#include "nand_health.h"
+#include "network_test.h"
+#include "startup.h"
+#include "storage_test.h"
+#include "system_info.h"
+#include "trace.h"
+#include "ui_common.h"
+
+#define HIST_RECORD_MAX 256 /* largest record size a reader accepts */
+#define HIST_CHUNK 4096     /* bytes per fread of a range */
+#define HIST_SCAN 256       /* most records the trend screen reads */
+#define HIST_WINDOW_DAYS 30 /* trend screen: days back from the newest run */
+#define HIST_SPARK 40       /* runs drawn per sparkline */
+#define HIST_RECENT 3       /* runs compared against the ones before */
+#define HIST_BASELINE_MIN 5 /* runs needed before that comparison */
+#define HIST_MIN_CHANGE 0.10 /* smaller changes are never flagged */
+#define HIST_WINDOW_MIN (HIST_BASELINE_MIN + HIST_RECENT) /* runs shown */
+
+static const u8 s_magic[4] = {'W', 'M', 'H', 'S'};
+static const char s_levels[] = "_.:-=+*#";
+
+static FILE *s_fp = NULL;
+static u32 s_record_size = HISTORY_RECORD;
+static int s_count = 0;
+
+/* This console's runs, oldest first, for the trend screen */
+static hist_record s_runs[HIST_SCAN];
+
+/*---------------------------------------------------------------------------*/
+static void put_be16(u8 *p, u16 v) {
+  p[0] = (u8)(v >> 8);
+  p[1] = (u8)v;
+}
+
+static void put_be32(u8 *p, u32 v) {
+  p[0] = (u8)(v >> 24);
+  p[1] = (u8)(v >> 16);
+  p[2] = (u8)(v >> 8);
+  p[3] = (u8)v;
+}
+
+static u16 get_be16(const u8 *p) { return (u16)(p[0] << 8 | p[1]); }
+
+static u32 get_be32(const u8 *p) {
+  return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+/* Record layout; bytes 26-27 and 49-63 are zero */
+static void pack(u8 *p, const hist_record *r) {
+  memset(p, 0, HISTORY_RECORD);
+  put_be32(p + 0, r->time);
+  put_be32(p + 4, r->device_id);
+  put_be32(p + 8, r->valid);
+  put_be32(p + 12, r->nand_clusters);
+  put_be32(p + 16, r->nand_inodes);
+  put_be16(p + 20, r->ios_total);
+  put_be16(p + 22, r->ios_stubs);
+  put_be16(p + 24, r->ios_cios);
+  put_be32(p + 28, r->sd_read_kbs);
+  put_be32(p + 32, r->sd_write_kbs);
+  put_be32(p + 36, r->usb_read_kbs);
+  put_be32(p + 40, r->usb_write_kbs);
+  put_be32(p + 44, r->rtt_ms);
+  p[48] = r->battery_pct;
+}
+
+static void unpack(const u8 *p, hist_record *r) {
+  r->time = get_be32(p + 0);
+  r->device_id = get_be32(p + 4);
+  r->valid = get_be32(p + 8);
+  r->nand_clusters = get_be32(p + 12);
+  r->nand_inodes = get_be32(p + 16);
+  r->ios_total = get_be16(p + 20);
+  r->ios_stubs = get_be16(p + 22);
+  r->ios_cios = get_be16(p + 24);
+  r->sd_read_kbs = get_be32(p + 28);
+  r->sd_write_kbs = get_be32(p + 32);
+  r->usb_read_kbs = get_be32(p + 36);
+  r->usb_write_kbs = get_be32(p + 40);
+  r->rtt_ms = get_be32(p + 44);
+  r->battery_pct = p[48];
+}
+
+/* Check the header of an open file; its record size goes to *size */
+static bool read_header(FILE *fp, u32 *size) {
+  u8 head[HISTORY_HEADER];
+
+  if (fread(head, 1, sizeof(head), fp) != sizeof(head) ||
+      memcmp(head, s_magic, sizeof(s_magic)) != 0)
+    return false;
+  *size = get_be16(head + 6);
+  return *size >= HISTORY_RECORD && *size <= HIST_RECORD_MAX;
+}
+
+/* Whole records after the header */
+static int record_count(FILE *fp, u32 size) {
+  long end;
+
+  if (fseek(fp, 0, SEEK_END) != 0 || (end = ftell(fp)) < HISTORY_HEADER)
+    return 0;
+  return (int)((end - HISTORY_HEADER) / size);
+}
+
+/*---------------------------------------------------------------------------*/
+void history_capture(u32 mask, hist_record *r) {
+  const sysinfo_result *si = get_system_info_result();
+  storage_speeds speeds;
+  int total, stubs, cios, battery;
+
+  memset(r, 0, sizeof(*r));
+  if (!si->valid)
+    collect_system_info();
+  r->time = (u32)time(NULL);
+  r->device_id = si->device_id;
+  r->battery_pct = 0xFF;
+
+  if ((mask & MODULE_BIT(MODULE_NAND)) &&
+      nand_health_get_usage(&r->nand_clusters, &r->nand_inodes))
+    r->valid |= HIST_V_NAND;
+  if ((mask & MODULE_BIT(MODULE_IOS)) &&
+      ios_check_get_counts(&total, &stubs, &cios)) {
+    r->ios_total = (u16)total;
+    r->ios_stubs = (u16)stubs;
+    r->ios_cios = (u16)cios;
+    r->valid |= HIST_V_IOS;
+  }
+  if (mask & MODULE_BIT(MODULE_STORAGE)) {
+    storage_test_get_speeds(&speeds);
+    r->sd_read_kbs = speeds.sd_read_kbs;
+    r->sd_write_kbs = speeds.sd_write_kbs;
+    r->usb_read_kbs = speeds.usb_read_kbs;
+    r->usb_write_kbs = speeds.usb_write_kbs;
+    r->valid |= HIST_V_STORAGE;
+  }
+  if (mask & MODULE_BIT(MODULE_NETWORK)) {
+    r->rtt_ms = network_test_get_rtt();
+    r->valid |= HIST_V_NETWORK;
+  }
+  if (mask & MODULE_BIT(MODULE_CONTROLLER)) {
+    battery = controller_test_lowest_battery();
+    if (battery >= 0)
+      r->battery_pct = (u8)battery;
+    r->valid |= HIST_V_CONTROLLER;
+  }
+}
+
+/* A file that exists but is not a history is left alone */
+static bool append_to(const char *path, const hist_record *r) {
+  u8 rec[HIST_RECORD_MAX];
+  FILE *fp = TRACE_CALL("fopen", fopen(path, "r+b"));
+  u32 size = HISTORY_RECORD;
+  bool ok;
+  int n;
+
+  if (fp) {
+    if (!read_header(fp, &size)) {
+      TRACE_CALL("fclose", fclose(fp));
+      return false;
+    }
+    n = record_count(fp, size);
+  } else {
+    u8 head[HISTORY_HEADER] = {0};
+
+    fp = TRACE_CALL("fopen", fopen(path, "wb"));
+    if (!fp)
+      return false;
+    memcpy(head, s_magic, sizeof(s_magic));
+    put_be16(head + 4, HISTORY_VERSION);
+    put_be16(head + 6, HISTORY_RECORD);
+    if (fwrite(head, 1, sizeof(head), fp) != sizeof(head)) {
+      TRACE_CALL("fclose", fclose(fp));
+      return false;
+    }
+    n = 0;
+  }
+
+  /* Newer versions may use longer records: the tail stays zero */
+  memset(rec, 0, size);
+  pack(rec, r);
+  ok = fseek(fp, HISTORY_HEADER + (long)n * size, SEEK_SET) == 0 &&
+       TRACE_CALL("fwrite", fwrite(rec, 1, size, fp)) == size;
+  if (TRACE_CALL("fclose", fclose(fp)) != 0)
+    ok = false;
+  return ok;
+}
+
+bool history_append(const hist_record *r) {
+  return append_to(HISTORY_PATH_SD, r) || append_to(HISTORY_PATH_USB, r);
+}
+
+/*---------------------------------------------------------------------------*/
+int history_open(void) {
+  static const char *const paths[2] = {HISTORY_PATH_SD, HISTORY_PATH_USB};
+  int i;
+
+  history_close();
+  for (i = 0; i < 2; i++) {
+    s_fp = TRACE_CALL("fopen", fopen(paths[i], "rb"));
+    if (!s_fp)
+      continue;
+    if (read_header(s_fp, &s_record_size)) {
+      s_count = record_count(s_fp, s_record_size);
+      return s_count;
+    }
+    history_close();
+  }
+  return -1;
+}
+
+int history_read(int first, int count, hist_record *out) {
+  u8 buf[HIST_CHUNK];
+  int per_chunk = (int)(sizeof(buf) / s_record_size);
+  int done = 0;
+
+  if (!s_fp || first < 0 || first >= s_count)
+    return 0;
+  if (count > s_count - first)
+    count = s_count - first;
+  if (fseek(s_fp, HISTORY_HEADER + (long)first * s_record_size, SEEK_SET))
+    return 0;
+  while (done < count) {
+    int want = count - done < per_chunk ? count - done : per_chunk;
+    int got = (int)fread(buf, s_record_size, want, s_fp);
+    int i;
+
+    for (i = 0; i < got; i++)
+      unpack(buf + i * s_record_size, &out[done + i]);
+    done += got;
+    if (got < want)
+      break;
+  }
+  return done;
+}
+
+int history_find(u32 time) {
+  int lo = 0, hi = s_count;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    u8 stamp[4];
+
+    if (fseek(s_fp, HISTORY_HEADER + (long)mid * s_record_size, SEEK_SET) ||
+        fread(stamp, 1, sizeof(stamp), s_fp) != sizeof(stamp))
+      break;
+    if (get_be32(stamp) < time)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+void history_close(void) {
+  if (s_fp)
+    TRACE_CALL("fclose", fclose(s_fp));
+  s_fp = NULL;
+  s_count = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Trend screen metrics */
+typedef enum {
+  MET_NAND_CLUSTERS,
+  MET_NAND_INODES,
+  MET_SD_READ,
+  MET_SD_WRITE,
+  MET_USB_READ,
+  MET_USB_WRITE,
+  MET_RTT,
+  MET_BATTERY,
+  MET_IOS_STUBS,
+  MET_COUNT
+} hist_metric;
+
+typedef struct {
+  const char *label;
+  const char *unit;
+  int worse; /* +1: higher is worse, -1: lower is worse, 0: not judged */
+} metric_info;
+
+static const metric_info s_metrics[MET_COUNT] = {
+    [MET_NAND_CLUSTERS] = {"NAND clusters", "used", 1},
+    [MET_NAND_INODES] = {"NAND inodes", "used", 1},
+    [MET_SD_READ] = {"SD read", "KB/s", -1},
+    [MET_SD_WRITE] = {"SD write", "KB/s", -1},
+    [MET_USB_READ] = {"USB read", "KB/s", -1},
+    [MET_USB_WRITE] = {"USB write", "KB/s", -1},
+    [MET_RTT] = {"Connect time", "ms", 1},
+    [MET_BATTERY] = {"Remote battery", "%", -1},
+    [MET_IOS_STUBS] = {"IOS stubs", "", 0},
+};
+
+/* A run's value of metric m; false if the run did not measure it */
+static bool metric_value(hist_metric m, const hist_record *r, u32 *v) {
+  switch (m) {
+  case MET_NAND_CLUSTERS:
+    *v = r->nand_clusters;
+    return (r->valid & HIST_V_NAND) != 0;
+  case MET_NAND_INODES:
+    *v = r->nand_inodes;
+    return (r->valid & HIST_V_NAND) != 0;
+  case MET_SD_READ:
+    *v = r->sd_read_kbs;
+    break;
+  case MET_SD_WRITE:
+    *v = r->sd_write_kbs;
+    break;
+  case MET_USB_READ:
+    *v = r->usb_read_kbs;
+    break;
+  case MET_USB_WRITE:
+    *v = r->usb_write_kbs;
+    break;
+  case MET_RTT:
+    *v = r->rtt_ms;
+    break;
+  case MET_BATTERY:
+    *v = r->battery_pct;
+    return r->battery_pct != 0xFF;
+  case MET_IOS_STUBS:
+    *v = r->ios_stubs;
+    return (r->valid & HIST_V_IOS) != 0;
+  default:
+    return false;
+  }
+  return *v != 0; /* speeds and connect time: 0 = not measured */
+}
+
+/* Two-sided 5% critical value of Student's t, rounded down to a tabulated
+   degrees of freedom so the test errs towards not flagging */
+static double t_critical(double df) {
+  static const double table[10] = {12.71, 4.30, 3.18, 2.78, 2.57,
+                                   2.45,  2.36, 2.31, 2.26, 2.23};
+
+  if (df < 1.0)
+    return table[0];
+  if (df < 11.0)
+    return table[(int)df - 1];
+  if (df < 21.0)
+    return 2.20;
+  if (df < 31.0)
+    return 2.08;
+  return 2.04;
+}
+
+static void mean_var(const u32 *v, int n, double *mean, double *var) {
+  double sum = 0.0, sq = 0.0;
+  int i;
+
+  for (i = 0; i < n; i++)
+    sum += v[i];
+  *mean = sum / n;
+  for (i = 0; i < n; i++)
+    sq += (v[i] - *mean) * (v[i] - *mean);
+  *var = n > 1 ? sq / (n - 1) : 0.0;
+}
+
+/* Welch's t-test of the last HIST_RECENT values against the rest. True if
+   they moved the worse way by at least HIST_MIN_CHANGE, significantly. */
+static bool regressed(const u32 *v, int n, int worse, double *before,
+                      double *after, double *t) {
+  int nb = n - HIST_RECENT;
+  double vb, va, sb, sa, se2, df, den;
+
+  if (!worse || nb < HIST_BASELINE_MIN)
+    return false;
+  mean_var(v, nb, before, &vb);
+  mean_var(v + nb, HIST_RECENT, after, &va);
+  if ((*after - *before) * worse <= 0.0 ||
+      fabs(*after - *before) < HIST_MIN_CHANGE * fmax(fabs(*before), 1.0))
+    return false;
+
+  sb = vb / nb;
+  sa = va / HIST_RECENT;
+  se2 = sb + sa;
+  if (se2 == 0.0) {
+    *t = INFINITY; /* every run identical on each side: a clean step */
+    return true;
+  }
+  *t = (*after - *before) / sqrt(se2);
+  den = sb * sb / (nb - 1) + sa * sa / (HIST_RECENT - 1);
+  df = den > 0.0 ? se2 * se2 / den : nb + HIST_RECENT - 2;
+  return fabs(*t) > t_critical(df);
+}
+
+/* Label, newest value and a sparkline of the newest HIST_SPARK values */
+static void draw_metric(const metric_info *info, const u32 *v, int n) {
+  char spark[HIST_SPARK + 1];
+  int first = n > HIST_SPARK ? n - HIST_SPARK : 0;
+  int top = (int)sizeof(s_levels) - 2;
+  u32 lo = v[first], hi = v[first];
+  int i;
+
+  for (i = first; i < n; i++) {
+    if (v[i] < lo)
+      lo = v[i];
+    if (v[i] > hi)
+      hi = v[i];
+  }
+  for (i = first; i < n; i++)
+    spark[i - first] = hi > lo ? s_levels[(u64)(v[i] - lo) * top / (hi - lo)]
+                               : s_levels[top / 2];
+  spark[n - first] = '\0';
+  ui_printf("   " UI_CYAN "%-14s" UI_RESET " " UI_BWHITE "%7u" UI_RESET
+            " %-4s " UI_BGREEN "%s\n" UI_RESET,
+            info->label, v[n - 1], info->unit, spark);
+  ui_printf("   " UI_WHITE "%-14s min %u, max %u over %d run(s)\n" UI_RESET,
+            "", lo, hi, n - first);
+}
+
+static void format_time(u32 t, char *buf, int size) {
+  time_t tt = (time_t)t;
+  struct tm *tm = gmtime(&tt);
+
+  if (!tm || !strftime(buf, size, "%Y-%m-%d %H:%M", tm))
+    snprintf(buf, size, "%u", t);
+}
+
+/*---------------------------------------------------------------------------*/
+void run_history_view(void) {
+  const sysinfo_result *si = get_system_info_result();
+  static u32 values[HIST_SCAN];
+  char buf[96], from[24], to[24];
+  int total, first, n, kept = 0, flagged = 0, i, m;
+  bool widened = false;
+  u32 device, since;
+
+  devices_wait(DEV_FAT);
+  total = history_open();
+  if (total <= 0) {
+    history_close();
+    ui_draw_info("No history yet: each full report adds one run to");
+    ui_draw_info(HISTORY_PATH_SD);
+    return;
+  }
+
+  /* The window: HIST_WINDOW_DAYS back from the newest run, widened to
+     enough runs for the regression test when the console was idle */
+  if (history_read(total - 1, 1, s_runs) != 1) {
+    history_close();
+    ui_draw_err("Could not read the history file");
+    return;
+  }
+  since = s_runs[0].time > HIST_WINDOW_DAYS * 86400u
+              ? s_runs[0].time - HIST_WINDOW_DAYS * 86400u
+              : 0;
+  first = history_find(since);
+  if (first > total - HIST_WINDOW_MIN) {
+    first = total > HIST_WINDOW_MIN ? total - HIST_WINDOW_MIN : 0;
+    widened = true;
+  }
+  if (first < total - HIST_SCAN)
+    first = total - HIST_SCAN;
+  n = history_read(first, total - first, s_runs);
+  history_close();
+  if (n == 0) {
+    ui_draw_err("Could not read the history file");
+    return;
+  }
+
+  /* Several consoles may share one card: keep this one's runs */
+  device = si->valid ? si->device_id : s_runs[n - 1].device_id;
+  for (i = 0; i < n; i++) {
+    if (s_runs[i].device_id == device)
+      s_runs[kept++] = s_runs[i];
+  }
+  if (kept == 0) {
+    device = s_runs[n - 1].device_id;
+    for (i = 0; i < n; i++) {
+      if (s_runs[i].device_id == device)
+        s_runs[kept++] = s_runs[i];
+    }
+  }
+
+  snprintf(buf, sizeof(buf), "%d (%d of console %u)", total, kept, device);
+  ui_draw_kv("Runs recorded", buf);
+  if (widened)
+    snprintf(buf, sizeof(buf), "last %d runs (fewer in %d days)",
+             total - first, HIST_WINDOW_DAYS);
+  else
+    snprintf(buf, sizeof(buf), "last %d days (%d runs)", HIST_WINDOW_DAYS,
+             total - first);
+  ui_draw_kv("Window", buf);
+  format_time(s_runs[0].time, from, sizeof(from));
+  format_time(s_runs[kept - 1].time, to, sizeof(to));
+  snprintf(buf, sizeof(buf), "%s to %s", from, to);
+  ui_draw_kv("Period", buf);
+  ui_printf("\n");
+
+  for (m = 0; m < MET_COUNT; m++) {
+    const metric_info *info = &s_metrics[m];
+    double before, after, t;
+    int count = 0;
+
+    for (i = 0; i < kept; i++) {
+      if (metric_value((hist_metric)m, &s_runs[i], &values[count]))
+        count++;
+    }
+    if (count == 0)
+      continue;
+    draw_metric(info, values, count);
+    if (regressed(values, count, info->worse, &before, &after, &t)) {
+      char stat[24];
+
+      if (isinf(t))
+        snprintf(stat, sizeof(stat), "step change");
+      else
+        snprintf(stat, sizeof(stat), "t = %.1f", t);
+      snprintf(buf, sizeof(buf), "%s %s: %.0f -> %.0f %s (%s)", info->label,
+               info->worse > 0 ? "rose" : "fell", before, after, info->unit,
+               stat);
+      ui_draw_err(buf);
+      flagged++;
+    }
+  }
+
+  ui_printf("\n");
+  if (flagged) {
+    snprintf(buf, sizeof(buf), "%d metric(s) got significantly worse over "
+             "the last %d runs", flagged, HIST_RECENT);
+    ui_draw_warn(buf);
+  } else {
+    ui_draw_ok("No significant regressions");
+  }
+  snprintf(buf, sizeof(buf), "Last %d runs vs the ones before (Welch t-test, "
+           "5%% level)", HIST_RECENT);
+  ui_draw_info(buf);
+}
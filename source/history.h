@@ -0,0 +1,72 @@
+/*
+ * WiiMedic - history.h
+ * Metrics history: one fixed-size record per report run, appended to a
+ * file on SD (USB without one), and a trend screen over it
+ */
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <gccore.h>
+
+#define HISTORY_PATH_SD "sd:/WiiMedic_History.bin"
+#define HISTORY_PATH_USB "usb:/WiiMedic_History.bin"
+
+// File layout, big-endian: a 16-byte header ("WMHS", u16 version, u16
+// record size, 8 bytes zero) then records back to back, oldest first.
+// Record n is at HISTORY_HEADER + n * record size; a torn last record is
+// ignored and overwritten by the next append.
+#define HISTORY_VERSION 1
+#define HISTORY_HEADER 16
+#define HISTORY_RECORD 64
+
+// hist_record.valid bits: which modules the run collected
+#define HIST_V_NAND (1u << 0)
+#define HIST_V_IOS (1u << 1)
+#define HIST_V_STORAGE (1u << 2)
+#define HIST_V_NETWORK (1u << 3)
+#define HIST_V_CONTROLLER (1u << 4)
+
+typedef struct {
+  u32 time; // seconds since 1970, console clock
+  u32 device_id;
+  u32 valid; // HIST_V_*
+  u32 nand_clusters;
+  u32 nand_inodes;
+  u16 ios_total;
+  u16 ios_stubs;
+  u16 ios_cios;
+  u32 sd_read_kbs; // 0 = no completed benchmark
+  u32 sd_write_kbs;
+  u32 usb_read_kbs;
+  u32 usb_write_kbs;
+  u32 rtt_ms;      // 0 = nothing connected
+  u8 battery_pct;  // lowest Wii Remote, 0xFF = none connected
+} hist_record;
+
+// Fill r from the results of the modules in mask (MODULE_BIT()s)
+void history_capture(u32 mask, hist_record *r);
+
+// Append r to the history on SD, else USB, creating the file if needed.
+// One seek and one write. Returns false if neither could be written.
+bool history_append(const hist_record *r);
+
+// Open the history for reading (SD first). Returns the number of records,
+// or -1 if there is none.
+int history_open(void);
+
+// Read count records from index first (0 = oldest) of the open history.
+// Returns the number read.
+int history_read(int first, int count, hist_record *out);
+
+// Index of the first record at or after time, by binary search (records
+// are in run order, which is time order unless the clock was set back)
+int history_find(u32 time);
+
+void history_close(void);
+
+// Trend screen: this console's runs of the last 30 days (found with
+// history_find) as sparklines, with a warning for each metric that got
+// significantly worse
+void run_history_view(void);
+
+#endif // HISTORY_H
@@ -0,0 +1,178 @@
+/*
+ * WiiMedic - io_arena.c
+ * One block of MEM2 is reserved for IPC/I/O buffers so per-title and per-run
+ * allocations never touch the MEM1 malloc heap. Pool blocks are carved
+ * upward from the bottom of the arena and recycled through per-class free
+ * lists; scratch allocations stack downward from the top. The two meet in
+ * the middle, so neither side needs a fixed share.
+ */
+
+#include <gccore.h>
+#include <malloc.h>
+#include <ogc/machine/processor.h>
+#include <string.h>
+
+#include "io_arena.h"
+
+/* Pool block header; one alignment unit so the payload stays aligned */
+typedef struct io_block {
+  struct io_block *next; /* free list link while free */
+  u32 cls;
+  u32 magic;
+  u8 pad[IO_ARENA_ALIGN - sizeof(void *) - 2 * sizeof(u32)];
+} io_block;
+
+#define IO_BLOCK_MAGIC 0x494F424B /* "IOBK" */
+#define IO_ALIGN_UP(x) (((x) + IO_ARENA_ALIGN - 1) & ~(IO_ARENA_ALIGN - 1))
+
+static const u32 s_class_size[IO_POOL_CLASSES] = {
+    64, 256, 1024, 4096, 16384, IO_POOL_MAX};
+
+static u8 *s_base = NULL; /* NULL until the arena is reserved */
+static bool s_init_failed = false;
+static u32 s_pool_top = 0;      /* offset of the first uncarved byte */
+static u32 s_scratch_low = 0;   /* offset of the lowest scratch byte */
+static io_block *s_free[IO_POOL_CLASSES];
+static io_arena_stats s_stats;
+
+/*---------------------------------------------------------------------------*/
+static bool arena_init(void) {
+  if (s_base)
+    return true;
+  if (s_init_failed)
+    return false;
+
+#ifdef WIIMEDIC_HOST
+  s_base = (u8 *)memalign(IO_ARENA_ALIGN, IO_ARENA_SIZE);
+#else
+  {
+    u32 level;
+    uintptr_t lo, hi;
+
+    /* Same as libogc's own MEM2 users: lower the arena's high mark */
+    _CPU_ISR_Disable(level);
+    lo = (uintptr_t)SYS_GetArena2Lo();
+    hi = (uintptr_t)SYS_GetArena2Hi() & ~(uintptr_t)(IO_ARENA_ALIGN - 1);
+    if (hi - lo >= IO_ARENA_SIZE) {
+      s_base = (u8 *)(hi - IO_ARENA_SIZE);
+      SYS_SetArena2Hi(s_base);
+    }
+    _CPU_ISR_Restore(level);
+  }
+#endif
+
+  if (!s_base) {
+    s_init_failed = true;
+    return false;
+  }
+
+  memcpy(s_stats.class_size, s_class_size, sizeof(s_class_size));
+  s_stats.arena_size = IO_ARENA_SIZE;
+  s_stats.base = (uintptr_t)s_base;
+  s_pool_top = 0;
+  s_scratch_low = IO_ARENA_SIZE;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+void *io_pool_alloc(u32 size) {
+  io_block *b;
+  u32 cls;
+
+  for (cls = 0; cls < IO_POOL_CLASSES; cls++) {
+    if (size <= s_class_size[cls])
+      break;
+  }
+  if (cls == IO_POOL_CLASSES || !arena_init()) {
+    s_stats.pool_failures++;
+    return NULL;
+  }
+
+  b = s_free[cls];
+  if (b) {
+    s_free[cls] = b->next;
+    s_stats.pool_reuses++;
+  } else {
+    u32 need = sizeof(io_block) + s_class_size[cls];
+    if (s_pool_top + need > s_scratch_low) {
+      s_stats.pool_failures++;
+      return NULL;
+    }
+    b = (io_block *)(s_base + s_pool_top);
+    b->cls = cls;
+    s_pool_top += need;
+    s_stats.pool_carved += need;
+    s_stats.class_blocks[cls]++;
+  }
+
+  b->magic = IO_BLOCK_MAGIC;
+  b->next = NULL;
+  s_stats.class_in_use[cls]++;
+  s_stats.pool_allocs++;
+  return b + 1;
+}
+
+void io_pool_free(void *ptr) {
+  io_block *b;
+
+  if (!ptr)
+    return;
+  b = (io_block *)ptr - 1;
+  if (b->magic != IO_BLOCK_MAGIC || b->cls >= IO_POOL_CLASSES)
+    return; /* double free or not a pool block */
+
+  b->magic = 0;
+  b->next = s_free[b->cls];
+  s_free[b->cls] = b;
+  s_stats.class_in_use[b->cls]--;
+}
+
+/*---------------------------------------------------------------------------*/
+void *io_scratch_alloc(u32 size) {
+  u32 need = IO_ALIGN_UP(size);
+
+  if (!arena_init() || need > s_scratch_low - s_pool_top) {
+    s_stats.scratch_failures++;
+    return NULL;
+  }
+
+  s_scratch_low -= need;
+  s_stats.scratch_used = IO_ARENA_SIZE - s_scratch_low;
+  if (s_stats.scratch_used > s_stats.scratch_peak)
+    s_stats.scratch_peak = s_stats.scratch_used;
+  return s_base + s_scratch_low;
+}
+
+u32 io_scratch_mark(void) { return s_stats.scratch_used; }
+
+void io_scratch_release(u32 mark) {
+  if (!s_base || mark > s_stats.scratch_used)
+    return;
+  s_scratch_low = IO_ARENA_SIZE - mark;
+  s_stats.scratch_used = mark;
+}
+
+void io_scratch_reset(void) { io_scratch_release(0); }
+
+void io_arena_get_stats(io_arena_stats *out) { *out = s_stats; }
+
+bool io_arena_walk(io_arena_visit visit, void *ctx) {
+  u32 off = 0;
+
+  if (!s_base)
+    return false;
+  while (off < s_pool_top) {
+    const io_block *b = (const io_block *)(s_base + off);
+    u32 size = sizeof(io_block) + s_class_size[b->cls];
+
+    visit((uintptr_t)b, size, b->magic == IO_BLOCK_MAGIC, ctx);
+    off += size;
+  }
+  if (s_scratch_low > s_pool_top)
+    visit((uintptr_t)(s_base + s_pool_top), s_scratch_low - s_pool_top, false,
+          ctx);
+  if (s_scratch_low < IO_ARENA_SIZE)
+    visit((uintptr_t)(s_base + s_scratch_low), IO_ARENA_SIZE - s_scratch_low,
+          true, ctx);
+  return true;
+}
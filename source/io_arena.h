@@ -0,0 +1,59 @@
+/*
+ * WiiMedic - io_arena.h
+ * 32-byte aligned MEM2 arena for IPC and I/O buffers: size-class pools for
+ * buffers handed to IOS (TMDs, ISFS paths) and a per-run scratch stack
+ */
+#ifndef IO_ARENA_H
+#define IO_ARENA_H
+
+#include <gccore.h>
+
+// Carved from the top of the MEM2 arena on first use
+#define IO_ARENA_SIZE (256 * 1024)
+#define IO_ARENA_ALIGN 32
+
+// Pool size classes; requests are rounded up to the next class
+#define IO_POOL_CLASSES 6
+#define IO_POOL_MAX (64 * 1024)
+
+typedef struct {
+  u32 arena_size;                  // bytes reserved in MEM2 (0 = unavailable)
+  uintptr_t base;                  // where they start
+  u32 pool_carved;                 // bytes given to pool blocks so far
+  u32 class_size[IO_POOL_CLASSES]; // payload size of each class
+  u32 class_blocks[IO_POOL_CLASSES];
+  u32 class_in_use[IO_POOL_CLASSES];
+  u32 pool_allocs;   // io_pool_alloc calls that succeeded
+  u32 pool_reuses;   // ... served from a free list without carving
+  u32 pool_failures; // too large, or the arena is full
+  u32 scratch_used;  // current scratch stack depth in bytes
+  u32 scratch_peak;
+  u32 scratch_failures;
+} io_arena_stats;
+
+// Pooled buffer of at least size bytes, 32-byte aligned. Freed blocks go
+// back on their class free list; the arena itself never shrinks.
+// Returns NULL if size > IO_POOL_MAX or the arena is exhausted.
+void *io_pool_alloc(u32 size);
+void io_pool_free(void *ptr);
+
+// Scratch stack for buffers that live for one module run:
+//   u32 mark = io_scratch_mark(); ... io_scratch_alloc() ...
+//   io_scratch_release(mark);
+void *io_scratch_alloc(u32 size);
+u32 io_scratch_mark(void);
+void io_scratch_release(u32 mark);
+
+// Drop all scratch allocations (called when a module screen ends)
+void io_scratch_reset(void);
+
+void io_arena_get_stats(io_arena_stats *out);
+
+// Call visit for each span of the arena in address order: pool blocks
+// (header included), the uncarved middle, then the scratch stack. Returns
+// false, visiting nothing, if the arena has not been reserved.
+typedef void (*io_arena_visit)(uintptr_t start, u32 size, bool used,
+                               void *ctx);
+bool io_arena_walk(io_arena_visit visit, void *ctx);
+
+#endif // IO_ARENA_H
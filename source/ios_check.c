@@ -9,10 +9,14 @@
 #include <malloc.h>
 #include <gccore.h>
 
+#include "io_arena.h"
 #include "ios_check.h"
+#include "results.h"
+#include "task.h"
+#include "trace.h"
 #include "ui_common.h"
 
-#define MAX_REPORT 8192
+#define MAX_IOS 253 /* slots 3-255 */
 
 /*---------------------------------------------------------------------------*/
 static bool is_known_stub_revision(u32 slot, u32 revision) {
@@ -54,8 +58,15 @@ static const char* get_ios_description(u32 slot) {
     }
 }
 
-/* Report state */
-static char s_report[MAX_REPORT];
+/* Report state: one row per installed IOS, in title list order */
+typedef struct {
+    u32 slot;
+    u32 revision;
+    const char *status;
+} ios_row;
+
+static ios_row s_rows[MAX_IOS];
+static bool s_scanned = false; /* the title list was read */
 static int  s_total_ios = 0;
 static int  s_stub_count = 0;
 static int  s_cios_count = 0;
@@ -65,12 +76,13 @@ void run_ios_check(void) {
     u32 title_count = 0;
     s32 ret;
     u32 i;
-    int rpos = 0;
+    u32 scratch = io_scratch_mark();
 
     ui_draw_info("Scanning installed IOS versions...");
     ui_printf("\n");
+    s_scanned = false;
 
-    ret = ES_GetNumTitles(&title_count);
+    ret = TRACE_CALL("ES_GetNumTitles", ES_GetNumTitles(&title_count));
     if (ret < 0 || title_count == 0) {
         char msg[64];
         snprintf(msg, sizeof(msg), "Failed to enumerate titles (error %d)", ret);
@@ -78,18 +90,18 @@ void run_ios_check(void) {
         return;
     }
 
-    u64 *title_list = (u64*)memalign(32, title_count * sizeof(u64));
+    u64 *title_list = (u64*)io_scratch_alloc(title_count * sizeof(u64));
     if (!title_list) {
         ui_draw_err("Memory allocation failed");
         return;
     }
 
-    ret = ES_GetTitles(title_list, title_count);
+    ret = TRACE_CALL("ES_GetTitles", ES_GetTitles(title_list, title_count));
     if (ret < 0) {
         char msg[64];
         snprintf(msg, sizeof(msg), "Failed to get title list (error %d)", ret);
         ui_draw_err(msg);
-        free(title_list);
+        io_scratch_release(scratch);
         return;
     }
 
@@ -102,21 +114,25 @@ void run_ios_check(void) {
     s_stub_count = 0;
     s_cios_count = 0;
 
-    memset(s_report, 0, sizeof(s_report));
-    rpos = snprintf(s_report, MAX_REPORT,
-        "=== IOS INSTALLATION SCAN ===\n"
-        "%-8s %-12s %-10s %s\n"
-        "-------- ------------ ---------- ----------------------------\n",
-        "IOS", "Revision", "Status", "Notes");
+    s_scanned = true;
 
-    /* Scan IOS titles */
+    /* Scan IOS titles; each TMD read is a point where a cancel lands */
     for (i = 0; i < title_count; i++) {
+        if (task_cancelled()) {
+            s_scanned = false;
+            io_scratch_release(scratch);
+            ui_printf("\n");
+            ui_draw_warn("IOS scan cancelled");
+            return;
+        }
+
         u32 title_upper = (u32)(title_list[i] >> 32);
         u32 title_lower = (u32)(title_list[i] & 0xFFFFFFFF);
 
         if (title_upper != 1) continue;
         if (title_lower < 3 || title_lower > 255) continue;
         if (title_lower == 0x100 || title_lower == 0x101) continue;
+        if (s_total_ios == MAX_IOS) break;
 
         s_total_ios++;
 
@@ -125,11 +141,13 @@ void run_ios_check(void) {
         u32 revision = 0;
         bool is_stub = false;
 
-        ret = ES_GetStoredTMDSize(title_list[i], &tmd_size);
+        ret = TRACE_CALL("ES_GetStoredTMDSize",
+                         ES_GetStoredTMDSize(title_list[i], &tmd_size));
         if (ret >= 0 && tmd_size > 0) {
-            signed_blob *tmd_buf = (signed_blob*)memalign(32, tmd_size);
+            signed_blob *tmd_buf = (signed_blob*)io_pool_alloc(tmd_size);
             if (tmd_buf) {
-                ret = ES_GetStoredTMD(title_list[i], tmd_buf, tmd_size);
+                ret = TRACE_CALL("ES_GetStoredTMD",
+                                 ES_GetStoredTMD(title_list[i], tmd_buf, tmd_size));
                 if (ret >= 0) {
                     tmd *t = SIGNATURE_PAYLOAD(tmd_buf);
                     revision = t->title_version;
@@ -137,7 +155,7 @@ void run_ios_check(void) {
                         is_known_stub_revision(title_lower, revision))
                         is_stub = true;
                 }
-                free(tmd_buf);
+                io_pool_free(tmd_buf);
             }
         }
 
@@ -165,12 +183,12 @@ void run_ios_check(void) {
         ui_printf("   %sIOS%-4u  rev %-8u %-10s" UI_WHITE " %s\n" UI_RESET,
                color, title_lower, revision, status, desc);
 
-        rpos += snprintf(s_report + rpos, MAX_REPORT - rpos,
-            "IOS%-4u  rev %-8u %-10s %s\n",
-            title_lower, revision, status, desc);
+        s_rows[s_total_ios - 1].slot = title_lower;
+        s_rows[s_total_ios - 1].revision = revision;
+        s_rows[s_total_ios - 1].status = status;
     }
 
-    free(title_list);
+    io_scratch_release(scratch);
 
     /* Summary */
     ui_draw_section("Summary");
@@ -195,10 +213,6 @@ void run_ios_check(void) {
         }
     }
 
-    rpos += snprintf(s_report + rpos, MAX_REPORT - rpos,
-        "\nTotal IOS: %d | Active: %d | Stubs: %d | cIOS: %d\n\n",
-        s_total_ios, s_total_ios - s_stub_count, s_stub_count, s_cios_count);
-
     /* Recommendations */
     ui_printf("\n");
     if (s_cios_count > 0) {
@@ -213,7 +227,56 @@ void run_ios_check(void) {
 }
 
 /*---------------------------------------------------------------------------*/
-void get_ios_check_report(char *buf, int bufsize) {
-    strncpy(buf, s_report, bufsize - 1);
-    buf[bufsize - 1] = '\0';
+/* The title list is the cheapest source of these counts, so this is the
+   full scan unless one is still fresh; its output goes nowhere here */
+void quick_ios_check(quick_result *q) {
+    if (!result_fresh(MODULE_IOS)) {
+        run_ios_check();
+        result_stamp(MODULE_IOS);
+    }
+    if (s_total_ios == 0) {
+        q->level = QUICK_RED;
+        snprintf(q->summary, sizeof(q->summary), "IOS scan failed");
+        return;
+    }
+    q->level = s_cios_count > 0 ? QUICK_GREEN : QUICK_YELLOW;
+    snprintf(q->summary, sizeof(q->summary), "%d IOS, %d stubs, %d cIOS",
+             s_total_ios, s_stub_count, s_cios_count);
+}
+
+/*---------------------------------------------------------------------------*/
+bool ios_check_get_counts(int *total, int *stubs, int *cios) {
+    *total = s_total_ios;
+    *stubs = s_stub_count;
+    *cios = s_cios_count;
+    return s_scanned;
+}
+
+/*---------------------------------------------------------------------------*/
+void get_ios_check_report(report_rec *out) {
+    int i;
+
+    if (!s_scanned) return;
+    rec_text(out,
+        "=== IOS INSTALLATION SCAN ===\n"
+        "IOS      Revision     Status     Notes\n"
+        "-------- ------------ ---------- ----------------------------\n");
+    rec_list(out, "titles");
+    for (i = 0; i < s_total_ios; i++) {
+        const ios_row *r = &s_rows[i];
+        rec_item(out);
+        rec_uint(out, "slot", "IOS%-4u  ", r->slot);
+        rec_uint(out, "revision", "rev %-8u ", r->revision);
+        rec_str(out, "status", "%-10s ", r->status);
+        rec_str(out, "notes", "%s", get_ios_description(r->slot));
+        rec_item_end(out);
+    }
+    rec_list_end(out);
+    rec_line(out);
+    rec_int(out, "total", "\nTotal IOS: %d", s_total_ios);
+    rec_int(out, "active", " | Active: %d", s_total_ios - s_stub_count);
+    rec_int(out, "stubs", " | Stubs: %d", s_stub_count);
+    rec_int(out, "cios", " | cIOS: %d", s_cios_count);
+    rec_line_end(out);
+    rec_text(out, "\n");
 }
@@ -5,10 +5,18 @@
 #ifndef IOS_CHECK_H
 #define IOS_CHECK_H
 
+#include "modules.h"
+
 // Run the IOS installation scan
 void run_ios_check(void);
 
-// Get IOS check report as string
-void get_ios_check_report(char *buf, int bufsize);
+// Quick Health Check: stub and cIOS counts, reusing a fresh scan
+void quick_ios_check(quick_result *q);
+
+// Counts from the last scan; false if it has not read the title list
+bool ios_check_get_counts(int *total, int *stubs, int *cios);
+
+// Write the IOS check report section
+void get_ios_check_report(report_rec *out);
 
 #endif // IOS_CHECK_H
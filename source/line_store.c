@@ -0,0 +1,328 @@
+/*
+ * WiiMedic - line_store.c
+ * Attributed text lines for the scroll buffer. Module output repeats the
+ * same few colour escapes on nearly every line, so a line is stored as its
+ * visible text plus one 4-byte run per colour change, packed back to back
+ * in heap chunks. A line record is [line_head][runs][text\0], 4-byte
+ * aligned; runs are written before the text is known, so a line reserves
+ * one run per ESC and gives back what the parse did not use.
+ */
+
+#include <gccore.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "line_store.h"
+#include "mem_budget.h"
+
+#define LINE_CHUNK_SIZE 4096 /* payload bytes; longer lines get their own */
+#define LINE_INDEX_MIN 64
+#define LINE_ALIGN(n) (((n) + 3u) & ~3u)
+#define LINE_PRINT_BUF 512
+
+struct line_chunk {
+  line_chunk *next;
+  u32 used;
+  u32 size;
+  u32 pad;
+  /* payload follows */
+};
+
+struct line_head {
+  u32 len;
+  u32 nruns;
+};
+
+/*---------------------------------------------------------------------------*/
+void line_store_init(line_store *s) { memset(s, 0, sizeof(*s)); }
+
+void line_store_clear(line_store *s) {
+  line_chunk *c = s->chunks;
+
+  /* Keep the oldest chunk: it is the standard size */
+  while (c && c->next) {
+    line_chunk *next = c->next;
+    mem_free(c);
+    c = next;
+  }
+  if (c)
+    c->used = 0;
+  s->chunks = c;
+  s->count = 0;
+}
+
+void line_store_free(line_store *s) {
+  line_store_clear(s);
+  mem_free(s->chunks);
+  mem_free(s->index);
+  line_store_init(s);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Space for a record of size bytes at the end of the newest chunk */
+static line_head *chunk_alloc(line_store *s, u32 size) {
+  line_chunk *c = s->chunks;
+
+  if (!c || c->size - c->used < size) {
+    u32 payload = size > LINE_CHUNK_SIZE ? size : LINE_CHUNK_SIZE;
+
+    c = (line_chunk *)mem_alloc(MEM_TAG_UI, sizeof(line_chunk) + payload);
+    if (!c)
+      return NULL;
+    c->size = payload;
+    c->used = 0;
+    c->next = s->chunks;
+    s->chunks = c;
+  }
+  c->used += size;
+  return (line_head *)((u8 *)(c + 1) + c->used - size);
+}
+
+static bool index_reserve(line_store *s) {
+  const line_head **grown;
+  u32 cap;
+
+  if (s->count < s->index_cap)
+    return true;
+  cap = s->index_cap ? s->index_cap * 2 : LINE_INDEX_MIN;
+  grown = (const line_head **)mem_alloc(MEM_TAG_UI, cap * sizeof(*grown));
+  if (!grown)
+    return false;
+  if (s->count)
+    memcpy(grown, s->index, s->count * sizeof(*grown));
+  mem_free(s->index);
+  s->index = grown;
+  s->index_cap = cap;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Apply the parameters of one SGR sequence ("0", "32;1", "") to attr */
+static u8 sgr_apply(u8 attr, const char *p, const char *end) {
+  while (p <= end) {
+    u32 v = 0;
+
+    while (p < end && *p >= '0' && *p <= '9')
+      v = v * 10 + (u32)(*p++ - '0');
+    if (v == 0)
+      attr = LINE_ATTR_DEFAULT;
+    else if (v == 1)
+      attr |= LINE_ATTR_BOLD;
+    else if (v == 22)
+      attr &= ~LINE_ATTR_BOLD;
+    else if (v >= 30 && v <= 37)
+      attr = (attr & LINE_ATTR_BOLD) | LINE_ATTR_FG | (u8)(v - 30);
+    else if (v == 39)
+      attr &= LINE_ATTR_BOLD;
+    p++; /* past ';' (or end) */
+  }
+  return attr;
+}
+
+void line_run_set(line_run *runs, u32 *nruns, u32 pos, u8 attr) {
+  u32 n = *nruns;
+  u8 prev;
+
+  if (n && LINE_RUN_START(runs[n - 1]) == pos)
+    n--;
+  prev = n ? LINE_RUN_ATTR(runs[n - 1]) : LINE_ATTR_DEFAULT;
+  if (attr != prev)
+    runs[n++] = LINE_RUN(pos, attr);
+  *nruns = n;
+}
+
+u8 line_sgr(u8 attr, const char *esc) {
+  const char *p = esc;
+
+  while ((p = strchr(p, '\x1b')) != NULL) {
+    const char *q;
+
+    if (p[1] != '[') {
+      p++;
+      continue;
+    }
+    for (q = p + 2; *q && (*q < 0x40 || *q > 0x7E); q++)
+      ;
+    if (!*q)
+      break;
+    if (*q == 'm')
+      attr = sgr_apply(attr, p + 2, q);
+    p = q + 1;
+  }
+  return attr;
+}
+
+bool line_store_add(line_store *s, const char *text, u32 len) {
+  const char *p = text, *end = text + len;
+  u32 max_runs = 0, reserved, used, pos = 0;
+  line_head *h;
+  line_run *runs;
+  char *out;
+  u8 attr = LINE_ATTR_DEFAULT;
+
+  while ((p = memchr(p, '\x1b', end - p)) != NULL) {
+    max_runs++;
+    p++;
+  }
+  if (!index_reserve(s))
+    return false;
+  reserved = sizeof(line_head) + max_runs * sizeof(line_run) +
+             LINE_ALIGN(len + 1);
+  h = chunk_alloc(s, reserved);
+  if (!h)
+    return false;
+  runs = (line_run *)(h + 1);
+  out = (char *)(runs + max_runs);
+  h->nruns = 0;
+
+  for (p = text; p < end; p++) {
+    const char *q;
+
+    if (*p != '\x1b') {
+      out[pos++] = *p;
+      continue;
+    }
+    if (p + 1 == end || p[1] != '[')
+      continue; /* lone ESC */
+    /* CSI: parameters, then a final byte in 0x40-0x7E */
+    for (q = p + 2; q < end && (*q < 0x40 || *q > 0x7E); q++)
+      ;
+    if (q == end)
+      break; /* cut off at the end of the line */
+    if (*q == 'm') {
+      attr = sgr_apply(attr, p + 2, q);
+      line_run_set(runs, &h->nruns, pos, attr);
+    }
+    p = q;
+  }
+  out[pos] = '\0';
+  h->len = pos;
+
+  /* Close the gap left by unused run slots and return the slack */
+  if (h->nruns < max_runs)
+    memmove(runs + h->nruns, out, pos + 1);
+  used = sizeof(line_head) + h->nruns * sizeof(line_run) + LINE_ALIGN(pos + 1);
+  s->chunks->used -= reserved - used;
+
+  s->index[s->count++] = h;
+  return true;
+}
+
+bool line_store_add_runs(line_store *s, const char *text, u32 len,
+                         const line_run *runs, u32 nruns) {
+  u32 size = sizeof(line_head) + nruns * sizeof(line_run) + LINE_ALIGN(len + 1);
+  line_head *h;
+  char *out;
+
+  if (!index_reserve(s))
+    return false;
+  h = chunk_alloc(s, size);
+  if (!h)
+    return false;
+  h->len = len;
+  h->nruns = nruns;
+  memcpy(h + 1, runs, nruns * sizeof(line_run));
+  out = (char *)((line_run *)(h + 1) + nruns);
+  memcpy(out, text, len);
+  out[len] = '\0';
+
+  s->index[s->count++] = h;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+void line_store_get(const line_store *s, u32 i, line_view *out) {
+  const line_head *h = s->index[i];
+
+  out->runs = (const line_run *)(h + 1);
+  out->nruns = h->nruns;
+  out->text = (const char *)(out->runs + h->nruns);
+  out->len = h->len;
+}
+
+u32 line_attr_escape(u8 attr, char *buf) {
+  u32 n = 0;
+
+  buf[n++] = '\x1b';
+  buf[n++] = '[';
+  buf[n++] = '0';
+  if (attr & LINE_ATTR_FG) {
+    buf[n++] = ';';
+    buf[n++] = '3';
+    buf[n++] = (char)('0' + LINE_ATTR_COLOR(attr));
+  }
+  if (attr & LINE_ATTR_BOLD) {
+    buf[n++] = ';';
+    buf[n++] = '1';
+  }
+  buf[n++] = 'm';
+  return n;
+}
+
+u32 line_format(const line_view *v, char *buf, u32 size) {
+  u32 pos = 0, n = 0, r;
+  u8 attr = LINE_ATTR_DEFAULT;
+
+  if (LINE_FORMAT_SIZE(v->len, v->nruns) > size)
+    return 0;
+  if (!v->nruns || LINE_RUN_START(v->runs[0]) > 0)
+    n += line_attr_escape(LINE_ATTR_DEFAULT, buf + n);
+  for (r = 0; r < v->nruns; r++) {
+    u32 start = LINE_RUN_START(v->runs[r]);
+
+    memcpy(buf + n, v->text + pos, start - pos);
+    n += start - pos;
+    attr = LINE_RUN_ATTR(v->runs[r]);
+    n += line_attr_escape(attr, buf + n);
+    pos = start;
+  }
+  memcpy(buf + n, v->text + pos, v->len - pos);
+  n += v->len - pos;
+  if (attr != LINE_ATTR_DEFAULT)
+    n += line_attr_escape(LINE_ATTR_DEFAULT, buf + n);
+  return n;
+}
+
+/* Lines too long for the stack buffer go out piece by piece */
+static void print_long(const line_view *v) {
+  char esc[LINE_ESC_MAX];
+  u32 pos = 0, r;
+
+  fwrite(esc, 1, line_attr_escape(LINE_ATTR_DEFAULT, esc), stdout);
+  for (r = 0; r < v->nruns; r++) {
+    u32 start = LINE_RUN_START(v->runs[r]);
+
+    fwrite(v->text + pos, 1, start - pos, stdout);
+    fwrite(esc, 1, line_attr_escape(LINE_RUN_ATTR(v->runs[r]), esc), stdout);
+    pos = start;
+  }
+  fwrite(v->text + pos, 1, v->len - pos, stdout);
+  fwrite(esc, 1, line_attr_escape(LINE_ATTR_DEFAULT, esc), stdout);
+  fputc('\n', stdout);
+}
+
+/* The whole line, colours included, goes out in one write */
+void line_store_print(const line_store *s, u32 i) {
+  line_view v;
+  char buf[LINE_PRINT_BUF];
+  u32 n;
+
+  line_store_get(s, i, &v);
+  n = line_format(&v, buf, sizeof(buf) - 1);
+  if (!n) {
+    print_long(&v);
+    return;
+  }
+  buf[n++] = '\n';
+  fwrite(buf, 1, n, stdout);
+}
+
+/*---------------------------------------------------------------------------*/
+u32 line_store_bytes(const line_store *s) {
+  const line_chunk *c;
+  u32 bytes = s->index_cap * sizeof(*s->index);
+
+  for (c = s->chunks; c; c = c->next)
+    bytes += sizeof(line_chunk) + c->size;
+  return bytes;
+}
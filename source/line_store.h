@@ -0,0 +1,94 @@
+/*
+ * WiiMedic - line_store.h
+ * Growable store of attributed text lines: each line is kept as plain text
+ * plus a few colour runs instead of raw ANSI escapes, in heap chunks that
+ * grow with the output (no line-count or line-length limit)
+ */
+#ifndef LINE_STORE_H
+#define LINE_STORE_H
+
+#include <gccore.h>
+
+// Attribute of a run: 0 = console default (UI_RESET), otherwise
+// LINE_ATTR_FG | colour (0-7, the 3x of "\x1b[3xm") and optionally BOLD
+#define LINE_ATTR_DEFAULT 0x00
+#define LINE_ATTR_BOLD 0x08
+#define LINE_ATTR_FG 0x10
+#define LINE_ATTR_COLOR(a) ((a) & 0x07)
+
+// A colour change: attr applies from text offset start to the next run
+typedef u32 line_run; // start << 8 | attr
+#define LINE_RUN(start, attr) ((u32)(start) << 8 | (u8)(attr))
+#define LINE_RUN_START(r) ((r) >> 8)
+#define LINE_RUN_ATTR(r) ((u8)((r) & 0xFF))
+
+// Longest escape line_format emits for one attribute ("\x1b[0;3x;1m")
+#define LINE_ESC_MAX 10
+// Buffer that always holds line_format of a line with these counts
+#define LINE_FORMAT_SIZE(len, nruns) ((len) + ((nruns) + 2) * LINE_ESC_MAX)
+
+typedef struct line_chunk line_chunk;
+typedef struct line_head line_head;
+
+typedef struct {
+  line_chunk *chunks; // newest first; lines are bump-allocated in the head
+  const line_head **index;
+  u32 count;
+  u32 index_cap;
+} line_store;
+
+typedef struct {
+  const char *text; // NUL-terminated, no escapes
+  u32 len;
+  const line_run *runs; // sorted by start; the text before runs[0] (if any)
+  u32 nruns;            // is in the default attribute
+} line_view;
+
+// Empty store; allocates nothing until the first line
+void line_store_init(line_store *s);
+
+// Drop every line, keeping the first chunk for the next use
+void line_store_clear(line_store *s);
+
+// Release all memory
+void line_store_free(line_store *s);
+
+// Append one line of console text (no '\n'). SGR escapes ("\x1b[...m")
+// become runs; any other escape sequence is dropped. Each line starts in the
+// default attribute. Returns false if out of memory (the line is lost).
+bool line_store_add(line_store *s, const char *text, u32 len);
+
+static inline u32 line_store_count(const line_store *s) { return s->count; }
+
+// Append a line that is already text plus runs (sorted, as line_run_set
+// leaves them); nothing is parsed
+bool line_store_add_runs(line_store *s, const char *text, u32 len,
+                         const line_run *runs, u32 nruns);
+
+// Line i (< count) without copying
+void line_store_get(const line_store *s, u32 i, line_view *out);
+
+// attr after the SGR escapes in esc (e.g. UI_BGREEN); other text is ignored
+u8 line_sgr(u8 attr, const char *esc);
+
+// Make attr start at text offset pos, after any earlier runs: merges with a
+// change at the same offset and drops one that changes nothing
+void line_run_set(line_run *runs, u32 *nruns, u32 pos, u8 attr);
+
+// Escape that sets attr whatever the console's current attribute; at most
+// LINE_ESC_MAX bytes. Returns its length.
+u32 line_attr_escape(u8 attr, char *buf);
+
+// Console text for v: colours as escapes, from the default attribute and
+// back to it at the end, no '\n'. Returns the length, or 0 if it needs more
+// than size bytes (LINE_FORMAT_SIZE always suffices).
+u32 line_format(const line_view *v, char *buf, u32 size);
+
+// Write line i to stdout with its colours and a '\n', starting from the
+// console default attribute
+void line_store_print(const line_store *s, u32 i);
+
+// Heap bytes held (chunks and index)
+u32 line_store_bytes(const line_store *s);
+
+#endif // LINE_STORE_H
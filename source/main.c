@@ -6,39 +6,47 @@
 
 #include <fat.h>
 #include <gccore.h>
+#include <ogc/lwp_watchdog.h>
 #include <ogc/system.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wiiuse/wpad.h>
 
-#include "controller_test.h"
-#include "ios_check.h"
-#include "nand_health.h"
-#include "network_test.h"
+#include "batch.h"
+#include "dashboard.h"
+#include "history.h"
+#include "io_arena.h"
+#include "modules.h"
+#include "precompute.h"
+#include "quick_check.h"
 #include "report.h"
-#include "storage_test.h"
-#include "system_info.h"
+#include "results.h"
+#include "screen.h"
+#include "snapshot.h"
+#include "startup.h"
+#include "task.h"
+#include "trace.h"
 #include "ui_common.h"
+#include "xfb_text.h"
 
-/* Menu configuration */
-#define MENU_ITEMS 8
-
-static const char *menu_labels[MENU_ITEMS] = {
-    "System Information",         "NAND Health Check",
-    "IOS Installation Scan",      "Storage Speed Test (SD/USB)",
-    "Controller Diagnostics",     "Network Connectivity Test",
-    "Generate Full Report to SD", "Exit to Homebrew Channel"};
-
-static const char *menu_descs[MENU_ITEMS] = {
-    "Hardware revision, firmware, region, video mode, memory",
-    "Scan NAND for space usage, file counts, and health score",
-    "Audit installed IOS versions, detect stubs and cIOS",
-    "Benchmark SD/USB read & write speeds, check filesystems",
-    "Test GC controllers and Wii Remotes, detect stick drift",
-    "Check WiFi module, IP config, internet connectivity",
-    "Save a full diagnostic report as text file to SD card",
-    "Return to the Homebrew Channel"};
+/* Menu: every module with a menu entry, in registry order, then these */
+#define MENU_MAX (MODULE_COUNT + 6)
+#define MENU_REPORT (-1)
+#define MENU_EXIT (-2)
+#define MENU_QUICK (-3)
+#define MENU_DASHBOARD (-4)
+#define MENU_HISTORY (-5)
+#define MENU_SNAPSHOT (-6)
+
+typedef struct {
+  const char *label;
+  const char *desc;
+  int action; /* module_id or MENU_* */
+} menu_item;
+
+static menu_item s_menu[MENU_MAX];
+static int s_menu_count = 0;
 
 static void *xfb = NULL;
 static GXRModeObj *rmode = NULL;
@@ -59,110 +67,332 @@ static void init_video(void) {
   VIDEO_WaitVSync();
   if (rmode->viTVMode & VI_NON_INTERLACE)
     VIDEO_WaitVSync();
+
+  /* Menu and scroll viewer draw into the framebuffers themselves */
+  xfb_text_init(rmode, xfb);
 }
 
 /*---------------------------------------------------------------------------*/
+static void add_menu_item(const char *label, const char *desc, int action) {
+  s_menu[s_menu_count].label = label;
+  s_menu[s_menu_count].desc = desc;
+  s_menu[s_menu_count].action = action;
+  s_menu_count++;
+}
+
+static void build_menu(void) {
+  int id;
+
+  s_menu_count = 0;
+  for (id = 0; id < MODULE_COUNT; id++) {
+    const module_desc *m = module_get((module_id)id);
+    if (m->menu_label)
+      add_menu_item(m->menu_label, m->menu_desc, id);
+  }
+  add_menu_item("Live System Dashboard",
+                "CPU load, memory, controllers and Wi-Fi, updated every frame",
+                MENU_DASHBOARD);
+  add_menu_item("Quick Health Check",
+                "Cheap check of every module in about two seconds",
+                MENU_QUICK);
+  add_menu_item("History & Trends",
+                "Metrics from past reports, with regressions flagged",
+                MENU_HISTORY);
+  add_menu_item("System Snapshot & Diff",
+                "Record titles, TMDs and settings; list changes since the last",
+                MENU_SNAPSHOT);
+  add_menu_item("Generate Full Report to SD",
+                "Save a full diagnostic report as text file to SD card",
+                MENU_REPORT);
+  add_menu_item("Exit to Homebrew Channel", "Return to the Homebrew Channel",
+                MENU_EXIT);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Menu frame; moving the cursor resends only the rows it touched */
 static void draw_menu(int selected) {
+  ui_line l;
   int i;
 
-  ui_clear();
+  screen_begin();
   ui_draw_banner();
 
-  printf(UI_BCYAN "   DIAGNOSTIC MODULES\n" UI_RESET);
-  printf(UI_WHITE "   -------------------\n\n" UI_RESET);
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_BCYAN);
+  ui_line_puts(&l, "   DIAGNOSTIC MODULES");
+  ui_line_end(&l);
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, "   -------------------");
+  ui_line_end(&l);
+  ui_line_begin(&l);
+  ui_line_end(&l);
 
-  for (i = 0; i < MENU_ITEMS; i++) {
-    if (i == selected) {
-      printf(UI_BGREEN "   >> [%d] %s\n" UI_RESET, i + 1, menu_labels[i]);
-    } else {
-      printf(UI_WHITE "      [%d] %s\n" UI_RESET, i + 1, menu_labels[i]);
-    }
+  for (i = 0; i < s_menu_count; i++) {
+    ui_line_begin(&l);
+    ui_line_color(&l, i == selected ? UI_BGREEN : UI_WHITE);
+    ui_line_puts(&l, i == selected ? "   >> [" : "      [");
+    ui_line_uint(&l, (u32)i + 1);
+    ui_line_puts(&l, "] ");
+    ui_line_puts(&l, s_menu[i].label);
+    ui_line_end(&l);
   }
 
-  printf("\n" UI_YELLOW "   %s\n" UI_RESET, menu_descs[selected]);
+  ui_line_begin(&l);
+  ui_line_end(&l);
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_YELLOW);
+  ui_line_puts(&l, "   ");
+  ui_line_puts(&l, s_menu[selected].desc);
+  ui_line_end(&l);
 
   ui_draw_footer(NULL);
+  if (ui_screenshot_note()[0]) {
+    ui_line_begin(&l);
+    ui_line_color(&l, UI_BYELLOW);
+    ui_line_puts(&l, "   ");
+    ui_line_puts(&l, ui_screenshot_note());
+    ui_line_end(&l);
+  }
+  screen_present();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wait for the devices a screen needs (it reads the pads at least); only
+   says so if they are still coming up */
+static void wait_devices(u32 devs) {
+  devs |= DEV_WPAD;
+  if (!devices_ready(devs))
+    printf(UI_WHITE "   Waiting for controllers and storage...\n" UI_RESET);
+  devices_wait(devs);
 }
 
 /*---------------------------------------------------------------------------*/
-static void run_subscreen(const char *title, void (*func)(void)) {
+/* Run func on the UI thread. If module >= 0 its results are stamped fresh
+   before the output is shown. */
+static void run_subscreen(const char *title, void (*func)(void), int module) {
   ui_clear();
   ui_draw_banner();
   ui_draw_section(title);
+  wait_devices(module >= 0 ? devices_for_resources(
+                                 module_get((module_id)module)->resources)
+                           : 0);
   printf(UI_WHITE "   Processing, please wait...\n" UI_RESET);
 
   ui_scroll_begin();
-  func();
+  TRACE_SPAN(title, func());
+  io_scratch_reset();
+  if (module >= 0 && module_get((module_id)module)->collect)
+    result_stamp((module_id)module);
   ui_scroll_view(title);
 }
 
+/*---------------------------------------------------------------------------*/
+/* Run a module on a worker thread with a progress bar; B cancels it.
+   Its results are stamped fresh only if it ran to completion. */
+static void run_task_subscreen(module_id id) {
+  const module_desc *m = module_get(id);
+  const char *title = m->title;
+  void (*func)(void) = m->run;
+  bool complete = true;
+  task_t task;
+  u32 last_key = ~0u;
+
+  ui_clear();
+  ui_draw_banner();
+  ui_draw_section(title);
+  wait_devices(devices_for_resources(m->resources));
+
+  ui_scroll_begin();
+  if (!task_start(&task, title, func, m->timeout_ms)) {
+    TRACE_SPAN(title, func());
+  } else {
+    /* Most modules finish quickly; only show progress for slow ones */
+    u64 quiet_until = gettime() + millisecs_to_ticks(TASK_QUIET_MS);
+    while (!task.done && gettime() < quiet_until) {
+      LWP_YieldThread();
+      VIDEO_WaitVSync();
+    }
+
+    while (!task.done) {
+      const char *status = "[B] Cancel";
+      u32 wpad, gpad, elapsed, key;
+
+      ui_output_drain();
+      WPAD_ScanPads();
+      PAD_ScanPads();
+      wpad = WPAD_ButtonsDown(0);
+      gpad = PAD_ButtonsDown(0);
+      if ((wpad & WPAD_BUTTON_B) || (gpad & PAD_BUTTON_B))
+        task_cancel(&task);
+
+      if (task_timed_out(&task))
+        status = "Timed out, stopping...";
+      else if (task.cancel)
+        status = "Cancelling...";
+
+      /* Only redraw when percent, spinner step or status changes */
+      elapsed = (u32)ticks_to_millisecs(gettime() - task.start);
+      key = (task.progress / 10) << 24 | (elapsed / 125) << 2 |
+            (task.cancel ? 1 : 0) | (status[0] == 'T' ? 2 : 0);
+      if (key != last_key) {
+        ui_draw_progress(task.progress, elapsed, status);
+        last_key = key;
+      }
+      VIDEO_WaitVSync();
+    }
+    task_join(&task);
+
+    ui_output_drain();
+    if (task.cancel)
+      ui_draw_warn("Cancelled - results above are partial.");
+    else if (task_timed_out(&task))
+      ui_draw_warn("Time limit reached - results above are partial.");
+    complete = !task.cancel && !task_timed_out(&task);
+  }
+  io_scratch_reset();
+  if (complete && m->collect)
+    result_stamp(id);
+  ui_scroll_view(title);
+}
+
+/*---------------------------------------------------------------------------*/
+static void run_module(module_id id) {
+  const module_desc *m = module_get(id);
+
+  /* Computed while the menu sat idle: nothing left to do but show it */
+  if (precompute_take(id)) {
+    ui_scroll_view(m->title);
+    return;
+  }
+  if (m->flags & MOD_F_UI_THREAD)
+    run_subscreen(m->title, m->run, id);
+  else
+    run_task_subscreen(id);
+}
+
+/*---------------------------------------------------------------------------*/
+/* HBC arguments or an SD plan file select unattended batch mode. Both the
+   plan file and the report need storage, so this waits for FAT: silently
+   when arguments asked for batch mode (the report may be going to stdout),
+   from the menu with the line a screen shows. Returns -1 to stay
+   interactive, otherwise main's exit status. */
+static int check_batch(int argc, char **argv, bool quiet) {
+  batch_plan plan;
+
+  if (quiet)
+    devices_wait(DEV_ALL);
+  else
+    wait_devices(DEV_FAT);
+  result_poll_media();
+  switch (batch_configure(argc, argv, &plan)) {
+  case BATCH_RUN:
+    return batch_run(&plan);
+  case BATCH_ERROR:
+    return 2;
+  default:
+    return -1;
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 int main(int argc, char **argv) {
   int selected = 0;
+  int media_poll = 0;
+  int idle_frames = 0;
+  int rc;
+  bool batch_checked = false;
+  bool menu_shown = false;
   bool running = true;
   bool exit_to_hbc = false;
 
-  /* Initialize subsystems */
-  init_video();
-  WPAD_Init();
-  WPAD_SetDataFormat(WPAD_CHAN_ALL, WPAD_FMT_BTNS_ACC_IR);
-  PAD_Init();
-  fatInitDefault();
+  /* Initialize subsystems; WPAD and FAT come up in the background while
+     the menu is already usable with a GameCube controller */
+  startup_begin();
+  STARTUP_STEP("VIDEO_Init", init_video());
+  STARTUP_STEP("PAD_Init", PAD_Init());
+  devices_start();
+
+  /* With arguments batch mode is likely; settle it before the menu */
+  if (argv && argc > 1) {
+    batch_checked = true;
+    if ((rc = check_batch(argc, argv, true)) >= 0)
+      return rc;
+  }
+
+  build_menu();
 
   while (running) {
-    draw_menu(selected);
+    if (!menu_shown) {
+      STARTUP_STEP("First menu draw", draw_menu(selected));
+      menu_shown = true;
+    } else {
+      draw_menu(selected);
+    }
 
     while (1) {
-      WPAD_ScanPads();
+      bool wpad_up = devices_ready(DEV_WPAD);
+
+      if (wpad_up)
+        WPAD_ScanPads();
       PAD_ScanPads();
 
-      u32 wpad = WPAD_ButtonsDown(0);
+      u32 wpad = wpad_up ? WPAD_ButtonsDown(0) : 0;
       u32 gpad = PAD_ButtonsDown(0);
 
+      if (wpad || gpad)
+        idle_frames = 0;
+
+      /* Wii Remote 1+2 or GC Z: screenshot, then redraw with the result */
+      if (ui_screenshot_poll(wpad_up ? WPAD_ButtonsHeld(0) : 0, gpad, NULL))
+        break;
+
+      /* Look for a plan file once everything is up, so it never waits,
+         or before acting on the first selection */
+      if (!batch_checked &&
+          (devices_ready(DEV_ALL) ||
+           (wpad & WPAD_BUTTON_A) || (gpad & PAD_BUTTON_A))) {
+        batch_checked = true;
+        if ((rc = check_batch(argc, argv, false)) >= 0)
+          return rc;
+      }
+
       /* Navigate up */
       if ((wpad & WPAD_BUTTON_UP) || (gpad & PAD_BUTTON_UP)) {
         selected--;
         if (selected < 0)
-          selected = MENU_ITEMS - 1;
+          selected = s_menu_count - 1;
         break;
       }
 
       /* Navigate down */
       if ((wpad & WPAD_BUTTON_DOWN) || (gpad & PAD_BUTTON_DOWN)) {
         selected++;
-        if (selected >= MENU_ITEMS)
+        if (selected >= s_menu_count)
           selected = 0;
         break;
       }
 
       /* Select item */
       if ((wpad & WPAD_BUTTON_A) || (gpad & PAD_BUTTON_A)) {
-        switch (selected) {
-        case 0:
-          run_subscreen("System Information", run_system_info);
-          break;
-        case 1:
-          run_subscreen("NAND Health Check", run_nand_health);
-          break;
-        case 2:
-          run_subscreen("IOS Installation Scan", run_ios_check);
-          break;
-        case 3:
-          run_subscreen("Storage Speed Test", run_storage_test);
-          break;
-        case 4:
-          run_subscreen("Controller Diagnostics", run_controller_test);
-          break;
-        case 5:
-          run_subscreen("Network Connectivity", run_network_test);
-          break;
-        case 6:
-          run_subscreen("Generate Full Report", run_report_generator);
-          break;
-        case 7:
+        precompute_stop(s_menu[selected].action);
+        if (s_menu[selected].action == MENU_DASHBOARD) {
+          ui_clear();
+          wait_devices(0);
+          run_dashboard();
+        } else if (s_menu[selected].action == MENU_QUICK) {
+          run_subscreen("Quick Health Check", run_quick_check, -1);
+        } else if (s_menu[selected].action == MENU_HISTORY) {
+          run_subscreen("History & Trends", run_history_view, -1);
+        } else if (s_menu[selected].action == MENU_SNAPSHOT) {
+          run_subscreen("System Snapshot & Diff", run_snapshot_view, -1);
+        } else if (s_menu[selected].action == MENU_REPORT) {
+          run_subscreen("Generate Full Report", run_report_generator, -1);
+        } else if (s_menu[selected].action == MENU_EXIT) {
           exit_to_hbc = true;
           running = false;
-          break;
+        } else {
+          run_module((module_id)s_menu[selected].action);
         }
         break;
       }
@@ -173,11 +403,30 @@ int main(int argc, char **argv) {
         break;
       }
 
+      /* SD/USB hot-plug makes storage results stale */
+      if (batch_checked &&
+          ++media_poll >= RESULTS_MEDIA_POLL_MS * 60 / 1000) {
+        media_poll = 0;
+        result_poll_media();
+      }
+
+      /* Spend idle menu time on the modules the user may pick next */
+      if (batch_checked) {
+        if (idle_frames < PRECOMPUTE_IDLE_MS * 60 / 1000)
+          idle_frames++;
+        precompute_poll(s_menu[selected].action,
+                        idle_frames >= PRECOMPUTE_IDLE_MS * 60 / 1000);
+      }
+
       VIDEO_WaitVSync();
     }
   }
 
   /* Cleanup */
+  precompute_stop(-1);
+  devices_wait(DEV_ALL);
+  if (trace_write(TRACE_OUT_SD) < 0)
+    trace_write(TRACE_OUT_USB);
   ui_clear();
   printf(UI_BGREEN "\n  WiiMedic shutting down. Stay healthy!\n\n" UI_RESET);
   WPAD_Shutdown();
@@ -0,0 +1,368 @@
+/*
+ * WiiMedic - mem_budget.c
+ * Heap accounting: every tracked block carries a small header just below the
+ * returned pointer recording its owner and size, so frees are attributed
+ * without a lookup table. Task, sampler and capture threads allocate too,
+ * so the counters are only updated with atomics. Static footprint comes
+ * from the linker map (copied next to boot.dol by "make install"), summed
+ * per object file.
+ */
+
+#include <gccore.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIIMEDIC_HOST
+#include <unistd.h>
+#endif
+
+#include "heap_map.h"
+#include "io_arena.h"
+#include "mem_budget.h"
+
+#define MEM_MAGIC 0xA5
+#define MEM_CHECK 0x5EB0C7A1u
+#define MEM_MAP_LINE 512
+
+typedef struct {
+  u32 size;
+  u32 check; /* MEM_CHECK ^ size ^ the returned pointer */
+  u32 unused;
+  u16 pad; /* bytes from the raw block to the returned pointer */
+  u8 tag;
+  u8 magic;
+} mem_header;
+
+typedef struct {
+  const char *name;
+  const char *object; /* object file in the linker map */
+} mem_tag_info;
+
+static const mem_tag_info s_tag_info[MEM_TAG_COUNT] = {
+    {"System Info", "system_info.o"},  {"NAND Health", "nand_health.o"},
+    {"IOS Check", "ios_check.o"},      {"Storage Test", "storage_test.o"},
+    {"Controllers", "controller_test.o"}, {"Network", "network_test.o"},
+    {"Report", "report.o"},            {"UI / scroll", "ui_common.o"},
+    {"Main menu", "main.o"},
+};
+
+/* [MEM_TAG_COUNT] holds the totals */
+static mem_tag_stats s_stats[MEM_TAG_COUNT + 1];
+
+/*---------------------------------------------------------------------------*/
+static void account(mem_tag_stats *st, s32 delta) {
+  u32 now, peak;
+
+  if (delta <= 0) {
+    __atomic_sub_fetch(&st->current, (u32)-delta, __ATOMIC_RELAXED);
+    return;
+  }
+  __atomic_fetch_add(&st->allocs, 1, __ATOMIC_RELAXED);
+  now = __atomic_add_fetch(&st->current, (u32)delta, __ATOMIC_RELAXED);
+  peak = __atomic_load_n(&st->peak, __ATOMIC_RELAXED);
+  while (now > peak &&
+         !__atomic_compare_exchange_n(&st->peak, &peak, now, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+static u32 header_check(const mem_header *hdr) {
+  return MEM_CHECK ^ hdr->size ^ (u32)(uintptr_t)(hdr + 1);
+}
+
+/* A pointer mem_alloc did not return, or one freed twice: the heap would
+   be corrupted by guessing, so stop here */
+static void bad_free(void *ptr) {
+  fprintf(stderr, "mem_free: %p is not a live mem_alloc block\n", ptr);
+  abort();
+}
+
+void *mem_memalign(mem_tag tag, u32 align, u32 size) {
+  u32 pad;
+  u8 *raw;
+  mem_header *hdr;
+
+  if ((u32)tag >= MEM_TAG_COUNT)
+    tag = MEM_TAG_MAIN;
+  if (align < sizeof(mem_header))
+    align = sizeof(mem_header);
+
+  /* The header sits in the padding, so the payload keeps its alignment */
+  pad = (sizeof(mem_header) + align - 1) & ~(align - 1);
+  raw = (u8 *)memalign(align, pad + size);
+  if (!raw) {
+    __atomic_fetch_add(&s_stats[tag].failures, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_stats[MEM_TAG_COUNT].failures, 1, __ATOMIC_RELAXED);
+    return NULL;
+  }
+
+  hdr = (mem_header *)(raw + pad) - 1;
+  hdr->size = size;
+  hdr->check = header_check(hdr);
+  hdr->unused = 0;
+  hdr->pad = (u16)pad;
+  hdr->tag = (u8)tag;
+  hdr->magic = MEM_MAGIC;
+
+  account(&s_stats[tag], (s32)size);
+  account(&s_stats[MEM_TAG_COUNT], (s32)size);
+  return raw + pad;
+}
+
+void *mem_alloc(mem_tag tag, u32 size) { return mem_memalign(tag, 8, size); }
+
+void mem_free(void *ptr) {
+  mem_header *hdr;
+
+  if (!ptr)
+    return;
+
+  hdr = (mem_header *)ptr - 1;
+  if (hdr->magic != MEM_MAGIC || hdr->tag >= MEM_TAG_COUNT ||
+      hdr->check != header_check(hdr))
+    bad_free(ptr);
+
+  hdr->magic = 0;
+  hdr->check = 0;
+  account(&s_stats[hdr->tag], -(s32)hdr->size);
+  account(&s_stats[MEM_TAG_COUNT], -(s32)hdr->size);
+  free((u8 *)ptr - hdr->pad);
+}
+
+void mem_get_stats(mem_tag tag, mem_tag_stats *out) {
+  if ((u32)tag > MEM_TAG_COUNT)
+    tag = MEM_TAG_COUNT;
+  out->current = __atomic_load_n(&s_stats[tag].current, __ATOMIC_RELAXED);
+  out->peak = __atomic_load_n(&s_stats[tag].peak, __ATOMIC_RELAXED);
+  out->allocs = __atomic_load_n(&s_stats[tag].allocs, __ATOMIC_RELAXED);
+  out->failures = __atomic_load_n(&s_stats[tag].failures, __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Static footprint from the linker map                                      */
+/*---------------------------------------------------------------------------*/
+
+typedef struct {
+  u32 data; /* .data/.sdata/.rodata: initialized, part of the DOL image */
+  u32 bss;  /* .bss/.sbss/COMMON: zeroed at startup */
+} mem_static;
+
+static FILE *open_map(void) {
+#ifdef WIIMEDIC_HOST
+  char path[512];
+  ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 5);
+  if (n <= 0)
+    return NULL;
+  strcpy(path + n, ".map");
+  return fopen(path, "r");
+#else
+  static const char *const candidates[] = {
+      "sd:/apps/WiiMedic/boot.elf.map", "usb:/apps/WiiMedic/boot.elf.map",
+      "sd:/boot.elf.map", "usb:/boot.elf.map"};
+  unsigned i;
+  for (i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+    FILE *fp = fopen(candidates[i], "r");
+    if (fp)
+      return fp;
+  }
+  return NULL;
+#endif
+}
+
+/* 0 = data, 1 = bss, -1 = not a data section */
+static int section_kind(const char *name) {
+  if (strcmp(name, "COMMON") == 0 || strncmp(name, ".bss", 4) == 0 ||
+      strncmp(name, ".sbss", 5) == 0)
+    return 1;
+  if (strncmp(name, ".data", 5) == 0 || strncmp(name, ".sdata", 6) == 0 ||
+      strncmp(name, ".rodata", 7) == 0)
+    return 0;
+  return -1;
+}
+
+/* Index into s_tag_info for an object path, MEM_TAG_COUNT for other app
+   objects, MEM_TAG_COUNT + 1 for library archive members */
+static int object_slot(const char *path) {
+  const char *base = strrchr(path, '/');
+  int i;
+
+  if (strchr(path, '('))
+    return MEM_TAG_COUNT + 1;
+  base = base ? base + 1 : path;
+  for (i = 0; i < MEM_TAG_COUNT; i++) {
+    if (strcmp(base, s_tag_info[i].object) == 0)
+      return i;
+  }
+  return MEM_TAG_COUNT;
+}
+
+/*
+ * Input section lines look like
+ *   " .bss    0x80412340   0x20000 build/ui_common.o"
+ * or, when the section name is long, the name alone followed by a line with
+ * just the address, size and object. Output section headers start at
+ * column 0 and are skipped, as is everything before the memory map.
+ */
+static bool load_static_footprint(mem_static *out) {
+  char line[MEM_MAP_LINE];
+  char pending[MEM_MAP_LINE];
+  FILE *fp = open_map();
+
+  if (!fp)
+    return false;
+
+  /* Skip the "Discarded input sections" list */
+  while (fgets(line, sizeof(line), fp)) {
+    if (strncmp(line, "Linker script and memory map", 28) == 0)
+      break;
+  }
+
+  pending[0] = '\0';
+  while (fgets(line, sizeof(line), fp)) {
+    char name[MEM_MAP_LINE], object[MEM_MAP_LINE];
+    unsigned long long addr, size;
+    int kind;
+
+    if (line[0] != ' ') {
+      pending[0] = '\0';
+      continue;
+    }
+
+    if (sscanf(line, " %511s 0x%llx 0x%llx %511[^\n]", name, &addr, &size,
+               object) == 4) {
+      pending[0] = '\0';
+    } else if (pending[0] &&
+               sscanf(line, " 0x%llx 0x%llx %511[^\n]", &addr, &size,
+                      object) == 3) {
+      strcpy(name, pending);
+      pending[0] = '\0';
+    } else {
+      char extra[2];
+      /* A long section name alone; its numbers follow on the next line */
+      if (sscanf(line, " %511s %1s", name, extra) == 1 &&
+          section_kind(name) >= 0)
+        strcpy(pending, name);
+      else
+        pending[0] = '\0';
+      continue;
+    }
+
+    kind = section_kind(name);
+    if (kind < 0 || size == 0)
+      continue;
+    if (kind)
+      out[object_slot(object)].bss += (u32)size;
+    else
+      out[object_slot(object)].data += (u32)size;
+  }
+
+  fclose(fp);
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* One table row; stat is NULL when there is no static column */
+static void budget_row(report_rec *out, const char *name,
+                       const mem_tag_stats *st, const mem_static *stat) {
+  rec_str(out, "tag", "%-16s", name);
+  rec_uint(out, "heap_kb", " %7u KB", (st->current + 1023) / 1024);
+  rec_uint(out, "peak_kb", " %8u KB", (st->peak + 1023) / 1024);
+  rec_uint(out, "allocs", " %7u", st->allocs);
+  rec_uint(out, "failures", " %6u", st->failures);
+  if (stat) {
+    rec_uint(out, "data_kb", " %5u KB", (stat->data + 1023) / 1024);
+    rec_uint(out, "bss_kb", " %5u KB", (stat->bss + 1023) / 1024);
+  }
+}
+
+void get_memory_budget_report(report_rec *out) {
+  mem_static stat[MEM_TAG_COUNT + 2];
+  heap_region_stats heap;
+  io_arena_stats io;
+  bool have_map;
+  int i;
+
+  memset(stat, 0, sizeof(stat));
+  have_map = load_static_footprint(stat);
+
+  rec_text(out, "=== MEMORY BUDGET ===\n"
+                "Module           Heap Now   Heap Peak  Allocs  Fails"
+                "   .data    .bss\n");
+  rec_list(out, "tags");
+  for (i = 0; i < MEM_TAG_COUNT; i++) {
+    rec_item(out);
+    budget_row(out, s_tag_info[i].name, &s_stats[i],
+               have_map ? &stat[i] : NULL);
+    rec_item_end(out);
+  }
+  rec_list_end(out);
+  rec_group(out, "heap_total");
+  rec_line(out);
+  budget_row(out, "Total (heap)", &s_stats[MEM_TAG_COUNT], NULL);
+  rec_line_end(out);
+  rec_group_end(out);
+
+  if (have_map) {
+    u32 data = 0, bss = 0;
+    for (i = 0; i < MEM_TAG_COUNT + 2; i++) {
+      data += stat[i].data;
+      bss += stat[i].bss;
+    }
+    rec_line(out);
+    rec_uint(out, "other_data_kb", "Other app objects:   .data %u KB",
+             (stat[MEM_TAG_COUNT].data + 1023) / 1024);
+    rec_uint(out, "other_bss_kb", ", .bss %u KB",
+             (stat[MEM_TAG_COUNT].bss + 1023) / 1024);
+    rec_line_end(out);
+    rec_line(out);
+    rec_uint(out, "lib_data_kb", "Libraries:           .data %u KB",
+             (stat[MEM_TAG_COUNT + 1].data + 1023) / 1024);
+    rec_uint(out, "lib_bss_kb", ", .bss %u KB",
+             (stat[MEM_TAG_COUNT + 1].bss + 1023) / 1024);
+    rec_line_end(out);
+    rec_uint(out, "static_kb", "Static Total:        %u KB",
+             (data + bss + 1023) / 1024);
+  } else {
+    rec_text(out, "Static footprint:    linker map not found "
+                  "(boot.elf.map next to boot.dol)\n");
+  }
+
+  if (heap_map_walk_mem1(&heap, NULL)) {
+    rec_line(out);
+    rec_uint(out, "mem1_heap_used_kb", "MEM1 Heap:           %u KB used",
+             heap.used_bytes / 1024);
+    rec_uint(out, "mem1_heap_free_kb", ", %u KB free",
+             heap.free_bytes / 1024);
+    rec_uint(out, "mem1_heap_free_chunks", " in %u chunks", heap.free_chunks);
+    rec_line_end(out);
+    rec_line(out);
+    rec_uint(out, "mem1_largest_free_kb", "MEM1 Largest Free:   %u KB",
+             heap.largest_free / 1024);
+    rec_int(out, "mem1_frag_pct", " (fragmentation %d%%)", heap.frag_pct);
+    rec_line_end(out);
+  }
+
+  io_arena_get_stats(&io);
+  rec_line(out);
+  rec_uint(out, "io_arena_kb", "MEM2 I/O Arena:      %u KB reserved",
+           io.arena_size / 1024);
+  rec_uint(out, "io_pooled_kb", ", %u KB pooled",
+           (io.pool_carved + 1023) / 1024);
+  rec_uint(out, "io_scratch_peak_kb", ", scratch peak %u KB",
+           (io.scratch_peak + 1023) / 1024);
+  rec_line_end(out);
+  rec_line(out);
+  rec_uint(out, "io_pool_calls", "I/O Pool Calls:      %u", io.pool_allocs);
+  rec_uint(out, "io_pool_reused", " (%u reused", io.pool_reuses);
+  rec_uint(out, "io_failed", ", %u failed)",
+           io.pool_failures + io.scratch_failures);
+  rec_line_end(out);
+
+  rec_uint(out, "mem1_free_kb", "MEM1 Arena Free:     %u KB",
+           SYS_GetArena1Size() / 1024);
+  rec_uint(out, "mem2_free_kb", "MEM2 Arena Free:     %u KB",
+           SYS_GetArena2Size() / 1024);
+  rec_text(out, "\n");
+}
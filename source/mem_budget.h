@@ -0,0 +1,48 @@
+/*
+ * WiiMedic - mem_budget.h
+ * Per-module heap accounting and static footprint ("Memory Budget")
+ */
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <gccore.h>
+
+#include "report_rec.h"
+
+// Owner of an allocation; also the row order of the report table
+typedef enum {
+  MEM_TAG_SYSTEM_INFO,
+  MEM_TAG_NAND,
+  MEM_TAG_IOS,
+  MEM_TAG_STORAGE,
+  MEM_TAG_CONTROLLER,
+  MEM_TAG_NETWORK,
+  MEM_TAG_REPORT,
+  MEM_TAG_UI,
+  MEM_TAG_MAIN,
+  MEM_TAG_COUNT
+} mem_tag;
+
+typedef struct {
+  u32 current;  // bytes live now
+  u32 peak;     // high-water mark of current
+  u32 allocs;   // successful allocations
+  u32 failures; // allocations that returned NULL
+} mem_tag_stats;
+
+// malloc/memalign/free with accounting. Blocks from mem_alloc/mem_memalign
+// must be released with mem_free (never plain free) and vice versa;
+// mem_free aborts on any other pointer, or on a block freed twice.
+// Safe to call from any thread.
+void *mem_alloc(mem_tag tag, u32 size);
+void *mem_memalign(mem_tag tag, u32 align, u32 size);
+void mem_free(void *ptr);
+
+// Heap counters for one tag (tag == MEM_TAG_COUNT gives the totals)
+void mem_get_stats(mem_tag tag, mem_tag_stats *out);
+
+// Write the "Memory Budget" report section: heap high-water per module, static
+// .data/.bss per module from the linker map, and the arena headroom
+void get_memory_budget_report(report_rec *out);
+
+#endif // MEM_BUDGET_H
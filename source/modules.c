@@ -0,0 +1,152 @@
+/*
+ * WiiMedic - modules.c
+ * The module table. Costs are rough figures from hardware runs and only
+ * order the scheduler's choices; resources decide what may overlap.
+ */
+
+#include "modules.h"
+#include "controller_test.h"
+#include "ios_check.h"
+#include "mem_budget.h"
+#include "nand_health.h"
+#include "network_test.h"
+#include "storage_test.h"
+#include "system_info.h"
+
+/* Module deadlines; the menu stays responsive past these, the module is
+   asked to stop at its next checkpoint */
+#define STORAGE_TIMEOUT_MS 120000
+#define NETWORK_TIMEOUT_MS 60000
+
+static const module_desc s_modules[MODULE_COUNT] = {
+    [MODULE_SYSTEM_INFO] =
+        {
+            .name = "system",
+            .title = "System Information",
+            .menu_label = "System Information",
+            .menu_desc =
+                "Hardware revision, firmware, region, video mode, memory",
+            .report_step = "Collecting system information...",
+            .run = run_system_info,
+            .collect = collect_system_info,
+            .report = get_system_info_report,
+            .quick = quick_system_info,
+            .cost_ms = 150,
+            .quick_cost_ms = 150,
+            .resources = MOD_RES_ISFS | MOD_RES_ES | MOD_RES_IOARENA,
+            .flags = MOD_F_PRECOMPUTE,
+        },
+    [MODULE_NAND] =
+        {
+            .name = "nand",
+            .title = "NAND Health Check",
+            .menu_label = "NAND Health Check",
+            .menu_desc =
+                "Scan NAND for space usage, file counts, and health score",
+            .report_step = "Scanning NAND health...",
+            .run = run_nand_health,
+            .collect = run_nand_health,
+            .report = get_nand_health_report,
+            .quick = quick_nand_health,
+            .cost_ms = 400,
+            .quick_cost_ms = 20,
+            .max_age_ms = 10 * 60 * 1000,
+            .resources = MOD_RES_ISFS | MOD_RES_IOARENA,
+            .flags = MOD_F_PRECOMPUTE,
+        },
+    [MODULE_IOS] =
+        {
+            .name = "ios",
+            .title = "IOS Installation Scan",
+            .menu_label = "IOS Installation Scan",
+            .menu_desc = "Audit installed IOS versions, detect stubs and cIOS",
+            .report_step = "Scanning IOS installations...",
+            .run = run_ios_check,
+            .collect = run_ios_check,
+            .report = get_ios_check_report,
+            .report_missing =
+                "=== IOS INSTALLATION SCAN ===\n"
+                "Run IOS Scan from main menu first to populate this "
+                "section.\n\n",
+            .quick = quick_ios_check,
+            .cost_ms = 300,
+            .quick_cost_ms = 300,
+            .resources = MOD_RES_ES | MOD_RES_IOARENA,
+            .flags = MOD_F_PRECOMPUTE,
+        },
+    [MODULE_STORAGE] =
+        {
+            .name = "storage",
+            .title = "Storage Speed Test",
+            .menu_label = "Storage Speed Test (SD/USB)",
+            .menu_desc =
+                "Benchmark SD/USB read & write speeds, check filesystems",
+            .report_step = "Checking storage devices...",
+            .run = run_storage_test,
+            .collect = run_storage_test,
+            .report = get_storage_test_report,
+            .report_missing =
+                "=== STORAGE TEST ===\n"
+                "Run Storage Test from main menu first to populate this "
+                "section.\n\n",
+            .quick = quick_storage_test,
+            .cost_ms = 3000,
+            .quick_cost_ms = 10,
+            .timeout_ms = STORAGE_TIMEOUT_MS,
+            .resources = MOD_RES_FAT | MOD_RES_IOARENA,
+        },
+    [MODULE_CONTROLLER] =
+        {
+            .name = "controller",
+            .title = "Controller Diagnostics",
+            .menu_label = "Controller Diagnostics",
+            .menu_desc =
+                "Test GC controllers and Wii Remotes, detect stick drift",
+            .report_step = "Checking controllers...",
+            .run = run_controller_test,
+            .collect = scan_controllers_quick,
+            .report = get_controller_test_report,
+            .quick = quick_controller_test,
+            .cost_ms = 500,
+            .quick_cost_ms = 5,
+            .max_age_ms = 30 * 1000,
+            .resources = MOD_RES_WPAD,
+            .flags = MOD_F_UI_THREAD,
+        },
+    [MODULE_NETWORK] =
+        {
+            .name = "network",
+            .title = "Network Connectivity",
+            .menu_label = "Network Connectivity Test",
+            .menu_desc = "Check WiFi module, IP config, internet connectivity",
+            .report_step = "Checking network...",
+            .run = run_network_test,
+            .collect = run_network_test,
+            .report = get_network_test_report,
+            .report_missing =
+                "=== NETWORK TEST ===\n"
+                "Run Network Test from main menu first to populate this "
+                "section.\n\n",
+            .quick = quick_network_test,
+            .cost_ms = 8000,
+            .timeout_ms = NETWORK_TIMEOUT_MS,
+            .max_age_ms = 2 * 60 * 1000,
+            .resources = MOD_RES_NET,
+        },
+    [MODULE_MEMORY] =
+        {
+            /* Last, so the peaks include the whole run; walks the heap, so
+               on the UI thread with no worker allocating */
+            .name = "memory",
+            .title = "Memory Budget",
+            .report_step = "Measuring memory budget...",
+            .report = get_memory_budget_report,
+            .cost_ms = 5,
+            .resources = MOD_RES_FAT, /* reads the linker map */
+            .deps = MODULE_ALL & ~MODULE_BIT(MODULE_MEMORY),
+            .flags = MOD_F_UI_THREAD,
+        },
+};
+
+/*---------------------------------------------------------------------------*/
+const module_desc *module_get(module_id id) { return &s_modules[id]; }
@@ -0,0 +1,80 @@
+/*
+ * WiiMedic - modules.h
+ * Registry of diagnostic modules: how each one runs from the menu, how the
+ * report collects it, and which shared resources it touches
+ */
+#ifndef MODULES_H
+#define MODULES_H
+
+#include <gccore.h>
+
+#include "report_rec.h"
+
+// Registry order is menu order and report section order
+typedef enum {
+  MODULE_SYSTEM_INFO,
+  MODULE_NAND,
+  MODULE_IOS,
+  MODULE_STORAGE,
+  MODULE_CONTROLLER,
+  MODULE_NETWORK,
+  MODULE_MEMORY,
+  MODULE_COUNT
+} module_id;
+
+#define MODULE_BIT(id) (1u << (id))
+#define MODULE_ALL ((1u << MODULE_COUNT) - 1)
+
+// Resources; two modules that share one never run at the same time
+#define MOD_RES_ISFS (1u << 0)    // ISFS_Initialize/Deinitialize state
+#define MOD_RES_ES (1u << 1)      // ES title/TMD queries
+#define MOD_RES_NET (1u << 2)     // net_* and WD_* (one radio)
+#define MOD_RES_FAT (1u << 3)     // sd:/usb: file I/O
+#define MOD_RES_WPAD (1u << 4)    // WPAD/PAD scanning
+#define MOD_RES_IOARENA (1u << 5) // io_arena pools/scratch (not thread-safe)
+
+// Flags
+#define MOD_F_UI_THREAD (1u << 0) // reads pads or prints directly
+#define MOD_F_PRECOMPUTE (1u << 1) // cheap, read-only: may run idle in menu
+
+// Quick Health Check verdict of one module
+typedef enum {
+  QUICK_UNKNOWN, // no data (not tested, or skipped for time)
+  QUICK_GREEN,
+  QUICK_YELLOW,
+  QUICK_RED
+} quick_level;
+
+typedef struct {
+  quick_level level;
+  char summary[48]; // one line for the summary screen
+} quick_result;
+
+typedef struct {
+  const char *name;       // short id: "nand", "network", ...
+  const char *title;      // sub-screen heading
+  const char *menu_label; // NULL = not on the menu
+  const char *menu_desc;
+  const char *report_step; // progress line while the report collects it
+
+  void (*run)(void);       // interactive sub-screen
+  void (*collect)(void);   // capture results; NULL = report() reads live
+  void (*report)(report_rec *out); // write the report section
+  const char *report_missing; // text used when report() writes no fields
+  void (*quick)(quick_result *q); // cheapest useful probe (UI thread, no
+                                  // screen output); NULL = none
+
+  u32 cost_ms;       // rough collect + report time on hardware
+  u32 quick_cost_ms; // rough quick() time on hardware
+  u32 timeout_ms;    // run/collect deadline, 0 = none
+  u32 max_age_ms;    // results reusable this long, 0 = until invalidated
+  u32 resources;     // MOD_RES_* used by collect() and report(); hot-plug
+                     // invalidates results of MOD_RES_FAT users
+  u32 deps;          // MODULE_BIT()s that must finish first in the report
+  u32 flags;         // MOD_F_*
+} module_desc;
+
+// Descriptor for id (never NULL for id < MODULE_COUNT)
+const module_desc *module_get(module_id id);
+
+#endif // MODULES_H
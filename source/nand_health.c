@@ -10,7 +10,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "io_arena.h"
 #include "nand_health.h"
+#include "task.h"
+#include "trace.h"
 #include "ui_common.h"
 
 /* NAND constants (Wii: 4096 blocks * 8 clusters/block = 32768 clusters) */
@@ -26,30 +29,81 @@ static int s_health_score = 100;
 static char s_health_status[64] = "Unknown";
 static int s_title_count = 0;
 static int s_ticket_count = 0;
+static bool s_have_usage = false; /* ISFS_GetUsage worked in the last run */
 
 /*---------------------------------------------------------------------------*/
+/* -1 on error, and once the scan is cancelled */
 static int count_nand_entries(const char *path) {
-  char pathbuf[ISFS_MAXPATH] ATTRIBUTE_ALIGN(32);
+  if (task_cancelled())
+    return -1;
+
+  /* IOS wants IPC buffers 32-byte aligned; stack alignment isn't reliable */
+  char *pathbuf = (char *)io_pool_alloc(ISFS_MAXPATH);
   u32 count = 0;
 
+  if (!pathbuf)
+    return -1;
   strncpy(pathbuf, path, ISFS_MAXPATH - 1);
   pathbuf[ISFS_MAXPATH - 1] = '\0';
 
-  s32 ret = ISFS_ReadDir(pathbuf, NULL, &count);
+  s32 ret = TRACE_CALL("ISFS_ReadDir", ISFS_ReadDir(pathbuf, NULL, &count));
+  io_pool_free(pathbuf);
   if (ret < 0)
     return -1;
   return (int)count;
 }
 
+/* Stop a cancelled scan, releasing ISFS if this run initialized it */
+static bool scan_cancelled(bool we_initialized) {
+  if (!task_cancelled())
+    return false;
+  strcpy(s_health_status, "Scan cancelled");
+  ui_draw_warn("NAND scan cancelled");
+  if (we_initialized)
+    TRACE_CALL("ISFS_Deinitialize", ISFS_Deinitialize());
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+int nand_compute_health_score(u32 used_clusters, u32 used_inodes,
+                              int import_count, int tmp_count) {
+  int score = 100;
+  float cluster_pct =
+      (float)used_clusters * 100.0f / (float)NAND_TOTAL_CLUSTERS;
+  float inode_pct = (float)used_inodes * 100.0f / (float)NAND_TOTAL_INODES;
+
+  if (cluster_pct > 95.0f)
+    score -= 30;
+  else if (cluster_pct > 85.0f)
+    score -= 15;
+  else if (cluster_pct > 75.0f)
+    score -= 5;
+
+  if (inode_pct > 95.0f)
+    score -= 30;
+  else if (inode_pct > 85.0f)
+    score -= 15;
+  else if (inode_pct > 75.0f)
+    score -= 5;
+
+  if (import_count > 0)
+    score -= 10;
+  if (tmp_count > 10)
+    score -= 5;
+  if (score < 0)
+    score = 0;
+  return score;
+}
+
 /*---------------------------------------------------------------------------*/
 void run_nand_health(void) {
   s32 ret;
-  float cluster_pct, inode_pct;
 
+  s_have_usage = false;
   ui_draw_info("Initializing NAND filesystem scan...");
   ui_printf("\n");
 
-  ret = ISFS_Initialize();
+  ret = TRACE_CALL("ISFS_Initialize", ISFS_Initialize());
   bool we_initialized = (ret >= 0);
   if (ret < 0 && ret != -105) { /* -105 = ISFS_EALREADY */
     ui_draw_err("Failed to initialize ISFS");
@@ -63,10 +117,12 @@ void run_nand_health(void) {
   /* Get NAND filesystem usage (returns used clusters, used inodes) */
   u32 used_clusters = 0, used_inodes = 0;
 
-  ret = ISFS_GetUsage("/", &used_clusters, &used_inodes);
+  ret = TRACE_CALL("ISFS_GetUsage",
+                   ISFS_GetUsage("/", &used_clusters, &used_inodes));
   if (ret >= 0) {
     s_used_blocks = used_clusters;
     s_used_inodes = used_inodes;
+    s_have_usage = true;
   }
 
   s_free_inodes = NAND_TOTAL_INODES - s_used_inodes;
@@ -104,6 +160,10 @@ void run_nand_health(void) {
   ui_printf("\n   Inode Usage:\n");
   ui_draw_bar(s_used_inodes, NAND_TOTAL_INODES, 40);
 
+  task_set_progress(1, 3);
+  if (scan_cancelled(we_initialized))
+    return;
+
   /* Directory scan */
   ui_draw_section("NAND Directory Scan");
 
@@ -118,6 +178,9 @@ void run_nand_health(void) {
 
     s_title_count = title_count;
     s_ticket_count = ticket_count;
+    task_set_progress(2, 3);
+    if (scan_cancelled(we_initialized))
+      return;
 
     if (sys_count >= 0) {
       snprintf(buf, sizeof(buf), "%d entries", sys_count);
@@ -157,30 +220,8 @@ void run_nand_health(void) {
     }
 
     /* Calculate health score */
-    s_health_score = 100;
-    cluster_pct = (float)s_used_blocks * 100.0f / (float)NAND_TOTAL_CLUSTERS;
-    inode_pct = (float)s_used_inodes * 100.0f / (float)NAND_TOTAL_INODES;
-
-    if (cluster_pct > 95.0f)
-      s_health_score -= 30;
-    else if (cluster_pct > 85.0f)
-      s_health_score -= 15;
-    else if (cluster_pct > 75.0f)
-      s_health_score -= 5;
-
-    if (inode_pct > 95.0f)
-      s_health_score -= 30;
-    else if (inode_pct > 85.0f)
-      s_health_score -= 15;
-    else if (inode_pct > 75.0f)
-      s_health_score -= 5;
-
-    if (import_count > 0)
-      s_health_score -= 10;
-    if (tmp_count > 10)
-      s_health_score -= 5;
-    if (s_health_score < 0)
-      s_health_score = 0;
+    s_health_score = nand_compute_health_score(s_used_blocks, s_used_inodes,
+                                               import_count, tmp_count);
   }
 
   /* Health score display */
@@ -224,23 +265,62 @@ void run_nand_health(void) {
   ui_draw_ok("NAND health check complete");
 
   if (we_initialized)
-    ISFS_Deinitialize();
+    TRACE_CALL("ISFS_Deinitialize", ISFS_Deinitialize());
+}
+
+/*---------------------------------------------------------------------------*/
+void quick_nand_health(quick_result *q) {
+  u32 used_clusters = 0, used_inodes = 0;
+  s32 ret = TRACE_CALL("ISFS_Initialize", ISFS_Initialize());
+  bool we_initialized = (ret >= 0);
+  int score;
+
+  if (ret < 0 && ret != -105) { /* -105 = ISFS_EALREADY */
+    q->level = QUICK_RED;
+    snprintf(q->summary, sizeof(q->summary), "ISFS unavailable (%d)", ret);
+    return;
+  }
+  ret = TRACE_CALL("ISFS_GetUsage",
+                   ISFS_GetUsage("/", &used_clusters, &used_inodes));
+  if (we_initialized)
+    TRACE_CALL("ISFS_Deinitialize", ISFS_Deinitialize());
+  if (ret < 0) {
+    q->level = QUICK_RED;
+    snprintf(q->summary, sizeof(q->summary), "Usage query failed (%d)", ret);
+    return;
+  }
+
+  /* Without the walk, pending imports and temp files are not counted */
+  score = nand_compute_health_score(used_clusters, used_inodes, 0, 0);
+  q->level = score >= 80 ? QUICK_GREEN : score >= 50 ? QUICK_YELLOW : QUICK_RED;
+  snprintf(q->summary, sizeof(q->summary), "%u%% used, score %d/100",
+           used_clusters * 100 / NAND_TOTAL_CLUSTERS, score);
+}
+
+/*---------------------------------------------------------------------------*/
+bool nand_health_get_usage(u32 *clusters_used, u32 *inodes_used) {
+  *clusters_used = s_used_blocks;
+  *inodes_used = s_used_inodes;
+  return s_have_usage;
 }
 
 /*---------------------------------------------------------------------------*/
-void get_nand_health_report(char *buf, int bufsize) {
-  snprintf(buf, bufsize,
-           "=== NAND HEALTH CHECK ===\n"
-           "Clusters Used:       %u / %u\n"
-           "Clusters Free:       %u\n"
-           "Inodes Used:         %u / %u\n"
-           "Inodes Free:         %u\n"
-           "Title Categories:    %d\n"
-           "Ticket Groups:       %d\n"
-           "Health Score:        %d/100\n"
-           "Status:              %s\n"
-           "\n",
-           s_used_blocks, (u32)NAND_TOTAL_CLUSTERS, s_free_blocks,
-           s_used_inodes, (u32)NAND_TOTAL_INODES, s_free_inodes, s_title_count,
-           s_ticket_count, s_health_score, s_health_status);
+void get_nand_health_report(report_rec *out) {
+  rec_text(out, "=== NAND HEALTH CHECK ===\n");
+  rec_line(out);
+  rec_uint(out, "clusters_used", "Clusters Used:       %u", s_used_blocks);
+  rec_uint(out, "clusters_total", " / %u", (u32)NAND_TOTAL_CLUSTERS);
+  rec_line_end(out);
+  rec_uint(out, "clusters_free", "Clusters Free:       %u", s_free_blocks);
+  rec_line(out);
+  rec_uint(out, "inodes_used", "Inodes Used:         %u", s_used_inodes);
+  rec_uint(out, "inodes_total", " / %u", (u32)NAND_TOTAL_INODES);
+  rec_line_end(out);
+  rec_uint(out, "inodes_free", "Inodes Free:         %u", s_free_inodes);
+  rec_int(out, "title_categories", "Title Categories:    %d", s_title_count);
+  rec_int(out, "ticket_groups", "Ticket Groups:       %d", s_ticket_count);
+  rec_int(out, "health_score", "Health Score:        %d/100",
+          s_health_score);
+  rec_str(out, "status", "Status:              %s", s_health_status);
+  rec_text(out, "\n");
 }
@@ -5,10 +5,24 @@
 #ifndef NAND_HEALTH_H
 #define NAND_HEALTH_H
 
+#include <gccore.h>
+
+#include "modules.h"
+
 // Run the NAND health check display
 void run_nand_health(void);
 
-// Get NAND health report as string
-void get_nand_health_report(char *buf, int bufsize);
+// Quick Health Check: usage query only, no directory walk
+void quick_nand_health(quick_result *q);
+
+// Usage from the last scan; false if it has not read it
+bool nand_health_get_usage(u32 *clusters_used, u32 *inodes_used);
+
+// Write the NAND health report section
+void get_nand_health_report(report_rec *out);
+
+// Score NAND usage out of 100 (pure; used by the scan and host benchmarks)
+int nand_compute_health_score(u32 used_clusters, u32 used_inodes,
+                              int import_count, int tmp_count);
 
 #endif // NAND_HEALTH_H
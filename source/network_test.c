@@ -21,6 +21,8 @@
 #include <string.h>
 
 #include "network_test.h"
+#include "results.h"
+#include "task.h"
 #include "ui_common.h"
 
 /* Max APs to display from scan results */
@@ -39,11 +41,51 @@
 #define AOSSAPScan 3
 #endif
 
-static char s_report[6144];
+/* One access point from the last scan */
+typedef struct {
+  char ssid[33];
+  char bssid[20];
+  u8 channel;
+  u8 signal; /* WD_GetRadioLevel: 0 weak .. 3 strong */
+  const char *security;
+} net_ap;
+
+/* WiFi card part of the last run */
+typedef enum {
+  WIFI_SKIPPED,     /* cancelled before it */
+  WIFI_NO_DRIVER,   /* WD_Init failed */
+  WIFI_NO_INFO,     /* WD_GetInfo failed; the scan still ran */
+  WIFI_INFO,
+} wifi_outcome;
+
+/* Report state */
+static bool s_tested = false; /* a run finished */
+static s32 s_connectivity_ret = 0;
+static wifi_outcome s_wifi = WIFI_SKIPPED;
+static char s_mac_str[20];
+static char s_firmware[81];
+static int s_channel = 0;
+static char s_channels[64];
+static s32 s_scan_ret = 0;
+static net_ap s_aps[MAX_SCAN_APS];
+static int s_ap_count = 0;
 static bool s_wifi_working = false;
 static bool s_wifi_driver_ok = false; /* true if WD_Init + card info worked */
 static bool s_ip_obtained = false;
 static char s_ip_str[32] = "N/A";
+static u32 s_rtt_ms = 0; /* fastest successful connect; 0 = none */
+
+/* Connection test targets: a DNS server and a web server by default */
+typedef struct {
+  char desc[48];
+  u32 ip;
+  u16 port;
+} net_target;
+
+static net_target s_targets[NETWORK_TEST_TARGETS] = {
+    {"Google DNS (8.8.8.8:53)", 0x08080808, 53},
+    {"HTTP Test (1.1.1.1:80)", 0x01010101, 80},
+};
 
 /*---------------------------------------------------------------------------*/
 static void ip_to_str(u32 ip, char *buf) {
@@ -77,6 +119,12 @@ static const char *get_signal_str(u8 level) {
   return "Strong";
 }
 
+static const char *get_signal_token(u8 level) {
+  static const char *const tokens[4] = {"weak", "fair", "good", "strong"};
+
+  return tokens[level < 3 ? level : 3];
+}
+
 /*---------------------------------------------------------------------------*/
 static bool test_tcp_connection(const char *host_desc, u32 host_ip, u16 port) {
   s32 sock = net_socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
@@ -104,6 +152,8 @@ static bool test_tcp_connection(const char *host_desc, u32 host_ip, u16 port) {
   net_close(sock);
 
   if (ret >= 0) {
+    if (s_rtt_ms == 0 || (u32)latency_ms < s_rtt_ms)
+      s_rtt_ms = latency_ms < 1.0f ? 1 : (u32)latency_ms;
     snprintf(buf, sizeof(buf), "%s: Connected (%.0f ms)", host_desc,
              latency_ms);
     ui_draw_ok(buf);
@@ -116,10 +166,16 @@ static bool test_tcp_connection(const char *host_desc, u32 host_ip, u16 port) {
   }
 }
 
+static bool test_target(int n) {
+  return test_tcp_connection(s_targets[n].desc, s_targets[n].ip,
+                             s_targets[n].port);
+}
+
 /*---------------------------------------------------------------------------*/
+/* Settle delay; cut short when the task is cancelled */
 static void delay_vsyncs(int count) {
   int i;
-  for (i = 0; i < count; i++)
+  for (i = 0; i < count && !task_cancelled(); i++)
     VIDEO_WaitVSync();
 }
 
@@ -135,27 +191,48 @@ static u16 bss_entry_len(BSSDescriptor *bss) {
   }
 }
 
+/*---------------------------------------------------------------------------*/
+/* Show one AP and keep it for the report */
+static void note_ap(BSSDescriptor *bss) {
+  net_ap *ap = &s_aps[s_ap_count++];
+  char line[128];
+
+  memset(ap->ssid, 0, sizeof(ap->ssid));
+  if (bss->SSIDLength > 0 && bss->SSIDLength <= 32)
+    memcpy(ap->ssid, bss->SSID, bss->SSIDLength);
+  else
+    strcpy(ap->ssid, "(Hidden)");
+
+  mac_to_str(bss->BSSID, ap->bssid);
+  ap->channel = bss->channel;
+  ap->signal = WD_GetRadioLevel(bss);
+  ap->security = get_security_str(bss);
+
+  snprintf(line, sizeof(line), "%-24s Ch:%-2d  Sig:%s  %s", ap->ssid,
+           ap->channel, get_signal_str(ap->signal), ap->security);
+
+  if (ap->signal >= 2)
+    ui_draw_ok(line);
+  else if (ap->signal == 1)
+    ui_draw_warn(line);
+  else
+    ui_draw_err(line);
+}
+
 /*---------------------------------------------------------------------------*/
 /*
  * Parse scan buffer and report APs. Tries format: 2-byte big-endian count
  * then BSSDescriptor list (entry stride from bss_entry_len). Falls back to
  * walking by bss->length if count format yields no valid APs.
  */
-static int do_ap_scan(int *rpos_ptr, u8 *scan_buf, s32 scan_ret) {
-  int rpos = *rpos_ptr;
-  int scan_count = 0;
+static int do_ap_scan(u8 *scan_buf, s32 scan_ret) {
   u8 *ptr = scan_buf;
   u8 *end = scan_buf + SCAN_BUF_SIZE;
 
-  rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                   "\n--- Nearby Access Points ---\n");
-
-  if (scan_ret < 0) {
-    rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                     "  AP scan failed (error %d)\n", (int)scan_ret);
-    *rpos_ptr = rpos;
+  s_scan_ret = scan_ret;
+  s_ap_count = 0;
+  if (scan_ret < 0)
     return -1;
-  }
 
   /* Try format: [count_hi, count_lo] then BSSDescriptor entries */
   if (ptr + 2 <= end) {
@@ -167,10 +244,6 @@ static int do_ap_scan(int *rpos_ptr, u8 *scan_buf, s32 scan_ret) {
       for (i = 0; i < count && ptr < (end - sizeof(BSSDescriptor)); i++) {
         BSSDescriptor *bss = (BSSDescriptor *)ptr;
         u16 entry_len;
-        char ssid[33];
-        char bssid_str[20];
-        char line[128];
-        u8 signal;
 
         if (bss->SSIDLength > 32) {
           entry_len = sizeof(BSSDescriptor);
@@ -190,32 +263,8 @@ static int do_ap_scan(int *rpos_ptr, u8 *scan_buf, s32 scan_ret) {
           continue;
         }
 
-        memset(ssid, 0, sizeof(ssid));
-        if (bss->SSIDLength > 0 && bss->SSIDLength <= 32)
-          memcpy(ssid, bss->SSID, bss->SSIDLength);
-        else
-          strcpy(ssid, "(Hidden)");
-
-        mac_to_str(bss->BSSID, bssid_str);
-        signal = WD_GetRadioLevel(bss);
-
-        snprintf(line, sizeof(line), "%-24s Ch:%-2d  Sig:%s  %s", ssid,
-                 bss->channel, get_signal_str(signal), get_security_str(bss));
-
-        if (signal >= 2)
-          ui_draw_ok(line);
-        else if (signal == 1)
-          ui_draw_warn(line);
-        else
-          ui_draw_err(line);
-
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                         "  %s  BSSID:%s  Ch:%d  Signal:%s  %s\n", ssid,
-                         bssid_str, bss->channel, get_signal_str(signal),
-                         get_security_str(bss));
-
-        scan_count++;
-        if (scan_count >= MAX_SCAN_APS)
+        note_ap(bss);
+        if (s_ap_count >= MAX_SCAN_APS)
           break;
         ptr += entry_len;
       }
@@ -223,11 +272,10 @@ static int do_ap_scan(int *rpos_ptr, u8 *scan_buf, s32 scan_ret) {
   }
 
   /* Fallback: no leading count, stride = bss->length */
-  if (scan_count == 0) {
+  if (s_ap_count == 0) {
     ptr = scan_buf;
-    while (ptr < (end - sizeof(BSSDescriptor)) && scan_count < MAX_SCAN_APS) {
+    while (ptr < (end - sizeof(BSSDescriptor)) && s_ap_count < MAX_SCAN_APS) {
       BSSDescriptor *bss = (BSSDescriptor *)ptr;
-      u16 entry_len;
 
       if (bss->length == 0 || bss->length < sizeof(BSSDescriptor) ||
           bss->SSIDLength > 32)
@@ -239,68 +287,102 @@ static int do_ap_scan(int *rpos_ptr, u8 *scan_buf, s32 scan_ret) {
         continue;
       }
 
-      entry_len = bss->length;
-
-      {
-        char ssid[33];
-        char bssid_str[20];
-        char line[128];
-        u8 signal;
-
-        memset(ssid, 0, sizeof(ssid));
-        if (bss->SSIDLength > 0)
-          memcpy(ssid, bss->SSID, bss->SSIDLength);
-        else
-          strcpy(ssid, "(Hidden)");
-
-        mac_to_str(bss->BSSID, bssid_str);
-        signal = WD_GetRadioLevel(bss);
-
-        snprintf(line, sizeof(line), "%-24s Ch:%-2d  Sig:%s  %s", ssid,
-                 bss->channel, get_signal_str(signal), get_security_str(bss));
-
-        if (signal >= 2)
-          ui_draw_ok(line);
-        else if (signal == 1)
-          ui_draw_warn(line);
-        else
-          ui_draw_err(line);
-
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                         "  %s  BSSID:%s  Ch:%d  Signal:%s  %s\n", ssid,
-                         bssid_str, bss->channel, get_signal_str(signal),
-                         get_security_str(bss));
-      }
-
-      scan_count++;
-      ptr += entry_len;
+      note_ap(bss);
+      ptr += bss->length;
     }
   }
 
-  if (scan_count == 0) {
+  if (s_ap_count == 0) {
     ui_draw_warn("No access points found");
-    rpos +=
-        snprintf(s_report + rpos, sizeof(s_report) - rpos, "  (none found)\n");
   } else {
     char cnt[64];
-    snprintf(cnt, sizeof(cnt), "Found %d access point(s)", scan_count);
+    snprintf(cnt, sizeof(cnt), "Found %d access point(s)", s_ap_count);
     ui_draw_ok(cnt);
   }
 
-  *rpos_ptr = rpos;
-  return scan_count;
+  return s_ap_count;
+}
+
+/*---------------------------------------------------------------------------*/
+int network_parse_ap_scan(u8 *scan_buf, s32 scan_ret) {
+  return do_ap_scan(scan_buf, scan_ret);
+}
+
+/*---------------------------------------------------------------------------*/
+static bool bssid_empty(const BSSDescriptor *bss) {
+  static const u8 zero[6] = {0};
+
+  return memcmp(bss->BSSID, zero, sizeof(zero)) == 0;
+}
+
+static void note_strongest(const BSSDescriptor *bss, char *ssid,
+                           int ssid_size, u16 *rssi, int count) {
+  int len = bss->SSIDLength < ssid_size - 1 ? bss->SSIDLength : ssid_size - 1;
+
+  if (count && (bss->RSSI & 0xFF) <= (*rssi & 0xFF))
+    return;
+  *rssi = bss->RSSI;
+  if (len > 0) {
+    memcpy(ssid, bss->SSID, len);
+    ssid[len] = '\0';
+  } else {
+    snprintf(ssid, ssid_size, "(Hidden)");
+  }
+}
+
+/* Same two layouts as do_ap_scan, without the report or the screen */
+int network_strongest_ap(u8 *scan_buf, s32 scan_ret, char *ssid,
+                         int ssid_size, u16 *rssi) {
+  u8 *end = scan_buf + SCAN_BUF_SIZE;
+  u8 *ptr = scan_buf + 2;
+  u16 count = (u16)((scan_buf[0] << 8) | scan_buf[1]);
+  int found = 0, i;
+
+  if (scan_ret < 0)
+    return 0;
+
+  if (count > 0 && count <= 64) {
+    for (i = 0; i < count && ptr < end - sizeof(BSSDescriptor); i++) {
+      BSSDescriptor *bss = (BSSDescriptor *)ptr;
+      u16 entry_len = sizeof(BSSDescriptor);
+
+      if (bss->SSIDLength <= 32 && bss_entry_len(bss) > entry_len)
+        entry_len = bss_entry_len(bss);
+      if (ptr + entry_len > end)
+        break;
+      if (bss->SSIDLength <= 32 && !bssid_empty(bss))
+        note_strongest(bss, ssid, ssid_size, rssi, found++);
+      ptr += entry_len;
+    }
+  }
+
+  if (found)
+    return found;
+  for (ptr = scan_buf; ptr < end - sizeof(BSSDescriptor);) {
+    BSSDescriptor *bss = (BSSDescriptor *)ptr;
+
+    if (bss->length < sizeof(BSSDescriptor) || bss->SSIDLength > 32)
+      break;
+    if (!bssid_empty(bss))
+      note_strongest(bss, ssid, ssid_size, rssi, found++);
+    ptr += bss->length;
+  }
+  return found;
 }
 
 /*---------------------------------------------------------------------------*/
 void run_network_test(void) {
-  int rpos = 0;
   s32 ret;
   s32 connectivity_ret = 0; /* used for report if connectivity never succeeds */
 
-  memset(s_report, 0, sizeof(s_report));
+  s_tested = false;
+  s_wifi = WIFI_SKIPPED;
+  s_scan_ret = 0;
+  s_ap_count = 0;
   s_wifi_working = false;
   s_wifi_driver_ok = false;
   s_ip_obtained = false;
+  s_rtt_ms = 0;
   strcpy(s_ip_str, "N/A");
 
   /* ======================================================================
@@ -312,7 +394,9 @@ void run_network_test(void) {
   ui_draw_info("This may take up to 15 seconds...");
   ui_printf("\n");
 
+  task_set_progress(0, 5);
   ret = net_init();
+  task_set_progress(1, 5);
 
   if (ret < 0) {
     connectivity_ret = ret;
@@ -375,10 +459,8 @@ void run_network_test(void) {
 
     ui_draw_section("Connection Tests");
     if (s_ip_obtained) {
-      bool dns_ok =
-          test_tcp_connection("Google DNS (8.8.8.8:53)", 0x08080808, 53);
-      bool http_ok =
-          test_tcp_connection("HTTP Test (1.1.1.1:80)", 0x01010101, 80);
+      bool dns_ok = test_target(0);
+      bool http_ok = test_target(1);
       ui_printf("\n");
       if (dns_ok && http_ok) {
         ui_draw_ok("Internet connectivity: FULL");
@@ -404,18 +486,19 @@ void run_network_test(void) {
    * PART 2: WiFi Card Info & AP Scan (after network released)
    * ====================================================================== */
 
+  task_set_progress(2, 5);
   delay_vsyncs(60); /* Give IOS time to release WiFi */
 
-  ui_draw_section("WiFi Card Information");
-  ui_draw_info("Scanning WiFi card and nearby access points...");
-  ui_printf("\n");
-
-  {
+  if (task_cancelled()) {
+    ui_draw_warn("WiFi card info and AP scan skipped (cancelled)");
+  } else {
     WDInfo wdinfo;
-    char mac_str[20];
-    char chan_buf[128];
     bool wd_ready = false;
 
+    ui_draw_section("WiFi Card Information");
+    ui_draw_info("Scanning WiFi card and nearby access points...");
+    ui_printf("\n");
+
     /* Try scan mode first (AOSSAPScan), then normal (0) */
     /* Initial driver probe */
     if (WD_Init(AOSSAPScan) == 0)
@@ -425,8 +508,7 @@ void run_network_test(void) {
 
     if (!wd_ready) {
       ui_draw_err("WiFi driver unavailable (WD_Init failed)");
-      rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                       "WiFi Driver Init: FAILED\n");
+      s_wifi = WIFI_NO_DRIVER;
     } else {
       s_wifi_driver_ok = true;
       /* Do NOT deinit yet - we need it for GetInfo and ScanOnce */
@@ -437,11 +519,14 @@ void run_network_test(void) {
       if (WD_GetInfo(&wdinfo) == 0) {
         int ci, ch_pos = 0;
 
-        mac_to_str(wdinfo.MAC, mac_str);
-        ui_draw_kv("MAC Address", mac_str);
+        s_wifi = WIFI_INFO;
+        mac_to_str(wdinfo.MAC, s_mac_str);
+        ui_draw_kv("MAC Address", s_mac_str);
 
         wdinfo.version[sizeof(wdinfo.version) - 1] = '\0';
-        ui_draw_kv("Firmware", (const char *)wdinfo.version);
+        snprintf(s_firmware, sizeof(s_firmware), "%s",
+                 (const char *)wdinfo.version);
+        ui_draw_kv("Firmware", s_firmware);
 
         {
           /* Only show as country code if both bytes are printable ASCII (e.g.
@@ -457,38 +542,29 @@ void run_network_test(void) {
 
         {
           char ch_str[8];
-          snprintf(ch_str, sizeof(ch_str), "%d", wdinfo.channel);
+          s_channel = wdinfo.channel;
+          snprintf(ch_str, sizeof(ch_str), "%d", s_channel);
           ui_draw_kv("Current Channel", ch_str);
         }
 
-        chan_buf[0] = '\0';
+        /* At most "1, 2, ..., 14": 46 bytes */
+        s_channels[0] = '\0';
         for (ci = 1; ci <= 14; ci++) {
-          if (wdinfo.EnableChannelsMask & (1 << (ci - 1))) {
-            if (ch_pos > 0)
-              ch_pos +=
-                  snprintf(chan_buf + ch_pos, sizeof(chan_buf) - ch_pos, ", ");
-            ch_pos += snprintf(chan_buf + ch_pos, sizeof(chan_buf) - ch_pos,
-                               "%d", ci);
-          }
+          if (wdinfo.EnableChannelsMask & (1 << (ci - 1)))
+            ch_pos += snprintf(s_channels + ch_pos, sizeof(s_channels) - ch_pos,
+                               ch_pos > 0 ? ", %d" : "%d", ci);
         }
         if (ch_pos > 0)
-          ui_draw_kv("Enabled Channels", chan_buf);
+          ui_draw_kv("Enabled Channels", s_channels);
 
         ui_draw_ok("WiFi card info retrieved");
-
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                         "MAC Address:         %s\n"
-                         "Firmware:            %s\n"
-                         "Current Channel:     %d\n"
-                         "Enabled Channels:    %s\n",
-                         mac_str, (const char *)wdinfo.version, wdinfo.channel,
-                         chan_buf);
       } else {
         ui_draw_err("Failed to read WiFi card info");
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                         "WiFi Card Info:      FAILED\n");
+        s_wifi = WIFI_NO_INFO;
       }
 
+      task_set_progress(3, 5);
+
       /* --- AP Scan (WD still initialized; no early WD_Deinit) --- */
       ui_draw_section("WiFi AP Scan");
       ui_draw_info("Scanning for nearby access points...");
@@ -508,18 +584,21 @@ void run_network_test(void) {
         scan_ret = WD_ScanOnce(&sparams, scan_buf, sizeof(scan_buf));
 
         /* Retry once if first scan returned empty */
-        if (scan_ret >= 0 && scan_buf[0] == 0 && scan_buf[1] == 0) {
+        if (scan_ret >= 0 && scan_buf[0] == 0 && scan_buf[1] == 0 &&
+            !task_cancelled()) {
           delay_vsyncs(45);
           scan_ret = WD_ScanOnce(&sparams, scan_buf, sizeof(scan_buf));
         }
 
-        do_ap_scan(&rpos, scan_buf, scan_ret);
+        do_ap_scan(scan_buf, scan_ret);
       }
     }
   }
 
+  task_set_progress(4, 5);
+
   /* Retry connectivity after WD released the driver (often fixes -24) */
-  if (!s_wifi_working) {
+  if (!s_wifi_working && !task_cancelled()) {
     ui_draw_section("Network Connectivity (retry)");
     ui_draw_info("Retrying... driver was released after scan.");
     delay_vsyncs(90);
@@ -556,10 +635,8 @@ void run_network_test(void) {
 
       ui_draw_section("Connection Tests");
       if (s_ip_obtained) {
-        bool dns_ok =
-            test_tcp_connection("Google DNS (8.8.8.8:53)", 0x08080808, 53);
-        bool http_ok =
-            test_tcp_connection("HTTP Test (1.1.1.1:80)", 0x01010101, 80);
+        bool dns_ok = test_target(0);
+        bool http_ok = test_target(1);
         ui_printf("\n");
         if (dns_ok && http_ok) {
           ui_draw_ok("Internet connectivity: FULL");
@@ -596,26 +673,7 @@ void run_network_test(void) {
     }
   }
 
-  if (s_wifi_working) {
-    rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                     "\n=== NETWORK CONNECTIVITY ===\nWiFi Status: OK\n");
-  } else {
-    if (connectivity_ret == -24)
-      rpos += snprintf(
-          s_report + rpos, sizeof(s_report) - rpos,
-          "\n=== NETWORK CONNECTIVITY ===\nWiFi Status: Not connected (error "
-          "-24)\n"
-          "  (normal when no connection is configured in Wii Settings)\n");
-    else
-      rpos += snprintf(
-          s_report + rpos, sizeof(s_report) - rpos,
-          "\n=== NETWORK CONNECTIVITY ===\nWiFi Status: FAILED (error %d)\n",
-          connectivity_ret);
-    if (connectivity_ret == -116)
-      rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-                       "  (error -116 = timeout / no response from router; AP "
-                       "scan still succeeded)\n");
-  }
+  s_connectivity_ret = connectivity_ret;
 
   /* Tips */
   ui_draw_section("WiFi Notes");
@@ -624,31 +682,114 @@ void run_network_test(void) {
   ui_draw_info("WPA3 and 5GHz networks are NOT supported");
   ui_draw_info("For Wiimmfi, ports 28910 and 29900-29901 must be open");
 
-  /* Report header */
-  {
-    char hdr[512];
-    int hlen = snprintf(hdr, sizeof(hdr),
-                        "=== NETWORK TEST ===\n"
-                        "Net Build:           " __DATE__ " " __TIME__ "\n"
-                        "WiFi Module:         %s\n"
-                        "IP Address:          %s\n\n",
-                        s_wifi_driver_ok ? "Working" : "Failed", s_ip_str);
-
-    if (hlen + rpos < (int)sizeof(s_report)) {
-      memmove(s_report + hlen, s_report, rpos + 1);
-      memcpy(s_report, hdr, hlen);
-      rpos += hlen;
-    }
-  }
-
-  rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos, "\n");
+  s_tested = true;
 
   ui_printf("\n");
   ui_draw_ok("Network test complete");
 }
 
 /*---------------------------------------------------------------------------*/
-void get_network_test_report(char *buf, int bufsize) {
-  strncpy(buf, s_report, bufsize - 1);
-  buf[bufsize - 1] = '\0';
+void network_test_set_target(int n, u32 ip, u16 port) {
+  char ip_str[16];
+
+  if (n < 0 || n >= NETWORK_TEST_TARGETS)
+    return;
+  ip_to_str(ip, ip_str);
+  snprintf(s_targets[n].desc, sizeof(s_targets[n].desc), "Target %d (%s:%u)",
+           n + 1, ip_str, port);
+  s_targets[n].ip = ip;
+  s_targets[n].port = port;
+}
+
+/*---------------------------------------------------------------------------*/
+void quick_network_test(quick_result *q) {
+  if (!result_fresh(MODULE_NETWORK)) {
+    q->level = QUICK_UNKNOWN;
+    snprintf(q->summary, sizeof(q->summary), "Not tested recently");
+  } else if (s_ip_obtained) {
+    q->level = QUICK_GREEN;
+    snprintf(q->summary, sizeof(q->summary), "Online, IP %s", s_ip_str);
+  } else if (s_wifi_working) {
+    q->level = QUICK_YELLOW;
+    snprintf(q->summary, sizeof(q->summary), "WiFi OK, no IP address");
+  } else {
+    q->level = QUICK_RED;
+    snprintf(q->summary, sizeof(q->summary), "WiFi module not working");
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+u32 network_test_get_rtt(void) { return s_rtt_ms; }
+
+void get_network_test_report(report_rec *out) {
+  int i;
+
+  if (!s_tested)
+    return;
+  rec_text(out, "=== NETWORK TEST ===\n"
+                "Net Build:           " __DATE__ " " __TIME__ "\n");
+  rec_bool(out, "wifi_module", "WiFi Module:         %s", s_wifi_driver_ok,
+           "Working", "Failed");
+  rec_str(out, "ip", "IP Address:          %s", s_ip_str);
+  rec_text(out, "\n");
+
+  switch (s_wifi) {
+  case WIFI_SKIPPED:
+    rec_enum(out, "wifi", "WiFi Scan:           %s", "skipped",
+             "Skipped (cancelled)");
+    break;
+  case WIFI_NO_DRIVER:
+    rec_enum(out, "wifi", "WiFi Driver Init: %s", "no_driver", "FAILED");
+    break;
+  case WIFI_NO_INFO:
+    rec_enum(out, "wifi", "WiFi Card Info:      %s", "no_info", "FAILED");
+    break;
+  case WIFI_INFO:
+    rec_enum(out, "wifi", NULL, "ok", NULL);
+    rec_str(out, "mac", "MAC Address:         %s", s_mac_str);
+    rec_str(out, "firmware", "Firmware:            %s", s_firmware);
+    rec_int(out, "channel", "Current Channel:     %d", s_channel);
+    rec_str(out, "channels", "Enabled Channels:    %s", s_channels);
+    break;
+  }
+
+  if (s_wifi == WIFI_NO_INFO || s_wifi == WIFI_INFO) {
+    rec_text(out, "\n--- Nearby Access Points ---\n");
+    if (s_scan_ret < 0)
+      rec_int(out, "scan_error", "  AP scan failed (error %d)", s_scan_ret);
+    else if (s_ap_count == 0)
+      rec_text(out, "  (none found)\n");
+    rec_list(out, "access_points");
+    for (i = 0; i < s_ap_count; i++) {
+      const net_ap *ap = &s_aps[i];
+      rec_item(out);
+      rec_str(out, "ssid", "  %s", ap->ssid);
+      rec_str(out, "bssid", "  BSSID:%s", ap->bssid);
+      rec_uint(out, "channel", "  Ch:%u", ap->channel);
+      rec_enum(out, "signal", "  Signal:%s", get_signal_token(ap->signal),
+               get_signal_str(ap->signal));
+      rec_str(out, "security", "  %s", ap->security);
+      rec_item_end(out);
+    }
+    rec_list_end(out);
+  }
+
+  rec_text(out, "\n=== NETWORK CONNECTIVITY ===\n");
+  if (s_wifi_working) {
+    rec_bool(out, "connected", "WiFi Status: %s", true, "OK", NULL);
+  } else {
+    rec_line(out);
+    rec_bool(out, "connected", "WiFi Status: %s", false, NULL,
+             s_connectivity_ret == -24 ? "Not connected" : "FAILED");
+    rec_int(out, "error", " (error %d)", s_connectivity_ret);
+    rec_line_end(out);
+  }
+  rec_uint(out, "rtt_ms", NULL, s_rtt_ms);
+  if (!s_wifi_working && s_connectivity_ret == -24)
+    rec_text(out, "  (normal when no connection is configured in Wii "
+                  "Settings)\n");
+  if (!s_wifi_working && s_connectivity_ret == -116)
+    rec_text(out, "  (error -116 = timeout / no response from router; AP "
+                  "scan still succeeded)\n");
+  rec_text(out, "\n");
 }
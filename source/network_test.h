@@ -5,10 +5,37 @@
 #ifndef NETWORK_TEST_H
 #define NETWORK_TEST_H
 
+#include <gccore.h>
+
+#include "modules.h"
+
+// Connection tests run against this many TCP targets
+#define NETWORK_TEST_TARGETS 2
+
 // Run the network connectivity test
 void run_network_test(void);
 
-// Get network test report as string
-void get_network_test_report(char *buf, int bufsize);
+// Replace connection test target n (0 = DNS, 1 = HTTP by default); ip is
+// host order
+void network_test_set_target(int n, u32 ip, u16 port);
+
+// Quick Health Check: state from a fresh full test; bringing up the network
+// takes far longer than the check's budget
+void quick_network_test(quick_result *q);
+
+// Fastest TCP connect of the last run in ms; 0 if none connected
+u32 network_test_get_rtt(void);
+
+// Write the network test report section
+void get_network_test_report(report_rec *out);
+
+// Parse a raw WD_ScanOnce() buffer into the AP list the report shows
+int network_parse_ap_scan(u8 *scan_buf, s32 scan_ret);
+
+// Strongest access point in a raw WD_ScanOnce() buffer (4 KB, as the test
+// uses): its SSID and the driver's RSSI. Returns the number of access
+// points, 0 if the scan failed or found none.
+int network_strongest_ap(u8 *scan_buf, s32 scan_ret, char *ssid,
+                         int ssid_size, u16 *rssi);
 
 #endif // NETWORK_TEST_H
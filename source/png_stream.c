@@ -0,0 +1,306 @@
+/*
+ * WiiMedic - png_stream.c
+ * Minimal PNG encoder for screenshots. Rows use the Sub filter (each byte
+ * minus the same channel of the pixel to its left), which turns the flat
+ * black background and the solid glyph strokes of a text screen into runs
+ * of one byte value, and a glyph row often repeats the one above it.
+ * Deflate then only needs one fixed-Huffman block with literals and two
+ * kinds of match: a run of the previous byte (distance 1) and a stretch
+ * equal to the previous row (distance one row). No hash chains, no window
+ * search, no per-image tables, and most of the 900 KB of pixel data goes
+ * away. Output is buffered up to one IDAT chunk and written as it fills.
+ */
+
+#include <gccore.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "png_stream.h"
+
+#define PNG_FILTER_SUB 1
+#define ADLER_MOD 65521
+#define ADLER_NMAX 5552 /* bytes before the sums can overflow 32 bits */
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_END_BLOCK 256
+
+/* Fixed Huffman literal/length codes, bit-reversed for an LSB-first
+   stream, and the length symbols with their extra bits */
+static u16 s_lit_code[288];
+static u8 s_lit_bits[288];
+static u16 s_len_sym[DEFLATE_MAX_MATCH + 1];
+static u8 s_len_extra_bits[DEFLATE_MAX_MATCH + 1];
+static u8 s_len_extra[DEFLATE_MAX_MATCH + 1];
+static u32 s_crc_table[256];
+static bool s_tables_ready = false;
+
+static const u16 s_len_base[29] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
+                                   15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
+                                   67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const u8 s_len_base_bits[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                       1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                       4, 4, 4, 4, 5, 5, 5, 5, 0};
+/* Distance code k covers distances from s_dist_base[k], with k / 2 - 1
+   extra bits from k = 4 on */
+static const u16 s_dist_base[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+
+/*---------------------------------------------------------------------------*/
+static u16 reverse_bits(u16 code, int bits) {
+  u16 r = 0;
+  int i;
+
+  for (i = 0; i < bits; i++)
+    r |= ((code >> i) & 1) << (bits - 1 - i);
+  return r;
+}
+
+static void build_tables(void) {
+  u32 sym, len, n, k;
+
+  for (sym = 0; sym < 288; sym++) {
+    u16 code;
+    int bits;
+
+    if (sym < 144) {
+      code = 0x30 + sym;
+      bits = 8;
+    } else if (sym < 256) {
+      code = 0x190 + sym - 144;
+      bits = 9;
+    } else if (sym < 280) {
+      code = sym - 256;
+      bits = 7;
+    } else {
+      code = 0xC0 + sym - 280;
+      bits = 8;
+    }
+    s_lit_code[sym] = reverse_bits(code, bits);
+    s_lit_bits[sym] = (u8)bits;
+  }
+
+  for (len = DEFLATE_MIN_MATCH, k = 0; len <= DEFLATE_MAX_MATCH; len++) {
+    while (k < 28 && len >= s_len_base[k + 1])
+      k++;
+    s_len_sym[len] = (u16)(257 + k);
+    s_len_extra_bits[len] = s_len_base_bits[k];
+    s_len_extra[len] = (u8)(len - s_len_base[k]);
+  }
+
+  for (n = 0; n < 256; n++) {
+    u32 c = n;
+
+    for (k = 0; k < 8; k++)
+      c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+    s_crc_table[n] = c;
+  }
+  s_tables_ready = true;
+}
+
+static u32 crc_update(u32 crc, const u8 *p, u32 len) {
+  while (len--)
+    crc = s_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+static void put_be32(u8 *p, u32 v) {
+  p[0] = (u8)(v >> 24);
+  p[1] = (u8)(v >> 16);
+  p[2] = (u8)(v >> 8);
+  p[3] = (u8)v;
+}
+
+/*---------------------------------------------------------------------------*/
+static void write_bytes(png_stream *p, const void *data, u32 len) {
+  if (p->failed)
+    return;
+  if (fwrite(data, 1, len, p->fp) != len)
+    p->failed = true;
+  p->bytes += len;
+}
+
+static void write_chunk(png_stream *p, const char *type, const u8 *data,
+                        u32 len) {
+  u8 head[8];
+  u32 crc;
+
+  put_be32(head, len);
+  memcpy(head + 4, type, 4);
+  crc = crc_update(0xFFFFFFFF, head + 4, 4);
+  crc = crc_update(crc, data, len) ^ 0xFFFFFFFF;
+  write_bytes(p, head, 8);
+  write_bytes(p, data, len);
+  put_be32(head, crc);
+  write_bytes(p, head, 4);
+}
+
+static void out_byte(png_stream *p, u8 b) {
+  p->out[p->out_len++] = b;
+  if (p->out_len == PNG_IDAT_SIZE) {
+    write_chunk(p, "IDAT", p->out, p->out_len);
+    p->out_len = 0;
+  }
+}
+
+/* value's low n bits (n <= 16), first bit first */
+static void put_bits(png_stream *p, u32 value, u32 n) {
+  p->bitbuf |= value << p->bitcount;
+  p->bitcount += n;
+  while (p->bitcount >= 8) {
+    out_byte(p, (u8)p->bitbuf);
+    p->bitbuf >>= 8;
+    p->bitcount -= 8;
+  }
+}
+
+static void put_symbol(png_stream *p, u32 sym) {
+  put_bits(p, s_lit_code[sym], s_lit_bits[sym]);
+}
+
+/*---------------------------------------------------------------------------*/
+static void adler_update(png_stream *p, const u8 *data, u32 len) {
+  u32 a = p->adler_a, b = p->adler_b;
+
+  while (len) {
+    u32 n = len < ADLER_NMAX ? len : ADLER_NMAX;
+
+    len -= n;
+    while (n--) {
+      a += *data++;
+      b += a;
+    }
+    a %= ADLER_MOD;
+    b %= ADLER_MOD;
+  }
+  p->adler_a = a;
+  p->adler_b = b;
+}
+
+static void put_length(png_stream *p, u32 len) {
+  put_symbol(p, s_len_sym[len]);
+  put_bits(p, s_len_extra[len], s_len_extra_bits[len]);
+}
+
+/* Literals, except where a run of the previous byte (distance 1, distance
+   code 0: five zero bits) or a stretch equal to the row above (up, NULL
+   for the first row) is long enough to be a match */
+static void deflate_row(png_stream *p, const u8 *data, const u8 *up,
+                        u32 len) {
+  u32 i = 0;
+
+  while (i < len) {
+    u32 max = len - i < DEFLATE_MAX_MATCH ? len - i : DEFLATE_MAX_MATCH;
+    u32 run = 0, same = 0;
+    u8 c = data[i];
+
+    if (p->last == c) {
+      while (run < max && data[i + run] == c)
+        run++;
+    }
+    if (up) {
+      while (same < max && data[i + same] == up[i + same])
+        same++;
+    }
+
+    if (same >= DEFLATE_MIN_MATCH && same > run) {
+      put_length(p, same);
+      put_bits(p, p->up_code, 5);
+      put_bits(p, p->up_extra, p->up_extra_bits);
+      p->last = data[i + same - 1];
+      i += same;
+    } else if (run >= DEFLATE_MIN_MATCH) {
+      put_length(p, run);
+      put_bits(p, 0, 5);
+      i += run;
+    } else {
+      put_symbol(p, c);
+      p->last = c;
+      i++;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+bool png_begin(png_stream *p, FILE *fp, u32 width, u32 height) {
+  static const u8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  u32 row = width * 3 + 1, k = 0;
+  u8 ihdr[13];
+
+  if (width == 0 || width > PNG_MAX_WIDTH)
+    return false;
+  if (!s_tables_ready)
+    build_tables();
+
+  /* One row back, in the stream: the filter byte plus width pixels */
+  while (k < 29 && row >= s_dist_base[k + 1])
+    k++;
+  p->up_code = reverse_bits((u16)k, 5);
+  p->up_extra_bits = (u8)(k < 4 ? 0 : k / 2 - 1);
+  p->up_extra = (u16)(row - s_dist_base[k]);
+
+  p->fp = fp;
+  p->width = width;
+  p->height = height;
+  p->rows = 0;
+  p->adler_a = 1;
+  p->adler_b = 0;
+  p->bitbuf = 0;
+  p->bitcount = 0;
+  p->last = -1;
+  p->out_len = 0;
+  p->bytes = 0;
+  p->failed = false;
+
+  write_bytes(p, signature, sizeof(signature));
+  put_be32(ihdr, width);
+  put_be32(ihdr + 4, height);
+  ihdr[8] = 8;  /* bits per channel */
+  ihdr[9] = 2;  /* RGB */
+  ihdr[10] = 0; /* deflate */
+  ihdr[11] = 0; /* adaptive filtering */
+  ihdr[12] = 0; /* not interlaced */
+  write_chunk(p, "IHDR", ihdr, sizeof(ihdr));
+
+  /* zlib header (deflate, 32K window, no dictionary), then the one block:
+     final, fixed Huffman codes */
+  out_byte(p, 0x78);
+  out_byte(p, 0x01);
+  put_bits(p, 1, 1);
+  put_bits(p, 1, 2);
+  return true;
+}
+
+void png_row(png_stream *p, const u8 *rgb) {
+  u32 n = p->width * 3, i;
+  u8 *f = p->filtered[p->rows & 1];
+  const u8 *up = p->rows ? p->filtered[(p->rows - 1) & 1] : NULL;
+
+  f[0] = PNG_FILTER_SUB;
+  f[1] = rgb[0];
+  f[2] = rgb[1];
+  f[3] = rgb[2];
+  for (i = 3; i < n; i++)
+    f[i + 1] = (u8)(rgb[i] - rgb[i - 3]);
+
+  adler_update(p, f, n + 1);
+  deflate_row(p, f, up, n + 1);
+  p->rows++;
+}
+
+bool png_end(png_stream *p) {
+  u8 adler[4];
+  u32 i;
+
+  put_symbol(p, DEFLATE_END_BLOCK);
+  if (p->bitcount)
+    put_bits(p, 0, 8 - p->bitcount);
+  put_be32(adler, p->adler_b << 16 | p->adler_a);
+  for (i = 0; i < 4; i++)
+    out_byte(p, adler[i]);
+  if (p->out_len)
+    write_chunk(p, "IDAT", p->out, p->out_len);
+  write_chunk(p, "IEND", NULL, 0);
+  return !p->failed && p->rows == p->height;
+}
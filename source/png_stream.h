@@ -0,0 +1,46 @@
+/*
+ * WiiMedic - png_stream.h
+ * Streaming PNG writer: RGB rows go in one at a time and leave compressed,
+ * in fixed-size IDAT chunks, so the image is never held whole
+ */
+#ifndef PNG_STREAM_H
+#define PNG_STREAM_H
+
+#include <gccore.h>
+#include <stdio.h>
+
+#define PNG_IDAT_SIZE 16384 // compressed bytes per IDAT chunk
+#define PNG_MAX_WIDTH 1024
+
+typedef struct {
+  FILE *fp;
+  u32 width;
+  u32 height;
+  u32 rows;      // rows written so far
+  u32 adler_a;   // Adler-32 of the uncompressed stream, kept as its halves
+  u32 adler_b;
+  u32 bitbuf;    // deflate bits not yet in out, LSB first
+  u32 bitcount;
+  int last;      // last byte of the uncompressed stream, -1 before the first
+  u16 up_code;   // distance code of one row back, and its extra bits
+  u8 up_extra_bits;
+  u16 up_extra;
+  u32 out_len;
+  u32 bytes;     // file bytes written
+  bool failed;   // a write failed; the rest is skipped
+  u8 out[PNG_IDAT_SIZE];
+  u8 filtered[2][1 + PNG_MAX_WIDTH * 3]; // this row and the one before
+} png_stream;
+
+// Write the signature and header of a width x height 8-bit RGB image to fp
+// (opened "wb"). Returns false if width is 0 or over PNG_MAX_WIDTH.
+bool png_begin(png_stream *p, FILE *fp, u32 width, u32 height);
+
+// Add the next row: width RGB triplets
+void png_row(png_stream *p, const u8 *rgb);
+
+// Finish the image after the last row (the caller closes fp). Returns
+// false if any write failed or rows are missing.
+bool png_end(png_stream *p);
+
+#endif // PNG_STREAM_H
@@ -0,0 +1,125 @@
+/*
+ * WiiMedic - precompute.c
+ * Speculative module runs. One module at a time runs as a background task
+ * (below every other thread that does work) with its output captured into a
+ * line store instead of the screen. A finished run is stamped like one the
+ * user started, and its screen stays valid for as long as that stamp does.
+ * Anything the user selects stops the task first, so background work never
+ * holds a resource a foreground module needs; only modules flagged free of
+ * side effects (no radio, no writes) are eligible.
+ */
+
+#include <gccore.h>
+
+#include "io_arena.h"
+#include "line_store.h"
+#include "precompute.h"
+#include "results.h"
+#include "startup.h"
+#include "task.h"
+#include "ui_common.h"
+
+typedef struct {
+  line_store lines;
+  u64 stamp; /* result_stamped_at when lines were captured, 0 = none */
+} pre_screen;
+
+static pre_screen s_screens[MODULE_COUNT];
+static task_t s_task;
+static int s_running = -1;      /* module id of s_task, -1 = none */
+static bool s_captured = false; /* s_task's output went into its screen */
+static bool s_disabled = false; /* no thread could be created */
+
+/*---------------------------------------------------------------------------*/
+static bool screen_valid(module_id id) {
+  const pre_screen *s = &s_screens[id];
+
+  return s->stamp && result_fresh(id) && result_stamped_at(id) == s->stamp;
+}
+
+static bool wanted(module_id id) {
+  const module_desc *m = module_get(id);
+
+  return (m->flags & MOD_F_PRECOMPUTE) && m->menu_label && m->run &&
+         !screen_valid(id);
+}
+
+static void pre_entry(void) {
+  module_id id = (module_id)s_running;
+
+  /* Without a capture the output would reach the screen */
+  if (!ui_output_capture(&s_screens[id].lines))
+    return;
+  s_captured = true;
+  module_get(id)->run();
+}
+
+/* Join the finished task; keep its screen only if it ran to the end */
+static void finish(void) {
+  module_id id = (module_id)s_running;
+  pre_screen *s = &s_screens[id];
+
+  task_join(&s_task);
+  io_scratch_reset();
+  if (s_captured && !s_task.cancel) {
+    result_stamp(id);
+    s->stamp = result_stamped_at(id);
+  } else {
+    /* A cancelled run has overwritten part of the old results */
+    if (s_captured)
+      result_invalidate(id);
+    line_store_clear(&s->lines);
+    s->stamp = 0;
+  }
+  s_running = -1;
+}
+
+/*---------------------------------------------------------------------------*/
+void precompute_poll(int highlighted, bool idle) {
+  int id = -1, i;
+
+  if (s_running >= 0) {
+    if (__atomic_load_n(&s_task.done, __ATOMIC_ACQUIRE))
+      finish();
+    return;
+  }
+  if (!idle || s_disabled || !devices_ready(DEV_ALL))
+    return;
+
+  if (highlighted >= 0 && wanted((module_id)highlighted))
+    id = highlighted;
+  for (i = 0; id < 0 && i < MODULE_COUNT; i++) {
+    if (wanted((module_id)i))
+      id = i;
+  }
+  if (id < 0)
+    return;
+
+  line_store_clear(&s_screens[id].lines);
+  s_screens[id].stamp = 0;
+  s_running = id;
+  s_captured = false;
+  if (!task_start_background(&s_task, module_get((module_id)id)->name,
+                             pre_entry, NULL)) {
+    s_running = -1;
+    s_disabled = true;
+  }
+}
+
+void precompute_stop(int keep) {
+  if (s_running < 0)
+    return;
+  if (s_running != keep)
+    task_cancel(&s_task);
+  while (!__atomic_load_n(&s_task.done, __ATOMIC_ACQUIRE))
+    VIDEO_WaitVSync();
+  finish();
+}
+
+bool precompute_take(module_id id) {
+  if (!screen_valid(id))
+    return false;
+  ui_scroll_adopt(&s_screens[id].lines);
+  s_screens[id].stamp = 0;
+  return true;
+}
@@ -0,0 +1,30 @@
+/*
+ * WiiMedic - precompute.h
+ * Runs cheap, read-only modules (MOD_F_PRECOMPUTE) in the background while
+ * the user sits in the menu, so selecting one shows its screen at once
+ */
+#ifndef PRECOMPUTE_H
+#define PRECOMPUTE_H
+
+#include <gccore.h>
+
+#include "modules.h"
+
+// Menu time without input before background work starts
+#define PRECOMPUTE_IDLE_MS 500
+
+// Start, or collect, background work. Call every menu frame; highlighted is
+// the module under the cursor (tried first) or -1, idle is true once no
+// input came for PRECOMPUTE_IDLE_MS. UI thread.
+void precompute_poll(int highlighted, bool idle);
+
+// Stop background work before the UI thread does anything else. A run of
+// module keep (or -1 for none) is waited for instead of cancelled. UI thread.
+void precompute_stop(int keep);
+
+// If id's screen was precomputed and its results have not been replaced or
+// gone stale since, start the scroll buffer with it and return true: the
+// caller only has to ui_scroll_view it. Call after precompute_stop(id).
+bool precompute_take(module_id id);
+
+#endif // PRECOMPUTE_H
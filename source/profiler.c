@@ -0,0 +1,596 @@
+/*
+ * WiiMedic - profiler.c
+ * Sampling profiler: records the interrupted PC plus a short call stack into
+ * a fixed ring buffer, then symbolizes against the linker map and writes a
+ * flat profile and folded stacks (flamegraph.pl input) to SD/USB.
+ *
+ * Console: a periodic alarm keeps the decrementer firing at the sample rate
+ * and a hook in front of libogc's decrementer exception handler reads SRR0,
+ * LR and the EABI back chain from the saved frame_context.
+ * Host: SIGPROF (ITIMER_PROF) with a frame-pointer walk.
+ */
+
+#ifdef WIIMEDIC_PROFILE
+
+#include <gccore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIIMEDIC_HOST
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#else
+#include <ogc/context.h>
+#endif
+
+#include "profiler.h"
+
+#define PROF_MAX_SAMPLES 8192
+#define PROF_DEPTH 8
+#define PROF_MAP_LINE 512
+
+typedef struct {
+  uintptr_t pc[PROF_DEPTH]; /* [0] = leaf */
+  u8 depth;
+} prof_sample;
+
+typedef struct {
+  uintptr_t addr;
+  char *name;
+} prof_sym;
+
+/* Rough buckets so a run answers "IPC, FAT or rendering?" at a glance.
+   A sample goes to the first bucket that matches walking out from the leaf. */
+typedef struct {
+  const char *name;
+  const char *prefixes[8];
+} prof_category;
+
+static const prof_category s_categories[] = {
+    {"IPC (ES/ISFS/IOS)",
+     {"ES_", "ISFS_", "IOS_", "__IOS", "__ES", "__ISFS", "iosAlloc", NULL}},
+    {"FAT / stdio I/O",
+     {"_FAT_", "fat", "fwrite", "fread", "fopen", "fclose", "fflush", NULL}},
+    {"Console rendering",
+     {"__console", "console", "VIDEO_", "ui_", "vprintf", "printf", NULL}},
+    {"Network / WD", {"net_", "WD_", "__net", "NCD", NULL}},
+    {"Controllers", {"WPAD_", "PAD_", "wiiuse", "__wpad", NULL}},
+};
+#define PROF_NUM_CATEGORIES                                                    \
+  (int)(sizeof(s_categories) / sizeof(s_categories[0]))
+
+static prof_sample s_samples[PROF_MAX_SAMPLES];
+static volatile u32 s_head = 0; /* total samples taken since prof_start */
+static volatile bool s_running = false;
+
+/*===========================================================================*/
+/* Samplers                                                                  */
+/*===========================================================================*/
+
+static inline void record_sample(const uintptr_t *pcs, int depth) {
+  prof_sample *s = &s_samples[s_head % PROF_MAX_SAMPLES];
+  int i;
+  for (i = 0; i < depth; i++)
+    s->pc[i] = pcs[i];
+  s->depth = (u8)depth;
+  s_head++;
+}
+
+#ifdef WIIMEDIC_HOST
+/*---------------------------------------------------------------------------*/
+static void sigprof_handler(int sig, siginfo_t *info, void *uctx) {
+  ucontext_t *uc = (ucontext_t *)uctx;
+  uintptr_t pcs[PROF_DEPTH];
+  uintptr_t fp, sp;
+  int depth = 0;
+
+  if (!s_running)
+    return;
+
+  pcs[depth++] = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+  fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+  sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+
+  /* Needs -fno-omit-frame-pointer (host.mk adds it with PROFILE=1) */
+  while (depth < PROF_DEPTH && fp >= sp && fp - sp < 8 * 1024 * 1024 &&
+         (fp & 7) == 0) {
+    uintptr_t next = ((uintptr_t *)fp)[0];
+    uintptr_t ret = ((uintptr_t *)fp)[1];
+    if (ret == 0)
+      break;
+    pcs[depth++] = ret;
+    if (next <= fp)
+      break;
+    fp = next;
+  }
+  record_sample(pcs, depth);
+}
+
+void prof_start(int hz) {
+  struct sigaction sa;
+  struct itimerval it;
+
+  s_head = 0;
+  s_running = true;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = sigprof_handler;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGPROF, &sa, NULL);
+
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = 1000000 / hz;
+  it.it_value = it.it_interval;
+  setitimer(ITIMER_PROF, &it, NULL);
+}
+
+void prof_stop(void) {
+  struct itimerval it;
+  memset(&it, 0, sizeof(it));
+  setitimer(ITIMER_PROF, &it, NULL);
+  s_running = false;
+}
+
+/*---------------------------------------------------------------------------*/
+static int map_candidates(char paths[][256], int max) {
+  char exe[240];
+  ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+  if (n <= 0 || max < 1)
+    return 0;
+  exe[n] = '\0';
+  snprintf(paths[0], 256, "%s.map", exe);
+  return 1;
+}
+
+#else /* console */
+/*---------------------------------------------------------------------------*/
+#ifndef EX_DEC
+#define EX_DEC 8
+#endif
+
+/* libogc's exception dispatch table (lib/libogc/exception.c) */
+extern void (*_exceptionhandlertable[])(frame_context *);
+
+static void (*s_prev_dec_handler)(frame_context *) = NULL;
+static syswd_t s_alarm;
+
+static inline bool is_stack_addr(u32 sp) {
+  return (sp & 7) == 0 &&
+         ((sp >= 0x80000000 && sp < 0x81800000) ||
+          (sp >= 0x90000000 && sp < 0x94000000));
+}
+
+static void dec_sampler(frame_context *ctx) {
+  if (s_running) {
+    uintptr_t pcs[PROF_DEPTH];
+    int depth = 0;
+    u32 sp = ctx->GPR[1];
+
+    pcs[depth++] = ctx->SRR0;
+    pcs[depth++] = ctx->LR; /* caller, even if the leaf never saved LR */
+
+    /* EABI frame: [sp] = back chain, [sp + 4] = saved LR of the caller */
+    if (is_stack_addr(sp))
+      sp = *(u32 *)sp;
+    while (depth < PROF_DEPTH && is_stack_addr(sp)) {
+      u32 lr = *(u32 *)(sp + 4);
+      if (lr == 0)
+        break;
+      pcs[depth++] = lr;
+      sp = *(u32 *)sp;
+    }
+    record_sample(pcs, depth);
+  }
+  s_prev_dec_handler(ctx);
+}
+
+/* Nothing to do: the alarm only exists to keep the decrementer ticking */
+static void alarm_tick(syswd_t alarm, void *arg) {}
+
+void prof_start(int hz) {
+  struct timespec period;
+  u32 level;
+
+  s_head = 0;
+
+  _CPU_ISR_Disable(level);
+  if (!s_prev_dec_handler) {
+    s_prev_dec_handler = _exceptionhandlertable[EX_DEC];
+    _exceptionhandlertable[EX_DEC] = dec_sampler;
+  }
+  s_running = true;
+  _CPU_ISR_Restore(level);
+
+  period.tv_sec = 0;
+  period.tv_nsec = 1000000000 / hz;
+  SYS_CreateAlarm(&s_alarm);
+  SYS_SetPeriodicAlarm(s_alarm, &period, &period, alarm_tick, NULL);
+}
+
+void prof_stop(void) {
+  u32 level;
+
+  SYS_RemoveAlarm(s_alarm);
+
+  _CPU_ISR_Disable(level);
+  s_running = false;
+  if (s_prev_dec_handler) {
+    _exceptionhandlertable[EX_DEC] = s_prev_dec_handler;
+    s_prev_dec_handler = NULL;
+  }
+  _CPU_ISR_Restore(level);
+}
+
+/*---------------------------------------------------------------------------*/
+/* "make install" copies boot.elf.map next to boot.dol in PROFILE builds */
+static int map_candidates(char paths[][256], int max) {
+  static const char *const dirs[] = {"sd:/apps/WiiMedic", "usb:/apps/WiiMedic",
+                                     "sd:", "usb:"};
+  int i, n = 0;
+  for (i = 0; i < 4 && n < max; i++)
+    snprintf(paths[n++], 256, "%s/boot.elf.map", dirs[i]);
+  return n;
+}
+#endif /* WIIMEDIC_HOST */
+
+/*===========================================================================*/
+/* Symbolization against the GNU ld map                                      */
+/*===========================================================================*/
+
+#define PROF_MAX_RANGES 4
+
+static prof_sym *s_syms = NULL;
+static int s_sym_count = 0;
+static int s_sym_cap = 0;
+
+/* Executable output sections (.init/.text); PCs outside them stay raw */
+static uintptr_t s_code_lo[PROF_MAX_RANGES], s_code_hi[PROF_MAX_RANGES];
+static int s_code_ranges = 0;
+
+/*---------------------------------------------------------------------------*/
+static void add_sym(uintptr_t addr, const char *name, int len) {
+  char *copy;
+
+  if (addr == 0 || len <= 0)
+    return;
+  if (s_sym_count == s_sym_cap) {
+    int ncap = s_sym_cap ? s_sym_cap * 2 : 1024;
+    prof_sym *n = (prof_sym *)realloc(s_syms, ncap * sizeof(prof_sym));
+    if (!n)
+      return;
+    s_syms = n;
+    s_sym_cap = ncap;
+  }
+  copy = (char *)malloc(len + 1);
+  if (!copy)
+    return;
+  memcpy(copy, name, len);
+  copy[len] = '\0';
+  s_syms[s_sym_count].addr = addr;
+  s_syms[s_sym_count].name = copy;
+  s_sym_count++;
+}
+
+static int sym_cmp(const void *a, const void *b) {
+  const prof_sym *x = (const prof_sym *)a, *y = (const prof_sym *)b;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+/*---------------------------------------------------------------------------*/
+/*
+ * ".text  0xADDR  0xSIZE" at column 0 is an output section; code ranges come
+ * from those. Two kinds of map lines then carry code addresses:
+ *   " .text.name  0xADDR  0xSIZE file.o"  (-ffunction-sections; covers statics,
+ *                                          name may sit alone on its own line)
+ *   "             0xADDR            name"  (global symbol inside a section)
+ */
+static bool load_map(void) {
+  char paths[4][256];
+  char line[PROF_MAP_LINE];
+  char pending[PROF_MAP_LINE];
+  int n = map_candidates(paths, 4);
+  FILE *fp = NULL;
+  int i;
+
+  for (i = 0; i < n && !fp; i++)
+    fp = fopen(paths[i], "r");
+  if (!fp)
+    return false;
+
+  pending[0] = '\0';
+  s_code_ranges = 0;
+  while (fgets(line, sizeof(line), fp)) {
+    char *p = line;
+    unsigned long long addr, size;
+    char *end;
+
+    if ((strncmp(p, ".text ", 6) == 0 || strncmp(p, ".init ", 6) == 0) &&
+        s_code_ranges < PROF_MAX_RANGES) {
+      addr = strtoull(p + 6, &end, 16);
+      size = strtoull(end, NULL, 16);
+      if (size) {
+        s_code_lo[s_code_ranges] = (uintptr_t)addr;
+        s_code_hi[s_code_ranges] = (uintptr_t)(addr + size);
+        s_code_ranges++;
+      }
+      continue;
+    }
+
+    if (strncmp(p, " .text.", 7) == 0) {
+      char *name = p + 7;
+      int len = (int)strcspn(name, " \t\r\n");
+      char *rest = name + len;
+      while (*rest == ' ' || *rest == '\t')
+        rest++;
+      if (*rest == '\0' || *rest == '\r' || *rest == '\n') {
+        /* Long name: address/size follow on the next line */
+        memcpy(pending, name, len);
+        pending[len] = '\0';
+        continue;
+      }
+      addr = strtoull(rest, &end, 16);
+      if (end != rest)
+        add_sym((uintptr_t)addr, name, len);
+      pending[0] = '\0';
+      continue;
+    }
+
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (strncmp(p, "0x", 2) != 0) {
+      pending[0] = '\0';
+      continue;
+    }
+    addr = strtoull(p, &end, 16);
+
+    if (pending[0]) {
+      add_sym((uintptr_t)addr, pending, (int)strlen(pending));
+      pending[0] = '\0';
+      continue;
+    }
+
+    /* Symbol line: address, then only whitespace, then a bare identifier */
+    p = end;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if ((*p == '_' || (*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))) {
+      int len = (int)strcspn(p, " \t\r\n");
+      if (p[len] == '\r' || p[len] == '\n' || p[len] == '\0')
+        add_sym((uintptr_t)addr, p, len);
+    }
+  }
+  fclose(fp);
+
+  qsort(s_syms, s_sym_count, sizeof(prof_sym), sym_cmp);
+  return s_sym_count > 0;
+}
+
+static void free_map(void) {
+  int i;
+  for (i = 0; i < s_sym_count; i++)
+    free(s_syms[i].name);
+  free(s_syms);
+  s_syms = NULL;
+  s_sym_count = 0;
+  s_sym_cap = 0;
+}
+
+/* Index of the symbol containing addr, or -1 */
+static int lookup(uintptr_t addr) {
+  int lo = 0, hi = s_sym_count - 1, best = -1;
+  int r;
+
+  for (r = 0; r < s_code_ranges; r++) {
+    if (addr >= s_code_lo[r] && addr < s_code_hi[r])
+      break;
+  }
+  if (r == s_code_ranges)
+    return -1;
+
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (s_syms[mid].addr <= addr) {
+      best = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return best;
+}
+
+/*===========================================================================*/
+/* Output                                                                    */
+/*===========================================================================*/
+
+typedef struct {
+  int frames[PROF_DEPTH]; /* symbol index, -1 = unresolved (see pcs) */
+  uintptr_t pcs[PROF_DEPTH];
+  int depth;
+} prof_stack;
+
+typedef struct {
+  int sym;
+  u32 self;
+  u32 total;
+} prof_row;
+
+static prof_stack *s_stacks = NULL;
+
+/*---------------------------------------------------------------------------*/
+static int stack_cmp(const void *a, const void *b) {
+  const prof_stack *x = (const prof_stack *)a, *y = (const prof_stack *)b;
+  int i;
+  for (i = 0; i < PROF_DEPTH; i++) {
+    int fx = i < x->depth ? x->frames[i] : -0x7FFFFFFF;
+    int fy = i < y->depth ? y->frames[i] : -0x7FFFFFFF;
+    if (fx != fy)
+      return (fx > fy) - (fx < fy);
+    if (fx == -1 && x->pcs[i] != y->pcs[i])
+      return (x->pcs[i] > y->pcs[i]) - (x->pcs[i] < y->pcs[i]);
+  }
+  return 0;
+}
+
+static int row_cmp(const void *a, const void *b) {
+  const prof_row *x = (const prof_row *)a, *y = (const prof_row *)b;
+  if (x->self != y->self)
+    return (y->self > x->self) - (y->self < x->self);
+  return (y->total > x->total) - (y->total < x->total);
+}
+
+static bool name_has_prefix(const char *name, const char *const *prefixes) {
+  int i;
+  for (i = 0; prefixes[i]; i++) {
+    if (strncmp(name, prefixes[i], strlen(prefixes[i])) == 0)
+      return true;
+  }
+  return false;
+}
+
+/*---------------------------------------------------------------------------*/
+int prof_write(const char *out_base) {
+  u32 total = s_head < PROF_MAX_SAMPLES ? s_head : PROF_MAX_SAMPLES;
+  u32 dropped = s_head - total;
+  u32 first = s_head - total;
+  u32 cat_counts[PROF_NUM_CATEGORIES + 1];
+  prof_row *rows = NULL;
+  int row_count = 0;
+  bool have_map;
+  char path[128];
+  FILE *fp;
+  u32 i;
+  int j, k;
+
+  if (s_running)
+    prof_stop();
+
+  have_map = load_map();
+  s_stacks = (prof_stack *)calloc(total ? total : 1, sizeof(prof_stack));
+  rows = (prof_row *)calloc(s_sym_count + 1, sizeof(prof_row));
+  if (!s_stacks || !rows) {
+    free(s_stacks);
+    free(rows);
+    free_map();
+    return -1;
+  }
+  memset(cat_counts, 0, sizeof(cat_counts));
+
+  /* Resolve every frame once; keep sample order for the folded output */
+  for (i = 0; i < total; i++) {
+    const prof_sample *s = &s_samples[(first + i) % PROF_MAX_SAMPLES];
+    prof_stack *st = &s_stacks[i];
+    int cat = PROF_NUM_CATEGORIES;
+
+    st->depth = s->depth;
+    for (j = 0; j < s->depth; j++) {
+      st->pcs[j] = s->pc[j];
+      st->frames[j] = have_map ? lookup(s->pc[j]) : -1;
+    }
+
+    for (j = 0; j < st->depth && cat == PROF_NUM_CATEGORIES; j++) {
+      if (st->frames[j] < 0)
+        continue;
+      for (k = 0; k < PROF_NUM_CATEGORIES; k++) {
+        if (name_has_prefix(s_syms[st->frames[j]].name,
+                            s_categories[k].prefixes)) {
+          cat = k;
+          break;
+        }
+      }
+    }
+    cat_counts[cat]++;
+
+    if (st->depth > 0 && st->frames[0] >= 0)
+      rows[st->frames[0]].self++;
+    for (j = 0; j < st->depth; j++) {
+      int f = st->frames[j];
+      bool seen = false;
+      if (f < 0)
+        continue;
+      for (k = 0; k < j; k++)
+        seen |= (st->frames[k] == f);
+      if (!seen)
+        rows[f].total++;
+    }
+  }
+
+  /* --- Flat profile --- */
+  snprintf(path, sizeof(path), "%s.txt", out_base);
+  fp = fopen(path, "w");
+  if (!fp) {
+    free(s_stacks);
+    free(rows);
+    free_map();
+    return -1;
+  }
+
+  fprintf(fp, "WiiMedic sampling profile\n"
+              "Samples: %u (%u older samples overwritten)\n"
+              "Symbols: %s\n\n",
+          (unsigned)total, (unsigned)dropped,
+          have_map ? "linker map" : "none (map not found, raw addresses)");
+
+  fprintf(fp, "--- By category (innermost match) ---\n");
+  for (k = 0; k <= PROF_NUM_CATEGORIES; k++) {
+    fprintf(fp, "%-22s %7u  %5.1f%%\n",
+            k < PROF_NUM_CATEGORIES ? s_categories[k].name : "Other",
+            (unsigned)cat_counts[k],
+            total ? (float)cat_counts[k] * 100.0f / (float)total : 0.0f);
+  }
+
+  for (j = 0; j < s_sym_count; j++) {
+    if (rows[j].self || rows[j].total) {
+      rows[row_count] = rows[j];
+      rows[row_count].sym = j;
+      row_count++;
+    }
+  }
+  qsort(rows, row_count, sizeof(prof_row), row_cmp);
+
+  fprintf(fp, "\n--- Flat profile ---\n%7s %6s %7s %6s  %s\n", "self", "%",
+          "total", "%", "function");
+  for (j = 0; j < row_count; j++) {
+    fprintf(fp, "%7u %5.1f%% %7u %5.1f%%  %s\n", (unsigned)rows[j].self,
+            (float)rows[j].self * 100.0f / (float)total,
+            (unsigned)rows[j].total,
+            (float)rows[j].total * 100.0f / (float)total,
+            s_syms[rows[j].sym].name);
+  }
+  fclose(fp);
+
+  /* --- Folded stacks: "outer;...;leaf count" --- */
+  snprintf(path, sizeof(path), "%s.folded", out_base);
+  fp = fopen(path, "w");
+  if (fp) {
+    qsort(s_stacks, total, sizeof(prof_stack), stack_cmp);
+    for (i = 0; i < total;) {
+      u32 run = 1;
+      while (i + run < total &&
+             stack_cmp(&s_stacks[i], &s_stacks[i + run]) == 0)
+        run++;
+      for (j = s_stacks[i].depth - 1; j >= 0; j--) {
+        if (s_stacks[i].frames[j] >= 0)
+          fprintf(fp, "%s", s_syms[s_stacks[i].frames[j]].name);
+        else
+          fprintf(fp, "0x%08lx", (unsigned long)s_stacks[i].pcs[j]);
+        fprintf(fp, "%s", j ? ";" : "");
+      }
+      fprintf(fp, " %u\n", (unsigned)run);
+      i += run;
+    }
+    fclose(fp);
+  }
+
+  free(s_stacks);
+  s_stacks = NULL;
+  free(rows);
+  free_map();
+  return (int)total;
+}
+
+#endif /* WIIMEDIC_PROFILE */
@@ -0,0 +1,38 @@
+/*
+ * WiiMedic - profiler.h
+ * Sampling profiler (compiled in with "make PROFILE=1")
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/* Default sample rate; the ring buffer holds ~32 s of samples at this rate */
+#define PROF_SAMPLE_HZ 250
+
+/* Profile output: <base>.txt (flat + category summary), <base>.folded */
+#define PROF_OUT_SD "sd:/WiiMedic_profile"
+#define PROF_OUT_USB "usb:/WiiMedic_profile"
+
+#ifdef WIIMEDIC_PROFILE
+
+// Start sampling the PC (and call stack) hz times per second
+void prof_start(int hz);
+
+// Stop sampling; samples stay in the ring buffer until the next start
+void prof_stop(void);
+
+// Symbolize the samples against the linker map and write the profile.
+// Returns the number of samples written, or -1 if no file could be created.
+int prof_write(const char *out_base);
+
+#else
+
+static inline void prof_start(int hz) { (void)hz; }
+static inline void prof_stop(void) {}
+static inline int prof_write(const char *out_base) {
+  (void)out_base;
+  return 0;
+}
+
+#endif // WIIMEDIC_PROFILE
+
+#endif // PROFILER_H
@@ -0,0 +1,122 @@
+/*
+ * WiiMedic - quick_check.c
+ * Quick Health Check. Each module offers a probe that answers "is anything
+ * obviously wrong" from one cheap query: ISFS usage instead of a NAND walk,
+ * mount state instead of a benchmark, one pad scan instead of a warmup. A
+ * probe the remaining budget cannot cover is dropped rather than postponed,
+ * so later cheap probes still get their turn.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "io_arena.h"
+#include "modules.h"
+#include "quick_check.h"
+#include "startup.h"
+#include "trace.h"
+#include "ui_common.h"
+
+/*---------------------------------------------------------------------------*/
+void quick_check_run(u32 budget_ms, quick_summary *out) {
+  u64 start = gettime();
+  int id;
+
+  memset(out, 0, sizeof(*out));
+  for (id = 0; id < MODULE_COUNT; id++) {
+    const module_desc *m = module_get((module_id)id);
+    quick_result *q = &out->result[id];
+    u32 spent = (u32)ticks_to_millisecs(gettime() - start);
+
+    if (!m->quick)
+      continue;
+    if (spent >= budget_ms || m->quick_cost_ms > budget_ms - spent) {
+      snprintf(q->summary, sizeof(q->summary), "Skipped: over time budget");
+      out->skipped |= MODULE_BIT(id);
+      continue;
+    }
+    if (!devices_ready(devices_for_resources(m->resources))) {
+      snprintf(q->summary, sizeof(q->summary), "Skipped: device starting up");
+      out->skipped |= MODULE_BIT(id);
+      continue;
+    }
+
+    ui_set_headless(true);
+    TRACE_SPAN(m->name, m->quick(q));
+    ui_set_headless(false);
+    io_scratch_reset();
+    out->probed |= MODULE_BIT(id);
+  }
+  out->elapsed_ms = (u32)ticks_to_millisecs(gettime() - start);
+}
+
+/*---------------------------------------------------------------------------*/
+static const char *level_color(quick_level level) {
+  switch (level) {
+  case QUICK_GREEN:
+    return UI_BGREEN;
+  case QUICK_YELLOW:
+    return UI_BYELLOW;
+  case QUICK_RED:
+    return UI_BRED;
+  default:
+    return UI_WHITE;
+  }
+}
+
+static const char *level_tag(quick_level level) {
+  switch (level) {
+  case QUICK_GREEN:
+    return "[OK]";
+  case QUICK_YELLOW:
+    return "[!!]";
+  case QUICK_RED:
+    return "[XX]";
+  default:
+    return "[--]";
+  }
+}
+
+void run_quick_check(void) {
+  quick_summary sum;
+  int worst = QUICK_UNKNOWN;
+  char buf[64];
+  int id;
+
+  quick_check_run(QUICK_BUDGET_MS, &sum);
+
+  for (id = 0; id < MODULE_COUNT; id++) {
+    const module_desc *m = module_get((module_id)id);
+    const quick_result *q = &sum.result[id];
+
+    if (!m->quick)
+      continue;
+    snprintf(buf, sizeof(buf), "%s %s", level_tag(q->level), q->summary);
+    ui_draw_kv_color(m->title, level_color(q->level), buf);
+    if ((int)q->level > worst)
+      worst = q->level;
+  }
+
+  ui_printf("\n");
+  if (worst == QUICK_RED)
+    ui_draw_err("Problems found - run the full module for details");
+  else if (worst == QUICK_YELLOW)
+    ui_draw_warn("Some checks need attention");
+  else if (worst == QUICK_GREEN)
+    ui_draw_ok("No problems found");
+  else
+    ui_draw_warn("Nothing could be checked - run the modules from the menu");
+
+  snprintf(buf, sizeof(buf), "Finished in %u ms (budget %u ms)",
+           sum.elapsed_ms, (u32)QUICK_BUDGET_MS);
+  ui_draw_info(buf);
+  if (sum.skipped) {
+    int n = __builtin_popcount(sum.skipped);
+
+    snprintf(buf, sizeof(buf), "%d check%s skipped: run %s from the menu", n,
+             n == 1 ? "" : "s", n == 1 ? "it" : "them");
+    ui_draw_info(buf);
+  }
+}
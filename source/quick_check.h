@@ -0,0 +1,31 @@
+/*
+ * WiiMedic - quick_check.h
+ * Quick Health Check: the cheapest useful probe of every module, cut off at
+ * a wall-clock budget, summarised on one screen
+ */
+#ifndef QUICK_CHECK_H
+#define QUICK_CHECK_H
+
+#include <gccore.h>
+
+#include "modules.h"
+
+// Budget of the menu's check
+#define QUICK_BUDGET_MS 2000
+
+typedef struct {
+  quick_result result[MODULE_COUNT]; // QUICK_UNKNOWN for modules not probed
+  u32 probed;                        // MODULE_BIT()s whose probe ran
+  u32 skipped;                       // MODULE_BIT()s left out for time/devices
+  u32 elapsed_ms;
+} quick_summary;
+
+// Run the probes in registry order on the UI thread, with their screen output
+// discarded. A probe is skipped when its quick_cost_ms no longer fits in what
+// is left of budget_ms, or its devices are still starting up.
+void quick_check_run(u32 budget_ms, quick_summary *out);
+
+// Menu entry: run with QUICK_BUDGET_MS and draw the traffic-light summary
+void run_quick_check(void);
+
+#endif // QUICK_CHECK_H
@@ -1,88 +1,73 @@
 /*
  * WiiMedic - report.c
- * Generates a comprehensive diagnostic report and saves to SD card
+ * Generates a comprehensive diagnostic report and saves to SD card, as
+ * text and as JSON beside it (binary too in batch runs). The files are
+ * opened first and each section is written as soon as it is collected, so
+ * an interrupted run leaves every finished section behind.
  */
 
+#include <dirent.h>
 #include <fat.h>
 #include <gccore.h>
 #include <malloc.h>
 #include <ogc/lwp_watchdog.h>
-#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <wiiuse/wpad.h>
 
-#include "controller_test.h"
-#include "ios_check.h"
-#include "nand_health.h"
-#include "network_test.h"
+#include "history.h"
+#include "modules.h"
+#include "profiler.h"
 #include "report.h"
-#include "storage_test.h"
-#include "system_info.h"
+#include "report_rec.h"
+#include "scheduler.h"
+#include "startup.h"
+#include "trace.h"
 #include "ui_common.h"
 
-/* Increased to 64KB to handle detailed IOS/NAND lists without truncation */
-#define REPORT_MAX_SIZE 65536
-#define REPORT_PATH_SD "sd:/WiiMedic_Report.txt"
-#define REPORT_PATH_USB "usb:/WiiMedic_Report.txt"
-
-/*---------------------------------------------------------------------------*/
-/* Helper to append text to the report buffer safely.
-   Prevents buffer overflows and tracks the current position. */
-static void report_append(char *buffer, int *pos, int max_size, const char *fmt,
-                          ...) {
-  if (*pos >= max_size - 1)
-    return; /* Buffer full */
-
-  va_list args;
-  va_start(args, fmt);
-
-  /* vsnprintf returns the number of characters that WOULD have been written */
-  int remaining = max_size - *pos;
-  int written = vsnprintf(buffer + *pos, remaining, fmt, args);
-
-  va_end(args);
-
-  if (written > 0) {
-    if (written >= remaining) {
-      /* Truncation occurred, buffer is now full */
-      *pos = max_size - 1;
-      buffer[*pos] = '\0'; /* Ensure null termination */
-    } else {
-      *pos += written;
-    }
-  }
-}
-
 /*---------------------------------------------------------------------------*/
 /* Check if a report file exists at the given path, return its size or -1 */
 static long check_existing_report(const char *path) {
-  FILE *f = fopen(path, "r");
+  FILE *f = TRACE_CALL("fopen", fopen(path, "r"));
   long size;
   if (!f)
     return -1;
   fseek(f, 0, SEEK_END);
   size = ftell(f);
-  fclose(f);
+  TRACE_CALL("fclose", fclose(f));
   return size;
 }
 
 /*---------------------------------------------------------------------------*/
-/* Find the next available numbered filename like WiiMedic_Report_2.txt */
+/* Find the next available numbered filename like WiiMedic_Report_2.txt,
+   from one listing of base_dir rather than an fopen per candidate */
 static void find_next_filename(const char *base_dir, char *out, int outsize) {
+  static const char prefix[] = "WiiMedic_Report_";
+  bool used[100] = {false};
+  DIR *dir = TRACE_CALL("opendir", opendir(base_dir));
+  struct dirent *entry;
   int num;
-  for (num = 2; num <= 99; num++) {
-    FILE *f;
-    snprintf(out, outsize, "%s/WiiMedic_Report_%d.txt", base_dir, num);
-    f = fopen(out, "r");
-    if (!f)
-      return; /* This name is free */
-    fclose(f);
+
+  while (dir && (entry = readdir(dir)) != NULL) {
+    const char *name = entry->d_name;
+    char *end;
+
+    if (strncasecmp(name, prefix, sizeof(prefix) - 1) != 0)
+      continue;
+    num = (int)strtol(name + sizeof(prefix) - 1, &end, 10);
+    if (num >= 2 && num <= 99 && strcasecmp(end, ".txt") == 0)
+      used[num] = true;
   }
-  /* Fallback: overwrite #99 */
-  snprintf(out, outsize, "%s/WiiMedic_Report_99.txt", base_dir);
+  if (dir)
+    closedir(dir);
+
+  /* Fallback when all are taken: overwrite #99 */
+  for (num = 2; num < 99 && used[num]; num++)
+    ;
+  snprintf(out, outsize, "%sWiiMedic_Report_%d.txt", base_dir, num);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -167,210 +152,356 @@ static int ask_existing_report_action(const char *path, long size) {
 }
 
 /*---------------------------------------------------------------------------*/
-void run_report_generator(void) {
-  char *report;
-  int pos = 0;
-  char section[8192];
+/* Shown while the modules are collected, after the existing-report prompt
+   took over the screen */
+static void draw_collecting(void) {
+  printf("\x1b[2J\x1b[0;0H");
+  printf(UI_BGREEN " [+] WiiMedic" UI_RESET " " UI_CYAN
+                   "v" WIIMEDIC_VERSION UI_RESET "\n");
+  printf(UI_WHITE " ---------------------------------------------------------"
+                  "-\n" UI_RESET);
+  printf("\n" UI_WHITE "   Collecting diagnostics, please wait...\n" UI_RESET);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Collect the modules in mask and write the whole report to out */
+static void build_report(report_rec *out, u32 mask) {
+  hist_record run;
+  sched_stats st;
   char buf[128];
-  FILE *fp;
+  int i;
 
-  ui_draw_info("This will run ALL diagnostic modules and save results.");
-  {
-    char pathm[128];
-    snprintf(pathm, sizeof(pathm), "Report will be saved to SD or USB");
-    ui_draw_info(pathm);
+  /* Header */
+  rec_section(out, "report");
+  rec_text(
+      out, "==========================================================\n"
+           "     WiiMedic Diagnostic Report v" WIIMEDIC_VERSION "\n"
+           "==========================================================\n\n"
+           "Generated by WiiMedic - Wii System Diagnostic & Health Monitor\n"
+           "Share this report when asking for help on forums or Reddit.\n"
+           "----------------------------------------------------------\n\n");
+  rec_str(out, "version", NULL, WIIMEDIC_VERSION);
+  rec_uint(out, "modules", NULL, mask & MODULE_ALL);
+  rec_section_end(out);
+
+  /* Module sections, collected concurrently where resources allow and
+     written in registry order as they complete */
+  sched_collect(mask, out, &st);
+
+  /* One record of the metrics history per report run */
+  history_capture(mask, &run);
+  if (!history_append(&run))
+    ui_draw_warn("Could not add this run to the metrics history");
+
+  /* Which sections came from earlier menu runs */
+  rec_section(out, "freshness");
+  rec_text(out, "=== DATA FRESHNESS ===\n");
+  rec_list(out, "modules");
+  for (i = 0; i < MODULE_COUNT; i++) {
+    const module_desc *m = module_get((module_id)i);
+
+    if (!(mask & MODULE_BIT(i)))
+      continue;
+    rec_item(out);
+    rec_enum(out, "module", "%-24s", m->name, m->title);
+    rec_bool(out, "reused", NULL, (st.reused & MODULE_BIT(i)) != 0, NULL,
+             NULL);
+    if (st.reused & MODULE_BIT(i))
+      rec_uint(out, "age_s", " reused (%us old)",
+               st.reused_age_ms[i] / 1000);
+    else
+      rec_text(out, " collected now");
+    rec_uint(out, "run_ms", NULL, st.run_ms[i]);
+    rec_item_end(out);
   }
+  rec_list_end(out);
+  rec_uint(out, "wall_ms", NULL, st.wall_ms);
+  rec_uint(out, "serial_ms", NULL, st.serial_ms);
+  rec_text(out, "\n");
+
+  snprintf(buf, sizeof(buf), "Collected in %u ms (%u ms run one by one)",
+           st.wall_ms, st.serial_ms);
   ui_printf("\n");
+  ui_draw_info(buf);
 
-  report = (char *)malloc(REPORT_MAX_SIZE);
-  if (!report) {
-    ui_draw_err("Memory allocation failed");
-    return;
-  }
-  memset(report, 0, REPORT_MAX_SIZE);
+  /* Footer */
+  rec_text(out, "----------------------------------------------------------\n"
+                "END OF WIIMEDIC DIAGNOSTIC REPORT\n"
+                "----------------------------------------------------------\n");
+  rec_section_end(out);
+}
 
-  /* Header */
-  report_append(
-      report, &pos, REPORT_MAX_SIZE,
-      "==========================================================\n"
-      "     WiiMedic Diagnostic Report v" WIIMEDIC_VERSION "\n"
-      "==========================================================\n\n"
-      "Generated by WiiMedic - Wii System Diagnostic & Health Monitor\n"
-      "Share this report when asking for help on forums or Reddit.\n"
-      "----------------------------------------------------------\n\n");
-
-  /* 1: System Info */
-  ui_printf(UI_BCYAN "   [1/6]" UI_WHITE
-                     " Collecting system information...\n" UI_RESET);
-  memset(section, 0, sizeof(section));
-  get_system_info_report(section, sizeof(section));
-  report_append(report, &pos, REPORT_MAX_SIZE, "%s", section);
-  ui_draw_ok("Done.");
-
-  /* 2: NAND Health */
-  ui_printf(UI_BCYAN "   [2/6]" UI_WHITE " Scanning NAND health...\n" UI_RESET);
-  run_nand_health();
-  memset(section, 0, sizeof(section));
-  get_nand_health_report(section, sizeof(section));
-  report_append(report, &pos, REPORT_MAX_SIZE, "%s", section);
-  ui_draw_ok("Done.");
-
-  /* 3: IOS Check */
-  ui_printf(UI_BCYAN "   [3/6]" UI_WHITE
-                     " Scanning IOS installations...\n" UI_RESET);
-  /* Redundant memory alloc removed here - get_ios_check_report handles it */
-  memset(section, 0, sizeof(section));
-  get_ios_check_report(section, sizeof(section));
-  if (strlen(section) > 0) {
-    report_append(report, &pos, REPORT_MAX_SIZE, "%s", section);
-  } else {
-    report_append(
-        report, &pos, REPORT_MAX_SIZE,
-        "=== IOS INSTALLATION SCAN ===\n"
-        "Run IOS Scan from main menu first to populate this section.\n\n");
+/*---------------------------------------------------------------------------*/
+/* The report forms, REPORT_FMT_* bit order: text, then its side files */
+#define REPORT_FORMS 3
+
+typedef struct {
+  FILE *fp[REPORT_FORMS]; /* NULL = form not written */
+  report_sink sink[REPORT_FORMS];
+  u32 bytes[REPORT_FORMS];
+  char path[REPORT_FORMS][160]; /* final name; "" for stdout */
+  bool no_memory;
+} report_files;
+
+/* path with its extension replaced by ext */
+static void side_path(const char *path, const char *ext, char *out,
+                      int outsize) {
+  const char *dot = strrchr(path, '.');
+  int len = (int)strlen(path);
+
+  if (dot && !strchr(dot, '/'))
+    len = (int)(dot - path);
+  snprintf(out, outsize, "%.*s%s", len, path, ext);
+}
+
+/* The name a form is written under until it is complete */
+#define PART_PATH_MAX (160 + sizeof(REPORT_EXT_PART))
+static void part_path(const report_files *f, int form, char *out) {
+  snprintf(out, PART_PATH_MAX, "%.159s" REPORT_EXT_PART, f->path[form]);
+}
+
+/* Open one form of the text report at path, under its part name */
+static bool open_form(report_files *f, const char *path, int form) {
+  char part[PART_PATH_MAX];
+
+  if (form == 0)
+    snprintf(f->path[0], sizeof(f->path[0]), "%s", path);
+  else
+    side_path(path, form == 1 ? REPORT_EXT_JSON : REPORT_EXT_TLV,
+              f->path[form], sizeof(f->path[form]));
+  part_path(f, form, part);
+  f->fp[form] = TRACE_CALL("fopen", fopen(part, form == 2 ? "wb" : "w"));
+  return f->fp[form] != NULL;
+}
+
+static bool close_forms(report_files *f) {
+  bool ok = true;
+  int i;
+
+  for (i = 0; i < REPORT_FORMS; i++) {
+    if (f->fp[i] && f->fp[i] != stdout &&
+        TRACE_CALL("fclose", fclose(f->fp[i])) != 0)
+      ok = false;
   }
-  ui_draw_ok("Done.");
-
-  /* 4: Storage */
-  ui_printf(UI_BCYAN "   [4/6]" UI_WHITE
-                     " Checking storage devices...\n" UI_RESET);
-  memset(section, 0, sizeof(section));
-  get_storage_test_report(section, sizeof(section));
-  if (strlen(section) > 0) {
-    report_append(report, &pos, REPORT_MAX_SIZE, "%s", section);
-  } else {
-    report_append(
-        report, &pos, REPORT_MAX_SIZE,
-        "=== STORAGE TEST ===\n"
-        "Run Storage Test from main menu first to populate this section.\n\n");
+  return ok;
+}
+
+/* Put every complete form in place of the old file (libfat's rename does
+   not replace, so the old one goes first), or with keep false delete the
+   part files. */
+static bool finish_forms(report_files *f, bool keep) {
+  char part[PART_PATH_MAX];
+  bool ok = true;
+  int i;
+
+  for (i = 0; i < REPORT_FORMS; i++) {
+    if (!f->fp[i] || !f->path[i][0])
+      continue;
+    part_path(f, i, part);
+    if (!keep) {
+      remove(part);
+      continue;
+    }
+    remove(f->path[i]);
+    if (TRACE_CALL("rename", rename(part, f->path[i])) != 0)
+      ok = false;
   }
-  ui_draw_ok("Done.");
-
-  /* 5: Controllers */
-  ui_printf(UI_BCYAN "   [5/6]" UI_WHITE " Checking controllers...\n" UI_RESET);
-  scan_controllers_quick();
-  memset(section, 0, sizeof(section));
-  get_controller_test_report(section, sizeof(section));
-  report_append(report, &pos, REPORT_MAX_SIZE, "%s", section);
-  ui_draw_ok("Done.");
-
-  /* 6: Network */
-  ui_printf(UI_BCYAN "   [6/6]" UI_WHITE " Checking network...\n" UI_RESET);
-  run_network_test();
-  memset(section, 0, sizeof(section));
-  get_network_test_report(section, sizeof(section));
-  if (strlen(section) > 0) {
-    report_append(report, &pos, REPORT_MAX_SIZE, "%s", section);
-  } else {
-    report_append(
-        report, &pos, REPORT_MAX_SIZE,
-        "=== NETWORK TEST ===\n"
-        "Run Network Test from main menu first to populate this section.\n\n");
+  return ok;
+}
+
+/* Build the report into every open form, close them and rename them into
+   place. Returns false if anything was lost, leaving the old files as they
+   were and what was written in the part files; no_memory says the report
+   was never started (and no part files are left). */
+static bool write_forms(report_files *f, u32 mask) {
+  report_sink *sinks[REPORT_FORMS] = {NULL};
+  report_rec rec;
+  bool ok = true;
+  int i;
+
+  for (i = 0; i < REPORT_FORMS; i++) {
+    if (!f->fp[i])
+      continue;
+    if (!report_open(&f->sink[i], f->fp[i])) {
+      while (--i >= 0) {
+        if (sinks[i])
+          report_close(sinks[i]);
+      }
+      f->no_memory = true;
+      close_forms(f);
+      finish_forms(f, false);
+      return false;
+    }
+    sinks[i] = &f->sink[i];
   }
-  ui_draw_ok("Done.");
 
-  /* Footer */
-  report_append(report, &pos, REPORT_MAX_SIZE,
-                "----------------------------------------------------------\n"
-                "END OF WIIMEDIC DIAGNOSTIC REPORT\n"
-                "For best results, run each module from the main menu first,\n"
-                "then generate this report to capture all data.\n"
-                "----------------------------------------------------------\n");
+  rec_begin(&rec, sinks[0], sinks[1], sinks[2]);
+  build_report(&rec, mask);
+  rec_end(&rec);
+  for (i = 0; i < REPORT_FORMS; i++) {
+    if (!sinks[i])
+      continue;
+    if (!report_close(sinks[i]))
+      ok = false;
+    f->bytes[i] = sinks[i]->bytes;
+  }
+  trace_counter("report_bytes", f->bytes[0]);
+  if (!close_forms(f))
+    ok = false;
+  return ok && finish_forms(f, true);
+}
 
-  /* Check for existing reports and ask user */
+/*---------------------------------------------------------------------------*/
+static void generate_report(void) {
+  const char *save_path = NULL;
+  const char *base_dir = NULL;
+  char alt_path[128];
+  char json_path[128];
+  char buf[192];
+  long existing_sd, existing_usb, existing = -1;
+  report_files files;
+  bool saved;
+
+  memset(&files, 0, sizeof(files));
+  ui_draw_info("This will run ALL diagnostic modules and save results.");
+  ui_draw_info("Report will be saved to SD or USB");
   ui_printf("\n");
 
-  {
-    const char *save_path = NULL;
-    const char *base_dir = NULL;
-    char alt_path[128];
-    long existing_sd = check_existing_report(REPORT_PATH_SD);
-    long existing_usb = check_existing_report(REPORT_PATH_USB);
-    long existing = -1;
-    bool cancelled = false;
-
-    /* Determine primary save target */
-    if (existing_sd >= 0) {
-      existing = existing_sd;
-      save_path = REPORT_PATH_SD;
-      base_dir = "sd:/";
-    } else if (existing_usb >= 0) {
-      existing = existing_usb;
+  /* The file is written while the modules run, so settle where first */
+  devices_wait(DEV_FAT);
+  existing_sd = check_existing_report(REPORT_PATH_SD);
+  existing_usb = check_existing_report(REPORT_PATH_USB);
+
+  /* Determine primary save target */
+  if (existing_sd >= 0) {
+    existing = existing_sd;
+    save_path = REPORT_PATH_SD;
+    base_dir = "sd:/";
+  } else if (existing_usb >= 0) {
+    existing = existing_usb;
+    save_path = REPORT_PATH_USB;
+    base_dir = "usb:/";
+  }
+
+  if (existing >= 0) {
+    /* Existing report found - ask user what to do */
+    int action = ask_existing_report_action(save_path, existing);
+
+    if (action == 2) {
+      ui_draw_info("Report generation cancelled.");
+      return;
+    } else if (action == 1) {
+      /* Keep both - find a new filename */
+      find_next_filename(base_dir, alt_path, sizeof(alt_path));
+      save_path = alt_path;
+    }
+    /* action == 0: Replace - save_path stays the same */
+    draw_collecting();
+    open_form(&files, save_path, 0);
+  } else {
+    /* No existing report - try SD first, then USB */
+    save_path = REPORT_PATH_SD;
+    if (!open_form(&files, save_path, 0)) {
       save_path = REPORT_PATH_USB;
-      base_dir = "usb:/";
+      open_form(&files, save_path, 0);
     }
+    if (!files.fp[0]) {
+      ui_draw_err("No writable storage found!");
+      ui_draw_warn("Insert an SD card or USB drive to save the report.");
+      return;
+    }
+  }
 
-    if (existing >= 0) {
-      /* Existing report found - ask user what to do */
-      int action = ask_existing_report_action(save_path, existing);
-
-      if (action == 2) {
-        /* Cancel */
-        cancelled = true;
-        ui_draw_info("Report generation cancelled.");
-        ui_draw_info("Diagnostic data was still collected in memory.");
-      } else if (action == 1) {
-        /* Keep both - find a new filename */
-        find_next_filename(base_dir, alt_path, sizeof(alt_path));
-        save_path = alt_path;
-      }
-      /* action == 0: Replace - save_path stays the same */
+  if (!files.fp[0]) {
+    ui_draw_err("Failed to save report!");
+    ui_draw_warn("Make sure an SD card or USB drive is inserted and writable.");
+    ui_draw_info("Try reformatting as FAT32.");
+    return;
+  }
+
+  /* The JSON copy is a bonus: the text report goes ahead without it */
+  open_form(&files, save_path, 1);
+  saved = write_forms(&files, MODULE_ALL);
+  if (files.no_memory) {
+    ui_draw_err("Memory allocation failed");
+    return;
+  }
+
+  ui_printf("\n");
+  if (!saved) {
+    ui_draw_err("Failed to save report!");
+    ui_draw_warn("The card filled up or was removed while writing.");
+    snprintf(buf, sizeof(buf), "Sections written so far are in %s%s",
+             save_path, REPORT_EXT_PART);
+    ui_draw_info(buf);
+    if (existing >= 0)
+      ui_draw_info("The previous report was left as it was.");
+    return;
+  }
+
+  ui_draw_ok("Report saved successfully!");
+  snprintf(buf, sizeof(buf), "File: %s", save_path);
+  ui_draw_ok(buf);
+  snprintf(buf, sizeof(buf), "Size: %u bytes", files.bytes[0]);
+  ui_draw_ok(buf);
+  if (files.fp[1]) {
+    side_path(save_path, REPORT_EXT_JSON, json_path, sizeof(json_path));
+    snprintf(buf, sizeof(buf), "JSON: %s (%u bytes)", json_path,
+             files.bytes[1]);
+    ui_draw_ok(buf);
+  }
+
+  if (existing >= 0) {
+    if (strcmp(save_path, REPORT_PATH_SD) == 0 ||
+        strcmp(save_path, REPORT_PATH_USB) == 0) {
+      ui_draw_info("Previous report was replaced.");
     } else {
-      /* No existing report - try SD first, then USB */
-      fp = fopen(REPORT_PATH_SD, "w");
-      if (fp) {
-        fclose(fp);
-        save_path = REPORT_PATH_SD;
-      } else {
-        fp = fopen(REPORT_PATH_USB, "w");
-        if (fp) {
-          fclose(fp);
-          save_path = REPORT_PATH_USB;
-        }
-      }
+      ui_draw_info("Previous report was kept.");
+      snprintf(buf, sizeof(buf), "New report: %s", save_path);
+      ui_draw_info(buf);
     }
+  }
 
-    if (!cancelled && save_path) {
-      char pathmsg[192];
-      ui_draw_info("Saving report...");
-      fp = fopen(save_path, "w");
-      if (fp) {
-        fwrite(report, 1, strlen(report), fp);
-        fclose(fp);
-
-        ui_draw_ok("Report saved successfully!");
-
-        snprintf(pathmsg, sizeof(pathmsg), "File: %s", save_path);
-        ui_draw_ok(pathmsg);
-
-        snprintf(buf, sizeof(buf), "Size: %d bytes", (int)strlen(report));
-        ui_draw_ok(buf);
-
-        if (existing >= 0) {
-          if (strcmp(save_path, REPORT_PATH_SD) == 0 ||
-              strcmp(save_path, REPORT_PATH_USB) == 0) {
-            ui_draw_info("Previous report was replaced.");
-          } else {
-            ui_draw_info("Previous report was kept.");
-            snprintf(pathmsg, sizeof(pathmsg), "New report: %s", save_path);
-            ui_draw_info(pathmsg);
-          }
-        }
-
-        ui_printf("\n");
-        ui_draw_info("You can now share this file when asking for help.");
-        ui_draw_info("Copy the report from your SD/USB to your PC.");
-      } else {
-        ui_draw_err("Failed to save report!");
-        ui_draw_warn(
-            "Make sure an SD card or USB drive is inserted and writable.");
-        ui_draw_info("Try reformatting as FAT32.");
-      }
-    } else if (!cancelled) {
-      ui_draw_err("No writable storage found!");
-      ui_draw_warn("Insert an SD card or USB drive to save the report.");
+  ui_printf("\n");
+  ui_draw_info("You can now share this file when asking for help.");
+  ui_draw_info("Copy the report from your SD/USB to your PC.");
+}
+
+/*---------------------------------------------------------------------------*/
+int report_write(u32 mask, const char *path, u32 formats) {
+  bool to_stdout = strcmp(path, "-") == 0;
+  report_files files;
+  int i, total = 0;
+
+  memset(&files, 0, sizeof(files));
+  devices_wait(DEV_FAT);
+  for (i = 0; i < REPORT_FORMS; i++) {
+    if (!(formats & (1u << i)))
+      continue;
+    if (to_stdout) {
+      files.fp[i] = stdout;
+      break;
+    }
+    if (!open_form(&files, path, i)) {
+      close_forms(&files);
+      finish_forms(&files, false);
+      return -1;
     }
   }
 
-  free(report);
+  if (!write_forms(&files, mask))
+    return -1;
+  for (i = 0; i < REPORT_FORMS; i++)
+    total += (int)files.bytes[i];
+  return total;
+}
+
+/*---------------------------------------------------------------------------*/
+void run_report_generator(void) {
+  /* No-ops unless built with PROFILE=1 */
+  prof_start(PROF_SAMPLE_HZ);
+  TRACE_SPAN("generate_report", generate_report());
+  prof_stop();
+  if (prof_write(PROF_OUT_SD) < 0)
+    prof_write(PROF_OUT_USB);
 }
\ No newline at end of file
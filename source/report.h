@@ -5,7 +5,30 @@
 #ifndef REPORT_H
 #define REPORT_H
 
+#include <gccore.h>
+
+#define REPORT_PATH_SD "sd:/WiiMedic_Report.txt"
+#define REPORT_PATH_USB "usb:/WiiMedic_Report.txt"
+
+// Report forms. The JSON and binary (report_rec.h) files sit next to the
+// text one: same name, these extensions.
+#define REPORT_FMT_TEXT (1u << 0)
+#define REPORT_FMT_JSON (1u << 1)
+#define REPORT_FMT_TLV (1u << 2)
+#define REPORT_FMT_DEFAULT (REPORT_FMT_TEXT | REPORT_FMT_JSON)
+#define REPORT_EXT_JSON ".json"
+#define REPORT_EXT_TLV ".bin"
+// Each form is written under its name plus this and renamed over the old
+// file only once complete, so a failed run leaves the last report intact
+#define REPORT_EXT_PART ".part"
+
 // Run the report generator (saves to SD card)
 void run_report_generator(void);
 
+// Collect the modules in mask (MODULE_BIT()s) and write the forms in
+// formats (REPORT_FMT_*) to path and its side files, replacing any there,
+// with no prompts. path "-" writes the first form in formats to stdout.
+// Returns the bytes written, or -1 on failure.
+int report_write(u32 mask, const char *path, u32 formats);
+
 #endif // REPORT_H
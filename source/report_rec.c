@@ -0,0 +1,366 @@
+/*
+ * WiiMedic - report_rec.c
+ * One pass over the records writes all three forms, each into its own
+ * sink. JSON is indented two spaces a level with commas placed from a
+ * member count per level. The binary form names each key once, in a KEY
+ * record at first use, and refers to it by a two-byte id afterwards, so a
+ * report is mostly values. Keys are string literals: the lookup compares
+ * pointers before it falls back to strcmp.
+ */
+
+#include <gccore.h>
+#include <string.h>
+
+#include "report_rec.h"
+
+/*---------------------------------------------------------------------------*/
+/* Length of the valid UTF-8 sequence at s: 1 for ASCII, 0 if s is not the
+   start of one (a stray or Latin-1 byte) */
+static u32 utf8_len(const u8 *s) {
+  static const u32 least[5] = {0, 0, 0x80, 0x800, 0x10000};
+  u32 n, i, cp;
+
+  if (s[0] < 0x80)
+    return 1;
+  if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+    n = 2;
+    cp = s[0] & 0x1F;
+  } else if ((s[0] & 0xF0) == 0xE0) {
+    n = 3;
+    cp = s[0] & 0x0F;
+  } else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+    n = 4;
+    cp = s[0] & 0x07;
+  } else {
+    return 0;
+  }
+  for (i = 1; i < n; i++) {
+    if ((s[i] & 0xC0) != 0x80) /* also stops at the NUL */
+      return 0;
+    cp = cp << 6 | (s[i] & 0x3F);
+  }
+  if (cp < least[n] || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+    return 0;
+  return n;
+}
+
+/*---------------------------------------------------------------------------*/
+static void tlv_head(report_rec *r, u8 tag, u16 key, u32 len) {
+  u8 head[5];
+
+  head[0] = tag;
+  head[1] = (u8)(key >> 8);
+  head[2] = (u8)key;
+  head[3] = (u8)(len >> 8);
+  head[4] = (u8)len;
+  report_bytes(r->tlv, head, sizeof(head));
+}
+
+static void tlv_record(report_rec *r, u8 tag, u16 key, const void *value,
+                       u32 len) {
+  if (len > 0xFFFF)
+    len = 0xFFFF;
+  tlv_head(r, tag, key, len);
+  if (len)
+    report_bytes(r->tlv, value, len);
+}
+
+/* Id of key, defining it first if it is new */
+static u16 tlv_key(report_rec *r, const char *key) {
+  u16 i;
+
+  for (i = 0; i < r->key_count; i++) {
+    if (r->keys[i] == key)
+      return i + 1;
+  }
+  for (i = 0; i < r->key_count; i++) {
+    if (strcmp(r->keys[i], key) == 0)
+      return i + 1;
+  }
+  if (r->key_count < REC_MAX_KEYS)
+    i = r->key_count++;
+  else
+    i = REC_MAX_KEYS - 1;
+  r->keys[i] = key;
+  tlv_record(r, REC_TAG_KEY, i + 1, key, (u32)strlen(key));
+  return i + 1;
+}
+
+static void tlv_value(report_rec *r, u8 tag, const char *key,
+                      const void *value, u32 len) {
+  if (r->tlv)
+    tlv_record(r, tag, key ? tlv_key(r, key) : 0, value, len);
+}
+
+static void tlv_u32(report_rec *r, u8 tag, const char *key, u32 v) {
+  u8 be[4] = {(u8)(v >> 24), (u8)(v >> 16), (u8)(v >> 8), (u8)v};
+
+  tlv_value(r, tag, key, be, sizeof(be));
+}
+
+/* A string value as UTF-8: bytes that are not already UTF-8 are re-encoded
+   as the Latin-1 character, two bytes each */
+static void tlv_str(report_rec *r, const char *key, const char *s) {
+  const u8 *p = (const u8 *)s;
+  u32 i, n, end, len = 0;
+
+  if (!r->tlv)
+    return;
+  for (end = 0; p[end]; end += n ? n : 1) {
+    n = utf8_len(p + end);
+    if (len + (n ? n : 2) > 0xFFFF)
+      break;
+    len += n ? n : 2;
+  }
+  if (len == end) {
+    tlv_value(r, REC_TAG_STR, key, s, len);
+    return;
+  }
+  tlv_head(r, REC_TAG_STR, key ? tlv_key(r, key) : 0, len);
+  for (i = 0; i < end; i += n) {
+    n = utf8_len(p + i);
+    if (n) {
+      report_bytes(r->tlv, p + i, n);
+    } else {
+      u8 two[2] = {(u8)(0xC0 | p[i] >> 6), (u8)(0x80 | (p[i] & 0x3F))};
+
+      report_bytes(r->tlv, two, sizeof(two));
+      n = 1;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+static void json_indent(report_rec *r) {
+  static const char spaces[2 * REC_MAX_DEPTH] = "                ";
+
+  report_bytes(r->json, spaces, 2 * r->depth);
+}
+
+static void json_string(report_rec *r, const char *s) {
+  report_puts(r->json, "\"");
+  while (*s) {
+    u32 n = 0;
+
+    /* Runs of printable ASCII and whole UTF-8 sequences go as they are;
+       anything else, Latin-1 bytes included, as \u00XX */
+    while (s[n] && s[n] != '"' && s[n] != '\\' && (u8)s[n] >= 0x20) {
+      u32 len = utf8_len((const u8 *)s + n);
+
+      if (!len)
+        break;
+      n += len;
+    }
+    report_bytes(r->json, s, n);
+    s += n;
+    if (!*s)
+      break;
+    if (*s == '"' || *s == '\\')
+      report_printf(r->json, "\\%c", *s);
+    else
+      report_printf(r->json, "\\u%04x", (u8)*s);
+    s++;
+  }
+  report_puts(r->json, "\"");
+}
+
+/* Comma, indent and name for the next member at this level */
+static void json_member(report_rec *r, const char *key) {
+  int level = r->depth - 1;
+
+  report_puts(r->json, r->members[level]++ ? ",\n" : "\n");
+  json_indent(r);
+  if (!r->is_list[level]) {
+    json_string(r, key);
+    report_puts(r->json, ": ");
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+static void open_container(report_rec *r, u8 tag, const char *key) {
+  bool list = tag == REC_TAG_LIST;
+
+  if (r->json) {
+    json_member(r, key);
+    report_puts(r->json, list ? "[" : "{");
+  }
+  tlv_value(r, tag, key, NULL, 0);
+  r->members[r->depth] = 0;
+  r->is_list[r->depth] = list;
+  r->depth++;
+}
+
+static void close_container(report_rec *r) {
+  r->depth--;
+  if (r->json) {
+    if (r->members[r->depth]) {
+      report_puts(r->json, "\n");
+      json_indent(r);
+    }
+    report_puts(r->json, r->is_list[r->depth] ? "]" : "}");
+  }
+  tlv_value(r, REC_TAG_END, NULL, NULL, 0);
+}
+
+/* Sections open at their first field, so an empty one can become null */
+static void open_pending(report_rec *r) {
+  const char *key = r->pending;
+
+  if (key) {
+    r->pending = NULL;
+    open_container(r, REC_TAG_OBJECT, key);
+  }
+}
+
+/* Data part of a field: open the section, name the member */
+static bool data_member(report_rec *r, const char *key) {
+  open_pending(r);
+  if (!r->json)
+    return false;
+  json_member(r, key);
+  return true;
+}
+
+static void text_end(report_rec *r) {
+  if (!r->line)
+    report_puts(r->text, "\n");
+}
+
+/*---------------------------------------------------------------------------*/
+void rec_begin(report_rec *r, report_sink *text, report_sink *json,
+               report_sink *tlv) {
+  static const u8 header[8] = {'W', 'M', 'R', 'B', REC_TLV_VERSION, 0, 0, 0};
+
+  memset(r, 0, sizeof(*r));
+  r->text = text;
+  r->json = json;
+  r->tlv = tlv;
+  if (tlv)
+    report_bytes(tlv, header, sizeof(header));
+  if (json)
+    report_puts(json, "{");
+  r->depth = 1;
+}
+
+void rec_end(report_rec *r) {
+  r->depth = 0;
+  if (r->json)
+    report_puts(r->json, r->members[0] ? "\n}\n" : "}\n");
+}
+
+void rec_text(report_rec *r, const char *text) {
+  if (r->text)
+    report_puts(r->text, text);
+}
+
+void rec_section(report_rec *r, const char *key) { r->pending = key; }
+
+void rec_section_end(report_rec *r) {
+  if (r->pending) {
+    if (r->json) {
+      json_member(r, r->pending);
+      report_puts(r->json, "null");
+    }
+    tlv_value(r, REC_TAG_NULL, r->pending, NULL, 0);
+    r->pending = NULL;
+  } else {
+    close_container(r);
+  }
+  if (r->text)
+    report_section_end(r->text);
+  if (r->json)
+    report_section_end(r->json);
+  if (r->tlv)
+    report_section_end(r->tlv);
+}
+
+void rec_hold(report_rec *r, bool hold) {
+  if (r->text)
+    report_hold(r->text, hold);
+  if (r->json)
+    report_hold(r->json, hold);
+  if (r->tlv)
+    report_hold(r->tlv, hold);
+}
+
+/*---------------------------------------------------------------------------*/
+void rec_group(report_rec *r, const char *key) {
+  open_pending(r);
+  open_container(r, REC_TAG_OBJECT, key);
+}
+
+void rec_group_end(report_rec *r) { close_container(r); }
+
+void rec_list(report_rec *r, const char *key) {
+  open_pending(r);
+  open_container(r, REC_TAG_LIST, key);
+}
+
+void rec_list_end(report_rec *r) { close_container(r); }
+
+void rec_item(report_rec *r) {
+  open_container(r, REC_TAG_ITEM, NULL);
+  r->line = true;
+}
+
+void rec_item_end(report_rec *r) {
+  rec_line_end(r);
+  close_container(r);
+}
+
+void rec_line(report_rec *r) { r->line = true; }
+
+void rec_line_end(report_rec *r) {
+  r->line = false;
+  if (r->text)
+    report_puts(r->text, "\n");
+}
+
+/*---------------------------------------------------------------------------*/
+void rec_uint(report_rec *r, const char *key, const char *fmt, u32 v) {
+  if (r->text && fmt) {
+    report_printf(r->text, fmt, v);
+    text_end(r);
+  }
+  if (data_member(r, key))
+    report_printf(r->json, "%u", v);
+  tlv_u32(r, REC_TAG_UINT, key, v);
+}
+
+void rec_int(report_rec *r, const char *key, const char *fmt, s32 v) {
+  if (r->text && fmt) {
+    report_printf(r->text, fmt, v);
+    text_end(r);
+  }
+  if (data_member(r, key))
+    report_printf(r->json, "%d", v);
+  tlv_u32(r, REC_TAG_INT, key, (u32)v);
+}
+
+void rec_str(report_rec *r, const char *key, const char *fmt, const char *v) {
+  rec_enum(r, key, fmt, v, v);
+}
+
+void rec_bool(report_rec *r, const char *key, const char *fmt, bool v,
+              const char *yes, const char *no) {
+  u8 b = v;
+
+  if (r->text && fmt) {
+    report_printf(r->text, fmt, v ? yes : no);
+    text_end(r);
+  }
+  if (data_member(r, key))
+    report_puts(r->json, v ? "true" : "false");
+  tlv_value(r, REC_TAG_BOOL, key, &b, 1);
+}
+
+void rec_enum(report_rec *r, const char *key, const char *fmt,
+              const char *token, const char *text) {
+  if (r->text && fmt) {
+    report_printf(r->text, fmt, text);
+    text_end(r);
+  }
+  if (data_member(r, key))
+    json_string(r, token);
+  tlv_str(r, key, token);
+}
@@ -0,0 +1,100 @@
+/*
+ * WiiMedic - report_rec.h
+ * Typed report records. Modules describe their section as keyed, typed
+ * fields; each field also carries the printf format of its text, so the
+ * text report, the JSON file and the binary file are all rendered from the
+ * same calls and cannot disagree.
+ *
+ * Binary (TLV) layout, big-endian like the console:
+ *   "WMRB" u8 version (1) u8 0 u16 0, then records of
+ *   u8 tag, u16 key id, u16 length, length bytes of value.
+ * A KEY record (re)defines its id as the name in its value; other records
+ * refer to ids defined before them. Items have key id 0.
+ */
+#ifndef REPORT_REC_H
+#define REPORT_REC_H
+
+#include <gccore.h>
+
+#include "report_sink.h"
+
+#define REC_TLV_VERSION 1
+#define REC_MAX_DEPTH 8
+#define REC_MAX_KEYS 192 // TLV key ids kept; later keys reuse the last id
+
+// TLV record tags
+#define REC_TAG_KEY 0x01    // value: key name
+#define REC_TAG_OBJECT 0x02 // keyed object until REC_TAG_END
+#define REC_TAG_LIST 0x03   // keyed list until REC_TAG_END
+#define REC_TAG_ITEM 0x04   // object in a list until REC_TAG_END
+#define REC_TAG_END 0x05
+#define REC_TAG_NULL 0x06   // module with no data
+#define REC_TAG_UINT 0x10   // u32
+#define REC_TAG_INT 0x11    // s32
+#define REC_TAG_BOOL 0x12   // u8 0 / 1
+#define REC_TAG_STR 0x13    // UTF-8, no NUL
+
+typedef struct report_rec {
+  report_sink *text; // each may be NULL: that form is not written
+  report_sink *json;
+  report_sink *tlv;
+
+  int depth;                    // open JSON objects and lists
+  u16 members[REC_MAX_DEPTH];   // written so far at each depth
+  bool is_list[REC_MAX_DEPTH];
+  const char *pending;          // section key not opened yet
+  bool line;                    // fields share one text line until line_end
+  const char *keys[REC_MAX_KEYS]; // TLV key id - 1
+  u16 key_count;
+} report_rec;
+
+// Start a report on the given sinks (opened by the caller; NULL = skip
+// that form): the JSON root object and the TLV header
+void rec_begin(report_rec *r, report_sink *text, report_sink *json,
+               report_sink *tlv);
+
+// Close the root object. The caller closes the sinks.
+void rec_end(report_rec *r);
+
+// Text for the text report only: headings, notes, blank lines
+void rec_text(report_rec *r, const char *text);
+
+// A module's section: its fields go in an object named key. A section
+// with no fields is written as null.
+void rec_section(report_rec *r, const char *key);
+
+// Close the section and end it on every sink (report_section_end)
+void rec_section_end(report_rec *r);
+
+// Apply report_hold to every sink
+void rec_hold(report_rec *r, bool hold);
+
+// Nested object, and list of items (each item is also one text line)
+void rec_group(report_rec *r, const char *key);
+void rec_group_end(report_rec *r);
+void rec_list(report_rec *r, const char *key);
+void rec_list_end(report_rec *r);
+void rec_item(report_rec *r);
+void rec_item_end(report_rec *r);
+
+// Put the following fields' text on one line, ended by rec_line_end
+void rec_line(report_rec *r);
+void rec_line_end(report_rec *r);
+
+// Fields. fmt is the text form with one conversion for the value (NULL =
+// data only); outside a line or item it is followed by a newline. Strings
+// are bytes from the console: valid UTF-8 is kept, and any other byte of
+// 0x80 and up is taken as Latin-1 in the JSON and TLV forms.
+void rec_uint(report_rec *r, const char *key, const char *fmt, u32 v);
+void rec_int(report_rec *r, const char *key, const char *fmt, s32 v);
+void rec_str(report_rec *r, const char *key, const char *fmt, const char *v);
+
+// A bool whose text is yes or no through fmt's %s
+void rec_bool(report_rec *r, const char *key, const char *fmt, bool v,
+              const char *yes, const char *no);
+
+// A string whose data value is a stable token and whose text is prose
+void rec_enum(report_rec *r, const char *key, const char *fmt,
+              const char *token, const char *text);
+
+#endif // REPORT_REC_H
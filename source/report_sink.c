@@ -0,0 +1,121 @@
+/*
+ * WiiMedic - report_sink.c
+ * Report text goes from vsnprintf straight into the sink's buffer and from
+ * there to fwrite: no section buffers, no whole-report copy. A buffer that
+ * fills up mid-section is written out early; only a held sink (storage
+ * benchmark running) grows it. Section ends flush the stdio and libfat
+ * caches, so every finished section is on the card; the one being written
+ * may be there in part, up to the last buffer that filled.
+ */
+
+#include <gccore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mem_budget.h"
+#include "report_sink.h"
+#include "trace.h"
+
+/*---------------------------------------------------------------------------*/
+static void sink_write(report_sink *s) {
+  if (s->fp && s->len && !s->failed &&
+      TRACE_CALL("fwrite", fwrite(s->buf, 1, s->len, s->fp)) != s->len)
+    s->failed = true;
+  s->len = 0;
+}
+
+/* Room for need more bytes (plus the NUL vsnprintf writes) */
+static bool sink_reserve(report_sink *s, u32 need) {
+  u32 cap = s->cap;
+  char *grown;
+
+  if (s->len + need < s->cap)
+    return true;
+  if (!s->held) {
+    sink_write(s);
+    if (need < s->cap)
+      return true;
+  }
+  while (cap <= s->len + need)
+    cap *= 2;
+  grown = (char *)mem_memalign(MEM_TAG_REPORT, 32, cap);
+  if (!grown) {
+    s->failed = true;
+    return false;
+  }
+  memcpy(grown, s->buf, s->len);
+  mem_free(s->buf);
+  s->buf = grown;
+  s->cap = cap;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+bool report_open(report_sink *s, FILE *fp) {
+  memset(s, 0, sizeof(*s));
+  s->fp = fp;
+  s->sync = fp && fp != stdout;
+  s->buf = (char *)mem_memalign(MEM_TAG_REPORT, 32, REPORT_SINK_CHUNK);
+  if (!s->buf)
+    return false;
+  s->cap = REPORT_SINK_CHUNK;
+  return true;
+}
+
+void report_printf(report_sink *s, const char *fmt, ...) {
+  va_list args;
+  int n;
+
+  va_start(args, fmt);
+  n = vsnprintf(s->buf + s->len, s->cap - s->len, fmt, args);
+  va_end(args);
+  if (n < 0)
+    return;
+  if ((u32)n >= s->cap - s->len) {
+    if (!sink_reserve(s, (u32)n))
+      return;
+    va_start(args, fmt);
+    vsnprintf(s->buf + s->len, s->cap - s->len, fmt, args);
+    va_end(args);
+  }
+  s->len += (u32)n;
+  s->bytes += (u32)n;
+}
+
+void report_puts(report_sink *s, const char *text) {
+  report_bytes(s, text, (u32)strlen(text));
+}
+
+void report_bytes(report_sink *s, const void *data, u32 len) {
+  if (!sink_reserve(s, len))
+    return;
+  memcpy(s->buf + s->len, data, len);
+  s->len += len;
+  s->bytes += len;
+}
+
+void report_section_end(report_sink *s) {
+  if (s->held)
+    return;
+  sink_write(s);
+  if (!s->fp)
+    return;
+  if (fflush(s->fp) != 0)
+    s->failed = true;
+  else if (s->sync)
+    TRACE_CALL("fsync", fsync(fileno(s->fp)));
+}
+
+void report_hold(report_sink *s, bool hold) { s->held = hold; }
+
+bool report_close(report_sink *s) {
+  s->held = false;
+  report_section_end(s);
+  s->len = 0;
+  mem_free(s->buf);
+  s->buf = NULL;
+  s->cap = 0;
+  return !s->failed;
+}
@@ -0,0 +1,56 @@
+/*
+ * WiiMedic - report_sink.h
+ * Streaming report writer: sections are formatted straight into one
+ * 32-byte-aligned buffer and written out as each one finishes, so a report
+ * has no size limit and an interrupted run still leaves the finished
+ * sections on disk
+ */
+#ifndef REPORT_SINK_H
+#define REPORT_SINK_H
+
+#include <gccore.h>
+#include <stdio.h>
+
+// Buffer size; text beyond it is written out early, or grows the buffer
+// while the sink is held
+#define REPORT_SINK_CHUNK 16384
+
+typedef struct report_sink {
+  FILE *fp;   // NULL: text is formatted and dropped (benchmarks)
+  char *buf;  // 32-byte aligned, cap bytes
+  u32 len;    // bytes waiting in buf
+  u32 cap;
+  u32 bytes;  // bytes accepted so far
+  bool held;  // keep off the file; see report_hold
+  bool sync;  // fsync at each section end (not for stdout)
+  bool failed; // a write or an allocation failed; text may be missing
+} report_sink;
+
+// Start a sink on fp (opened "w", or stdout, or NULL). Returns false if
+// the buffer could not be allocated.
+bool report_open(report_sink *s, FILE *fp);
+
+// Append formatted text. Never truncates: the buffer is written out or
+// grown as needed.
+void report_printf(report_sink *s, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// Append text as is
+void report_puts(report_sink *s, const char *text);
+
+// Append len bytes of binary data
+void report_bytes(report_sink *s, const void *data, u32 len);
+
+// End a section: write the buffer out and flush it to the medium, unless
+// held (then this happens at the next section end after release)
+void report_section_end(report_sink *s);
+
+// While held nothing reaches the file, so a benchmark on the same medium
+// is not disturbed; the buffer grows instead
+void report_hold(report_sink *s, bool hold);
+
+// Write out what is left and free the buffer (the caller closes fp).
+// Returns false if anything was lost.
+bool report_close(report_sink *s);
+
+#endif // REPORT_SINK_H
@@ -0,0 +1,69 @@
+/*
+ * WiiMedic - results.c
+ * Capture stamps per module. The results themselves stay in each module's
+ * own state; this only tracks whether they can be trusted. Stamps are
+ * written on the UI thread when a run or collect finishes without being
+ * cancelled, and cleared by age, hot-plug or an explicit invalidate.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <ogc/usbstorage.h>
+#include <sdcard/wiisd_io.h>
+
+#include "results.h"
+
+#define MEDIA_SD 0x1
+#define MEDIA_USB 0x2
+
+static u64 s_captured[MODULE_COUNT]; /* ticks, 0 = nothing usable */
+static int s_media = -1;             /* MEDIA_* bits, -1 = not polled yet */
+
+/*---------------------------------------------------------------------------*/
+void result_stamp(module_id id) {
+  u64 now = gettime();
+
+  s_captured[id] = now ? now : 1;
+}
+
+bool result_fresh(module_id id) {
+  u32 max_age = module_get(id)->max_age_ms;
+
+  if (!s_captured[id])
+    return false;
+  return max_age == 0 || result_age_ms(id) < max_age;
+}
+
+u64 result_stamped_at(module_id id) { return s_captured[id]; }
+
+u32 result_age_ms(module_id id) {
+  return (u32)ticks_to_millisecs(gettime() - s_captured[id]);
+}
+
+void result_invalidate(module_id id) { s_captured[id] = 0; }
+
+void result_invalidate_resources(u32 res) {
+  int id;
+
+  for (id = 0; id < MODULE_COUNT; id++) {
+    if (module_get((module_id)id)->resources & res)
+      s_captured[id] = 0;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+bool result_poll_media(void) {
+  int media = 0;
+  bool changed;
+
+  if (__io_wiisd.isInserted())
+    media |= MEDIA_SD;
+  if (__io_usbstorage.isInserted())
+    media |= MEDIA_USB;
+
+  changed = s_media >= 0 && media != s_media;
+  s_media = media;
+  if (changed)
+    result_invalidate_resources(MOD_RES_FAT);
+  return changed;
+}
@@ -0,0 +1,38 @@
+/*
+ * WiiMedic - results.h
+ * Freshness of each module's captured results, so the report can reuse a
+ * scan the user just ran instead of repeating it
+ */
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <gccore.h>
+
+#include "modules.h"
+
+// How often the menu polls for SD/USB hot-plug
+#define RESULTS_MEDIA_POLL_MS 1000
+
+// Record that id's results were just captured in full (not cancelled)
+void result_stamp(module_id id);
+
+// True if id has complete results younger than its max_age_ms that have not
+// been invalidated since
+bool result_fresh(module_id id);
+
+// When id was last stamped (ticks), 0 if its results are not usable; tells
+// apart two captures of the same age class
+u64 result_stamped_at(module_id id);
+
+// Milliseconds since id was stamped (meaningless unless it was)
+u32 result_age_ms(module_id id);
+
+// Forget id's results / those of every module using any of res (MOD_RES_*)
+void result_invalidate(module_id id);
+void result_invalidate_resources(u32 res);
+
+// Check the SD and USB slots; a change invalidates MOD_RES_FAT users.
+// Returns true if something was inserted or removed. UI thread only.
+bool result_poll_media(void);
+
+#endif // RESULTS_H
@@ -0,0 +1,216 @@
+/*
+ * WiiMedic - scheduler.c
+ * List scheduler over the module table. A module is ready once its deps are
+ * done and none of its resources are held by a running module; among ready
+ * modules the most expensive starts first, so net_init and the TCP connects
+ * overlap the ISFS and ES work instead of following it. Modules flagged
+ * MOD_F_UI_THREAD run inline between polls while the workers carry on.
+ * Modules whose results are still fresh skip collect() and only format.
+ * Sections are formatted on the UI thread, straight into the report sinks,
+ * as soon as the registry-order prefix they belong to is complete.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "results.h"
+#include "scheduler.h"
+#include "startup.h"
+#include "task.h"
+#include "trace.h"
+#include "ui_common.h"
+
+/* One slot of task.c's pool stays free for interactive use. Host build, one
+   CPU, ipc_us=2000, net_init_ms=1500: a full report takes 1745 ms with one
+   worker and 1511 ms with three (same binary, median of 5). Not measured
+   on a console. */
+#define SCHED_WORKERS 3
+
+typedef struct {
+  module_id id;
+  task_t task;
+} sched_job;
+
+/*---------------------------------------------------------------------------*/
+static void job_collect(const module_desc *m) {
+  if (m->collect)
+    m->collect();
+}
+
+static void job_entry(void) {
+  sched_job *job = (sched_job *)task_arg();
+
+  ui_output_mute();
+  job_collect(module_get(job->id));
+}
+
+/* Sections of the modules in mask from *next on, up to the first one not
+   done yet */
+static void write_sections(report_rec *out, u32 mask, u32 done, int *next) {
+  for (; *next < MODULE_COUNT && (done & MODULE_BIT(*next)); (*next)++) {
+    const module_desc *m = module_get((module_id)*next);
+
+    if (!(mask & MODULE_BIT(*next)))
+      continue;
+    rec_section(out, m->name);
+    if (m->report)
+      m->report(out);
+    if (out->pending && m->report_missing)
+      rec_text(out, m->report_missing);
+    rec_section_end(out);
+  }
+}
+
+/* Highest-cost ready module, or -1. Worker modules are preferred so they
+   are all in flight before the UI thread ties itself up with an inline one.
+   Modules whose devices are still coming up wait like busy ones. */
+static int pick_next(u32 pending, u32 done, u32 busy) {
+  int best = -1;
+  bool best_inline = true;
+  int id;
+
+  for (id = 0; id < MODULE_COUNT; id++) {
+    const module_desc *m = module_get((module_id)id);
+    bool is_inline = (m->flags & MOD_F_UI_THREAD) != 0;
+
+    if (!(pending & MODULE_BIT(id)) || (m->deps & ~done) ||
+        (m->resources & busy) ||
+        !devices_ready(devices_for_resources(m->resources)))
+      continue;
+    if (best < 0 || (best_inline && !is_inline) ||
+        (best_inline == is_inline && m->cost_ms > module_get(best)->cost_ms)) {
+      best = id;
+      best_inline = is_inline;
+    }
+  }
+  return best;
+}
+
+static u32 ms_since(u64 start) {
+  return (u32)ticks_to_millisecs(gettime() - start);
+}
+
+static void report_done(const module_desc *m, u32 ms) {
+  char msg[96];
+
+  snprintf(msg, sizeof(msg), "%s done (%u ms)", m->title, ms);
+  ui_draw_ok(msg);
+}
+
+static void report_reused(const module_desc *m, u32 age_ms) {
+  char msg[96];
+
+  snprintf(msg, sizeof(msg), "%s: reusing results from %us ago", m->title,
+           age_ms / 1000);
+  ui_draw_ok(msg);
+}
+
+/*---------------------------------------------------------------------------*/
+int sched_collect(u32 mask, report_rec *out, sched_stats *st) {
+  sched_job jobs[SCHED_WORKERS];
+  bool used[SCHED_WORKERS] = {false};
+  u32 pending = mask & MODULE_ALL;
+  u32 done = ~pending; /* modules outside mask count as satisfied deps */
+  u32 busy = 0;
+  int total = __builtin_popcount(pending);
+  int step = 0, running = 0, next_section = 0;
+  u64 t0 = gettime();
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  mask = pending;
+
+  while (pending || running) {
+    bool reaped = false;
+
+    /* Start everything that can start */
+    while (running < SCHED_WORKERS) {
+      int id = pick_next(pending, done, busy);
+      const module_desc *m;
+      int slot;
+
+      if (id < 0)
+        break;
+      m = module_get((module_id)id);
+      pending &= ~MODULE_BIT(id);
+      st->start_ms[id] = ms_since(t0);
+      ui_printf(UI_BCYAN "   [%d/%d]" UI_WHITE " %s\n" UI_RESET, ++step,
+                total, m->report_step);
+
+      /* Fresh results: just format them, nothing to wait for */
+      if (m->collect && result_fresh((module_id)id)) {
+        st->reused_age_ms[id] = result_age_ms((module_id)id);
+        st->reused |= MODULE_BIT(id);
+        st->run_ms[id] = ms_since(t0) - st->start_ms[id];
+        done |= MODULE_BIT(id);
+        report_reused(m, st->reused_age_ms[id]);
+        continue;
+      }
+
+      for (slot = 0; slot < SCHED_WORKERS && used[slot]; slot++)
+        ;
+      jobs[slot].id = (module_id)id;
+      if (!(m->flags & MOD_F_UI_THREAD) &&
+          task_start_arg(&jobs[slot].task, m->name, job_entry, &jobs[slot],
+                         m->timeout_ms)) {
+        used[slot] = true;
+        busy |= m->resources;
+        rec_hold(out, (busy & MOD_RES_FAT) != 0);
+        running++;
+        if (running > st->max_running)
+          st->max_running = running;
+        continue;
+      }
+
+      /* Inline: UI-thread module, or no thread available */
+      TRACE_SPAN(m->name, job_collect(m));
+      st->run_ms[id] = ms_since(t0) - st->start_ms[id];
+      done |= MODULE_BIT(id);
+      if (m->collect)
+        result_stamp((module_id)id);
+      report_done(m, st->run_ms[id]);
+    }
+
+    if (!running && pending && !devices_ready(DEV_ALL)) {
+      devices_wait(DEV_ALL);
+      continue;
+    }
+    if (!running && pending) {
+      /* Only a dependency cycle in the table gets here */
+      ui_draw_err("Scheduler stalled: module dependencies never met");
+      break;
+    }
+
+    ui_output_drain();
+    for (i = 0; i < SCHED_WORKERS; i++) {
+      const module_desc *m;
+
+      if (!used[i] || !__atomic_load_n(&jobs[i].task.done, __ATOMIC_ACQUIRE))
+        continue;
+      task_join(&jobs[i].task);
+      m = module_get(jobs[i].id);
+      if (m->collect && !jobs[i].task.cancel &&
+          !task_timed_out(&jobs[i].task))
+        result_stamp(jobs[i].id);
+      st->run_ms[jobs[i].id] = ms_since(t0) - st->start_ms[jobs[i].id];
+      used[i] = false;
+      busy &= ~m->resources;
+      rec_hold(out, (busy & MOD_RES_FAT) != 0);
+      done |= MODULE_BIT(jobs[i].id);
+      running--;
+      reaped = true;
+      report_done(m, st->run_ms[jobs[i].id]);
+    }
+    write_sections(out, mask, done, &next_section);
+    if (!reaped && running)
+      VIDEO_WaitVSync();
+  }
+  write_sections(out, mask, done, &next_section);
+
+  st->wall_ms = ms_since(t0);
+  for (i = 0; i < MODULE_COUNT; i++)
+    st->serial_ms += st->run_ms[i];
+  return step;
+}
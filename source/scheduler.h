@@ -0,0 +1,33 @@
+/*
+ * WiiMedic - scheduler.h
+ * Dependency-aware module scheduler: collects several modules at once on
+ * worker threads, never overlapping two that share a resource
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <gccore.h>
+
+#include "modules.h"
+#include "report_rec.h"
+
+typedef struct {
+  u32 start_ms[MODULE_COUNT]; // since sched_collect started
+  u32 run_ms[MODULE_COUNT];
+  u32 wall_ms;     // whole collection
+  u32 serial_ms;   // sum of run_ms: the wall time without overlap
+  int max_running; // most modules in flight at once
+  u32 reused;      // MODULE_BIT()s formatted from fresh results, not collected
+  u32 reused_age_ms[MODULE_COUNT]; // age of those results
+} sched_stats;
+
+// Run collect() for every module in mask (MODULE_BIT()s) and write their
+// report() sections to out in registry order, each as soon as it and every
+// section before it are done; out is held while a MOD_RES_FAT module runs.
+// Modules with fresh results (results.h) are not collected again; the
+// others are stamped when collect() completes uncancelled. Call from the
+// UI thread; prints a progress line as each module starts and finishes.
+// Module screen output is discarded. Returns the number run.
+int sched_collect(u32 mask, report_rec *out, sched_stats *st);
+
+#endif // SCHEDULER_H
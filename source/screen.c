@@ -0,0 +1,188 @@
+/*
+ * WiiMedic - screen.c
+ * Retained screen. The Wii console draws every glyph in software, so a full
+ * clear-and-reprint on each button press flickers and costs far more than
+ * the handful of cells that actually change. Frames are normally drawn
+ * straight into the framebuffer (xfb_text.c); before that is set up, and
+ * on the host as well, two cell grids are kept: the frame being drawn and
+ * what the console shows. Presenting walks them row by row and sends each
+ * stretch of changed cells after one cursor move; short unchanged gaps are
+ * resent rather than skipped, as a cursor move costs about as much as
+ * several cells.
+ */
+
+#include <gccore.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "screen.h"
+#include "xfb_text.h"
+
+#define SCREEN_GAP 6 /* unchanged cells worth resending to save a move */
+#define SCREEN_OUT_SIZE 2048
+#define SCREEN_ATTR_UNKNOWN 0xFF
+
+/* Nobody watches the host's framebuffer: keep the console output too */
+#ifdef WIIMEDIC_HOST
+#define SCREEN_CONSOLE_MIRROR true
+#else
+#define SCREEN_CONSOLE_MIRROR false
+#endif
+
+static screen_cell s_back[SCREEN_ROWS][SCREEN_COLS];  /* frame being drawn */
+static screen_cell s_front[SCREEN_ROWS][SCREEN_COLS]; /* console shows */
+static bool s_front_valid = false;
+static bool s_capturing = false;
+static int s_row;
+
+static char s_out[SCREEN_OUT_SIZE];
+static u32 s_out_len;
+static u32 s_out_total;
+
+/*---------------------------------------------------------------------------*/
+static void out_flush(void) {
+  if (s_out_len) {
+    fwrite(s_out, 1, s_out_len, stdout);
+    s_out_total += s_out_len;
+    s_out_len = 0;
+  }
+}
+
+static void out_bytes(const char *p, u32 n) {
+  if (s_out_len + n > SCREEN_OUT_SIZE)
+    out_flush();
+  memcpy(s_out + s_out_len, p, n);
+  s_out_len += n;
+}
+
+/* Console rows and columns count from 1 */
+static void out_move(int row, int col) {
+  char buf[16];
+  int n = 0;
+
+  buf[n++] = '\x1b';
+  buf[n++] = '[';
+  if (row + 1 >= 10)
+    buf[n++] = (char)('0' + (row + 1) / 10);
+  buf[n++] = (char)('0' + (row + 1) % 10);
+  buf[n++] = ';';
+  if (col + 1 >= 10)
+    buf[n++] = (char)('0' + (col + 1) / 10);
+  buf[n++] = (char)('0' + (col + 1) % 10);
+  buf[n++] = 'H';
+  out_bytes(buf, n);
+}
+
+static void fill_blank(screen_cell grid[SCREEN_ROWS][SCREEN_COLS]) {
+  int r, c;
+
+  for (r = 0; r < SCREEN_ROWS; r++)
+    for (c = 0; c < SCREEN_COLS; c++)
+      grid[r][c] = SCREEN_BLANK;
+}
+
+/*---------------------------------------------------------------------------*/
+void screen_begin(void) {
+  fill_blank(s_back);
+  s_row = 0;
+  s_capturing = true;
+}
+
+bool screen_capturing(void) { return s_capturing; }
+
+void screen_line(const line_view *v) {
+  u32 end = v->len < SCREEN_COLS ? v->len : SCREEN_COLS;
+  u32 pos, r = 0;
+  u8 attr = LINE_ATTR_DEFAULT;
+  screen_cell *row;
+
+  if (s_row >= SCREEN_ROWS)
+    return;
+  row = s_back[s_row++];
+  for (pos = 0; pos < end; pos++) {
+    u8 ch = (u8)v->text[pos];
+
+    while (r < v->nruns && LINE_RUN_START(v->runs[r]) <= pos)
+      attr = LINE_RUN_ATTR(v->runs[r++]);
+    /* Spaces look the same in any attribute; keep them comparable */
+    if (ch <= ' ')
+      row[pos] = SCREEN_BLANK;
+    else
+      row[pos] = SCREEN_CELL(ch, attr);
+  }
+}
+
+void screen_put(int row, int col, char ch, u8 attr) {
+  if (row < 0 || row >= SCREEN_ROWS || col < 0 || col >= SCREEN_COLS)
+    return;
+  s_back[row][col] = (u8)ch <= ' ' ? SCREEN_BLANK : SCREEN_CELL(ch, attr);
+}
+
+void screen_invalidate(void) {
+  s_front_valid = false;
+  if (xfb_text_active())
+    xfb_text_release();
+}
+
+/*---------------------------------------------------------------------------*/
+static u32 present_console(void) {
+  u8 attr = SCREEN_ATTR_UNKNOWN;
+  char esc[LINE_ESC_MAX];
+  int row, col;
+
+  s_out_total = 0;
+  if (!s_front_valid) {
+    out_bytes("\x1b[2J", 4);
+    fill_blank(s_front);
+    s_front_valid = true;
+  }
+
+  for (row = 0; row < SCREEN_ROWS; row++) {
+    const screen_cell *back = s_back[row];
+    screen_cell *front = s_front[row];
+
+    col = 0;
+    while (col < SCREEN_COLS) {
+      int last, c;
+
+      if (back[col] == front[col]) {
+        col++;
+        continue;
+      }
+      /* Stretch to the last change with no long unchanged gap before it */
+      last = col;
+      for (c = col + 1; c < SCREEN_COLS && c - last <= SCREEN_GAP; c++) {
+        if (back[c] != front[c])
+          last = c;
+      }
+
+      out_move(row, col);
+      for (c = col; c <= last; c++) {
+        u8 a = SCREEN_CELL_ATTR(back[c]);
+        char ch = (char)SCREEN_CELL_CH(back[c]);
+
+        if (a != attr) {
+          out_bytes(esc, line_attr_escape(a, esc));
+          attr = a;
+        }
+        out_bytes(&ch, 1);
+        front[c] = back[c];
+      }
+      col = last + 1;
+    }
+  }
+
+  if (attr != SCREEN_ATTR_UNKNOWN && attr != LINE_ATTR_DEFAULT)
+    out_bytes(esc, line_attr_escape(LINE_ATTR_DEFAULT, esc));
+  out_flush();
+  fflush(stdout);
+  return s_out_total;
+}
+
+u32 screen_present(void) {
+  s_capturing = false;
+  if (!xfb_text_active())
+    return present_console();
+  xfb_text_present(s_back);
+  return SCREEN_CONSOLE_MIRROR ? present_console() : 0;
+}
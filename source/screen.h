@@ -0,0 +1,51 @@
+/*
+ * WiiMedic - screen.h
+ * Retained text screen for the menu and the scroll viewer: a frame is drawn
+ * into a grid of cells, and only the cells that differ from what the
+ * console already shows are sent to it
+ */
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <gccore.h>
+
+#include "line_store.h"
+
+// Cells kept clear of the console's last column and row, so writing a cell
+// never wraps or scrolls the console
+#define SCREEN_ROWS 28
+#define SCREEN_COLS 78
+
+// A cell: character in the low byte, line attribute in the high byte
+typedef u16 screen_cell;
+#define SCREEN_CELL(ch, attr) ((screen_cell)((u16)(attr) << 8 | (u8)(ch)))
+#define SCREEN_CELL_CH(c) ((u8)((c) & 0xFF))
+#define SCREEN_CELL_ATTR(c) ((u8)((c) >> 8))
+#define SCREEN_BLANK SCREEN_CELL(' ', LINE_ATTR_DEFAULT)
+
+// Start a frame: every cell blank. Until screen_present, ui_line_end on the
+// UI thread fills rows from the top (see screen_line) instead of printing.
+void screen_begin(void);
+
+// True between screen_begin and screen_present
+bool screen_capturing(void);
+
+// Put v on the next row of the frame, cut at SCREEN_COLS; rows past
+// SCREEN_ROWS are dropped. A blank line just advances.
+void screen_line(const line_view *v);
+
+// Overwrite one cell of the frame (row and col from 0), e.g. a marker on a
+// row already drawn
+void screen_put(int row, int col, char ch, u8 attr);
+
+// Show the frame and end it: drawn into the framebuffer once xfb_text_init
+// has run, otherwise its changes go to the console. Returns the bytes
+// written to the console.
+u32 screen_present(void);
+
+// The console no longer shows the last frame (ui_clear calls this); the
+// next present clears it and draws the whole frame. The console's
+// framebuffer is shown again meanwhile.
+void screen_invalidate(void);
+
+#endif // SCREEN_H
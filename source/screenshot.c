@@ -0,0 +1,223 @@
+/*
+ * WiiMedic - screenshot.c
+ * Screenshots. The framebuffer on screen is read a line at a time,
+ * converted from YUYV to RGB and handed to the PNG writer, so a capture
+ * needs one line of RGB and one IDAT chunk of memory rather than a 900 KB
+ * image. The conversion is BT.601 in fixed point from tables: for each
+ * pair of pixels the chroma terms are looked up once, then each pixel is
+ * three adds and three clamp-table loads. The host build does four pairs
+ * at a time with SSE2 (same fixed point, same results); the console's
+ * paired singles have no integer lanes, so it keeps the tables.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIIMEDIC_HOST) && defined(__SSE2__)
+#include <emmintrin.h>
+#define YUYV_SSE2
+#endif
+
+#include "png_stream.h"
+#include "screenshot.h"
+#include "startup.h"
+#include "trace.h"
+#include "xfb_text.h"
+
+#define SHOT_PATH "sd:/WiiMedic_shot_%03d.png"
+#define SHOT_MAX 1000
+#define CLAMP_OFFSET 256 /* sums >> 8 stay within -171..534 */
+#define CLAMP_SIZE 1024
+
+static s32 s_y_term[256]; /* 298 * (Y - 16) + 128 */
+static s32 s_rv[256];     /* 409 * (V - 128) */
+static s32 s_gu[256];     /* -100 * (U - 128) */
+static s32 s_gv[256];     /* -208 * (V - 128) */
+static s32 s_bu[256];     /* 516 * (U - 128) */
+static u8 s_clamp[CLAMP_SIZE];
+static bool s_tables_ready = false;
+
+static png_stream s_png; /* ~20 KB: kept off the UI thread's stack */
+static u8 s_row[PNG_MAX_WIDTH * 3];
+static int s_next_shot = 0; /* no lower number is free */
+
+/*---------------------------------------------------------------------------*/
+static void build_tables(void) {
+  int i;
+
+  for (i = 0; i < 256; i++) {
+    s_y_term[i] = 298 * (i - 16) + 128;
+    s_rv[i] = 409 * (i - 128);
+    s_gu[i] = -100 * (i - 128);
+    s_gv[i] = -208 * (i - 128);
+    s_bu[i] = 516 * (i - 128);
+  }
+  for (i = 0; i < CLAMP_SIZE; i++) {
+    int v = i - CLAMP_OFFSET;
+
+    s_clamp[i] = (u8)(v < 0 ? 0 : v > 255 ? 255 : v);
+  }
+  s_tables_ready = true;
+}
+
+#ifdef YUYV_SSE2
+/* Each lane is one pair. pmaddwd takes two 16-bit factors per lane, so
+   the chroma terms are both U and V against a weight pair, and the luma
+   term is Y - 16 against 298 and 0. packs and packus do the clamping. */
+static u32 yuyv_to_rgb_sse2(const u32 *src, u8 *dst, u32 pairs) {
+  const __m128i low = _mm_set1_epi32(0xFFFF);
+  const __m128i byte = _mm_set1_epi32(0xFF);
+  const __m128i w_y = _mm_set1_epi32(298);
+  const __m128i w_r = _mm_set1_epi32(409 << 16);
+  const __m128i w_g =
+      _mm_set1_epi32((s32)((u32)(u16)-208 << 16 | (u16)-100));
+  const __m128i w_b = _mm_set1_epi32(516);
+  const __m128i round = _mm_set1_epi32(128);
+  const __m128i zero = _mm_setzero_si128();
+  u32 done = 0;
+
+  for (; done + 4 <= pairs; done += 4) {
+    __m128i w = _mm_loadu_si128((const __m128i *)(src + done));
+    __m128i u = _mm_and_si128(_mm_srli_epi32(w, 16), byte);
+    __m128i v = _mm_and_si128(w, byte);
+    __m128i uv = _mm_or_si128(
+        _mm_and_si128(_mm_sub_epi32(u, round), low),
+        _mm_slli_epi32(_mm_sub_epi32(v, round), 16));
+    __m128i y1 = _mm_and_si128(
+        _mm_sub_epi32(_mm_srli_epi32(w, 24), _mm_set1_epi32(16)), low);
+    __m128i y2 = _mm_and_si128(
+        _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(w, 8), byte),
+                      _mm_set1_epi32(16)),
+        low);
+    __m128i r = _mm_madd_epi16(uv, w_r);
+    __m128i g = _mm_madd_epi16(uv, w_g);
+    __m128i b = _mm_madd_epi16(uv, w_b);
+    __m128i t1, t2, rr, gg, bb, rg, bz;
+    u32 px[8];
+    int i;
+
+    y1 = _mm_add_epi32(_mm_madd_epi16(y1, w_y), round);
+    y2 = _mm_add_epi32(_mm_madd_epi16(y2, w_y), round);
+
+    /* Pixels in order (pair 0 left, pair 0 right, ...), 16 bits each */
+#define YUYV_CHANNEL(c, out)                                                 \
+  t1 = _mm_srai_epi32(_mm_add_epi32(y1, c), 8);                              \
+  t2 = _mm_srai_epi32(_mm_add_epi32(y2, c), 8);                              \
+  out = _mm_packs_epi32(_mm_unpacklo_epi32(t1, t2), _mm_unpackhi_epi32(t1, t2))
+    YUYV_CHANNEL(r, rr);
+    YUYV_CHANNEL(g, gg);
+    YUYV_CHANNEL(b, bb);
+#undef YUYV_CHANNEL
+
+    rg = _mm_unpacklo_epi8(_mm_packus_epi16(rr, rr), _mm_packus_epi16(gg, gg));
+    bz = _mm_unpacklo_epi8(_mm_packus_epi16(bb, bb), zero);
+    _mm_storeu_si128((__m128i *)px, _mm_unpacklo_epi16(rg, bz));
+    _mm_storeu_si128((__m128i *)(px + 4), _mm_unpackhi_epi16(rg, bz));
+
+    /* Four-byte stores, each over the spare byte of the one before */
+    for (i = 0; i < 7; i++, dst += 3)
+      memcpy(dst, &px[i], 4);
+    memcpy(dst, &px[7], 3);
+    dst += 3;
+  }
+  return done;
+}
+#endif
+
+void yuyv_to_rgb(const u32 *src, u8 *dst, u32 pairs) {
+  const u8 *clamp = s_clamp + CLAMP_OFFSET;
+
+#ifdef YUYV_SSE2
+  u32 done = yuyv_to_rgb_sse2(src, dst, pairs);
+
+  src += done;
+  dst += 6 * done;
+  pairs -= done;
+#endif
+  if (!s_tables_ready)
+    build_tables();
+  while (pairs--) {
+    u32 w = *src++;
+    s32 y1 = s_y_term[w >> 24];
+    s32 y2 = s_y_term[(w >> 8) & 0xFF];
+    u32 u = (w >> 16) & 0xFF, v = w & 0xFF;
+    s32 r = s_rv[v], g = s_gu[u] + s_gv[v], b = s_bu[u];
+
+    dst[0] = clamp[(y1 + r) >> 8];
+    dst[1] = clamp[(y1 + g) >> 8];
+    dst[2] = clamp[(y1 + b) >> 8];
+    dst[3] = clamp[(y2 + r) >> 8];
+    dst[4] = clamp[(y2 + g) >> 8];
+    dst[5] = clamp[(y2 + b) >> 8];
+    dst += 6;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* The first free number is looked up once; later shots go on from it */
+static bool next_name(char *path, int size) {
+  for (; s_next_shot < SHOT_MAX; s_next_shot++) {
+    FILE *f;
+
+    snprintf(path, size, SHOT_PATH, s_next_shot);
+    f = fopen(path, "rb");
+    if (!f) {
+      s_next_shot++;
+      return true;
+    }
+    fclose(f);
+  }
+  return false;
+}
+
+static bool write_png(FILE *fp, const u32 *fb, u32 width, u32 height) {
+  u32 y;
+
+  if (!png_begin(&s_png, fp, width, height))
+    return false;
+  for (y = 0; y < height; y++) {
+    yuyv_to_rgb(fb + y * (width / 2), s_row, width / 2);
+    png_row(&s_png, s_row);
+  }
+  return png_end(&s_png);
+}
+
+bool screenshot_save(char *note, int note_size) {
+  u64 start = gettime();
+  const u32 *fb;
+  u32 width, height;
+  char path[64];
+  FILE *fp;
+  bool ok;
+
+  fb = xfb_text_shown(&width, &height);
+  if (!fb) {
+    snprintf(note, note_size, "Screenshot: no framebuffer to read");
+    return false;
+  }
+  if (!devices_ready(DEV_FAT) || !next_name(path, sizeof(path))) {
+    snprintf(note, note_size, "Screenshot: SD card not available");
+    return false;
+  }
+  fp = TRACE_CALL("fopen", fopen(path, "wb"));
+  if (!fp) {
+    snprintf(note, note_size, "Screenshot: cannot create %s", path);
+    return false;
+  }
+
+  ok = TRACE_CALL("Screenshot", write_png(fp, fb, width, height));
+  if (TRACE_CALL("fclose", fclose(fp)) != 0)
+    ok = false;
+  if (!ok) {
+    remove(path);
+    snprintf(note, note_size, "Screenshot: could not write %s", path);
+    return false;
+  }
+
+  snprintf(note, note_size, "Saved %s (%u KB, %u ms)", path,
+           (unsigned)((s_png.bytes + 1023) / 1024),
+           (unsigned)ticks_to_millisecs(gettime() - start));
+  return true;
+}
@@ -0,0 +1,18 @@
+/*
+ * WiiMedic - screenshot.h
+ * Saves what is on the TV as sd:/WiiMedic_shot_NNN.png
+ */
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+#include <gccore.h>
+
+// Convert pairs YUYV words (two pixels each) to 2 * pairs RGB triplets
+void yuyv_to_rgb(const u32 *src, u8 *dst, u32 pairs);
+
+// Write the framebuffer on screen to the next free
+// sd:/WiiMedic_shot_NNN.png. Either way note gets a one-line result for
+// the user (file name, size and time, or what went wrong).
+bool screenshot_save(char *note, int note_size);
+
+#endif // SCREENSHOT_H
@@ -0,0 +1,191 @@
+/*
+ * WiiMedic - scroll_search.c
+ * Viewer search. Opening the viewer indexes which status markers each line
+ * carries, so the severity presets never look at the text again; a text
+ * query is one pass over the lines. Either way the matching line numbers
+ * end up in an ascending array, and next/previous is a step (or, before the
+ * first jump, a binary search) in it.
+ */
+
+#include <gccore.h>
+#include <string.h>
+
+#include "mem_budget.h"
+#include "scroll_search.h"
+
+#define MARK_OK 0x01
+#define MARK_WARN 0x02
+#define MARK_ERR 0x04
+
+/*---------------------------------------------------------------------------*/
+/* Markers in one line: "[OK]", "[!!]" or "[XX]" anywhere in the text */
+static u8 line_marks(const line_view *v) {
+  const char *p = v->text, *end = v->text + v->len;
+  u8 marks = 0;
+
+  while (end - p >= 4 && (p = memchr(p, '[', end - p - 3)) != NULL) {
+    if (p[3] == ']') {
+      if (p[1] == 'O' && p[2] == 'K')
+        marks |= MARK_OK;
+      else if (p[1] == '!' && p[2] == '!')
+        marks |= MARK_WARN;
+      else if (p[1] == 'X' && p[2] == 'X')
+        marks |= MARK_ERR;
+    }
+    p++;
+  }
+  return marks;
+}
+
+bool search_begin(scroll_search *s, const line_store *lines) {
+  line_view v;
+  u32 i;
+
+  memset(s, 0, sizeof(*s));
+  s->lines = lines;
+  s->cur = -1;
+  if (!line_store_count(lines))
+    return true;
+
+  /* Marks and hits in one block: a byte and a line number per line */
+  s->hits = (u32 *)mem_alloc(MEM_TAG_UI, line_store_count(lines) * 5);
+  if (!s->hits)
+    return false;
+  s->count = line_store_count(lines);
+  s->marks = (u8 *)(s->hits + s->count);
+  for (i = 0; i < s->count; i++) {
+    line_store_get(lines, i, &v);
+    s->marks[i] = line_marks(&v);
+  }
+  return true;
+}
+
+void search_end(scroll_search *s) {
+  mem_free(s->hits);
+  memset(s, 0, sizeof(*s));
+}
+
+/*---------------------------------------------------------------------------*/
+static char fold(char c) { return (c >= 'a' && c <= 'z') ? c - 32 : c; }
+
+/* query is already folded */
+static bool line_has(const line_view *v, const char *query, u32 qlen) {
+  u32 i, j;
+
+  if (qlen > v->len)
+    return false;
+  for (i = 0; i + qlen <= v->len; i++) {
+    if (fold(v->text[i]) != query[0])
+      continue;
+    for (j = 1; j < qlen && fold(v->text[i + j]) == query[j]; j++)
+      ;
+    if (j == qlen)
+      return true;
+  }
+  return false;
+}
+
+static void collect_hits(scroll_search *s) {
+  static const u8 mode_marks[] = {
+      [SEARCH_ERRORS] = MARK_ERR,
+      [SEARCH_WARNINGS] = MARK_WARN,
+      [SEARCH_PROBLEMS] = MARK_ERR | MARK_WARN,
+  };
+  u32 i, qlen = (u32)strlen(s->text);
+  line_view v;
+
+  s->nhits = 0;
+  s->cur = -1;
+  if (s->mode == SEARCH_OFF || !s->hits)
+    return;
+
+  for (i = 0; i < s->count; i++) {
+    bool hit;
+
+    if (s->mode == SEARCH_TEXT) {
+      line_store_get(s->lines, i, &v);
+      hit = line_has(&v, s->text, qlen);
+    } else {
+      hit = (s->marks[i] & mode_marks[s->mode]) != 0;
+    }
+    if (hit)
+      s->hits[s->nhits++] = i;
+  }
+}
+
+void search_next_preset(scroll_search *s) {
+  if (s->mode == SEARCH_PROBLEMS)
+    s->mode = SEARCH_OFF;
+  else if (s->mode == SEARCH_TEXT)
+    s->mode = SEARCH_ERRORS;
+  else
+    s->mode++;
+  collect_hits(s);
+}
+
+void search_set_text(scroll_search *s, const char *text) {
+  u32 i;
+
+  for (i = 0; i < SEARCH_TEXT_MAX && text[i]; i++)
+    s->text[i] = fold(text[i]);
+  s->text[i] = '\0';
+  s->mode = i ? SEARCH_TEXT : SEARCH_OFF;
+  collect_hits(s);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Index of the first hit at or after line */
+static u32 first_hit_from(const scroll_search *s, u32 line) {
+  u32 lo = 0, hi = s->nhits;
+
+  while (lo < hi) {
+    u32 mid = (lo + hi) / 2;
+
+    if (s->hits[mid] < line)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+int search_jump(scroll_search *s, u32 from, int dir) {
+  u32 k;
+
+  if (!s->nhits)
+    return -1;
+  if (s->cur < 0) {
+    k = first_hit_from(s, from);
+    if (dir < 0)
+      k = k ? k - 1 : s->nhits - 1;
+    else if (k == s->nhits)
+      k = 0;
+  } else if (dir > 0) {
+    k = (u32)s->cur + 1 < s->nhits ? (u32)s->cur + 1 : 0;
+  } else {
+    k = s->cur ? (u32)s->cur - 1 : s->nhits - 1;
+  }
+  s->cur = (int)k;
+  return (int)s->hits[k];
+}
+
+bool search_is_hit(const scroll_search *s, u32 i) {
+  u32 k = first_hit_from(s, i);
+
+  return k < s->nhits && s->hits[k] == i;
+}
+
+const char *search_label(const scroll_search *s) {
+  switch (s->mode) {
+  case SEARCH_ERRORS:
+    return "errors [XX]";
+  case SEARCH_WARNINGS:
+    return "warnings [!!]";
+  case SEARCH_PROBLEMS:
+    return "errors and warnings";
+  case SEARCH_TEXT:
+    return s->text;
+  default:
+    return "";
+  }
+}
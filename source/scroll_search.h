@@ -0,0 +1,60 @@
+/*
+ * WiiMedic - scroll_search.h
+ * Search for the scroll viewer: a severity preset or a text query over the
+ * stored lines, with the matching lines kept in order for next/previous
+ */
+#ifndef SCROLL_SEARCH_H
+#define SCROLL_SEARCH_H
+
+#include <gccore.h>
+
+#include "line_store.h"
+
+#define SEARCH_TEXT_MAX 24
+
+typedef enum {
+  SEARCH_OFF,
+  SEARCH_ERRORS,   // lines with [XX]
+  SEARCH_WARNINGS, // lines with [!!]
+  SEARCH_PROBLEMS, // either
+  SEARCH_TEXT,     // text, ignoring case
+} search_mode;
+
+typedef struct {
+  const line_store *lines;
+  u32 count;
+  u8 *marks; // per line: the status markers in it (index built once)
+  search_mode mode;
+  char text[SEARCH_TEXT_MAX + 1];
+  u32 *hits; // matching lines, ascending
+  u32 nhits;
+  int cur; // hit last jumped to, -1 before the first jump
+} scroll_search;
+
+// Index the lines stored so far (one pass for the [OK]/[!!]/[XX] markers
+// the drawing helpers emit). The store must not change until search_end.
+// Returns false if out of memory; searching then finds nothing.
+bool search_begin(scroll_search *s, const line_store *lines);
+
+// Release the index
+void search_end(scroll_search *s);
+
+// Cycle the presets: off, errors, warnings, both, off. A text search
+// continues with errors.
+void search_next_preset(scroll_search *s);
+
+// Search for text (ignoring case); empty turns the search off
+void search_set_text(scroll_search *s, const char *text);
+
+// Go to the next (dir > 0) or previous match, wrapping around. Before the
+// first jump, "next" is the first match at or after line from. Returns the
+// line, or -1 if nothing matches.
+int search_jump(scroll_search *s, u32 from, int dir);
+
+// True if line i matches the current search
+bool search_is_hit(const scroll_search *s, u32 i);
+
+// What is being searched for, for the status row
+const char *search_label(const scroll_search *s);
+
+#endif // SCROLL_SEARCH_H
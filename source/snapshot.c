@@ -0,0 +1,822 @@
+/*
+ * WiiMedic - snapshot.c
+ * System snapshots and their diff. Titles are written sorted by title id,
+ * each with a digest of its content records, so two snapshots compare in
+ * one forward pass over both files (a merge join): neither is loaded
+ * into memory, and a title's contents are only skipped over, never read
+ * back, because the digest already says whether they changed.
+ */
+
+#include <dirent.h>
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <wiiuse/wpad.h>
+
+#include "io_arena.h"
+#include "snapshot.h"
+#include "startup.h"
+#include "system_info.h"
+#include "trace.h"
+#include "ui_common.h"
+
+#define SNAP_MAX_DIRS 16    /* top-level NAND directories kept */
+#define SNAP_NAME_LEN 12    /* longest NAND file name */
+#define SNAP_FILE_BUF 8192  /* stdio buffer per open snapshot */
+#define SNAP_PREFIX "WiiMedic_Snap_"
+#define SNAP_PICK_ROWS 12   /* list rows shown around the cursor */
+
+static const u8 s_magic[4] = {'W', 'M', 'S', 'N'};
+
+typedef struct {
+  char name[SNAP_NAME_LEN + 1];
+  u32 clusters;
+  u32 inodes;
+} snap_dir;
+
+typedef struct {
+  u64 tid;
+  u64 ios;
+  u16 revision;
+  u16 contents;
+  u8 flags;
+  u32 digest;
+  u32 kb;
+} snap_title;
+
+/* An open snapshot: header, settings and directories read, titles next */
+typedef struct {
+  FILE *fp;
+  u32 time;
+  u32 device_id;
+  u32 titles;
+  u32 left; /* titles not read yet */
+  u32 clusters;
+  u32 inodes;
+  int setting_count;
+  s32 settings[SYSCONF_COUNT];
+  int dir_count;
+  snap_dir dirs[SNAP_MAX_DIRS];
+} snap_reader;
+
+/* Taking and comparing never overlap: the writer uses the first */
+static u8 s_file_buf[2][SNAP_FILE_BUF];
+
+/* Snapshot numbers on the medium in use, ascending, for the picker */
+static int s_nums[SNAPSHOT_MAX];
+static const char *s_pattern = SNAPSHOT_PATH_SD;
+
+/*---------------------------------------------------------------------------*/
+static void put_be16(u8 *p, u16 v) {
+  p[0] = (u8)(v >> 8);
+  p[1] = (u8)v;
+}
+
+static void put_be32(u8 *p, u32 v) {
+  p[0] = (u8)(v >> 24);
+  p[1] = (u8)(v >> 16);
+  p[2] = (u8)(v >> 8);
+  p[3] = (u8)v;
+}
+
+static void put_be64(u8 *p, u64 v) {
+  put_be32(p, (u32)(v >> 32));
+  put_be32(p + 4, (u32)v);
+}
+
+static u16 get_be16(const u8 *p) { return (u16)(p[0] << 8 | p[1]); }
+
+static u32 get_be32(const u8 *p) {
+  return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static u64 get_be64(const u8 *p) {
+  return (u64)get_be32(p) << 32 | get_be32(p + 4);
+}
+
+static u32 fnv1a(u32 h, const u8 *p, u32 len) {
+  while (len--)
+    h = (h ^ *p++) * 16777619u;
+  return h;
+}
+
+static int compare_tid(const void *a, const void *b) {
+  u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int compare_int(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+/* "IOS58", "System Menu", "00010001-HAXX" */
+static void title_name(u64 tid, char *buf, int size) {
+  u32 hi = (u32)(tid >> 32), lo = (u32)tid;
+  char code[5];
+  int i;
+
+  if (hi == 1) {
+    if (lo == 1)
+      snprintf(buf, size, "boot2");
+    else if (lo == 2)
+      snprintf(buf, size, "System Menu");
+    else if (lo == 0x100)
+      snprintf(buf, size, "BC");
+    else if (lo == 0x101)
+      snprintf(buf, size, "MIOS");
+    else
+      snprintf(buf, size, "IOS%u", lo);
+    return;
+  }
+  for (i = 0; i < 4; i++) {
+    code[i] = (char)(lo >> (24 - 8 * i));
+    if (code[i] < 0x20 || code[i] > 0x7E)
+      break;
+  }
+  code[4] = '\0';
+  if (i == 4)
+    snprintf(buf, size, "%08X-%s", hi, code);
+  else
+    snprintf(buf, size, "%08X-%08X", hi, lo);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Usage of each top-level NAND directory, sorted by name */
+static int collect_dirs(snap_dir *dirs, u32 *clusters, u32 *inodes) {
+  char *path = (char *)io_pool_alloc(ISFS_MAXPATH);
+  char *names = NULL;
+  u32 count = 0, i;
+  int n = 0, j;
+  s32 ret = TRACE_CALL("ISFS_Initialize", ISFS_Initialize());
+  bool we_initialized = (ret >= 0);
+
+  *clusters = *inodes = 0;
+  if ((ret < 0 && ret != -105) || !path) { /* -105 = ISFS_EALREADY */
+    if (path)
+      io_pool_free(path);
+    return 0;
+  }
+  TRACE_CALL("ISFS_GetUsage", ISFS_GetUsage("/", clusters, inodes));
+
+  strcpy(path, "/");
+  if (TRACE_CALL("ISFS_ReadDir", ISFS_ReadDir(path, NULL, &count)) >= 0 &&
+      count > 0)
+    names = (char *)io_pool_alloc(count * (SNAP_NAME_LEN + 1));
+  if (names &&
+      TRACE_CALL("ISFS_ReadDir", ISFS_ReadDir(path, names, &count)) >= 0) {
+    const char *name = names;
+
+    for (i = 0; i < count && n < SNAP_MAX_DIRS; i++) {
+      snap_dir d;
+
+      memset(&d, 0, sizeof(d));
+      strncpy(d.name, name, SNAP_NAME_LEN);
+      name += strlen(name) + 1;
+      snprintf(path, ISFS_MAXPATH, "/%s", d.name);
+      if (TRACE_CALL("ISFS_GetUsage",
+                     ISFS_GetUsage(path, &d.clusters, &d.inodes)) < 0)
+        continue;
+      /* Insertion sort: there are only a handful */
+      for (j = n; j > 0 && strcmp(dirs[j - 1].name, d.name) > 0; j--)
+        dirs[j] = dirs[j - 1];
+      dirs[j] = d;
+      n++;
+    }
+  }
+  if (names)
+    io_pool_free(names);
+  io_pool_free(path);
+
+  if (we_initialized)
+    TRACE_CALL("ISFS_Deinitialize", ISFS_Deinitialize());
+  return n;
+}
+
+static void pack_content(u8 *p, const tmd_content *c) {
+  put_be32(p, c->cid);
+  put_be16(p + 4, c->index);
+  put_be16(p + 6, c->type);
+  put_be64(p + 8, c->size);
+  memcpy(p + 16, c->hash, 20);
+}
+
+/* One title: header, then its content records. The digest goes in the
+   header, so the contents are packed twice rather than buffered. */
+static bool write_title(FILE *fp, u64 tid, snapshot_summary *sum) {
+  u8 head[SNAPSHOT_TITLE], rec[SNAPSHOT_CONTENT];
+  signed_blob *buf = NULL;
+  tmd *t = NULL;
+  u32 size = 0, views = 0, digest = 2166136261u, i;
+  u64 bytes = 0;
+  u16 n = 0;
+  u8 flags = 0;
+  bool ok = true;
+
+  if (TRACE_CALL("ES_GetStoredTMDSize", ES_GetStoredTMDSize(tid, &size)) >=
+          0 &&
+      size > sizeof(tmd) && size <= IO_POOL_MAX)
+    buf = (signed_blob *)io_pool_alloc(size);
+  if (buf && TRACE_CALL("ES_GetStoredTMD",
+                        ES_GetStoredTMD(tid, buf, size)) >= 0) {
+    u32 offset = (u32)((u8 *)SIGNATURE_PAYLOAD(buf) - (u8 *)buf);
+
+    if (offset + sizeof(tmd) <= size) {
+      u32 room = (size - offset - (u32)sizeof(tmd)) / sizeof(tmd_content);
+
+      t = SIGNATURE_PAYLOAD(buf);
+      n = t->num_contents < room ? t->num_contents : (u16)room;
+      flags |= SNAP_F_TMD;
+      for (i = 0; i < n; i++) {
+        pack_content(rec, &t->contents[i]);
+        digest = fnv1a(digest, rec, sizeof(rec));
+        bytes += t->contents[i].size;
+      }
+    }
+  }
+  if (TRACE_CALL("ES_GetNumTicketViews", ES_GetNumTicketViews(tid, &views)) >=
+          0 &&
+      views > 0)
+    flags |= SNAP_F_TICKET;
+
+  memset(head, 0, sizeof(head));
+  put_be64(head, tid);
+  put_be64(head + 8, t ? t->sys_version : 0);
+  put_be16(head + 16, t ? t->title_version : 0);
+  put_be16(head + 18, n);
+  head[20] = flags;
+  put_be32(head + 24, digest);
+  put_be32(head + 28, (u32)((bytes + 1023) / 1024));
+  ok = fwrite(head, 1, sizeof(head), fp) == sizeof(head);
+  for (i = 0; ok && i < n; i++) {
+    pack_content(rec, &t->contents[i]);
+    ok = fwrite(rec, 1, sizeof(rec), fp) == sizeof(rec);
+  }
+  if (buf)
+    io_pool_free(buf);
+
+  sum->titles++;
+  sum->contents += n;
+  if (flags & SNAP_F_TMD)
+    sum->tmds++;
+  if (flags & SNAP_F_TICKET)
+    sum->tickets++;
+  return ok;
+}
+
+bool snapshot_take(const char *path, snapshot_summary *out) {
+  const sysinfo_result *si = get_system_info_result();
+  static snap_dir dirs[SNAP_MAX_DIRS];
+  u8 head[SNAPSHOT_HEADER], rec[SNAPSHOT_DIR];
+  u32 scratch = io_scratch_mark();
+  u64 start = gettime();
+  u32 count = 0, clusters, inodes, i;
+  u64 *titles;
+  FILE *fp;
+  bool ok;
+  int n;
+
+  memset(out, 0, sizeof(*out));
+  if (!si->valid)
+    collect_system_info();
+  if (TRACE_CALL("ES_GetNumTitles", ES_GetNumTitles(&count)) < 0 ||
+      count == 0)
+    return false;
+  titles = (u64 *)io_scratch_alloc(count * sizeof(u64));
+  if (!titles ||
+      TRACE_CALL("ES_GetTitles", ES_GetTitles(titles, count)) < 0) {
+    io_scratch_release(scratch);
+    return false;
+  }
+  qsort(titles, count, sizeof(u64), compare_tid);
+  n = collect_dirs(dirs, &clusters, &inodes);
+
+  fp = TRACE_CALL("fopen", fopen(path, "wb"));
+  if (!fp) {
+    io_scratch_release(scratch);
+    return false;
+  }
+  setvbuf(fp, (char *)s_file_buf[0], _IOFBF, SNAP_FILE_BUF);
+
+  memset(head, 0, sizeof(head));
+  memcpy(head, s_magic, sizeof(s_magic));
+  put_be16(head + 4, SNAPSHOT_VERSION);
+  put_be16(head + 6, SYSCONF_COUNT);
+  put_be32(head + 8, (u32)time(NULL));
+  put_be32(head + 12, si->device_id);
+  put_be32(head + 16, count);
+  put_be16(head + 20, (u16)n);
+  put_be32(head + 24, clusters);
+  put_be32(head + 28, inodes);
+  ok = fwrite(head, 1, sizeof(head), fp) == sizeof(head);
+
+  for (i = 0; ok && i < SYSCONF_COUNT; i++) {
+    put_be32(rec, (u32)sysconf_read((sysconf_setting)i));
+    ok = fwrite(rec, 1, 4, fp) == 4;
+  }
+  for (i = 0; ok && i < (u32)n; i++) {
+    memset(rec, 0, sizeof(rec));
+    memcpy(rec, dirs[i].name, strlen(dirs[i].name));
+    put_be32(rec + 12, dirs[i].clusters);
+    put_be32(rec + 16, dirs[i].inodes);
+    ok = fwrite(rec, 1, sizeof(rec), fp) == sizeof(rec);
+  }
+  for (i = 0; ok && i < count; i++)
+    ok = write_title(fp, titles[i], out);
+  io_scratch_release(scratch);
+
+  out->dirs = (u32)n;
+  if (ok)
+    out->bytes = (u32)ftell(fp);
+  if (TRACE_CALL("fclose", fclose(fp)) != 0)
+    ok = false;
+  if (!ok)
+    remove(path);
+  out->ms = (u32)ticks_to_millisecs(gettime() - start);
+  return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+static bool reader_open(snap_reader *r, const char *path, u8 *vbuf) {
+  u8 head[SNAPSHOT_HEADER], rec[SNAPSHOT_DIR];
+  int settings, dirs, i;
+
+  memset(r, 0, sizeof(*r));
+  r->fp = TRACE_CALL("fopen", fopen(path, "rb"));
+  if (!r->fp)
+    return false;
+  setvbuf(r->fp, (char *)vbuf, _IOFBF, SNAP_FILE_BUF);
+  if (fread(head, 1, sizeof(head), r->fp) != sizeof(head) ||
+      memcmp(head, s_magic, sizeof(s_magic)) != 0 ||
+      get_be16(head + 4) != SNAPSHOT_VERSION)
+    return false;
+  settings = get_be16(head + 6);
+  r->time = get_be32(head + 8);
+  r->device_id = get_be32(head + 12);
+  r->titles = r->left = get_be32(head + 16);
+  dirs = get_be16(head + 20);
+  r->clusters = get_be32(head + 24);
+  r->inodes = get_be32(head + 28);
+
+  /* Settings and directories beyond what this build knows are skipped */
+  for (i = 0; i < settings; i++) {
+    if (fread(rec, 1, 4, r->fp) != 4)
+      return false;
+    if (i < SYSCONF_COUNT)
+      r->settings[r->setting_count++] = (s32)get_be32(rec);
+  }
+  for (i = 0; i < dirs; i++) {
+    snap_dir *d = &r->dirs[r->dir_count];
+
+    if (fread(rec, 1, sizeof(rec), r->fp) != sizeof(rec))
+      return false;
+    if (r->dir_count == SNAP_MAX_DIRS)
+      continue;
+    memcpy(d->name, rec, SNAP_NAME_LEN);
+    d->name[SNAP_NAME_LEN] = '\0';
+    d->clusters = get_be32(rec + 12);
+    d->inodes = get_be32(rec + 16);
+    r->dir_count++;
+  }
+  return true;
+}
+
+/* Next title header; its content records are skipped */
+static bool reader_next(snap_reader *r, snap_title *t) {
+  u8 head[SNAPSHOT_TITLE];
+
+  if (r->left == 0 || fread(head, 1, sizeof(head), r->fp) != sizeof(head)) {
+    r->left = 0;
+    return false;
+  }
+  r->left--;
+  t->tid = get_be64(head);
+  t->ios = get_be64(head + 8);
+  t->revision = get_be16(head + 16);
+  t->contents = get_be16(head + 18);
+  t->flags = head[20];
+  t->digest = get_be32(head + 24);
+  t->kb = get_be32(head + 28);
+  if (t->contents &&
+      fseek(r->fp, (long)t->contents * SNAPSHOT_CONTENT, SEEK_CUR) != 0)
+    r->left = 0;
+  return true;
+}
+
+static void reader_close(snap_reader *r) {
+  if (r->fp)
+    TRACE_CALL("fclose", fclose(r->fp));
+  r->fp = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static void format_time(u32 t, char *buf, int size) {
+  time_t tt = (time_t)t;
+  struct tm *tm = gmtime(&tt);
+
+  if (!tm || !strftime(buf, size, "%Y-%m-%d %H:%M", tm))
+    snprintf(buf, size, "%u", t);
+}
+
+static void format_delta(u32 before, u32 after, const char *unit, char *buf,
+                         int size) {
+  if (before == after)
+    snprintf(buf, size, "%u %s, unchanged", after, unit);
+  else
+    snprintf(buf, size, "%u -> %u %s (%+d)", before, after, unit,
+             (int)(after - before));
+}
+
+/* One title line: a change mark, the name and what changed */
+static void draw_title(const char *color, char mark, u64 tid,
+                       const char *detail) {
+  char name[24];
+
+  title_name(tid, name, sizeof(name));
+  ui_printf("   %s%c %-15s" UI_WHITE " %s\n" UI_RESET, color, mark, name,
+            detail);
+}
+
+static void diff_settings(const snap_reader *a, const snap_reader *b) {
+  int n = a->setting_count < b->setting_count ? a->setting_count
+                                              : b->setting_count;
+  int changed = 0, i;
+  char buf[96];
+
+  ui_draw_section("Settings");
+  for (i = 0; i < n; i++) {
+    if (a->settings[i] == b->settings[i])
+      continue;
+    snprintf(buf, sizeof(buf), "%s -> %s",
+             sysconf_value_name((sysconf_setting)i, a->settings[i]),
+             sysconf_value_name((sysconf_setting)i, b->settings[i]));
+    ui_draw_kv_color(sysconf_label((sysconf_setting)i), UI_BYELLOW, buf);
+    changed++;
+  }
+  if (!changed)
+    ui_draw_ok("SYSCONF settings unchanged");
+}
+
+static void diff_nand(const snap_reader *a, const snap_reader *b) {
+  int i = 0, j = 0;
+  char label[24], buf[96];
+
+  ui_draw_section("NAND Usage");
+  format_delta(a->clusters, b->clusters, "clusters", buf, sizeof(buf));
+  ui_draw_kv("Clusters used", buf);
+  format_delta(a->inodes, b->inodes, "inodes", buf, sizeof(buf));
+  ui_draw_kv("Inodes used", buf);
+
+  /* Both lists are sorted by name: merge them */
+  while (i < a->dir_count || j < b->dir_count) {
+    int cmp = i == a->dir_count   ? 1
+              : j == b->dir_count ? -1
+                                  : strcmp(a->dirs[i].name, b->dirs[j].name);
+    const snap_dir *d = cmp <= 0 ? &a->dirs[i] : &b->dirs[j];
+
+    snprintf(label, sizeof(label), "/%s", d->name);
+    if (cmp < 0) {
+      ui_draw_kv_color(label, UI_BRED, "removed");
+      i++;
+    } else if (cmp > 0) {
+      ui_draw_kv_color(label, UI_BGREEN, "added");
+      j++;
+    } else {
+      if (a->dirs[i].clusters != b->dirs[j].clusters ||
+          a->dirs[i].inodes != b->dirs[j].inodes) {
+        snprintf(buf, sizeof(buf), "%+d clusters, %+d inodes",
+                 (int)(b->dirs[j].clusters - a->dirs[i].clusters),
+                 (int)(b->dirs[j].inodes - a->dirs[i].inodes));
+        ui_draw_kv(label, buf);
+      }
+      i++;
+      j++;
+    }
+  }
+}
+
+/* What changed in a title present in both; false if nothing did */
+static bool title_changes(const snap_title *x, const snap_title *y,
+                          char *buf, int size, bool *reversioned) {
+  int len = 0;
+
+  *reversioned = x->revision != y->revision;
+  if (*reversioned)
+    len = snprintf(buf, size, "rev %u -> %u", x->revision, y->revision);
+  else if (x->digest != y->digest || x->contents != y->contents ||
+           ((x->flags ^ y->flags) & SNAP_F_TMD))
+    len = snprintf(buf, size, "rev %u, contents changed", y->revision);
+  if (len && x->kb != y->kb && len < size)
+    len += snprintf(buf + len, size - len, " (%+d KB)", (int)(y->kb - x->kb));
+  if (x->ios != y->ios && len < size)
+    len += snprintf(buf + len, size - len, "%sIOS%u -> IOS%u",
+                    len ? ", " : "", (u32)x->ios, (u32)y->ios);
+  if (((x->flags ^ y->flags) & SNAP_F_TICKET) && len < size)
+    len += snprintf(buf + len, size - len, "%sticket %s", len ? ", " : "",
+                    (y->flags & SNAP_F_TICKET) ? "added" : "removed");
+  return len > 0;
+}
+
+bool snapshot_diff(const char *before, const char *after) {
+  static snap_reader a, b;
+  snap_title x, y;
+  u64 start = gettime();
+  u32 added = 0, removed = 0, reversioned = 0, modified = 0, same = 0;
+  u32 us;
+  bool have_x, have_y;
+  char buf[96], from[24], to[24];
+
+  if (!reader_open(&a, before, s_file_buf[0]) ||
+      !reader_open(&b, after, s_file_buf[1])) {
+    reader_close(&a);
+    reader_close(&b);
+    return false;
+  }
+
+  format_time(a.time, from, sizeof(from));
+  format_time(b.time, to, sizeof(to));
+  snprintf(buf, sizeof(buf), "%s (%u titles)", from, a.titles);
+  ui_draw_kv("Before", buf);
+  snprintf(buf, sizeof(buf), "%s (%u titles)", to, b.titles);
+  ui_draw_kv("After", buf);
+  if (a.device_id != b.device_id)
+    ui_draw_warn("The snapshots are from different consoles");
+
+  diff_settings(&a, &b);
+  diff_nand(&a, &b);
+
+  /* Titles: one pass over both, in title id order */
+  ui_draw_section("Titles");
+  have_x = reader_next(&a, &x);
+  have_y = reader_next(&b, &y);
+  while (have_x || have_y) {
+    if (have_x && (!have_y || x.tid < y.tid)) {
+      snprintf(buf, sizeof(buf), "removed (was rev %u)", x.revision);
+      draw_title(UI_BRED, '-', x.tid, buf);
+      removed++;
+      have_x = reader_next(&a, &x);
+    } else if (have_y && (!have_x || y.tid < x.tid)) {
+      snprintf(buf, sizeof(buf), "added, rev %u, %u KB%s", y.revision, y.kb,
+               (y.flags & SNAP_F_TICKET) ? "" : ", no ticket");
+      draw_title(UI_BGREEN, '+', y.tid, buf);
+      added++;
+      have_y = reader_next(&b, &y);
+    } else {
+      bool rev;
+
+      if (title_changes(&x, &y, buf, sizeof(buf), &rev)) {
+        draw_title(UI_BYELLOW, rev ? '~' : '*', y.tid, buf);
+        if (rev)
+          reversioned++;
+        else
+          modified++;
+      } else {
+        same++;
+      }
+      have_x = reader_next(&a, &x);
+      have_y = reader_next(&b, &y);
+    }
+  }
+  us = (u32)ticks_to_microsecs(gettime() - start);
+  reader_close(&a);
+  reader_close(&b);
+
+  if (added + removed + reversioned + modified == 0)
+    ui_draw_ok("No titles added, removed or changed");
+  ui_printf("\n");
+  snprintf(buf, sizeof(buf), "%u", added);
+  ui_draw_kv_color("Added", added ? UI_BGREEN : UI_WHITE, buf);
+  snprintf(buf, sizeof(buf), "%u", removed);
+  ui_draw_kv_color("Removed", removed ? UI_BRED : UI_WHITE, buf);
+  snprintf(buf, sizeof(buf), "%u", reversioned);
+  ui_draw_kv_color("Re-versioned", reversioned ? UI_BYELLOW : UI_WHITE, buf);
+  snprintf(buf, sizeof(buf), "%u", modified);
+  ui_draw_kv_color("Other changes", modified ? UI_BYELLOW : UI_WHITE, buf);
+  snprintf(buf, sizeof(buf), "%u", same);
+  ui_draw_kv("Unchanged", buf);
+  snprintf(buf, sizeof(buf), "Compared in %u.%03u ms", us / 1000, us % 1000);
+  ui_draw_info(buf);
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The snapshot numbers in dir, ascending, into s_nums from one listing.
+   Returns how many, or -1 if the directory cannot be read. */
+static int list_snapshots(const char *dir) {
+  size_t prefix = strlen(SNAP_PREFIX);
+  DIR *d = TRACE_CALL("opendir", opendir(dir));
+  struct dirent *e;
+  int count = 0;
+
+  if (!d)
+    return -1;
+  while ((e = readdir(d)) != NULL && count < SNAPSHOT_MAX) {
+    char *end;
+    long n;
+
+    if (strncasecmp(e->d_name, SNAP_PREFIX, prefix) != 0)
+      continue;
+    n = strtol(e->d_name + prefix, &end, 10);
+    if (end != e->d_name + prefix && strcasecmp(end, ".bin") == 0 &&
+        n >= 0 && n < SNAPSHOT_MAX)
+      s_nums[count++] = (int)n;
+  }
+  TRACE_CALL("closedir", closedir(d));
+  qsort(s_nums, count, sizeof(s_nums[0]), compare_int);
+  return count;
+}
+
+/* "012  2026-10-16 19:55  312 titles" from the header alone */
+static void snapshot_label(int i, char *buf, int size) {
+  char path[48], when[24];
+  u8 head[SNAPSHOT_HEADER];
+  FILE *fp;
+  bool ok = false;
+
+  snprintf(path, sizeof(path), s_pattern, s_nums[i]);
+  fp = TRACE_CALL("fopen", fopen(path, "rb"));
+  if (fp) {
+    ok = fread(head, 1, sizeof(head), fp) == sizeof(head) &&
+         memcmp(head, s_magic, sizeof(s_magic)) == 0;
+    TRACE_CALL("fclose", fclose(fp));
+  }
+  if (!ok) {
+    snprintf(buf, size, "%03d  (not a snapshot)", s_nums[i]);
+    return;
+  }
+  format_time(get_be32(head + 8), when, sizeof(when));
+  snprintf(buf, size, "%03d  %s  %u titles", s_nums[i], when,
+           get_be32(head + 16));
+}
+
+static void action_label(int i, char *buf, int size) {
+  static const char *const actions[3] = {
+      "Take a new snapshot and compare it with the last",
+      "Compare two saved snapshots", "Cancel - go back to menu"};
+
+  snprintf(buf, size, "[%d] %s", i + 1, actions[i]);
+}
+
+/* Full-screen list drawn like the report prompt: UP/DOWN choose, A picks,
+   B cancels. Returns the index picked or -1. */
+static int pick(const char *heading, int count, int selected,
+                void (*label)(int i, char *buf, int size)) {
+  char buf[80];
+
+  while (1) {
+    int first = selected - SNAP_PICK_ROWS / 2;
+    int i;
+
+    if (first > count - SNAP_PICK_ROWS)
+      first = count - SNAP_PICK_ROWS;
+    if (first < 0)
+      first = 0;
+
+    printf("\x1b[2J\x1b[0;0H");
+    printf(UI_BGREEN " [+] WiiMedic" UI_RESET " " UI_CYAN
+                     "v" WIIMEDIC_VERSION UI_RESET "\n");
+    printf(UI_WHITE " ---------------------------------------------------------"
+                    "-\n" UI_RESET);
+    printf("\n" UI_BYELLOW "   %s\n\n" UI_RESET, heading);
+    for (i = first; i < count && i < first + SNAP_PICK_ROWS; i++) {
+      label(i, buf, sizeof(buf));
+      if (i == selected)
+        printf(UI_BGREEN "   >> %s\n" UI_RESET, buf);
+      else
+        printf(UI_WHITE "      %s\n" UI_RESET, buf);
+    }
+    printf("\n" UI_WHITE " ----------------------------------------------------"
+           "------\n" UI_RESET);
+    printf(UI_WHITE " [UP/DOWN] Choose   [A] Confirm   [B] Cancel\n" UI_RESET);
+
+    while (1) {
+      u32 wpad, gpad;
+
+      WPAD_ScanPads();
+      PAD_ScanPads();
+      wpad = WPAD_ButtonsDown(0);
+      gpad = PAD_ButtonsDown(0);
+      if ((wpad & WPAD_BUTTON_A) || (gpad & PAD_BUTTON_A))
+        return selected;
+      if ((wpad & WPAD_BUTTON_B) || (gpad & PAD_BUTTON_B))
+        return -1;
+      if ((wpad & WPAD_BUTTON_UP) || (gpad & PAD_BUTTON_UP)) {
+        selected = selected > 0 ? selected - 1 : count - 1;
+        break;
+      }
+      if ((wpad & WPAD_BUTTON_DOWN) || (gpad & PAD_BUTTON_DOWN)) {
+        selected = selected < count - 1 ? selected + 1 : 0;
+        break;
+      }
+      VIDEO_WaitVSync();
+    }
+  }
+}
+
+/* Diff two snapshots already on the card, picked from a list */
+static void compare_saved(int count) {
+  char before[48], after[48], buf[64];
+  int a, b;
+
+  a = pick("Compare from (usually the older one):", count, count - 2,
+           snapshot_label);
+  if (a < 0) {
+    ui_draw_info("Comparison cancelled.");
+    return;
+  }
+  b = pick("Compare to:", count, a < count - 1 ? count - 1 : 0,
+           snapshot_label);
+  if (b < 0) {
+    ui_draw_info("Comparison cancelled.");
+    return;
+  }
+  if (a == b) {
+    ui_draw_warn("Pick two different snapshots to compare.");
+    return;
+  }
+  printf("\x1b[2J\x1b[0;0H");
+  printf(UI_WHITE "   Comparing snapshots, please wait...\n" UI_RESET);
+
+  snprintf(before, sizeof(before), s_pattern, s_nums[a]);
+  snprintf(after, sizeof(after), s_pattern, s_nums[b]);
+  snprintf(buf, sizeof(buf), "Changes from snapshot %03d to %03d", s_nums[a],
+           s_nums[b]);
+  ui_draw_section(buf);
+  if (!snapshot_diff(before, after))
+    ui_draw_err("One of the snapshots could not be read");
+}
+
+void run_snapshot_view(void) {
+  char path[48], prev[48], buf[96];
+  snapshot_summary sum;
+  int count, last;
+
+  devices_wait(DEV_FAT);
+  s_pattern = SNAPSHOT_PATH_SD;
+  count = list_snapshots("sd:/");
+  if (count < 0) {
+    s_pattern = SNAPSHOT_PATH_USB;
+    count = list_snapshots("usb:/");
+  }
+  if (count < 0) {
+    ui_draw_err("No SD card or USB drive to save the snapshot to");
+    return;
+  }
+  last = count ? s_nums[count - 1] : -1;
+
+  /* Two saved snapshots can be compared without taking a third */
+  if (count >= 2) {
+    switch (pick("What would you like to do?", 3, 0, action_label)) {
+    case 0:
+      break;
+    case 1:
+      compare_saved(count);
+      return;
+    default:
+      ui_draw_info("Snapshot cancelled.");
+      return;
+    }
+    printf("\x1b[2J\x1b[0;0H");
+    printf(UI_WHITE "   Taking a snapshot, please wait...\n" UI_RESET);
+  }
+  if (last + 1 >= SNAPSHOT_MAX) {
+    ui_draw_err("Too many snapshots: delete some old ones first");
+    return;
+  }
+
+  snprintf(path, sizeof(path), s_pattern, last + 1);
+  ui_draw_info("Reading titles, TMDs, tickets, NAND usage and settings...");
+  if (!snapshot_take(path, &sum)) {
+    ui_draw_err("Could not take the snapshot");
+    return;
+  }
+
+  ui_draw_section("New Snapshot");
+  ui_draw_kv("Saved to", path);
+  snprintf(buf, sizeof(buf), "%u (%u with TMD, %u with ticket)", sum.titles,
+           sum.tmds, sum.tickets);
+  ui_draw_kv("Titles", buf);
+  snprintf(buf, sizeof(buf), "%u", sum.contents);
+  ui_draw_kv("Contents", buf);
+  snprintf(buf, sizeof(buf), "%u", sum.dirs);
+  ui_draw_kv("NAND directories", buf);
+  snprintf(buf, sizeof(buf), "%u bytes in %u ms", sum.bytes, sum.ms);
+  ui_draw_kv("Written", buf);
+
+  if (last < 0) {
+    ui_printf("\n");
+    ui_draw_info("First snapshot: take another after installing something");
+    ui_draw_info("to see exactly what changed on the console.");
+    return;
+  }
+
+  snprintf(prev, sizeof(prev), s_pattern, last);
+  snprintf(buf, sizeof(buf), "Changes since %s", strchr(prev, '/') + 1);
+  ui_draw_section(buf);
+  if (!snapshot_diff(prev, path))
+    ui_draw_err("The previous snapshot could not be read");
+}
@@ -0,0 +1,65 @@
+/*
+ * WiiMedic - snapshot.h
+ * System snapshots: every installed title with its TMD contents and
+ * ticket, NAND usage per top-level directory and the SYSCONF display
+ * settings, in one binary file on SD, and a diff of two of them. Of
+ * SYSCONF only the sysconf_setting values (system_info.h) are kept, not
+ * the whole file: other SYSCONF changes do not show in a diff.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <gccore.h>
+
+// Snapshots are numbered; the newest is the highest number
+#define SNAPSHOT_PATH_SD "sd:/WiiMedic_Snap_%03d.bin"
+#define SNAPSHOT_PATH_USB "usb:/WiiMedic_Snap_%03d.bin"
+#define SNAPSHOT_MAX 1000
+
+// File layout, big-endian:
+//   header (SNAPSHOT_HEADER bytes): "WMSN", u16 version, u16 setting
+//     count, u32 time, u32 device id, u32 title count, u16 directory
+//     count, u16 0, u32 NAND clusters used, u32 NAND inodes used
+//   settings: one s32 per sysconf_setting
+//   directories (SNAPSHOT_DIR bytes each, sorted by name): char name[12]
+//     NUL-padded, u32 clusters, u32 inodes
+//   titles (sorted by title id), each a SNAPSHOT_TITLE byte header then
+//     its contents: u64 title id, u64 IOS it runs on, u16 revision, u16
+//     content count, u8 flags (SNAP_F_*), u8 0, u16 0, u32 FNV-1a of the
+//     content records, u32 content size in KB
+//   content (SNAPSHOT_CONTENT bytes): u32 content id, u16 index, u16 type,
+//     u64 size, u8 sha1[20]
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER 32
+#define SNAPSHOT_DIR 20
+#define SNAPSHOT_TITLE 32
+#define SNAPSHOT_CONTENT 36
+
+#define SNAP_F_TMD (1u << 0)    // the TMD was read; contents are listed
+#define SNAP_F_TICKET (1u << 1) // ES has at least one ticket view
+
+typedef struct {
+  u32 titles;
+  u32 tmds;    // titles whose TMD was read
+  u32 tickets; // titles with a ticket
+  u32 contents;
+  u32 dirs;
+  u32 bytes; // file size
+  u32 ms;    // time to take it
+} snapshot_summary;
+
+// Take a snapshot into path. Returns false (and removes the file) if the
+// title list could not be read or the file could not be written.
+bool snapshot_take(const char *path, snapshot_summary *out);
+
+// Show what changed from snapshot before to snapshot after: settings,
+// NAND usage, and added, removed, re-versioned and modified titles.
+// Returns false if either file is not a snapshot.
+bool snapshot_diff(const char *before, const char *after);
+
+// Menu screen: take a new snapshot, then diff it against the previous one.
+// With two or more saved, it first offers to diff two of them instead,
+// picked from a list.
+void run_snapshot_view(void);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,181 @@
+/*
+ * WiiMedic - startup.c
+ * Startup timeline and background device bring-up. fatInitDefault can sit
+ * for seconds on a slow or absent USB drive, so WPAD and FAT come up on
+ * their own thread while the menu is already on screen; whatever needs a
+ * device waits for it only at the point of use.
+ */
+
+#include <fat.h>
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdio.h>
+#include <string.h>
+#include <wiiuse/wpad.h>
+
+#include "mem_budget.h"
+#include "modules.h"
+#include "startup.h"
+#include "trace.h"
+#include "ui_common.h"
+
+#define DEVICE_STACK_SIZE (32 * 1024)
+#define DEVICE_PRIO 48 /* below the UI thread, like module tasks */
+
+typedef struct {
+  startup_step step;
+  volatile bool done; /* step filled in; readers skip it until then */
+} startup_slot;
+
+static u64 s_t0;
+static startup_slot s_steps[STARTUP_MAX_STEPS];
+static u32 s_step_count;
+
+static lwp_t s_dev_thread = LWP_THREAD_NULL;
+static void *s_dev_stack;
+static u32 s_dev_ready; /* DEV_* bits, set by the device thread */
+
+/*---------------------------------------------------------------------------*/
+void startup_begin(void) { s_t0 = gettime(); }
+
+void startup_record(const char *name, u64 start, u64 end) {
+  u32 i = __atomic_fetch_add(&s_step_count, 1, __ATOMIC_RELAXED);
+  startup_slot *s;
+
+  if (i >= STARTUP_MAX_STEPS)
+    return;
+  s = &s_steps[i];
+  s->step.name = name;
+  s->step.start_ms = (u32)ticks_to_millisecs(start - s_t0);
+  s->step.dur_ms = (u32)ticks_to_millisecs(end - start);
+  s->step.background =
+      s_dev_thread != LWP_THREAD_NULL && LWP_GetSelf() == s_dev_thread;
+  __atomic_store_n(&s->done, true, __ATOMIC_RELEASE);
+}
+
+int startup_get_steps(startup_step *out, int max) {
+  u32 count = __atomic_load_n(&s_step_count, __ATOMIC_RELAXED);
+  int i, n = 0;
+
+  if (count > STARTUP_MAX_STEPS)
+    count = STARTUP_MAX_STEPS;
+  for (i = 0; i < (int)count && n < max; i++) {
+    if (__atomic_load_n(&s_steps[i].done, __ATOMIC_ACQUIRE))
+      out[n++] = s_steps[i].step;
+  }
+  return n;
+}
+
+/*---------------------------------------------------------------------------*/
+void startup_draw(void) {
+  startup_step steps[STARTUP_MAX_STEPS];
+  int n = startup_get_steps(steps, STARTUP_MAX_STEPS);
+  char buf[64];
+  int i;
+
+  ui_draw_section("Startup Timeline");
+  for (i = 0; i < n; i++) {
+    snprintf(buf, sizeof(buf), "at %4u ms, took %4u ms%s", steps[i].start_ms,
+             steps[i].dur_ms, steps[i].background ? " (bg)" : "");
+    ui_draw_kv(steps[i].name, buf);
+  }
+  if (!devices_ready(DEV_ALL))
+    ui_draw_info("Device bring-up still in progress");
+}
+
+void startup_report(report_rec *out) {
+  startup_step steps[STARTUP_MAX_STEPS];
+  int n = startup_get_steps(steps, STARTUP_MAX_STEPS);
+  int i;
+
+  rec_text(out, "--- Startup Timeline ---\n");
+  rec_list(out, "startup");
+  for (i = 0; i < n; i++) {
+    rec_item(out);
+    rec_str(out, "step", "%-20s", steps[i].name);
+    rec_uint(out, "start_ms", " +%5u ms", steps[i].start_ms);
+    rec_uint(out, "duration_ms", " %5u ms", steps[i].dur_ms);
+    rec_bool(out, "background", "%s", steps[i].background, "  (background)",
+             "");
+    rec_item_end(out);
+  }
+  rec_list_end(out);
+  rec_text(out, "\n");
+}
+
+/*---------------------------------------------------------------------------*/
+static void init_wpad(void) {
+  WPAD_Init();
+  WPAD_SetDataFormat(WPAD_CHAN_ALL, WPAD_FMT_BTNS_ACC_IR);
+}
+
+static void bring_up_devices(void) {
+  STARTUP_STEP("WPAD_Init", init_wpad());
+  __atomic_or_fetch(&s_dev_ready, DEV_WPAD, __ATOMIC_RELEASE);
+
+  STARTUP_STEP("fatInitDefault",
+               TRACE_CALL("fatInitDefault", fatInitDefault()));
+  __atomic_or_fetch(&s_dev_ready, DEV_FAT, __ATOMIC_RELEASE);
+}
+
+static void *device_entry(void *arg) {
+  (void)arg;
+  /* The creator may not have stored the handle yet */
+  s_dev_thread = LWP_GetSelf();
+  TRACE_SPAN("devices", bring_up_devices());
+  return NULL;
+}
+
+void devices_start(void) {
+  s_dev_stack = mem_memalign(MEM_TAG_MAIN, 32, DEVICE_STACK_SIZE);
+  if (!s_dev_stack ||
+      LWP_CreateThread(&s_dev_thread, device_entry, NULL, s_dev_stack,
+                       DEVICE_STACK_SIZE, DEVICE_PRIO) < 0) {
+    mem_free(s_dev_stack);
+    s_dev_stack = NULL;
+    s_dev_thread = LWP_THREAD_NULL;
+    bring_up_devices();
+  }
+}
+
+bool devices_ready(u32 devs) {
+  return (__atomic_load_n(&s_dev_ready, __ATOMIC_ACQUIRE) & devs) == devs;
+}
+
+/* Join the device thread once everything is up (UI thread) */
+static void devices_reap(void) {
+  if (s_dev_stack && devices_ready(DEV_ALL)) {
+    LWP_JoinThread(s_dev_thread, NULL);
+    mem_free(s_dev_stack);
+    s_dev_stack = NULL;
+  }
+}
+
+void devices_wait(u32 devs) {
+  u64 start;
+
+  if (devices_ready(devs)) {
+    devices_reap();
+    return;
+  }
+  start = gettime();
+  trace_begin("devices_wait");
+  while (!devices_ready(devs)) {
+    LWP_YieldThread();
+    VIDEO_WaitVSync();
+  }
+  trace_end("devices_wait");
+  startup_record(devs & DEV_FAT ? "Waited for FAT" : "Waited for WPAD", start,
+                 gettime());
+  devices_reap();
+}
+
+u32 devices_for_resources(u32 resources) {
+  u32 devs = 0;
+
+  if (resources & MOD_RES_FAT)
+    devs |= DEV_FAT;
+  if (resources & MOD_RES_WPAD)
+    devs |= DEV_WPAD;
+  return devs;
+}
@@ -0,0 +1,64 @@
+/*
+ * WiiMedic - startup.h
+ * Startup timeline, and WPAD / FAT bring-up on a background thread so the
+ * menu appears as soon as video is up
+ */
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+
+#include "report_rec.h"
+
+// Devices brought up in the background
+#define DEV_WPAD (1u << 0) // WPAD_Init + data format
+#define DEV_FAT (1u << 1)  // fatInitDefault (sd:/ and usb:/)
+#define DEV_ALL (DEV_WPAD | DEV_FAT)
+
+#define STARTUP_MAX_STEPS 16
+
+typedef struct {
+  const char *name; // string literal
+  u32 start_ms;     // since startup_begin
+  u32 dur_ms;
+  bool background;  // ran on the device thread
+} startup_step;
+
+// Time zero of the timeline; first thing in main
+void startup_begin(void);
+
+// Record a step that ran from start to end (ticks). Any thread.
+void startup_record(const char *name, u64 start, u64 end);
+
+// Run stmt and record it as a step
+#define STARTUP_STEP(name, stmt)                                               \
+  do {                                                                         \
+    u64 _step_start = gettime();                                               \
+    stmt;                                                                      \
+    startup_record(name, _step_start, gettime());                              \
+  } while (0)
+
+// Completed steps in the order they were recorded; returns the count
+int startup_get_steps(startup_step *out, int max);
+
+// Draw the timeline (System Information) / format it for the report
+void startup_draw(void);
+void startup_report(report_rec *out);
+
+// Start WPAD and FAT bring-up on a background thread (inline if no thread
+// can be created)
+void devices_start(void);
+
+// True once every device in devs (DEV_*) has finished bring-up
+bool devices_ready(u32 devs);
+
+// Block the UI thread until devs are ready; returns at once if they already
+// are. The time spent waiting is added to the timeline, and the device
+// thread is joined here once everything is up.
+void devices_wait(u32 devs);
+
+// DEV_* bits a module needs for the MOD_RES_* resources it uses
+u32 devices_for_resources(u32 resources);
+
+#endif // STARTUP_H
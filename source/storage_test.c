@@ -14,17 +14,42 @@
 #include <sys/stat.h>
 #include <ogc/lwp_watchdog.h>
 
+#include "io_arena.h"
 #include "storage_test.h"
+#include "task.h"
 #include "ui_common.h"
 
-/* Test parameters */
+/* Test parameters; batch plans may override them */
 #define TEST_FILE_SIZE    (1024 * 1024)  /* 1 MB */
 #define TEST_BLOCK_SIZE   (32 * 1024)    /* 32 KB */
 #define TEST_ITERATIONS   3
+#define TEST_FILE_MAX     (64 * 1024 * 1024)
+#define TEST_BLOCK_MIN    (4 * 1024)
+#define TEST_BLOCK_MAX    IO_POOL_MAX    /* comfortably fits the scratch stack */
+#define TEST_ITER_MAX     20
 #define SPEED_GOOD_KB     2000
 #define SPEED_OK_KB       1000
 
-static char s_report[4096];
+/* Report state: what happened on each device in the last run */
+typedef enum {
+    BENCH_NOT_RUN,     /* no run yet */
+    BENCH_ABSENT,
+    BENCH_COMPLETED,
+    BENCH_CANCELLED,
+    BENCH_SKIPPED      /* cancelled before this device */
+} bench_outcome;
+
+static bench_outcome s_sd_outcome = BENCH_NOT_RUN;
+static bench_outcome s_usb_outcome = BENCH_NOT_RUN;
+static storage_speeds s_speeds;
+
+static int s_file_size  = TEST_FILE_SIZE;
+static int s_block_size = TEST_BLOCK_SIZE;
+static int s_iterations = TEST_ITERATIONS;
+
+/* Progress across all benchmarked devices, for task_set_progress */
+static int s_bench_index = 0;
+static int s_bench_count = 1;
 
 /*---------------------------------------------------------------------------*/
 static bool check_device_present(const char *path) {
@@ -87,41 +112,68 @@ static void get_device_info(const char *device_name, const char *path) {
 }
 
 /*---------------------------------------------------------------------------*/
-static void run_benchmark(const char *device_name, const char *base_path) {
+/* step counts blocks written + read on the current device */
+static void bench_progress(int step) {
+    const int per_device = 2 * s_iterations * (s_file_size / s_block_size);
+    task_set_progress((u32)(s_bench_index * per_device + step),
+                      (u32)(s_bench_count * per_device));
+}
+
+/* Abandon a benchmark part way: close and delete the test file */
+static void bench_cancel(FILE *fp, const char *testpath, u32 scratch) {
+    if (fp)
+        fclose(fp);
+    remove(testpath);
+    io_scratch_release(scratch);
+    ui_draw_warn("Benchmark cancelled");
+}
+
+/*---------------------------------------------------------------------------*/
+/* Returns false if the benchmark was cancelled before completing. The
+   speeds are only set when both passes complete. */
+static bool run_benchmark(const char *device_name, const char *base_path,
+                          u32 *read_kbs, u32 *write_kbs) {
     char testpath[256];
-    int blocks = TEST_FILE_SIZE / TEST_BLOCK_SIZE;
+    int blocks = s_file_size / s_block_size;
     int i, iter;
     u64 write_total_ticks = 0, read_total_ticks = 0;
     float write_speed_kbs, read_speed_kbs;
     const char *write_color, *read_color, *rating;
     char buf[128];
+    u32 scratch = io_scratch_mark();
 
     snprintf(testpath, sizeof(testpath), "%s/wiimedic_benchmark.tmp", base_path);
 
-    u8 *buffer = (u8*)memalign(32, TEST_BLOCK_SIZE);
+    u8 *buffer = (u8*)io_scratch_alloc(s_block_size);
     if (!buffer) {
         ui_draw_err("Memory allocation failed for benchmark");
-        return;
+        return true;
     }
 
-    for (i = 0; i < TEST_BLOCK_SIZE; i++)
+    for (i = 0; i < s_block_size; i++)
         buffer[i] = (u8)(i & 0xFF);
 
     /* Write speed */
     ui_printf("   " UI_WHITE "Running write speed test...\n" UI_RESET);
 
-    for (iter = 0; iter < TEST_ITERATIONS; iter++) {
+    for (iter = 0; iter < s_iterations; iter++) {
         FILE *fp = fopen(testpath, "wb");
         u64 start, end;
         if (!fp) {
             snprintf(buf, sizeof(buf), "Cannot create test file on %s", device_name);
             ui_draw_err(buf);
-            free(buffer);
-            return;
+            io_scratch_release(scratch);
+            return true;
         }
         start = gettime();
-        for (i = 0; i < blocks; i++)
-            fwrite(buffer, 1, TEST_BLOCK_SIZE, fp);
+        for (i = 0; i < blocks; i++) {
+            if (task_cancelled()) {
+                bench_cancel(fp, testpath, scratch);
+                return false;
+            }
+            fwrite(buffer, 1, s_block_size, fp);
+            bench_progress(iter * blocks + i + 1);
+        }
         fflush(fp);
         fclose(fp);
         end = gettime();
@@ -129,36 +181,44 @@ static void run_benchmark(const char *device_name, const char *base_path) {
     }
 
     {
-        float write_time_ms = (float)ticks_to_millisecs(write_total_ticks / TEST_ITERATIONS);
+        float write_time_ms = (float)ticks_to_millisecs(write_total_ticks / s_iterations);
         write_speed_kbs = (write_time_ms > 0)
-            ? (float)(TEST_FILE_SIZE / 1024) * 1000.0f / write_time_ms
+            ? (float)(s_file_size / 1024) * 1000.0f / write_time_ms
             : 0.0f;
     }
 
     /* Read speed */
     ui_printf("   " UI_WHITE "Running read speed test...\n" UI_RESET);
 
-    for (iter = 0; iter < TEST_ITERATIONS; iter++) {
+    for (iter = 0; iter < s_iterations; iter++) {
         FILE *fp = fopen(testpath, "rb");
         u64 start, end;
         if (!fp) { ui_draw_err("Cannot open test file for reading"); break; }
         start = gettime();
-        for (i = 0; i < blocks; i++)
-            fread(buffer, 1, TEST_BLOCK_SIZE, fp);
+        for (i = 0; i < blocks; i++) {
+            if (task_cancelled()) {
+                bench_cancel(fp, testpath, scratch);
+                return false;
+            }
+            fread(buffer, 1, s_block_size, fp);
+            bench_progress((s_iterations + iter) * blocks + i + 1);
+        }
         fclose(fp);
         end = gettime();
         read_total_ticks += (end - start);
     }
 
     {
-        float read_time_ms = (float)ticks_to_millisecs(read_total_ticks / TEST_ITERATIONS);
+        float read_time_ms = (float)ticks_to_millisecs(read_total_ticks / s_iterations);
         read_speed_kbs = (read_time_ms > 0)
-            ? (float)(TEST_FILE_SIZE / 1024) * 1000.0f / read_time_ms
+            ? (float)(s_file_size / 1024) * 1000.0f / read_time_ms
             : 0.0f;
     }
 
     remove(testpath);
-    free(buffer);
+    io_scratch_release(scratch);
+    *read_kbs = (u32)read_speed_kbs;
+    *write_kbs = (u32)write_speed_kbs;
 
     /* Results */
     write_color = (write_speed_kbs > SPEED_GOOD_KB) ? UI_BGREEN :
@@ -189,47 +249,50 @@ static void run_benchmark(const char *device_name, const char *base_path) {
         snprintf(buf, sizeof(buf), "Speed Rating: %s", rating);
         ui_draw_err(buf);
     }
+    return true;
 }
 
 /*---------------------------------------------------------------------------*/
 void run_storage_test(void) {
-    int rpos = 0;
     bool sd_present, usb_present;
 
-    memset(s_report, 0, sizeof(s_report));
-    rpos = snprintf(s_report, sizeof(s_report), "=== STORAGE SPEED TEST ===\n");
-
     sd_present  = check_device_present("sd:/");
     usb_present = check_device_present("usb:/");
+    s_bench_index = 0;
+    s_bench_count = (sd_present && usb_present) ? 2 : 1;
+    memset(&s_speeds, 0, sizeof(s_speeds));
 
     /* SD Card */
     ui_draw_section("SD Card");
 
     if (sd_present) {
         get_device_info("SD Card", "sd:/");
-        run_benchmark("SD Card", "sd:");
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-            "SD Card: Detected, benchmark completed\n");
+        s_sd_outcome = run_benchmark("SD Card", "sd:", &s_speeds.sd_read_kbs,
+                                     &s_speeds.sd_write_kbs)
+                           ? BENCH_COMPLETED : BENCH_CANCELLED;
+        s_bench_index++;
     } else {
         ui_draw_warn("SD Card not detected");
         ui_draw_info("Insert an SD card and restart to test");
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-            "SD Card: Not detected\n");
+        s_sd_outcome = BENCH_ABSENT;
     }
 
     /* USB */
     ui_draw_section("USB Storage");
 
-    if (usb_present) {
+    if (usb_present && task_cancelled()) {
+        ui_draw_warn("USB benchmark skipped (cancelled)");
+        s_usb_outcome = BENCH_SKIPPED;
+    } else if (usb_present) {
         get_device_info("USB Storage", "usb:/");
-        run_benchmark("USB Storage", "usb:");
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-            "USB Storage: Detected, benchmark completed\n");
+        s_usb_outcome = run_benchmark("USB Storage", "usb:",
+                                      &s_speeds.usb_read_kbs,
+                                      &s_speeds.usb_write_kbs)
+                            ? BENCH_COMPLETED : BENCH_CANCELLED;
     } else {
         ui_printf("   " UI_WHITE "USB not detected (normal if none is connected)\n" UI_RESET);
         ui_draw_info("USB must be in the port closest to the edge");
-        rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos,
-            "USB Storage: Not detected\n");
+        s_usb_outcome = BENCH_ABSENT;
     }
 
     /* Tips */
@@ -239,14 +302,80 @@ void run_storage_test(void) {
     ui_draw_info("SDHC cards (Class 10 / UHS-I) give best SD performance");
     ui_draw_info("Format USB as FAT32 (32KB clusters) or WBFS for games");
 
-    rpos += snprintf(s_report + rpos, sizeof(s_report) - rpos, "\n");
-
     ui_printf("\n");
     ui_draw_ok("Storage test complete");
 }
 
 /*---------------------------------------------------------------------------*/
-void get_storage_test_report(char *buf, int bufsize) {
-    strncpy(buf, s_report, bufsize - 1);
-    buf[bufsize - 1] = '\0';
+void storage_test_set_params(u32 file_kb, u32 block_kb, u32 iterations) {
+    if (block_kb) {
+        if (block_kb < TEST_BLOCK_MIN / 1024) block_kb = TEST_BLOCK_MIN / 1024;
+        if (block_kb > TEST_BLOCK_MAX / 1024) block_kb = TEST_BLOCK_MAX / 1024;
+        s_block_size = (int)block_kb * 1024;
+    }
+    if (file_kb) {
+        if (file_kb > TEST_FILE_MAX / 1024) file_kb = TEST_FILE_MAX / 1024;
+        s_file_size = (int)file_kb * 1024;
+    }
+    if (iterations)
+        s_iterations = iterations > TEST_ITER_MAX ? TEST_ITER_MAX : (int)iterations;
+
+    /* Whole blocks only, at least one */
+    if (s_file_size < s_block_size)
+        s_file_size = s_block_size;
+    s_file_size -= s_file_size % s_block_size;
+}
+
+/*---------------------------------------------------------------------------*/
+void quick_storage_test(quick_result *q) {
+    bool sd  = check_device_present("sd:/");
+    bool usb = check_device_present("usb:/");
+
+    if (sd || usb) {
+        q->level = QUICK_GREEN;
+        snprintf(q->summary, sizeof(q->summary), "SD %s, USB %s",
+                 sd ? "mounted" : "absent", usb ? "mounted" : "absent");
+    } else {
+        q->level = QUICK_YELLOW;
+        snprintf(q->summary, sizeof(q->summary), "No SD or USB mounted");
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+void storage_test_get_speeds(storage_speeds *out) {
+    *out = s_speeds;
+}
+
+/*---------------------------------------------------------------------------*/
+static const char *outcome_text(bench_outcome o) {
+    switch (o) {
+        case BENCH_COMPLETED: return "Detected, benchmark completed";
+        case BENCH_CANCELLED: return "Detected, benchmark cancelled";
+        case BENCH_SKIPPED:   return "Detected, benchmark skipped";
+        default:              return "Not detected";
+    }
+}
+
+/* Stable names for the JSON and binary report */
+static const char *outcome_token(bench_outcome o) {
+    switch (o) {
+        case BENCH_COMPLETED: return "completed";
+        case BENCH_CANCELLED: return "cancelled";
+        case BENCH_SKIPPED:   return "skipped";
+        default:              return "absent";
+    }
+}
+
+void get_storage_test_report(report_rec *out) {
+    if (s_sd_outcome == BENCH_NOT_RUN) return;
+    rec_text(out, "=== STORAGE SPEED TEST ===\n");
+    rec_enum(out, "sd", "SD Card: %s", outcome_token(s_sd_outcome),
+        outcome_text(s_sd_outcome));
+    rec_enum(out, "usb", "USB Storage: %s", outcome_token(s_usb_outcome),
+        outcome_text(s_usb_outcome));
+    rec_uint(out, "sd_read_kbs", NULL, s_speeds.sd_read_kbs);
+    rec_uint(out, "sd_write_kbs", NULL, s_speeds.sd_write_kbs);
+    rec_uint(out, "usb_read_kbs", NULL, s_speeds.usb_read_kbs);
+    rec_uint(out, "usb_write_kbs", NULL, s_speeds.usb_write_kbs);
+    rec_text(out, "\n");
 }
@@ -5,10 +5,33 @@
 #ifndef STORAGE_TEST_H
 #define STORAGE_TEST_H
 
+#include <gccore.h>
+
+#include "modules.h"
+
+// Speeds of the last run in KB/s; 0 where the device was absent or its
+// benchmark did not complete
+typedef struct {
+  u32 sd_read_kbs;
+  u32 sd_write_kbs;
+  u32 usb_read_kbs;
+  u32 usb_write_kbs;
+} storage_speeds;
+
 // Run the storage speed test
 void run_storage_test(void);
 
-// Get storage test report as string
-void get_storage_test_report(char *buf, int bufsize);
+// Benchmark size: test file (KB), block per fwrite/fread (KB) and passes.
+// 0 keeps the current value; out-of-range values are clamped.
+void storage_test_set_params(u32 file_kb, u32 block_kb, u32 iterations);
+
+// Speeds of the last run
+void storage_test_get_speeds(storage_speeds *out);
+
+// Quick Health Check: which of SD and USB are mounted, no benchmark
+void quick_storage_test(quick_result *q);
+
+// Write the storage test report section
+void get_storage_test_report(report_rec *out);
 
 #endif // STORAGE_TEST_H
@@ -12,7 +12,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "heap_map.h"
+#include "io_arena.h"
+#include "results.h"
+#include "startup.h"
 #include "system_info.h"
+#include "task.h"
+#include "trace.h"
 #include "ui_common.h"
 
 /*---------------------------------------------------------------------------*/
@@ -29,15 +35,18 @@
  */
 static u32 get_SM_boot_content_id(void) {
   u32 tmd_size = 0;
-  if (ES_GetStoredTMDSize(SM_ID, &tmd_size) < 0 || tmd_size == 0)
+  if (TRACE_CALL("ES_GetStoredTMDSize",
+                 ES_GetStoredTMDSize(SM_ID, &tmd_size)) < 0 ||
+      tmd_size == 0)
     return 0;
 
-  signed_blob *stmd = (signed_blob *)memalign(32, (tmd_size + 31) & ~31);
+  signed_blob *stmd = (signed_blob *)io_pool_alloc((tmd_size + 31) & ~31);
   if (!stmd)
     return 0;
 
   u32 content_id = 0;
-  if (ES_GetStoredTMD(SM_ID, stmd, tmd_size) >= 0) {
+  if (TRACE_CALL("ES_GetStoredTMD", ES_GetStoredTMD(SM_ID, stmd, tmd_size)) >=
+      0) {
     tmd *tmd_ptr = (tmd *)SIGNATURE_PAYLOAD(stmd);
     u16 boot_index = tmd_ptr->boot_index;
 
@@ -50,7 +59,7 @@ static u32 get_SM_boot_content_id(void) {
     }
   }
 
-  free(stmd);
+  io_pool_free(stmd);
   return content_id;
 }
 
@@ -65,7 +74,7 @@ static bool detect_priiloader(void) {
     return false;
 
   /* Handle ISFS state. If already initialized, ISFS_Initialize returns < 0. */
-  s32 isfs_res = ISFS_Initialize();
+  s32 isfs_res = TRACE_CALL("ISFS_Initialize", ISFS_Initialize());
   bool we_initialized_isfs = (isfs_res >= 0);
 
   if (isfs_res < 0 && isfs_res != ISFS_EALREADY) {
@@ -80,10 +89,11 @@ static bool detect_priiloader(void) {
   const char *data_files[] = {"/title/00000001/00000002/data/loader.ini",
                               "/title/00000001/00000002/data/setting.ini"};
   for (int j = 0; j < 2; j++) {
-    s32 fd = ISFS_Open(data_files[j], ISFS_OPEN_READ);
+    s32 fd =
+        TRACE_CALL("ISFS_Open", ISFS_Open(data_files[j], ISFS_OPEN_READ));
     if (fd >= 0) {
       detected = true;
-      ISFS_Close(fd);
+      TRACE_CALL("ISFS_Close", ISFS_Close(fd));
       break;
     }
   }
@@ -92,15 +102,15 @@ static bool detect_priiloader(void) {
   if (!detected) {
     snprintf(path, sizeof(path), "/title/00000001/00000002/content/%08x.app",
              (unsigned int)(content_id + 0x10000000));
-    s32 fd_backup = ISFS_Open(path, ISFS_OPEN_READ);
+    s32 fd_backup = TRACE_CALL("ISFS_Open", ISFS_Open(path, ISFS_OPEN_READ));
     if (fd_backup >= 0) {
       detected = true;
-      ISFS_Close(fd_backup);
+      TRACE_CALL("ISFS_Close", ISFS_Close(fd_backup));
     }
   }
 
   if (we_initialized_isfs) {
-    ISFS_Deinitialize();
+    TRACE_CALL("ISFS_Deinitialize", ISFS_Deinitialize());
   }
 
   return detected;
@@ -109,14 +119,18 @@ static bool detect_priiloader(void) {
 static bool detect_bootmii_ios(void) {
   u32 tmd_size = 0;
   u64 tid_254 = 0x00000001000000FEULL; /* IOS254 */
-  if (ES_GetStoredTMDSize(tid_254, &tmd_size) >= 0 && tmd_size > 0)
+  if (TRACE_CALL("ES_GetStoredTMDSize",
+                 ES_GetStoredTMDSize(tid_254, &tmd_size)) >= 0 &&
+      tmd_size > 0)
     return true;
 
   return false;
 }
 
-/* PPC Hollywood regs */
+/* PPC Hollywood regs (the host build supplies its own register window) */
+#ifndef HW_REG_BASE
 #define HW_REG_BASE 0xCD000000
+#endif
 #define HW_AHBPROT_OFF 0x064
 #define HW_OTPCMD_OFF 0x1ec
 #define HW_OTPDATA_OFF 0x1f0
@@ -169,8 +183,8 @@ static int get_boot1_bootmii_compatible(void) {
 }
 
 /*---------------------------------------------------------------------------*/
-static const char *get_region_string(void) {
-  switch (CONF_GetRegion()) {
+static const char *get_region_string(s32 region) {
+  switch (region) {
   case CONF_REGION_JP:
     return "Japan (NTSC-J)";
   case CONF_REGION_US:
@@ -186,8 +200,8 @@ static const char *get_region_string(void) {
   }
 }
 
-static const char *get_video_mode_string(void) {
-  switch (CONF_GetVideo()) {
+static const char *get_video_mode_string(s32 video) {
+  switch (video) {
   case CONF_VIDEO_NTSC:
     return "NTSC (480i/480p)";
   case CONF_VIDEO_PAL:
@@ -199,8 +213,8 @@ static const char *get_video_mode_string(void) {
   }
 }
 
-static const char *get_language_string(void) {
-  switch (CONF_GetLanguage()) {
+static const char *get_language_string(s32 language) {
+  switch (language) {
   case CONF_LANG_JAPANESE:
     return "Japanese";
   case CONF_LANG_ENGLISH:
@@ -226,8 +240,8 @@ static const char *get_language_string(void) {
   }
 }
 
-static const char *get_aspect_string(void) {
-  switch (CONF_GetAspectRatio()) {
+static const char *get_aspect_string(s32 aspect) {
+  switch (aspect) {
   case CONF_ASPECT_4_3:
     return "4:3 (Standard)";
   case CONF_ASPECT_16_9:
@@ -237,8 +251,7 @@ static const char *get_aspect_string(void) {
   }
 }
 
-static const char *get_progressive_string(void) {
-  s32 prog = CONF_GetProgressiveScan();
+static const char *get_progressive_string(s32 prog) {
   if (prog > 0)
     return "Enabled";
   if (prog == 0)
@@ -246,41 +259,132 @@ static const char *get_progressive_string(void) {
   return "Unknown";
 }
 
+/*---------------------------------------------------------------------------*/
+s32 sysconf_read(sysconf_setting s) {
+  switch (s) {
+  case SYSCONF_REGION:
+    return CONF_GetRegion();
+  case SYSCONF_VIDEO:
+    return CONF_GetVideo();
+  case SYSCONF_LANGUAGE:
+    return CONF_GetLanguage();
+  case SYSCONF_ASPECT:
+    return CONF_GetAspectRatio();
+  case SYSCONF_PROGRESSIVE:
+    return CONF_GetProgressiveScan();
+  default:
+    return -1;
+  }
+}
+
+const char *sysconf_label(sysconf_setting s) {
+  static const char *const labels[SYSCONF_COUNT] = {
+      "Console Region", "Video Standard", "Display Language", "Aspect Ratio",
+      "Progressive Scan"};
+
+  return (unsigned)s < SYSCONF_COUNT ? labels[s] : "Unknown";
+}
+
+const char *sysconf_value_name(sysconf_setting s, s32 value) {
+  switch (s) {
+  case SYSCONF_REGION:
+    return get_region_string(value);
+  case SYSCONF_VIDEO:
+    return get_video_mode_string(value);
+  case SYSCONF_LANGUAGE:
+    return get_language_string(value);
+  case SYSCONF_ASPECT:
+    return get_aspect_string(value);
+  case SYSCONF_PROGRESSIVE:
+    return get_progressive_string(value);
+  default:
+    return "Unknown";
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+static sysinfo_result s_info;
+
+/* Each IOS call is a cancellation point; a cancelled collect leaves
+   valid false */
+void collect_system_info(void) {
+  memset(&s_info, 0, sizeof(s_info));
+  s_info.hollywood_ver = SYS_GetHollywoodRevision();
+  s_info.ios_ver = IOS_GetVersion();
+  s_info.ios_rev = IOS_GetRevision();
+  s_info.boot2_ret = TRACE_CALL("ES_GetBoot2Version",
+                                ES_GetBoot2Version(&s_info.boot2_version));
+  if (task_cancelled())
+    return;
+  TRACE_CALL("ES_GetDeviceID", ES_GetDeviceID(&s_info.device_id));
+  if (task_cancelled())
+    return;
+  s_info.has_priiloader = detect_priiloader();
+  if (task_cancelled())
+    return;
+  s_info.boot1_ok = get_boot1_bootmii_compatible();
+  s_info.has_bootmii_ios = detect_bootmii_ios();
+  s_info.valid = !task_cancelled();
+}
+
+const sysinfo_result *get_system_info_result(void) { return &s_info; }
+
+/* Same rating as the report: Priiloader plus one BootMii flavour is GOOD */
+void quick_system_info(quick_result *q) {
+  const sysinfo_result *r = &s_info;
+  bool bootmii;
+
+  collect_system_info();
+  result_stamp(MODULE_SYSTEM_INFO);
+  bootmii = r->boot1_ok == 1 || r->has_bootmii_ios;
+  if (r->has_priiloader && bootmii)
+    q->level = QUICK_GREEN;
+  else if (r->has_priiloader || bootmii)
+    q->level = QUICK_YELLOW;
+  else
+    q->level = QUICK_RED;
+  snprintf(q->summary, sizeof(q->summary), "IOS%d, brick protection %s",
+           r->ios_ver,
+           q->level == QUICK_GREEN    ? "GOOD"
+           : q->level == QUICK_YELLOW ? "PARTIAL"
+                                      : "NONE");
+}
+
 /*---------------------------------------------------------------------------*/
 void run_system_info(void) {
-  u32 hollywood_ver = SYS_GetHollywoodRevision();
+  const sysinfo_result *r = &s_info;
   u32 mem1_size = SYS_GetArena1Size();
   u32 mem2_size = SYS_GetArena2Size();
-  s32 ios_ver = IOS_GetVersion();
-  s32 ios_rev = IOS_GetRevision();
-  u32 boot2_version = 0;
-  s32 ret = ES_GetBoot2Version(&boot2_version);
-  u32 device_id = 0;
   char buf[64];
 
-  ES_GetDeviceID(&device_id);
+  collect_system_info();
+  if (!r->valid) {
+    ui_draw_warn("System information cancelled");
+    return;
+  }
 
   /* Display settings */
-  ui_draw_kv("Console Region", get_region_string());
-  ui_draw_kv("Video Standard", get_video_mode_string());
-  ui_draw_kv("Display Language", get_language_string());
-  ui_draw_kv("Aspect Ratio", get_aspect_string());
-  ui_draw_kv("Progressive Scan", get_progressive_string());
+  ui_draw_kv("Console Region", get_region_string(CONF_GetRegion()));
+  ui_draw_kv("Video Standard", get_video_mode_string(CONF_GetVideo()));
+  ui_draw_kv("Display Language", get_language_string(CONF_GetLanguage()));
+  ui_draw_kv("Aspect Ratio", get_aspect_string(CONF_GetAspectRatio()));
+  ui_draw_kv("Progressive Scan",
+             get_progressive_string(CONF_GetProgressiveScan()));
 
   /* Hardware */
   ui_draw_section("Hardware");
 
-  snprintf(buf, sizeof(buf), "0x%08X", hollywood_ver);
+  snprintf(buf, sizeof(buf), "0x%08X", r->hollywood_ver);
   ui_draw_kv("Hollywood Revision", buf);
 
-  snprintf(buf, sizeof(buf), "%u", device_id);
+  snprintf(buf, sizeof(buf), "%u", r->device_id);
   ui_draw_kv("Device ID", buf);
 
   /* Boot2 version */
-  if (ret >= 0) {
-    snprintf(buf, sizeof(buf), "v%u", boot2_version);
+  if (r->boot2_ret >= 0) {
+    snprintf(buf, sizeof(buf), "v%u", r->boot2_version);
     ui_draw_kv("Boot2 Version", buf);
-    if (boot2_version >= 5)
+    if (r->boot2_version >= 5)
       ui_draw_warn("Boot2v5+ - BootMii can only run as IOS");
   }
 
@@ -298,10 +402,12 @@ void run_system_info(void) {
   ui_draw_kv("MEM1 Total", "24 MB (fixed)");
   ui_draw_kv("MEM2 Total", "64 MB (fixed)");
 
+  heap_map_draw();
+
   /* Firmware */
   ui_draw_section("Firmware");
 
-  snprintf(buf, sizeof(buf), "IOS%d (rev %d)", ios_ver, ios_rev);
+  snprintf(buf, sizeof(buf), "IOS%d (rev %d)", r->ios_ver, r->ios_rev);
   ui_draw_kv("Running IOS", buf);
   ui_draw_kv("CPU", "Broadway (IBM PowerPC 750CL)");
   ui_draw_kv("CPU Clock", "729 MHz (fixed)");
@@ -310,29 +416,27 @@ void run_system_info(void) {
 
   ui_draw_section("Brick Protection");
   {
-    bool has_priiloader = detect_priiloader();
-    int boot1_ok = get_boot1_bootmii_compatible();
-    bool boot2_suggests_bootmii_ok = (ret >= 0 && boot2_version <= 4);
-    bool has_bootmii_ios = detect_bootmii_ios();
+    bool boot2_suggests_bootmii_ok =
+        (r->boot2_ret >= 0 && r->boot2_version <= 4);
     int protection_count = 0;
 
-    if (has_priiloader) {
+    if (r->has_priiloader) {
       ui_draw_kv_color("Priiloader", UI_BGREEN, "Installed");
       protection_count++;
     } else {
       ui_draw_kv_color("Priiloader", UI_BRED, "Not found");
     }
 
-    if (hollywood_ver >= 0x21) {
+    if (r->hollywood_ver >= 0x21) {
       ui_draw_kv_color("BootMii (boot2)", UI_BYELLOW,
                        "Not compatible (Late HW)");
-    } else if (boot1_ok == 1) {
+    } else if (r->boot1_ok == 1) {
       ui_draw_kv_color("BootMii (boot2)", UI_BGREEN, "Compatible (boot1a/b)");
       protection_count++;
-    } else if (boot1_ok == 0) {
+    } else if (r->boot1_ok == 0) {
       ui_draw_kv_color("BootMii (boot2)", UI_BYELLOW,
                        "Not compatible (boot1c/d)");
-    } else if (boot1_ok == 2) {
+    } else if (r->boot1_ok == 2) {
       ui_draw_kv_color("BootMii (boot2)", UI_BYELLOW, "Unknown boot1 revision");
     } else {
       /* Fallback logic if OTP read failed */
@@ -345,7 +449,7 @@ void run_system_info(void) {
       }
     }
 
-    if (has_bootmii_ios) {
+    if (r->has_bootmii_ios) {
       ui_draw_kv_color("BootMii (IOS)", UI_BGREEN, "Installed");
       protection_count++;
     } else {
@@ -362,77 +466,93 @@ void run_system_info(void) {
     }
   }
 
+  startup_draw();
+
   ui_printf("\n");
   ui_draw_ok("System information collected successfully");
 }
 
 /*---------------------------------------------------------------------------*/
-void get_system_info_report(char *buf, int bufsize) {
-  u32 hollywood_ver = SYS_GetHollywoodRevision();
+void get_system_info_report(report_rec *out) {
+  const sysinfo_result *r = &s_info;
   u32 mem1_size = SYS_GetArena1Size();
   u32 mem2_size = SYS_GetArena2Size();
-  s32 ios_ver = IOS_GetVersion();
-  s32 ios_rev = IOS_GetRevision();
-  u32 boot2_version = 0;
-  u32 device_id = 0;
-  s32 boot2_ret;
 
-  boot2_ret = ES_GetBoot2Version(&boot2_version);
-  ES_GetDeviceID(&device_id);
+  /* Standalone callers (benchmarks) may not have collected yet */
+  if (!r->valid)
+    collect_system_info();
 
   {
-    bool has_priiloader = detect_priiloader();
-    int boot1_ok = get_boot1_bootmii_compatible();
-    bool boot2_suggests_ok = (boot2_ret >= 0 && boot2_version <= 4);
-    bool has_bootmii_ios = detect_bootmii_ios();
+    bool has_priiloader = r->has_priiloader;
+    int boot1_ok = r->boot1_ok;
+    bool boot2_suggests_ok = (r->boot2_ret >= 0 && r->boot2_version <= 4);
+    bool has_bootmii_ios = r->has_bootmii_ios;
 
     /* Logic correction: boot1 compatible means boot2 install is possible */
     bool has_bootmii_boot2 = (boot1_ok == 1);
 
-    const char *prii_status = has_priiloader ? "Installed" : "Not found";
-
-    const char *boot2_str;
-    if (hollywood_ver >= 0x21)
+    const char *boot2_token, *boot2_str;
+    if (r->hollywood_ver >= 0x21) {
+      boot2_token = "late_hw";
       boot2_str = "Not compatible (Late HW)";
-    else if (boot1_ok == 1)
+    } else if (boot1_ok == 1) {
+      boot2_token = "compatible";
       boot2_str = "Compatible (boot1a/b)";
-    else if (boot1_ok == 0)
+    } else if (boot1_ok == 0) {
+      boot2_token = "not_compatible";
       boot2_str = "Not compatible (boot1c/d)";
-    else if (boot1_ok == 2)
+    } else if (boot1_ok == 2) {
+      boot2_token = "unknown_boot1";
       boot2_str = "Unknown boot1 revision";
-    else
-      boot2_str = boot2_suggests_ok ? "Likely compatible (boot2 proxy)"
-                                    : "Likely not (boot2 v5+)";
+    } else if (boot2_suggests_ok) {
+      boot2_token = "likely_compatible";
+      boot2_str = "Likely compatible (boot2 proxy)";
+    } else {
+      boot2_token = "likely_not";
+      boot2_str = "Likely not (boot2 v5+)";
+    }
 
     const char *rating =
         (has_priiloader && (has_bootmii_boot2 || has_bootmii_ios)) ? "GOOD"
         : (has_priiloader || has_bootmii_ios || has_bootmii_boot2) ? "PARTIAL"
                                                                    : "NONE";
 
-    snprintf(buf, bufsize,
-             "=== SYSTEM INFORMATION ===\n"
-             "Region:              %s\n"
-             "Video Standard:      %s\n"
-             "Language:            %s\n"
-             "Aspect Ratio:        %s\n"
-             "Progressive Scan:    %s\n"
-             "Hollywood Revision:  0x%08X\n"
-             "Device ID:           %u\n"
-             "Boot2 Version:       v%u\n"
-             "Running IOS:         IOS%d (rev %d)\n"
-             "MEM1 Arena Free:     %u KB\n"
-             "MEM2 Arena Free:     %u KB\n"
-             "\n"
-             "--- Brick Protection ---\n"
-             "Priiloader:          %s\n"
-             "BootMii (boot2):     %s\n"
-             "BootMii (IOS):       %s\n"
-             "Protection Rating:   %s\n"
-             "\n",
-             get_region_string(), get_video_mode_string(),
-             get_language_string(), get_aspect_string(),
-             get_progressive_string(), hollywood_ver, device_id, boot2_version,
-             ios_ver, ios_rev, mem1_size / 1024, mem2_size / 1024, prii_status,
-             boot2_str, has_bootmii_ios ? "Installed" : "Not found", rating);
+    rec_text(out, "=== SYSTEM INFORMATION ===\n");
+    rec_str(out, "region", "Region:              %s",
+            get_region_string(CONF_GetRegion()));
+    rec_str(out, "video", "Video Standard:      %s",
+            get_video_mode_string(CONF_GetVideo()));
+    rec_str(out, "language", "Language:            %s",
+            get_language_string(CONF_GetLanguage()));
+    rec_str(out, "aspect", "Aspect Ratio:        %s",
+            get_aspect_string(CONF_GetAspectRatio()));
+    rec_str(out, "progressive", "Progressive Scan:    %s",
+            get_progressive_string(CONF_GetProgressiveScan()));
+    rec_uint(out, "hollywood", "Hollywood Revision:  0x%08X",
+             r->hollywood_ver);
+    rec_uint(out, "device_id", "Device ID:           %u", r->device_id);
+    rec_uint(out, "boot2", "Boot2 Version:       v%u", r->boot2_version);
+    rec_line(out);
+    rec_int(out, "ios", "Running IOS:         IOS%d", r->ios_ver);
+    rec_int(out, "ios_revision", " (rev %d)", r->ios_rev);
+    rec_line_end(out);
+    rec_uint(out, "mem1_free_kb", "MEM1 Arena Free:     %u KB",
+             mem1_size / 1024);
+    rec_uint(out, "mem2_free_kb", "MEM2 Arena Free:     %u KB",
+             mem2_size / 1024);
+
+    rec_text(out, "\n--- Brick Protection ---\n");
+    rec_group(out, "brick_protection");
+    rec_bool(out, "priiloader", "Priiloader:          %s", has_priiloader,
+             "Installed", "Not found");
+    rec_enum(out, "bootmii_boot2", "BootMii (boot2):     %s", boot2_token,
+             boot2_str);
+    rec_bool(out, "bootmii_ios", "BootMii (IOS):       %s", has_bootmii_ios,
+             "Installed", "Not found");
+    rec_str(out, "rating", "Protection Rating:   %s", rating);
+    rec_group_end(out);
+    rec_text(out, "\n");
   }
+
+  startup_report(out);
 }
\ No newline at end of file
@@ -5,11 +5,56 @@
 #ifndef SYSTEM_INFO_H
 #define SYSTEM_INFO_H
 
-// Run the system information display
+#include <gccore.h>
+
+#include "modules.h"
+
+// Results of the last collect_system_info()
+typedef struct {
+  u32 hollywood_ver;
+  u32 device_id;
+  s32 boot2_ret; // ES_GetBoot2Version result; boot2_version valid if >= 0
+  u32 boot2_version;
+  s32 ios_ver;
+  s32 ios_rev;
+  bool has_priiloader;
+  int boot1_ok; // 1 = BootMii-compatible boot1, 0 = not, 2 = unknown,
+                // -1 = OTP unreadable
+  bool has_bootmii_ios;
+  bool valid; // collected at least once
+} sysinfo_result;
+
+// SYSCONF display settings, for code that stores or compares them
+typedef enum {
+  SYSCONF_REGION,
+  SYSCONF_VIDEO,
+  SYSCONF_LANGUAGE,
+  SYSCONF_ASPECT,
+  SYSCONF_PROGRESSIVE,
+  SYSCONF_COUNT
+} sysconf_setting;
+
+// Current value of a setting (the CONF_Get* result; negative = error)
+s32 sysconf_read(sysconf_setting s);
+
+// Screen label of a setting and the display name of one of its values
+const char *sysconf_label(sysconf_setting s);
+const char *sysconf_value_name(sysconf_setting s, s32 value);
+
+// Run the system information display (collects fresh results first)
 void run_system_info(void);
 
-// Get system info as formatted string for reports
-// buf must be at least 2048 bytes
-void get_system_info_report(char *buf, int bufsize);
+// Query ES, ISFS and OTP and keep the results (no screen output)
+void collect_system_info(void);
+
+// Quick Health Check: collect, then rate brick protection
+void quick_system_info(quick_result *q);
+
+// Results of the last collect; valid is false before the first
+const sysinfo_result *get_system_info_result(void);
+
+// Write the system info report section, from the last collect
+// (collecting first if there was none)
+void get_system_info_report(report_rec *out);
 
 #endif // SYSTEM_INFO_H
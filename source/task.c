@@ -0,0 +1,139 @@
+/*
+ * WiiMedic - task.c
+ * Module tasks. A worker thread runs below the main thread's priority, so
+ * the UI loop gets the CPU back every vsync to drain output, poll the pads
+ * and animate progress. Cancellation is cooperative: modules poll
+ * task_cancelled() between units of work; a call stuck inside IOS still has
+ * to return before the task can stop.
+ */
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <string.h>
+
+#include "mem_budget.h"
+#include "task.h"
+#include "trace.h"
+#include "ui_common.h"
+
+#define TASK_MAX 4
+#define TASK_STACK_SIZE (64 * 1024)
+#define TASK_PRIO 48 /* main thread runs at 64 */
+#define TASK_PRIO_BACKGROUND 8 /* only the dashboard's idle spinner is lower */
+
+/* Running tasks, so module code can find its own without a parameter */
+static task_t *volatile s_running[TASK_MAX];
+
+/*---------------------------------------------------------------------------*/
+static task_t *task_current(void) {
+  lwp_t self = LWP_GetSelf();
+  int i;
+
+  for (i = 0; i < TASK_MAX; i++) {
+    task_t *t = s_running[i];
+    if (t && t->thread == self)
+      return t;
+  }
+  return NULL;
+}
+
+void task_set_progress(u32 done, u32 total) {
+  task_t *t = task_current();
+
+  if (!t || total == 0)
+    return;
+  if (done > total)
+    done = total;
+  t->progress = (u32)((u64)done * 1000 / total);
+}
+
+bool task_cancelled(void) {
+  task_t *t = task_current();
+
+  if (!t)
+    return false;
+  return t->cancel || task_timed_out(t);
+}
+
+void *task_arg(void) {
+  task_t *t = task_current();
+
+  return t ? t->arg : NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static void *task_entry(void *arg) {
+  task_t *t = (task_t *)arg;
+
+  /* The creator may not have stored the handle yet */
+  t->thread = LWP_GetSelf();
+  TRACE_SPAN(t->name, t->func());
+  ui_output_detach();
+  t->progress = 1000;
+  __atomic_store_n(&t->done, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+bool task_start(task_t *t, const char *name, void (*func)(void),
+                u32 timeout_ms) {
+  return task_start_arg(t, name, func, NULL, timeout_ms);
+}
+
+static bool task_spawn(task_t *t, const char *name, void (*func)(void),
+                       void *arg, u32 timeout_ms, int prio) {
+  int slot;
+
+  memset(t, 0, sizeof(*t));
+  t->name = name;
+  t->func = func;
+  t->arg = arg;
+  t->thread = LWP_THREAD_NULL;
+  t->start = gettime();
+  if (timeout_ms)
+    t->deadline = t->start + millisecs_to_ticks(timeout_ms);
+
+  for (slot = 0; slot < TASK_MAX; slot++) {
+    if (__sync_bool_compare_and_swap(&s_running[slot], NULL, t))
+      break;
+  }
+  if (slot == TASK_MAX)
+    return false;
+
+  t->stack = mem_memalign(MEM_TAG_MAIN, 32, TASK_STACK_SIZE);
+  if (!t->stack || LWP_CreateThread(&t->thread, task_entry, t, t->stack,
+                                    TASK_STACK_SIZE, prio) < 0) {
+    mem_free(t->stack);
+    t->stack = NULL;
+    s_running[slot] = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool task_start_arg(task_t *t, const char *name, void (*func)(void),
+                    void *arg, u32 timeout_ms) {
+  return task_spawn(t, name, func, arg, timeout_ms, TASK_PRIO);
+}
+
+bool task_start_background(task_t *t, const char *name, void (*func)(void),
+                           void *arg) {
+  return task_spawn(t, name, func, arg, 0, TASK_PRIO_BACKGROUND);
+}
+
+void task_cancel(task_t *t) { t->cancel = true; }
+
+bool task_timed_out(const task_t *t) {
+  return t->deadline && gettime() > t->deadline;
+}
+
+void task_join(task_t *t) {
+  int i;
+
+  LWP_JoinThread(t->thread, NULL);
+  for (i = 0; i < TASK_MAX; i++) {
+    if (s_running[i] == t)
+      s_running[i] = NULL;
+  }
+  mem_free(t->stack);
+  t->stack = NULL;
+}
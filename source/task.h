@@ -0,0 +1,70 @@
+/*
+ * WiiMedic - task.h
+ * Cooperative module tasks: run a module on its own LWP thread with
+ * progress reporting, cancellation and an optional deadline
+ */
+#ifndef TASK_H
+#define TASK_H
+
+#include <gccore.h>
+
+// Runners wait this long before drawing progress, so quick modules don't
+// flash a progress bar
+#define TASK_QUIET_MS 100
+
+typedef struct {
+  const char *name;
+  void (*func)(void);
+  void *arg;                 // returned by task_arg() inside func
+  lwp_t thread;
+  void *stack;
+  u64 start;                 // ticks
+  u64 deadline;              // ticks, 0 = none
+  volatile u32 progress;     // per mille
+  volatile bool cancel;      // set by task_cancel
+  volatile bool done;        // func has returned
+} task_t;
+
+/*---------------------------------------------------------------------------*/
+/* Module side. Both are no-ops / false when not running inside a task, so
+   modules work unchanged when called directly (report, benchmarks).        */
+/*---------------------------------------------------------------------------*/
+
+// Report progress as done out of total units of work
+void task_set_progress(u32 done, u32 total);
+
+// True once the user cancelled or the deadline passed; check between units
+// of work and return early (leaving results consistent) when set
+bool task_cancelled(void);
+
+// The arg given to task_start_arg, NULL outside a task
+void *task_arg(void);
+
+/*---------------------------------------------------------------------------*/
+/* Runner side (UI thread)                                                   */
+/*---------------------------------------------------------------------------*/
+
+// Start func on a worker thread; timeout_ms = 0 means no deadline.
+// Returns false if no thread could be created (run func directly instead).
+bool task_start(task_t *t, const char *name, void (*func)(void),
+                u32 timeout_ms);
+
+// As task_start, with a value func can fetch through task_arg()
+bool task_start_arg(task_t *t, const char *name, void (*func)(void),
+                    void *arg, u32 timeout_ms);
+
+// As task_start_arg without a deadline, far below the main thread's
+// priority: the task only gets the CPU the UI leaves idle
+bool task_start_background(task_t *t, const char *name, void (*func)(void),
+                           void *arg);
+
+// Ask the task to stop at its next cancellation check
+void task_cancel(task_t *t);
+
+// True if the deadline has passed
+bool task_timed_out(const task_t *t);
+
+// Wait for the thread to exit and release its stack. Call once done is set.
+void task_join(task_t *t);
+
+#endif // TASK_H
@@ -0,0 +1,112 @@
+/*
+ * WiiMedic - trace.c
+ * Span tracing: begin/end/instant/counter events are stamped with the raw
+ * timebase and stored in a preallocated ring buffer. Recording is a single
+ * atomic slot reservation, so it is safe from any thread and cheap enough to
+ * wrap individual IPC and file calls. trace_write() converts the ring to
+ * Chrome trace JSON; once the ring wraps the oldest events are overwritten.
+ */
+
+#ifdef WIIMEDIC_TRACE
+
+#include <gccore.h>
+#include <ogc/lwp_watchdog.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+#include "ui_common.h"
+
+#define TRACE_RING_SIZE 16384 /* power of two */
+
+typedef struct {
+  u64 ticks;
+  const char *name;
+  s64 value; /* counters only */
+  lwp_t tid;
+  char phase; /* Chrome "ph": B, E, i, C */
+} trace_event;
+
+static trace_event s_events[TRACE_RING_SIZE];
+static u32 s_head = 0; /* total events reserved */
+
+/*---------------------------------------------------------------------------*/
+static inline void record(char phase, const char *name, s64 value) {
+  u32 slot = __atomic_fetch_add(&s_head, 1, __ATOMIC_RELAXED);
+  trace_event *e = &s_events[slot & (TRACE_RING_SIZE - 1)];
+
+  e->ticks = gettime();
+  e->name = name;
+  e->value = value;
+  e->tid = LWP_GetSelf();
+  e->phase = phase;
+}
+
+void trace_begin(const char *name) { record('B', name, 0); }
+
+void trace_end(const char *name) { record('E', name, 0); }
+
+void trace_instant(const char *name) { record('i', name, 0); }
+
+void trace_counter(const char *name, s64 value) { record('C', name, value); }
+
+/*---------------------------------------------------------------------------*/
+/* Names are literals, but menu titles and the like may contain quotes */
+static void write_json_string(FILE *fp, const char *s) {
+  fputc('"', fp);
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\')
+      fputc('\\', fp);
+    if ((unsigned char)*s >= 0x20)
+      fputc(*s, fp);
+  }
+  fputc('"', fp);
+}
+
+int trace_write(const char *path) {
+  u32 head = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+  u32 total = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+  u32 first = head - total;
+  u64 base = 0;
+  FILE *fp;
+  u32 i;
+
+  if (total == 0)
+    return 0;
+
+  fp = fopen(path, "w");
+  if (!fp)
+    return -1;
+
+  /* Timestamps are relative to the oldest surviving event */
+  base = s_events[first & (TRACE_RING_SIZE - 1)].ticks;
+
+  fprintf(fp,
+          "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"app\":\"WiiMedic "
+          "v" WIIMEDIC_VERSION "\",\"dropped\":%u},\n\"traceEvents\":[\n",
+          (unsigned)first);
+  for (i = 0; i < total; i++) {
+    const trace_event *e = &s_events[(first + i) & (TRACE_RING_SIZE - 1)];
+    u64 dt = e->ticks > base ? e->ticks - base : 0;
+
+    fprintf(fp, "%s{\"name\":", i ? ",\n" : "");
+    write_json_string(fp, e->name ? e->name : "?");
+    /* ticks -> microseconds with sub-microsecond precision */
+    fprintf(fp, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", e->phase,
+            (double)dt * 1000.0 / TB_TIMER_CLOCK, (unsigned)e->tid);
+    if (e->phase == 'C') {
+      fputs(",\"args\":{", fp);
+      write_json_string(fp, e->name ? e->name : "?");
+      fprintf(fp, ":%lld}", (long long)e->value);
+    } else if (e->phase == 'i') {
+      fputs(",\"s\":\"t\"", fp);
+    }
+    fputc('}', fp);
+  }
+  fputs("\n]}\n", fp);
+  fclose(fp);
+
+  return (int)total;
+}
+
+#endif // WIIMEDIC_TRACE
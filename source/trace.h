@@ -0,0 +1,73 @@
+/*
+ * WiiMedic - trace.h
+ * Span tracing exported as Chrome trace JSON (compiled in with "make TRACE=1")
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <gctypes.h>
+
+/* Load in chrome://tracing or https://ui.perfetto.dev */
+#define TRACE_OUT_SD "sd:/WiiMedic_trace.json"
+#define TRACE_OUT_USB "usb:/WiiMedic_trace.json"
+
+#ifdef WIIMEDIC_TRACE
+
+// Event names are stored by pointer: pass string literals (or strings that
+// outlive the trace, such as the menu titles).
+
+// Open / close a span. Spans nest per thread; end must match the innermost
+// begin on the same thread.
+void trace_begin(const char *name);
+void trace_end(const char *name);
+
+// Zero-length marker
+void trace_instant(const char *name);
+
+// Sample a value; shown as a graph track named after the counter
+void trace_counter(const char *name, s64 value);
+
+// Write the recorded events as Chrome trace JSON. Call while no spans are
+// being recorded. Returns the number of events written, or -1 on error.
+int trace_write(const char *path);
+
+// Evaluate call inside a span named name and yield its result
+#define TRACE_CALL(name, call)                                                 \
+  ({                                                                           \
+    trace_begin(name);                                                         \
+    __typeof__(call) _trace_ret = (call);                                      \
+    trace_end(name);                                                           \
+    _trace_ret;                                                                \
+  })
+
+// Run a statement (e.g. a void call) inside a span named name
+#define TRACE_SPAN(name, stmt)                                                 \
+  do {                                                                         \
+    trace_begin(name);                                                         \
+    stmt;                                                                      \
+    trace_end(name);                                                           \
+  } while (0)
+
+#else
+
+static inline void trace_begin(const char *name) { (void)name; }
+static inline void trace_end(const char *name) { (void)name; }
+static inline void trace_instant(const char *name) { (void)name; }
+static inline void trace_counter(const char *name, s64 value) {
+  (void)name;
+  (void)value;
+}
+static inline int trace_write(const char *path) {
+  (void)path;
+  return 0;
+}
+
+#define TRACE_CALL(name, call) (call)
+#define TRACE_SPAN(name, stmt)                                                 \
+  do {                                                                         \
+    stmt;                                                                      \
+  } while (0)
+
+#endif // WIIMEDIC_TRACE
+
+#endif // TRACE_H
@@ -9,245 +9,905 @@
 #include <string.h>
 #include <wiiuse/wpad.h>
 
+#include "line_store.h"
+#include "mem_budget.h"
+#include "screen.h"
+#include "screenshot.h"
+#include "scroll_search.h"
 #include "ui_common.h"
 
 #define LINE_WIDTH 60
 
 /* Scroll buffer system */
-#define SCROLL_MAX_LINES 256
-#define SCROLL_LINE_LEN 512
 #define SCROLL_VISIBLE 18
+#define SCROLL_FIRST_ROW 2 /* screen row of the first visible line */
+#define SCROLL_MARK_ATTR (LINE_ATTR_FG | LINE_ATTR_BOLD | 3) /* yellow */
 
-static char s_scroll_lines[SCROLL_MAX_LINES][SCROLL_LINE_LEN];
-static int s_scroll_count = 0;
-static char s_scroll_cur[SCROLL_LINE_LEN];
-static int s_scroll_pos = 0;
+/* On-screen keyboard: the D-pad moves over KB_ROWS x KB_COLS keys */
+#define KB_COLS 13
+#define KB_ROWS 4
+#define KB_KEYS (KB_COLS * KB_ROWS)
+
+/* Screenshot chord on the Wii Remote */
+#define UI_SHOT_CHORD (WPAD_BUTTON_1 | WPAD_BUTTON_2)
+#define UI_LINEBUF_MIN 256
+
+/* Worker output rings: one single-producer/single-consumer ring of line
+   records per worker thread, drained into the scroll buffer by the UI thread.
+   Records are [u16 len][text], 4-byte aligned; UI_REC_WRAP means the rest of
+   the ring is unused and the next record starts at offset 0. A line longer
+   than UI_RING_LINE goes as UI_REC_MORE pieces followed by a plain record. */
+#define UI_RING_COUNT 4
+#define UI_RING_SIZE 8192 /* bytes, power of two */
+#define UI_RING_LINE 256  /* producer's line buffer */
+#define UI_REC_WRAP 0xFFFF
+#define UI_REC_MORE 0x8000 /* flag in len: the line continues */
+#define UI_REC_SIZE(len) ((2u + (len) + 3u) & ~3u)
+
+/* Threads whose output goes straight into a store of their own */
+#define UI_CAPTURE_COUNT 2
+
+/* Growable partial line, assembled from ui_printf pieces */
+typedef struct {
+  char *buf;
+  u32 len;
+  u32 cap;
+} ui_linebuf;
+
+typedef struct {
+  u32 claimed; /* 0 = free; set and cleared by the owner */
+  lwp_t owner;
+  line_store *store;
+  ui_linebuf cur; /* partial line */
+} ui_capture;
+
+typedef struct {
+  u8 data[UI_RING_SIZE];
+  u32 head;     /* written only by the producer */
+  u32 tail;     /* written only by the consumer */
+  u32 claimed;  /* 0 = free; set by the producer, cleared by the consumer */
+  u32 closed;   /* producer is done; consumer frees the ring once empty */
+  u32 muted;    /* producer's output is discarded */
+  lwp_t owner;
+  char cur[UI_RING_LINE]; /* producer's partial line */
+  int cur_pos;
+  ui_linebuf pend; /* consumer's copy of a line sent in pieces */
+} ui_ring;
+
+static line_store s_scroll;
+static ui_linebuf s_scroll_cur;
 static bool s_scroll_active = false;
 
+static ui_ring s_rings[UI_RING_COUNT];
+static ui_capture s_captures[UI_CAPTURE_COUNT];
+static lwp_t s_ui_thread = LWP_THREAD_NULL;
+static bool s_headless = false;
+
+static u32 s_chord_held;  /* chord buttons held at the last poll */
+static bool s_chord_used; /* chord completed since they were all up */
+static char s_shot_note[80];
+
+/*---------------------------------------------------------------------------*/
+/* Append text to a partial line; on allocation failure the text is lost */
+static void linebuf_append(ui_linebuf *b, const char *text, u32 len) {
+  if (b->len + len > b->cap) {
+    u32 cap = b->cap ? b->cap : UI_LINEBUF_MIN;
+    char *grown;
+
+    while (cap < b->len + len)
+      cap *= 2;
+    grown = (char *)mem_alloc(MEM_TAG_UI, cap);
+    if (!grown)
+      return;
+    if (b->len)
+      memcpy(grown, b->buf, b->len);
+    mem_free(b->buf);
+    b->buf = grown;
+    b->cap = cap;
+  }
+  memcpy(b->buf + b->len, text, len);
+  b->len += len;
+}
+
+/* Append one finished line (UI thread only) */
+static void scroll_store_line(const char *line, int len) {
+  if (!s_scroll_active) {
+    printf("%.*s\n", len, line);
+    return;
+  }
+  line_store_add(&s_scroll, line, (u32)len);
+}
+
+/* Split text at newlines into the scroll buffer (UI thread only) */
+static void scroll_write_text(const char *text, int len) {
+  const char *end = text + len;
+
+  while (text < end) {
+    const char *nl = memchr(text, '\n', end - text);
+
+    if (!nl) {
+      linebuf_append(&s_scroll_cur, text, end - text);
+      return;
+    }
+    if (s_scroll_cur.len) {
+      linebuf_append(&s_scroll_cur, text, nl - text);
+      scroll_store_line(s_scroll_cur.buf, s_scroll_cur.len);
+      s_scroll_cur.len = 0;
+    } else {
+      scroll_store_line(text, nl - text);
+    }
+    text = nl + 1;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Producer side. Blocks (yielding) while the ring is full. */
+static void ring_push(ui_ring *r, const char *line, u16 len, bool more) {
+  u32 need = UI_REC_SIZE(len);
+  u16 hdr = more ? (u16)(len | UI_REC_MORE) : len;
+
+  while (1) {
+    u32 head = r->head;
+    u32 tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    u32 off = head & (UI_RING_SIZE - 1);
+    u32 to_end = UI_RING_SIZE - off;
+    u32 total = need <= to_end ? need : to_end + need;
+
+    if (UI_RING_SIZE - (head - tail) >= total) {
+      if (need > to_end) {
+        u16 wrap = UI_REC_WRAP;
+        memcpy(r->data + off, &wrap, 2);
+        head += to_end;
+        off = 0;
+      }
+      memcpy(r->data + off, &hdr, 2);
+      memcpy(r->data + off + 2, line, len);
+      __atomic_store_n(&r->head, head + need, __ATOMIC_RELEASE);
+      return;
+    }
+    LWP_YieldThread();
+  }
+}
+
+/* Consumer side: move every complete record into the scroll buffer */
+static int ring_drain(ui_ring *r) {
+  u32 head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+  u32 tail = r->tail;
+  int lines = 0;
+
+  while (tail != head) {
+    u32 off = tail & (UI_RING_SIZE - 1);
+    const char *text = (const char *)r->data + off + 2;
+    u16 hdr, len;
+
+    memcpy(&hdr, r->data + off, 2);
+    len = hdr & ~UI_REC_MORE;
+    if (hdr == UI_REC_WRAP) {
+      tail += UI_RING_SIZE - off;
+    } else if (hdr & UI_REC_MORE) {
+      linebuf_append(&r->pend, text, len);
+      tail += UI_REC_SIZE(len);
+    } else {
+      if (r->pend.len) {
+        linebuf_append(&r->pend, text, len);
+        scroll_store_line(r->pend.buf, r->pend.len);
+        r->pend.len = 0;
+      } else {
+        scroll_store_line(text, len);
+      }
+      tail += UI_REC_SIZE(len);
+      lines++;
+    }
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+  }
+  return lines;
+}
+
+/* The calling worker's ring, claiming a free one on first use */
+static ui_ring *worker_ring(lwp_t self) {
+  int i;
+
+  for (i = 0; i < UI_RING_COUNT; i++) {
+    ui_ring *r = &s_rings[i];
+    if (__atomic_load_n(&r->claimed, __ATOMIC_ACQUIRE) && !r->closed &&
+        r->owner == self)
+      return r;
+  }
+
+  /* Claim a free ring; if all are busy, wait for the UI thread to retire
+     a finished worker's */
+  while (1) {
+    for (i = 0; i < UI_RING_COUNT; i++) {
+      ui_ring *r = &s_rings[i];
+      u32 expected = 0;
+      if (__atomic_compare_exchange_n(&r->claimed, &expected, 1, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        r->owner = self;
+        r->cur_pos = 0;
+        r->closed = 0;
+        r->muted = 0;
+        return r;
+      }
+    }
+    LWP_YieldThread();
+  }
+}
+
+static void ring_write_text(ui_ring *r, const char *text, int len) {
+  int i;
+
+  for (i = 0; i < len && text[i]; i++) {
+    if (text[i] == '\n') {
+      ring_push(r, r->cur, (u16)r->cur_pos, false);
+      r->cur_pos = 0;
+      continue;
+    }
+    if (r->cur_pos == UI_RING_LINE) {
+      ring_push(r, r->cur, (u16)r->cur_pos, true);
+      r->cur_pos = 0;
+    }
+    r->cur[r->cur_pos++] = text[i];
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/* The calling thread's capture, or NULL */
+static ui_capture *capture_of(lwp_t self) {
+  int i;
+
+  for (i = 0; i < UI_CAPTURE_COUNT; i++) {
+    ui_capture *c = &s_captures[i];
+    if (__atomic_load_n(&c->claimed, __ATOMIC_ACQUIRE) && c->owner == self)
+      return c;
+  }
+  return NULL;
+}
+
+static void capture_write_text(ui_capture *c, const char *text, int len) {
+  const char *end = text + len;
+
+  while (text < end) {
+    const char *nl = memchr(text, '\n', end - text);
+
+    if (!nl) {
+      linebuf_append(&c->cur, text, end - text);
+      return;
+    }
+    linebuf_append(&c->cur, text, nl - text);
+    line_store_add(c->store, c->cur.buf ? c->cur.buf : "", c->cur.len);
+    c->cur.len = 0;
+    text = nl + 1;
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 int ui_printf(const char *fmt, ...) {
-  va_list args;
+  va_list args, again;
   char tmp[512];
-  int len, i;
+  char *text = tmp;
+  int len;
+  lwp_t self;
+  ui_capture *cap;
 
+  if (s_headless)
+    return 0;
+
+  self = LWP_GetSelf();
+  cap = capture_of(self);
   va_start(args, fmt);
-  if (!s_scroll_active) {
+  if (!cap && !s_scroll_active &&
+      (s_ui_thread == LWP_THREAD_NULL || self == s_ui_thread)) {
     len = vprintf(fmt, args);
     va_end(args);
     return len;
   }
 
+  va_copy(again, args);
   len = vsnprintf(tmp, sizeof(tmp), fmt, args);
   va_end(args);
-
-  for (i = 0; i < len && tmp[i]; i++) {
-    if (tmp[i] == '\n') {
-      s_scroll_cur[s_scroll_pos] = '\0';
-      if (s_scroll_count < SCROLL_MAX_LINES) {
-        memcpy(s_scroll_lines[s_scroll_count], s_scroll_cur, s_scroll_pos + 1);
-        s_scroll_count++;
-      }
-      s_scroll_pos = 0;
-      s_scroll_cur[0] = '\0';
+  /* Rare long output: format it again into a buffer that fits */
+  if (len >= (int)sizeof(tmp)) {
+    text = (char *)mem_alloc(MEM_TAG_UI, (u32)len + 1);
+    if (text) {
+      vsnprintf(text, (size_t)len + 1, fmt, again);
     } else {
-      if (s_scroll_pos < SCROLL_LINE_LEN - 1) {
-        s_scroll_cur[s_scroll_pos++] = tmp[i];
-      }
+      text = tmp;
+      len = sizeof(tmp) - 1;
     }
   }
+  va_end(again);
+  if (len < 0)
+    return len;
+
+  if (cap) {
+    capture_write_text(cap, text, len);
+  } else if (s_ui_thread != LWP_THREAD_NULL && self != s_ui_thread) {
+    ui_ring *r = worker_ring(self);
+    if (!r->muted)
+      ring_write_text(r, text, len);
+  } else {
+    scroll_write_text(text, len);
+  }
+  if (text != tmp)
+    mem_free(text);
   return len;
 }
 
 /*---------------------------------------------------------------------------*/
-void ui_clear(void) { printf("\x1b[2J\x1b[0;0H"); }
+void ui_line_begin(ui_line *l) {
+  l->len = 0;
+  l->nruns = 0;
+  l->attr = LINE_ATTR_DEFAULT;
+}
+
+void ui_line_color(ui_line *l, const char *color) {
+  u8 attr = line_sgr(l->attr, color);
+
+  if (attr == l->attr || l->nruns == UI_LINE_RUNS)
+    return;
+  line_run_set(l->runs, &l->nruns, l->len, attr);
+  l->attr = attr;
+}
+
+void ui_line_puts(ui_line *l, const char *s) {
+  u32 n = (u32)strlen(s);
+
+  if (n > UI_LINE_TEXT - l->len)
+    n = UI_LINE_TEXT - l->len;
+  memcpy(l->text + l->len, s, n);
+  l->len += n;
+}
+
+void ui_line_fill(ui_line *l, char c, int count) {
+  if (count <= 0)
+    return;
+  if ((u32)count > UI_LINE_TEXT - l->len)
+    count = (int)(UI_LINE_TEXT - l->len);
+  memset(l->text + l->len, c, count);
+  l->len += count;
+}
+
+void ui_line_uint(ui_line *l, u32 v) {
+  char digits[10];
+  int n = 0;
+
+  do {
+    digits[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n && l->len < UI_LINE_TEXT)
+    l->text[l->len++] = digits[--n];
+}
+
+/* v right-aligned in width columns, like "%*u" */
+static void line_uint_pad(ui_line *l, u32 v, int width) {
+  u32 t = v;
+  int digits = 1;
+
+  while (t >= 10) {
+    t /= 10;
+    digits++;
+  }
+  ui_line_fill(l, ' ', width - digits);
+  ui_line_uint(l, v);
+}
+
+/* Console text of l (escapes, then '\n' if newline) in buf */
+static u32 line_escaped(const ui_line *l, char *buf, bool newline) {
+  line_view v;
+  u32 n;
+
+  v.text = l->text;
+  v.len = l->len;
+  v.runs = l->runs;
+  v.nruns = l->nruns;
+  n = line_format(&v, buf, LINE_FORMAT_SIZE(UI_LINE_TEXT, UI_LINE_RUNS));
+  if (newline)
+    buf[n++] = '\n';
+  return n;
+}
+
+void ui_line_end(ui_line *l) {
+  char buf[LINE_FORMAT_SIZE(UI_LINE_TEXT, UI_LINE_RUNS) + 1];
+  ui_capture *cap;
+  lwp_t self;
+  u32 n;
+
+  if (s_headless)
+    return;
+
+  self = LWP_GetSelf();
+  if ((cap = capture_of(self)) != NULL) {
+    if (cap->cur.len)
+      capture_write_text(cap, buf, (int)line_escaped(l, buf, true));
+    else
+      line_store_add_runs(cap->store, l->text, l->len, l->runs, l->nruns);
+    return;
+  }
+  if (s_ui_thread != LWP_THREAD_NULL && self != s_ui_thread) {
+    ui_ring *r = worker_ring(self);
+    if (!r->muted)
+      ring_write_text(r, buf, (int)line_escaped(l, buf, true));
+    return;
+  }
+  if (screen_capturing()) {
+    line_view v;
+
+    v.text = l->text;
+    v.len = l->len;
+    v.runs = l->runs;
+    v.nruns = l->nruns;
+    screen_line(&v);
+    return;
+  }
+  /* Straight into the store unless it would split a ui_printf line */
+  if (s_scroll_active && s_scroll_cur.len == 0) {
+    line_store_add_runs(&s_scroll, l->text, l->len, l->runs, l->nruns);
+    return;
+  }
+  n = line_escaped(l, buf, true);
+  if (s_scroll_active)
+    scroll_write_text(buf, (int)n);
+  else
+    fwrite(buf, 1, n, stdout);
+}
 
 /*---------------------------------------------------------------------------*/
+void ui_output_detach(void) {
+  lwp_t self = LWP_GetSelf();
+  ui_capture *cap = capture_of(self);
+  int i;
+
+  if (cap) {
+    if (cap->cur.len)
+      line_store_add(cap->store, cap->cur.buf, cap->cur.len);
+    cap->cur.len = 0;
+    __atomic_store_n(&cap->claimed, 0, __ATOMIC_RELEASE);
+    return;
+  }
+  for (i = 0; i < UI_RING_COUNT; i++) {
+    ui_ring *r = &s_rings[i];
+    if (__atomic_load_n(&r->claimed, __ATOMIC_ACQUIRE) && !r->closed &&
+        r->owner == self) {
+      if (r->cur_pos > 0)
+        ring_push(r, r->cur, (u16)r->cur_pos, false);
+      __atomic_store_n(&r->closed, 1, __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+bool ui_output_capture(line_store *ls) {
+  int i;
+
+  for (i = 0; i < UI_CAPTURE_COUNT; i++) {
+    ui_capture *c = &s_captures[i];
+    u32 expected = 0;
+
+    if (__atomic_compare_exchange_n(&c->claimed, &expected, 1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      c->owner = LWP_GetSelf();
+      c->store = ls;
+      c->cur.len = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ui_output_mute(void) {
+  lwp_t self = LWP_GetSelf();
+
+  if (s_ui_thread != LWP_THREAD_NULL && self != s_ui_thread)
+    worker_ring(self)->muted = 1;
+}
+
+/*---------------------------------------------------------------------------*/
+int ui_output_drain(void) {
+  int lines = 0;
+  int i;
+
+  for (i = 0; i < UI_RING_COUNT; i++) {
+    ui_ring *r = &s_rings[i];
+    bool closed;
+
+    if (!__atomic_load_n(&r->claimed, __ATOMIC_ACQUIRE))
+      continue;
+    /* Read closed first: everything pushed before it is then visible */
+    closed = __atomic_load_n(&r->closed, __ATOMIC_ACQUIRE) != 0;
+    lines += ring_drain(r);
+    if (closed) {
+      r->head = r->tail = 0;
+      __atomic_store_n(&r->claimed, 0, __ATOMIC_RELEASE);
+    }
+  }
+  return lines;
+}
+
+/*---------------------------------------------------------------------------*/
+void ui_set_headless(bool on) { s_headless = on; }
+
+/*---------------------------------------------------------------------------*/
+void ui_clear(void) {
+  printf("\x1b[2J\x1b[0;0H");
+  screen_invalidate();
+  s_shot_note[0] = '\0';
+}
+
+/*---------------------------------------------------------------------------*/
+bool ui_screenshot_poll(u32 wpad_held, u32 gpad_down, u32 *solo) {
+  u32 held = wpad_held & UI_SHOT_CHORD;
+  bool chord = held == UI_SHOT_CHORD && !s_chord_used;
+
+  if (chord)
+    s_chord_used = true;
+  if (solo && !s_chord_used)
+    *solo |= s_chord_held & ~held;
+  if (!held)
+    s_chord_used = false;
+  s_chord_held = held;
+
+  if (!chord && !(gpad_down & PAD_TRIGGER_Z))
+    return false;
+  screenshot_save(s_shot_note, sizeof(s_shot_note));
+  return true;
+}
+
+const char *ui_screenshot_note(void) { return s_shot_note; }
+
+/*---------------------------------------------------------------------------*/
+static void blank_line(void) {
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_end(&l);
+}
+
+static void banner_rule(void) {
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_puts(&l, "  ");
+  ui_line_color(&l, UI_BGREEN);
+  ui_line_fill(&l, '=', 58);
+  ui_line_end(&l);
+}
+
 void ui_draw_banner(void) {
-  printf("\n");
-  printf(
-      UI_BGREEN
-      "  "
-      "==========================================================\n" UI_RESET);
-  printf("\n");
-  printf(UI_BWHITE "          [+]  W i i M e d i c" UI_RESET "   " UI_CYAN
-                   "v" WIIMEDIC_VERSION "\n" UI_RESET);
-  printf("\n");
-  printf(UI_WHITE "          System Diagnostic & Health Monitor\n" UI_RESET);
-  printf("\n");
-  printf(
-      UI_BGREEN
-      "  "
-      "==========================================================\n" UI_RESET);
-  printf("\n");
+  ui_line l;
+
+  blank_line();
+  banner_rule();
+  blank_line();
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_BWHITE);
+  ui_line_puts(&l, "          [+]  W i i M e d i c");
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, "   ");
+  ui_line_color(&l, UI_CYAN);
+  ui_line_puts(&l, "v" WIIMEDIC_VERSION);
+  ui_line_end(&l);
+  blank_line();
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, "          System Diagnostic & Health Monitor");
+  ui_line_end(&l);
+  blank_line();
+  banner_rule();
+  blank_line();
 }
 
 /*---------------------------------------------------------------------------*/
 void ui_draw_line(void) {
-  int i;
-  ui_printf("  " UI_WHITE);
-  for (i = 0; i < LINE_WIDTH; i++)
-    ui_printf("-");
-  ui_printf("\n" UI_RESET);
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_puts(&l, "  ");
+  ui_line_color(&l, UI_WHITE);
+  ui_line_fill(&l, '-', LINE_WIDTH);
+  ui_line_end(&l);
 }
 
 /*---------------------------------------------------------------------------*/
 void ui_draw_section(const char *title) {
-  ui_printf("\n" UI_BCYAN "   --- %s ---\n\n" UI_RESET, title);
+  ui_line l;
+
+  blank_line();
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_BCYAN);
+  ui_line_puts(&l, "   --- ");
+  ui_line_puts(&l, title);
+  ui_line_puts(&l, " ---");
+  ui_line_end(&l);
+  blank_line();
 }
 
 /*---------------------------------------------------------------------------*/
 void ui_draw_kv(const char *label, const char *value) {
-  int label_len = (int)strlen(label);
-  int dots = 30 - label_len;
-  int i;
-  if (dots < 2)
-    dots = 2;
-
-  ui_printf("   " UI_CYAN "%s " UI_RESET, label);
-  for (i = 0; i < dots; i++)
-    ui_printf(".");
-  ui_printf(" " UI_BWHITE "%s\n" UI_RESET, value);
+  ui_draw_kv_color(label, UI_BWHITE, value);
 }
 
 /*---------------------------------------------------------------------------*/
 void ui_draw_kv_color(const char *label, const char *color, const char *value) {
-  int label_len = (int)strlen(label);
-  int dots = 30 - label_len;
-  int i;
+  int dots = 30 - (int)strlen(label);
+  ui_line l;
+
   if (dots < 2)
     dots = 2;
 
-  ui_printf("   " UI_CYAN "%s " UI_RESET, label);
-  for (i = 0; i < dots; i++)
-    ui_printf(".");
-  ui_printf(" %s%s\n" UI_RESET, color, value);
+  ui_line_begin(&l);
+  ui_line_puts(&l, "   ");
+  ui_line_color(&l, UI_CYAN);
+  ui_line_puts(&l, label);
+  ui_line_puts(&l, " ");
+  ui_line_color(&l, UI_RESET);
+  ui_line_fill(&l, '.', dots);
+  ui_line_puts(&l, " ");
+  ui_line_color(&l, color);
+  ui_line_puts(&l, value);
+  ui_line_end(&l);
 }
 
 /*---------------------------------------------------------------------------*/
 void ui_draw_bar(u32 used, u32 total, int bar_width) {
   int filled = 0;
-  float pct = 0.0f;
+  u32 tenths = 0; /* percent x 10, rounded */
   const char *color;
-  int i;
+  ui_line l;
 
   if (total > 0) {
     filled = (int)((u64)used * bar_width / total);
-    pct = (float)used * 100.0f / (float)total;
+    tenths = (u32)(((u64)used * 1000 + total / 2) / total);
   }
   if (filled > bar_width)
     filled = bar_width;
+  if (filled < 0)
+    filled = 0;
 
-  if (pct > 90.0f)
+  if ((u64)used * 10 > (u64)total * 9)
     color = UI_BRED;
-  else if (pct > 70.0f)
+  else if ((u64)used * 10 > (u64)total * 7)
     color = UI_BYELLOW;
   else
     color = UI_BGREEN;
 
-  ui_printf("   [");
-  for (i = 0; i < bar_width; i++) {
-    if (i < filled)
-      ui_printf("%s#" UI_RESET, color);
-    else
-      ui_printf(UI_WHITE "." UI_RESET);
-  }
-  ui_printf("] %s%.1f%%\n" UI_RESET, color, pct);
+  ui_line_begin(&l);
+  ui_line_puts(&l, "   [");
+  ui_line_color(&l, color);
+  ui_line_fill(&l, '#', filled);
+  ui_line_color(&l, UI_RESET); /* drop the bold */
+  ui_line_color(&l, UI_WHITE);
+  ui_line_fill(&l, '.', bar_width - filled);
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, "] ");
+  ui_line_color(&l, color);
+  ui_line_uint(&l, tenths / 10);
+  ui_line_puts(&l, ".");
+  ui_line_uint(&l, tenths % 10);
+  ui_line_puts(&l, "%");
+  ui_line_end(&l);
 }
 
 /*---------------------------------------------------------------------------*/
-void ui_draw_ok(const char *msg) {
-  ui_printf("   " UI_BGREEN "[OK]" UI_RESET " %s\n", msg);
-}
+void ui_draw_progress(u32 permille, u32 elapsed_ms, const char *status) {
+  static const char spinner[4] = {'|', '/', '-', '\\'};
+  const int width = 30;
+  int filled = (int)(permille * width / 1000);
+  char buf[LINE_FORMAT_SIZE(UI_LINE_TEXT, UI_LINE_RUNS)];
+  ui_line l;
 
-void ui_draw_warn(const char *msg) {
-  ui_printf("   " UI_BYELLOW "[!!]" UI_RESET " %s\n", msg);
-}
+  if (filled > width)
+    filled = width;
 
-void ui_draw_err(const char *msg) {
-  ui_printf("   " UI_BRED "[XX]" UI_RESET " %s\n", msg);
+  /* Redrawn in place every frame, so bypass the scroll buffer */
+  ui_line_begin(&l);
+  ui_line_puts(&l, "\r   ");
+  ui_line_color(&l, UI_BCYAN);
+  ui_line_fill(&l, spinner[(elapsed_ms / 125) & 3], 1);
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, " [");
+  ui_line_color(&l, UI_BGREEN);
+  ui_line_fill(&l, '#', filled);
+  ui_line_color(&l, UI_WHITE);
+  ui_line_fill(&l, '.', width - filled);
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, "] ");
+  line_uint_pad(&l, permille / 10, 3);
+  ui_line_puts(&l, "%  ");
+  line_uint_pad(&l, elapsed_ms / 1000, 3);
+  ui_line_puts(&l, "s  ");
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, status);
+  ui_line_fill(&l, ' ', 22 - (int)strlen(status));
+  fwrite(buf, 1, line_escaped(&l, buf, false), stdout);
+  fflush(stdout);
 }
 
-void ui_draw_info(const char *msg) {
-  ui_printf("   " UI_BCYAN "(i)" UI_RESET "  %s\n", msg);
+/*---------------------------------------------------------------------------*/
+/* "   <tag>msg" with the tag in color */
+static void draw_status(const char *color, const char *tag, const char *msg) {
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_puts(&l, "   ");
+  ui_line_color(&l, color);
+  ui_line_puts(&l, tag);
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, msg);
+  ui_line_end(&l);
 }
 
+void ui_draw_ok(const char *msg) { draw_status(UI_BGREEN, "[OK] ", msg); }
+void ui_draw_warn(const char *msg) { draw_status(UI_BYELLOW, "[!!] ", msg); }
+void ui_draw_err(const char *msg) { draw_status(UI_BRED, "[XX] ", msg); }
+void ui_draw_info(const char *msg) { draw_status(UI_BCYAN, "(i)  ", msg); }
+
 /*---------------------------------------------------------------------------*/
 void ui_scroll_begin(void) {
-  s_scroll_count = 0;
-  s_scroll_pos = 0;
-  s_scroll_cur[0] = '\0';
+  s_ui_thread = LWP_GetSelf();
+  line_store_clear(&s_scroll);
+  s_scroll_cur.len = 0;
   s_scroll_active = true;
 }
 
+void ui_scroll_adopt(line_store *ls) {
+  line_store emptied;
+
+  ui_scroll_begin();
+  emptied = s_scroll;
+  s_scroll = *ls;
+  *ls = emptied;
+}
+
 /*---------------------------------------------------------------------------*/
+static void scroll_rule(void) {
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, " ");
+  ui_line_fill(&l, '-', 58);
+  ui_line_end(&l);
+}
+
+/* Search status under the footer: what is searched for and which match */
+static void draw_search_status(const scroll_search *search) {
+  ui_line l;
+
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, " [1/Y] Filter  [2/X] Search");
+  if (search->mode != SEARCH_OFF)
+    ui_line_puts(&l, "  [+/- R/L] Next/Prev match");
+  ui_line_end(&l);
+
+  ui_line_begin(&l);
+  if (search->mode != SEARCH_OFF) {
+    ui_line_color(&l, UI_CYAN);
+    ui_line_puts(&l, " Find: ");
+    ui_line_color(&l, UI_BYELLOW);
+    ui_line_puts(&l, search_label(search));
+    ui_line_color(&l, UI_CYAN);
+    if (!search->nhits) {
+      ui_line_puts(&l, "  (no matches)");
+    } else {
+      ui_line_puts(&l, "  match ");
+      if (search->cur >= 0)
+        ui_line_uint(&l, (u32)search->cur + 1);
+      else
+        ui_line_puts(&l, "-");
+      ui_line_puts(&l, "/");
+      ui_line_uint(&l, search->nhits);
+    }
+  }
+  ui_line_end(&l);
+}
+
+/* One frame of the viewer; only what changed since the last one is sent */
+static void draw_scroll_frame(const char *title, int offset, int count,
+                              const scroll_search *search) {
+  int end = offset + SCROLL_VISIBLE;
+  line_view v;
+  ui_line l;
+  int i;
+
+  if (end > count)
+    end = count;
+
+  screen_begin();
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_BGREEN);
+  ui_line_puts(&l, " [+] WiiMedic");
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, " ");
+  ui_line_color(&l, UI_CYAN);
+  ui_line_puts(&l, "v" WIIMEDIC_VERSION);
+  ui_line_color(&l, UI_RESET);
+  ui_line_puts(&l, "  ");
+  ui_line_color(&l, UI_BWHITE);
+  ui_line_puts(&l, title);
+  ui_line_end(&l);
+  scroll_rule();
+
+  for (i = offset; i < end; i++) {
+    line_store_get(&s_scroll, (u32)i, &v);
+    screen_line(&v);
+  }
+  /* Blank rows keep the footer at the bottom */
+  for (i = end - offset; i < SCROLL_VISIBLE; i++)
+    blank_line();
+  /* Matches in view are marked in the first column */
+  if (search->nhits) {
+    for (i = offset; i < end; i++) {
+      if (search_is_hit(search, (u32)i))
+        screen_put(SCROLL_FIRST_ROW + i - offset, 0, '>', SCROLL_MARK_ATTR);
+    }
+  }
+
+  scroll_rule();
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_WHITE);
+  if (count > SCROLL_VISIBLE) {
+    ui_line_puts(&l, " [UP/DOWN] Scroll  [LEFT/RIGHT] Page  [A/B] Return");
+    ui_line_color(&l, UI_RESET);
+    ui_line_color(&l, UI_CYAN);
+    ui_line_puts(&l, "  [");
+    ui_line_uint(&l, (u32)offset + 1);
+    ui_line_puts(&l, "-");
+    ui_line_uint(&l, (u32)end);
+    ui_line_puts(&l, "/");
+    ui_line_uint(&l, (u32)count);
+    ui_line_puts(&l, "]");
+  } else {
+    ui_line_puts(&l, " Press [A] or [B] to return to menu...");
+  }
+  ui_line_end(&l);
+  draw_search_status(search);
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_BYELLOW);
+  ui_line_puts(&l, " ");
+  ui_line_puts(&l, s_shot_note);
+  ui_line_end(&l);
+  screen_present();
+}
+
 void ui_scroll_view(const char *title) {
+  scroll_search search;
   int offset = 0;
-  int max_offset;
+  int max_offset, count;
   int visible = SCROLL_VISIBLE;
 
-  /* Flush any remaining partial line */
-  if (s_scroll_pos > 0) {
-    s_scroll_cur[s_scroll_pos] = '\0';
-    if (s_scroll_count < SCROLL_MAX_LINES) {
-      memcpy(s_scroll_lines[s_scroll_count], s_scroll_cur, s_scroll_pos + 1);
-      s_scroll_count++;
-    }
-    s_scroll_pos = 0;
+  /* Collect worker output, then flush any remaining partial line */
+  ui_output_drain();
+  if (s_scroll_cur.len > 0) {
+    scroll_store_line(s_scroll_cur.buf, s_scroll_cur.len);
+    s_scroll_cur.len = 0;
   }
   s_scroll_active = false;
+  count = (int)line_store_count(&s_scroll);
 
-  max_offset = s_scroll_count - visible;
+  max_offset = count - visible;
   if (max_offset < 0)
     max_offset = 0;
+  search_begin(&search, &s_scroll);
 
   while (1) {
-    int i, end;
     u32 wpad, gpad;
     bool redraw;
+    int jump;
 
-    printf("\x1b[2J\x1b[0;0H");
-
-    /* Compact header */
-    printf(UI_BGREEN " [+] WiiMedic" UI_RESET " " UI_CYAN
-                     "v" WIIMEDIC_VERSION UI_RESET "  " UI_BWHITE
-                     "%s\n" UI_RESET,
-           title);
-    printf(UI_WHITE " ");
-    for (i = 0; i < 58; i++)
-      printf("-");
-    printf("\n" UI_RESET);
-
-    /* Content lines */
-    end = offset + visible;
-    if (end > s_scroll_count)
-      end = s_scroll_count;
-    for (i = offset; i < end; i++) {
-      printf(UI_RESET "%s\n", s_scroll_lines[i]);
-    }
-    /* Pad so footer stays at bottom */
-    for (i = end - offset; i < visible; i++)
-      printf("\n");
-
-    /* Footer */
-    printf(UI_WHITE " ");
-    for (i = 0; i < 58; i++)
-      printf("-");
-    printf("\n" UI_RESET);
-    if (max_offset > 0) {
-      printf(UI_WHITE " [UP/DOWN] Scroll  [LEFT/RIGHT] Page  "
-                      "[A/B] Return" UI_RESET UI_CYAN "  [%d-%d/%d]\n" UI_RESET,
-             offset + 1, end, s_scroll_count);
-    } else {
-      printf(UI_WHITE " Press [A] or [B] to return to menu...\n" UI_RESET);
-    }
+    draw_scroll_frame(title, offset, count, &search);
 
     /* Input loop */
     while (1) {
+      u32 solo = 0;
+
       WPAD_ScanPads();
       PAD_ScanPads();
       wpad = WPAD_ButtonsDown(0);
       gpad = PAD_ButtonsDown(0);
-      redraw = false;
+      redraw = ui_screenshot_poll(WPAD_ButtonsHeld(0), gpad, &solo);
+      jump = 0;
 
       if ((wpad & WPAD_BUTTON_UP) || (gpad & PAD_BUTTON_UP)) {
         if (offset > 0) {
@@ -273,8 +933,38 @@ void ui_scroll_view(const char *title) {
           offset = max_offset;
         redraw = true;
       }
+
+      /* Search: a preset or typed text, then next/previous match. 1 and 2
+         act on release, as together they take a screenshot. */
+      if ((solo & WPAD_BUTTON_1) || (gpad & PAD_BUTTON_Y)) {
+        search_next_preset(&search);
+        jump = 1;
+      }
+      if ((solo & WPAD_BUTTON_2) || (gpad & PAD_BUTTON_X)) {
+        char text[SEARCH_TEXT_MAX + 1] = "";
+
+        if (search.mode == SEARCH_TEXT)
+          strcpy(text, search.text);
+        if (ui_keyboard("Search", text, sizeof(text)))
+          search_set_text(&search, text);
+        jump = 1;
+      }
+      if ((wpad & WPAD_BUTTON_PLUS) || (gpad & PAD_TRIGGER_R))
+        jump = 1;
+      if ((wpad & WPAD_BUTTON_MINUS) || (gpad & PAD_TRIGGER_L))
+        jump = -1;
+      if (jump) {
+        int line = search_jump(&search, (u32)offset, jump);
+
+        if (line >= 0)
+          offset = line < max_offset ? line : max_offset;
+        redraw = true;
+      }
+
       if ((wpad & WPAD_BUTTON_A) || (wpad & WPAD_BUTTON_B) ||
           (gpad & PAD_BUTTON_A) || (gpad & PAD_BUTTON_B)) {
+        search_end(&search);
+        s_shot_note[0] = '\0';
         return;
       }
 
@@ -285,21 +975,117 @@ void ui_scroll_view(const char *title) {
   }
 }
 
+/*---------------------------------------------------------------------------*/
+static const char s_kb_keys[KB_KEYS + 1] = "ABCDEFGHIJKLM"
+                                           "NOPQRSTUVWXYZ"
+                                           "0123456789.-/"
+                                           "[]()!:%#+=,* ";
+
+static void draw_keyboard(const char *title, const char *text, int sel) {
+  ui_line l;
+  int r, c;
+
+  screen_begin();
+  ui_draw_banner();
+  ui_draw_section(title);
+  ui_line_begin(&l);
+  ui_line_color(&l, UI_CYAN);
+  ui_line_puts(&l, "   > ");
+  ui_line_color(&l, UI_BWHITE);
+  ui_line_puts(&l, text);
+  ui_line_color(&l, UI_BGREEN);
+  ui_line_puts(&l, "_");
+  ui_line_end(&l);
+  blank_line();
+
+  for (r = 0; r < KB_ROWS; r++) {
+    ui_line_begin(&l);
+    ui_line_puts(&l, "     ");
+    for (c = 0; c < KB_COLS; c++) {
+      int k = r * KB_COLS + c;
+      char key[4] = "   ";
+
+      /* The space bar shows as '_' */
+      key[1] = s_kb_keys[k] == ' ' ? '_' : s_kb_keys[k];
+      if (k == sel) {
+        key[0] = '[';
+        key[2] = ']';
+        ui_line_color(&l, UI_BGREEN);
+      } else {
+        ui_line_color(&l, UI_WHITE);
+      }
+      ui_line_puts(&l, key);
+    }
+    ui_line_end(&l);
+  }
+
+  ui_draw_footer("[A] Type  [B] Delete  [+/START] Done  [HOME/Z] Cancel");
+  screen_present();
+}
+
+bool ui_keyboard(const char *title, char *buf, int size) {
+  int len = (int)strlen(buf);
+  int sel = 0;
+
+  while (1) {
+    u32 wpad, gpad;
+
+    draw_keyboard(title, buf, sel);
+    while (1) {
+      WPAD_ScanPads();
+      PAD_ScanPads();
+      wpad = WPAD_ButtonsDown(0);
+      gpad = PAD_ButtonsDown(0);
+      if (wpad || gpad)
+        break;
+      VIDEO_WaitVSync();
+    }
+
+    if ((wpad & WPAD_BUTTON_HOME) || (gpad & PAD_TRIGGER_Z))
+      return false;
+    if ((wpad & WPAD_BUTTON_PLUS) || (gpad & PAD_BUTTON_START))
+      return true;
+
+    if ((wpad & WPAD_BUTTON_UP) || (gpad & PAD_BUTTON_UP))
+      sel = (sel + KB_KEYS - KB_COLS) % KB_KEYS;
+    if ((wpad & WPAD_BUTTON_DOWN) || (gpad & PAD_BUTTON_DOWN))
+      sel = (sel + KB_COLS) % KB_KEYS;
+    if ((wpad & WPAD_BUTTON_LEFT) || (gpad & PAD_BUTTON_LEFT))
+      sel = sel % KB_COLS ? sel - 1 : sel + KB_COLS - 1;
+    if ((wpad & WPAD_BUTTON_RIGHT) || (gpad & PAD_BUTTON_RIGHT))
+      sel = (sel + 1) % KB_COLS ? sel + 1 : sel - KB_COLS + 1;
+
+    if (((wpad & WPAD_BUTTON_A) || (gpad & PAD_BUTTON_A)) && len < size - 1) {
+      buf[len++] = s_kb_keys[sel];
+      buf[len] = '\0';
+    }
+    if ((wpad & WPAD_BUTTON_B) || (gpad & PAD_BUTTON_B)) {
+      if (!len)
+        return false;
+      buf[--len] = '\0';
+    }
+    VIDEO_WaitVSync();
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 void ui_draw_footer(const char *msg) {
-  printf("\n");
+  ui_line l;
+
+  blank_line();
   ui_draw_line();
-  if (msg)
-    printf("   " UI_WHITE "%s\n" UI_RESET, msg);
-  else
-    printf("   " UI_WHITE
-           "[UP/DOWN] Navigate   [A] Select   [HOME] Exit\n" UI_RESET);
+  ui_line_begin(&l);
+  ui_line_puts(&l, "   ");
+  ui_line_color(&l, UI_WHITE);
+  ui_line_puts(&l, msg ? msg : "[UP/DOWN] Navigate   [A] Select   [HOME] Exit");
+  ui_line_end(&l);
 }
 
 /*---------------------------------------------------------------------------*/
-void ui_wait_button(void) {
-  printf("\n   " UI_WHITE "Press [A] or [B] to return to menu..." UI_RESET
-         "\n");
+void ui_wait_button(void) { ui_wait_button_to("return to menu"); }
+
+void ui_wait_button_to(const char *what) {
+  printf("\n   " UI_WHITE "Press [A] or [B] to %s..." UI_RESET "\n", what);
 
   while (1) {
     WPAD_ScanPads();
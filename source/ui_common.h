@@ -9,6 +9,8 @@
 
 #include <gccore.h>
 
+#include "line_store.h"
+
 /* App version */
 #define WIIMEDIC_VERSION "1.1.0"
 
@@ -54,6 +56,10 @@ void ui_draw_kv_color(const char *label, const char *color, const char *value);
 /* Draw a progress bar: [####..........] 45.2%  */
 void ui_draw_bar(u32 used, u32 total, int bar_width);
 
+/* Draw a one-line task progress bar in place (printf, not the scroll
+   buffer):  | [#######.......]  45%   12s  [B] Cancel */
+void ui_draw_progress(u32 permille, u32 elapsed_ms, const char *status);
+
 /* Status messages with indicator prefix */
 void ui_draw_ok(const char *msg);
 void ui_draw_warn(const char *msg);
@@ -66,13 +72,82 @@ void ui_draw_footer(const char *msg);
 /* Print that routes through scroll buffer when active */
 int ui_printf(const char *fmt, ...);
 
+/* Line builder: compose one row of text and colour changes without printf
+   and emit it whole, wherever ui_printf would send it. The drawing helpers
+   use it. Text past UI_LINE_TEXT is cut; colour changes past UI_LINE_RUNS
+   are ignored. */
+#define UI_LINE_TEXT 256
+#define UI_LINE_RUNS 16
+
+typedef struct {
+  char text[UI_LINE_TEXT];
+  u32 len;
+  line_run runs[UI_LINE_RUNS];
+  u32 nruns;
+  u8 attr;
+} ui_line;
+
+void ui_line_begin(ui_line *l);
+void ui_line_color(ui_line *l, const char *color); /* UI_*, as printf */
+void ui_line_puts(ui_line *l, const char *s);
+void ui_line_fill(ui_line *l, char c, int count);
+void ui_line_uint(ui_line *l, u32 v);
+void ui_line_end(ui_line *l); /* emit, followed by a newline */
+
+/* Worker threads: ui_printf from any thread other than the one that called
+   ui_scroll_begin goes through a per-thread lock-free ring. A worker must
+   call ui_output_detach before it exits; the UI thread must keep calling
+   ui_output_drain while workers run (a full ring blocks its producer). */
+void ui_output_detach(void);
+
+/* Send the calling thread's output into ls until it detaches, instead of
+   the screen or the scroll buffer; ui_output_drain is not needed. For a
+   screen computed in the background and shown later: ls belongs to the
+   thread until then. Returns false if too many threads capture already. */
+bool ui_output_capture(line_store *ls);
+
+/* Discard the calling worker's output until it detaches (no-op on the UI
+   thread). For background work whose results are consumed elsewhere. */
+void ui_output_mute(void);
+
+/* Move finished worker lines into the scroll buffer (UI thread only).
+   Returns the number of lines moved. */
+int ui_output_drain(void);
+
+/* Batch mode: drop all ui_printf / ui_draw_* output from every thread
+   without formatting it */
+void ui_set_headless(bool on);
+
 /* Start capturing output to scroll buffer */
 void ui_scroll_begin(void);
 
-/* Display scroll viewer with UP/DOWN/LEFT/RIGHT navigation */
+/* As ui_scroll_begin, with the lines of ls already in the buffer (no copy:
+   ls is left empty, holding the buffer's old memory) */
+void ui_scroll_adopt(line_store *ls);
+
+/* Display scroll viewer with UP/DOWN/LEFT/RIGHT navigation; [1]/[2] (GC
+   Y/X) search by severity marker or text, [+]/[-] (GC R/L) jump between
+   matches, [1]+[2] (GC Z) takes a screenshot */
 void ui_scroll_view(const char *title);
 
+/* Screenshot chord for screens with their own input loop: Wii Remote 1+2
+   together, or GC Z, saves the screen to SD. Call after every pad scan.
+   Returns true if a screenshot was attempted; redraw to show
+   ui_screenshot_note. If solo is given, Wii Remote 1 or 2 released without
+   completing the chord is added to it. */
+bool ui_screenshot_poll(u32 wpad_held, u32 gpad_down, u32 *solo);
+
+/* Result of the last screenshot on this screen, or "" */
+const char *ui_screenshot_note(void);
+
+/* On-screen keyboard editing buf (NUL-terminated, at most size - 1 chars).
+   Returns false if cancelled; buf may have changed. */
+bool ui_keyboard(const char *title, char *buf, int size);
+
 /* Wait for A or B button press */
 void ui_wait_button(void);
 
+/* The same, with "Press [A] or [B] to <what>..." */
+void ui_wait_button_to(const char *what);
+
 #endif /* _UI_COMMON_H_ */
@@ -0,0 +1,227 @@
+/*
+ * WiiMedic - xfb_text.c
+ * Text straight into the framebuffer. The console parses every escape and
+ * draws each glyph pixel by pixel into the one framebuffer on screen, so a
+ * redraw can be seen happening. Here the retained screen's cells go into
+ * whichever of two framebuffers is hidden, and that one is shown from the
+ * next VSync. An XFB holds YUYV: one 32-bit word is two pixels sharing
+ * their chroma, so an 8-pixel glyph row is 4 words. For each colour every
+ * possible glyph row (one font byte) is expanded into those 4 words at
+ * init, which turns a glyph into 16 four-word copies. Drawing goes through
+ * the cached mapping and the touched lines are stored out afterwards,
+ * rather than one uncached bus write per word.
+ */
+
+#include <gccore.h>
+
+#include "xfb_text.h"
+
+#define XFB_GLYPH_W 8
+#define XFB_GLYPH_H 16
+#define XFB_ROW_WORDS (XFB_GLYPH_W / 2)
+#define XFB_COLORS 16      /* console colours 30-37, then the bold ones */
+#define XFB_DEFAULT_FG 15  /* the console starts in bright white */
+#define XFB_NO_FLIP 0xFFFFFFFF
+
+/* The console's font: 256 glyphs of 16 bytes, one per row, MSB leftmost */
+extern u8 console_font_8x16[];
+
+/* Two pixels: Y of the left one, shared U, Y of the right one, shared V */
+#define XFB_PAIR(y1, u, y2, v)                                                 \
+  ((u32)(y1) << 24 | (u32)(u) << 16 | (u32)(y2) << 8 | (u32)(v))
+
+static const u8 s_rgb[XFB_COLORS][3] = {
+    {0, 0, 0},      {170, 0, 0},     {0, 170, 0},    {170, 170, 0},
+    {0, 0, 170},    {170, 0, 170},   {0, 170, 170},  {170, 170, 170},
+    {85, 85, 85},   {255, 85, 85},   {85, 255, 85},  {255, 255, 85},
+    {85, 85, 255},  {255, 85, 255},  {85, 255, 255}, {255, 255, 255},
+};
+
+/* s_glyph_rows[colour][font byte] = that row of pixels over black */
+static u32 s_glyph_rows[XFB_COLORS][256][XFB_ROW_WORDS];
+static u32 s_black;
+
+static void *s_xfb[2];  /* as given to VIDEO_SetNextFramebuffer */
+static u32 *s_draw[2];  /* the same, cached */
+static bool s_valid[2]; /* false: holds something else, clear first */
+static screen_cell s_shown[2][SCREEN_ROWS][SCREEN_COLS];
+static int s_cur; /* buffer on screen (or about to be) */
+static u32 s_flip_retrace;
+static bool s_active = false;
+
+static u32 s_width;
+static u32 s_height;
+static u32 s_stride;   /* words per line */
+static u32 s_words;    /* words per framebuffer */
+static u32 s_origin;   /* word offset of cell (0,0) */
+
+/*---------------------------------------------------------------------------*/
+/* BT.601 studio range, as the VI expects */
+static void rgb_to_yuv(const u8 *rgb, u32 *y, u32 *u, u32 *v) {
+  int r = rgb[0], g = rgb[1], b = rgb[2];
+
+  *y = (u32)(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+  *u = (u32)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+  *v = (u32)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+}
+
+static void build_glyph_rows(void) {
+  u32 by, bu, bv;
+  int c, bits, w;
+
+  rgb_to_yuv(s_rgb[0], &by, &bu, &bv);
+  s_black = XFB_PAIR(by, bu, by, bv);
+
+  for (c = 0; c < XFB_COLORS; c++) {
+    u32 fy, fu, fv, pair[4];
+
+    /* pair[left bit << 1 | right bit] */
+    rgb_to_yuv(s_rgb[c], &fy, &fu, &fv);
+    pair[0] = s_black;
+    pair[1] = XFB_PAIR(by, (bu + fu) / 2, fy, (bv + fv) / 2);
+    pair[2] = XFB_PAIR(fy, (bu + fu) / 2, by, (bv + fv) / 2);
+    pair[3] = XFB_PAIR(fy, fu, fy, fv);
+
+    for (bits = 0; bits < 256; bits++)
+      for (w = 0; w < XFB_ROW_WORDS; w++)
+        s_glyph_rows[c][bits][w] = pair[(bits >> (6 - 2 * w)) & 3];
+  }
+}
+
+static int attr_color(u8 attr) {
+  if (!(attr & LINE_ATTR_FG))
+    return XFB_DEFAULT_FG;
+  return LINE_ATTR_COLOR(attr) + ((attr & LINE_ATTR_BOLD) ? 8 : 0);
+}
+
+/*---------------------------------------------------------------------------*/
+bool xfb_text_init(GXRModeObj *rmode, void *console_fb) {
+  u32 x, y;
+  void *fb;
+
+  if (rmode->fbWidth < SCREEN_COLS * XFB_GLYPH_W ||
+      rmode->xfbHeight < SCREEN_ROWS * XFB_GLYPH_H)
+    return false;
+  fb = SYS_AllocateFramebuffer(rmode);
+  if (!fb)
+    return false;
+
+  build_glyph_rows();
+  s_xfb[0] = console_fb;
+  s_xfb[1] = MEM_K0_TO_K1(fb);
+  s_draw[0] = (u32 *)MEM_K1_TO_K0(console_fb);
+  s_draw[1] = (u32 *)fb;
+  s_valid[0] = s_valid[1] = false;
+  s_cur = 0;
+  s_flip_retrace = XFB_NO_FLIP;
+
+  /* Centre the grid; x must be even to start on a whole pair */
+  s_width = rmode->fbWidth;
+  s_height = rmode->xfbHeight;
+  s_stride = rmode->fbWidth / 2;
+  s_words = s_stride * rmode->xfbHeight;
+  x = ((rmode->fbWidth - SCREEN_COLS * XFB_GLYPH_W) / 2) & ~1u;
+  y = (rmode->xfbHeight - SCREEN_ROWS * XFB_GLYPH_H) / 2;
+  s_origin = y * s_stride + x / 2;
+
+  s_active = true;
+  return true;
+}
+
+bool xfb_text_active(void) { return s_active; }
+
+/*---------------------------------------------------------------------------*/
+static void draw_cell(u32 *dst, screen_cell cell) {
+  const u8 *glyph = &console_font_8x16[SCREEN_CELL_CH(cell) * XFB_GLYPH_H];
+  u32(*rows)[XFB_ROW_WORDS] = s_glyph_rows[attr_color(SCREEN_CELL_ATTR(cell))];
+  int y;
+
+  for (y = 0; y < XFB_GLYPH_H; y++) {
+    const u32 *src = rows[glyph[y]];
+
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    dst[3] = src[3];
+    dst += s_stride;
+  }
+}
+
+static void clear_buffer(int b) {
+  u32 *p = s_draw[b], *end = p + s_words;
+  int r, c;
+
+  while (p < end)
+    *p++ = s_black;
+  for (r = 0; r < SCREEN_ROWS; r++)
+    for (c = 0; c < SCREEN_COLS; c++)
+      s_shown[b][r][c] = SCREEN_BLANK;
+  s_valid[b] = true;
+}
+
+void xfb_text_present(const screen_cell cells[SCREEN_ROWS][SCREEN_COLS]) {
+  int back = s_cur ^ 1;
+  int row, col, first = -1, last = -1;
+  u32 *fb = s_draw[back];
+  bool cleared = false;
+
+  /* The last flip happens at a VSync; until one has passed, the buffer
+     about to be drawn may still be the one on screen */
+  if (VIDEO_GetRetraceCount() == s_flip_retrace)
+    VIDEO_WaitVSync();
+
+  if (!s_valid[back]) {
+    clear_buffer(back);
+    cleared = true;
+  }
+
+  for (row = 0; row < SCREEN_ROWS; row++) {
+    const screen_cell *want = cells[row];
+    screen_cell *shown = s_shown[back][row];
+    u32 *line = fb + s_origin + (u32)row * XFB_GLYPH_H * s_stride;
+
+    for (col = 0; col < SCREEN_COLS; col++) {
+      if (want[col] == shown[col])
+        continue;
+      draw_cell(line + col * XFB_ROW_WORDS, want[col]);
+      shown[col] = want[col];
+      if (first < 0)
+        first = row;
+      last = row;
+    }
+  }
+
+  if (cleared) {
+    DCStoreRange(fb, s_words * 4);
+  } else if (first >= 0) {
+    u32 *start = fb + s_origin + (u32)first * XFB_GLYPH_H * s_stride;
+
+    DCStoreRange(start, (u32)(last - first + 1) * XFB_GLYPH_H * s_stride * 4);
+  }
+
+  VIDEO_SetNextFramebuffer(s_xfb[back]);
+  VIDEO_Flush();
+  s_cur = back;
+  s_flip_retrace = VIDEO_GetRetraceCount();
+}
+
+const u32 *xfb_text_shown(u32 *width, u32 *height) {
+  if (!s_active)
+    return NULL;
+  /* The console writes its buffer uncached; drop any stale lines. Ours
+     hold nothing unwritten: every present stores what it drew. */
+  DCInvalidateRange(s_draw[s_cur], s_words * 4);
+  *width = s_width;
+  *height = s_height;
+  return s_draw[s_cur];
+}
+
+void xfb_text_release(void) {
+  s_valid[0] = false;
+  if (s_cur == 0)
+    return;
+  VIDEO_SetNextFramebuffer(s_xfb[0]);
+  VIDEO_Flush();
+  s_cur = 0;
+  s_flip_retrace = VIDEO_GetRetraceCount();
+}
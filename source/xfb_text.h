@@ -0,0 +1,35 @@
+/*
+ * WiiMedic - xfb_text.h
+ * Glyph renderer for the retained screen: cells are drawn straight into the
+ * video framebuffers (YUYV) instead of going through the libogc console,
+ * double buffered and flipped on VSync
+ */
+#ifndef XFB_TEXT_H
+#define XFB_TEXT_H
+
+#include <gccore.h>
+
+#include "screen.h"
+
+// Take over text drawing for the retained screen. console_fb is the
+// framebuffer console_init draws into; it becomes one of the pair and a
+// second one is allocated. Returns false (console output stays in use) if
+// that allocation fails.
+bool xfb_text_init(GXRModeObj *rmode, void *console_fb);
+
+// True once xfb_text_init succeeded
+bool xfb_text_active(void);
+
+// Draw the cells that differ from what the back buffer holds, then show it
+// from the next VSync
+void xfb_text_present(const screen_cell cells[SCREEN_ROWS][SCREEN_COLS]);
+
+// The framebuffer on screen, for reading (YUYV, width / 2 words per line),
+// or NULL before xfb_text_init
+const u32 *xfb_text_shown(u32 *width, u32 *height);
+
+// Show the console's framebuffer again: the console draws into it directly
+// until the next present, which starts from a cleared buffer
+void xfb_text_release(void);
+
+#endif // XFB_TEXT_H